@@ -539,6 +539,42 @@ msgstr("Video Input Device")
 msgid(VIDEOFRAMERATE)
 msgstr("Video Frame Rate (FPS)")
 
+msgid(AUDIO_FRAME_SIZE)
+msgstr("Audio Frame Size")
+
+msgid(AUDIO_SAMPLE_RATE)
+msgstr("Microphone Sample Rate")
+
+/*
+ * Video call overlay. Leave the %u, they are the width, height, frame rate and bitrate we send at.
+ */
+msgid(VIDEO_SEND_STATS)
+msgstr("Sending video at %ux%u, %u FPS, %u kbit/s")
+
+/* Call statistics overlay, shown when clicking inline video. Leave the %.0f, %.1f and %u, they are the numbers. */
+msgid(CALL_STATS_VIDEO)
+msgstr("Video: %.0f FPS captured, %.0f sent, %.0f received, %u kbit/s")
+
+msgid(CALL_STATS_TIMING)
+msgstr("Converting %.1f ms, encoding %.1f ms, decode to display %.1f ms")
+
+msgid(CALL_STATS_AUDIO)
+msgstr("Audio: %u frames queued, %u underruns, %u dropped, %u kbit/s")
+
+/* Shown after /callstats, %s is the file. */
+msgid(CALL_STATS_SAVED)
+msgstr("Call statistics saved to %s")
+
+msgid(CALL_STATS_NONE)
+msgstr("There are no call statistics for this friend yet.")
+
+/* Shown after /drawbench. Leave the %u and %.2f, they are the numbers. */
+msgid(DRAW_BENCHMARK)
+msgstr("Drew the window %u times: %.2f ms and %u requests to the display server per frame")
+
+msgid(DRAW_BENCHMARK_UNSUPPORTED)
+msgstr("Measuring drawing isn't supported on this platform.")
+
 msgid(PUSH_TO_TALK)
 msgstr("Push To Talk")
 
@@ -158,6 +158,16 @@ typedef enum {
     STR_AUDIOOUTPUTDEVICE,
     STR_VIDEOINPUTDEVICE,
     STR_VIDEOFRAMERATE,
+    STR_AUDIO_FRAME_SIZE,
+    STR_AUDIO_SAMPLE_RATE,
+    STR_VIDEO_SEND_STATS,
+    STR_CALL_STATS_VIDEO,
+    STR_CALL_STATS_TIMING,
+    STR_CALL_STATS_AUDIO,
+    STR_CALL_STATS_SAVED,
+    STR_CALL_STATS_NONE,
+    STR_DRAW_BENCHMARK,
+    STR_DRAW_BENCHMARK_UNSUPPORTED,
     STR_PUSH_TO_TALK,
 
     // Status info
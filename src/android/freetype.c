@@ -73,6 +73,11 @@ GLYPH *font_getglyph(FONT *f, uint32_t ch) {
     return g;
 }
 
+int font_getadvance(FONT *f, uint32_t ch) {
+    const GLYPH *g = font_getglyph(f, ch);
+    return g ? g->xadvance : 0;
+}
+
 void initfonts(void) {
     FT_Init_FreeType(&ftlib);
 }
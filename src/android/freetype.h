@@ -26,6 +26,7 @@ extern FT_Library ftlib;
 extern FONT       font[16], *sfont;
 
 GLYPH *font_getglyph(FONT *f, uint32_t ch);
+int font_getadvance(FONT *f, uint32_t ch);
 
 void initfonts(void);
 void loadfonts(void);
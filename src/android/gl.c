@@ -173,6 +173,7 @@ void drawvline(int x, int y, int y2, uint32_t color) {
 }
 
 void drawalpha(int bm, int x, int y, int width, int height, uint32_t color) {
+    svg_load(bm);
     set_color(color);
     glBindTexture(GL_TEXTURE_2D, bitmap[bm]);
     makequad(&quads[0], x, y, x + width, y + height);
@@ -350,7 +351,7 @@ bool gl_init(void) {
 
     glGenTextures(COUNTOF(bitmap), bitmap);
 
-    svg_draw(0);
+    svg_draw();
     loadfonts();
 
     float vec[4];
@@ -441,6 +442,18 @@ void GL_draw_image(const NATIVE_IMAGE *data, int x, int y, uint32_t width, uint3
     glUniform3fv(k2, 1, one);
 }
 
+NATIVE_IMAGE *GL_utox_rgba_to_native(uint8_t *data, uint16_t width, uint16_t height, bool keep_alpha) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    free(data);
+
+    return texture;
+}
+
 NATIVE_IMAGE *GL_utox_image_to_native(const uint8_t *data, size_t size, uint16_t *w, uint16_t *h, bool keep_alpha) {
     unsigned width, height, bpp;
     uint8_t *out = stbi_load_from_memory(data, size, &width, &height, &bpp, 3);
@@ -49,6 +49,7 @@ bool init_display(ANativeWindow *window);
 
 void GL_draw_image(const NATIVE_IMAGE *data, int x, int y, uint32_t width, uint32_t height, uint32_t imgx, uint32_t imgy);
 
+NATIVE_IMAGE *GL_utox_rgba_to_native(uint8_t *data, uint16_t width, uint16_t height, bool keep_alpha);
 NATIVE_IMAGE *GL_utox_image_to_native(const uint8_t *data, size_t size, uint16_t *w, uint16_t *h, bool keep_alpha);
 
 int GL_utox_android_redraw_window();
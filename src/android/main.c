@@ -6,6 +6,7 @@
 #include "../debug.h"
 #include "../filesys.h"
 #include "../flist.h"
+#include "../macros.h"
 #include "../main.h"
 #include "../settings.h"
 #include "../stb.h"
@@ -124,6 +125,10 @@ void setselection(char *data, uint16_t length) { /* Unsupported on android */
 void edit_will_deactivate(void) { /* Unsupported on android */
 }
 
+NATIVE_IMAGE *utox_rgba_to_native(uint8_t *rgba_data, uint16_t width, uint16_t height, bool keep_alpha) {
+    return GL_utox_rgba_to_native(rgba_data, width, height, keep_alpha);
+}
+
 NATIVE_IMAGE *utox_image_to_native(const UTOX_IMAGE data, size_t size, uint16_t *w, uint16_t *h, bool keep_alpha) {
     return GL_utox_image_to_native(data, size, w, h, keep_alpha);
 }
@@ -329,7 +334,7 @@ void setscale_fonts(void) {
 
 void setscale(void) {
     if (window) {
-        svg_draw(0);
+        svg_draw();
     }
     setscale_fonts();
 }
@@ -464,6 +469,16 @@ void force_redraw(void) {
     redraw();
 }
 
+void redraw_rect(int UNUSED(x), int UNUSED(y), int UNUSED(width), int UNUSED(height)) {
+    redraw();
+}
+
+#ifdef ENABLE_DEVELOPER_COMMANDS
+bool redraw_benchmark(uint16_t UNUSED(frames), uint64_t *UNUSED(frame_ns), uint32_t *UNUSED(requests)) {
+    return false;
+}
+#endif
+
 void update_tray(void) { /* Unsupported on android */
 }
 
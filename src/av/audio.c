@@ -1,7 +1,13 @@
 #include "audio.h"
 
+#include "audio_mixer.h"
+#include "audio_ring.h"
+#include "call_stats.h"
 #include "utox_av.h"
 #include "filter_audio.h"
+#include "resampler.h"
+#include "vad.h"
+#include "tones.h"
 
 #include "../native/audio.h"
 #include "../native/keyboard.h"
@@ -20,7 +26,8 @@
 
 #include "../../langs/i18n_decls.h"
 
-#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 #include <tox/toxav.h>
@@ -63,7 +70,256 @@ static int16_t    speakers_count, microphone_count;
  * NO SRSLY don't leave this like this! */
 static ALuint ringtone, preview, notifytone;
 
-static ALuint RingBuffer, ToneBuffer;
+/* Buffers each streaming source cycles through. Caps how far behind a source can fall before frames are dropped. */
+#define SOURCE_RING_BUFFERS 16
+
+/* How often a streaming source's state is checked to see if it ran dry. */
+#define SOURCE_STATE_INTERVAL ((uint64_t)20 * 1000 * 1000)
+
+typedef struct {
+    ALuint source;
+
+    ALuint  buffers[SOURCE_RING_BUFFERS];
+    ALuint  free[SOURCE_RING_BUFFERS]; // Buffers that aren't queued on the source
+    uint8_t free_count;
+
+    uint64_t last_state_check;
+
+    AUDIO_PLAYBACK_STATS stats;
+} SOURCE_RING;
+
+/* Friend audio is queued from the toxav thread, everything else from the audio thread. */
+static pthread_mutex_t source_rings_lock = PTHREAD_MUTEX_INITIALIZER;
+static SOURCE_RING    *source_rings;
+static uint32_t        source_rings_count;
+
+static SOURCE_RING *source_ring_find(ALuint source) {
+    for (uint32_t i = 0; i < source_rings_count; ++i) {
+        if (source_rings[i].source == source) {
+            return &source_rings[i];
+        }
+    }
+
+    return NULL;
+}
+
+static SOURCE_RING *source_ring_get(ALuint source) {
+    SOURCE_RING *ring = source_ring_find(source);
+    if (ring) {
+        return ring;
+    }
+
+    SOURCE_RING *new_rings = realloc(source_rings, sizeof(SOURCE_RING) * (source_rings_count + 1));
+    if (!new_rings) {
+        LOG_ERR("uTox Audio", "Unable to realloc for source %u", source);
+        return NULL;
+    }
+    source_rings = new_rings;
+
+    ring = &source_rings[source_rings_count];
+    memset(ring, 0, sizeof(SOURCE_RING));
+
+    alGetError();
+    alGenBuffers(SOURCE_RING_BUFFERS, ring->buffers);
+    ALint error = alGetError();
+    if (error != AL_NO_ERROR) {
+        LOG_ERR("uTox Audio", "Error generating buffers for source %u with err %x", source, error);
+        return NULL;
+    }
+
+    ring->source     = source;
+    ring->free_count = SOURCE_RING_BUFFERS;
+    memcpy(ring->free, ring->buffers, sizeof(ring->free));
+    ++source_rings_count;
+
+    alSourcei(source, AL_LOOPING, AL_FALSE);
+    return ring;
+}
+
+/* Takes the buffers the source is done with back. */
+static void source_ring_recycle(SOURCE_RING *ring) {
+    ALint processed = 0;
+    alGetSourcei(ring->source, AL_BUFFERS_PROCESSED, &processed);
+    if (processed <= 0) {
+        return;
+    }
+
+    processed = MIN(processed, SOURCE_RING_BUFFERS - ring->free_count);
+    alSourceUnqueueBuffers(ring->source, processed, ring->free + ring->free_count);
+    ring->free_count += processed;
+}
+
+/* Detaches and deletes the buffers for source. Must be called before the source is deleted. */
+static void source_ring_free(ALuint source) {
+    pthread_mutex_lock(&source_rings_lock);
+    SOURCE_RING *ring = source_ring_find(source);
+    if (ring) {
+        LOG_INFO("uTox Audio", "Source %u played %u frames: %u underruns, %u overruns, %u dropped", source,
+                 ring->stats.frames_queued, ring->stats.underruns, ring->stats.overruns, ring->stats.dropped);
+
+        alSourceStop(source);
+        alSourcei(source, AL_BUFFER, 0);
+        alDeleteBuffers(SOURCE_RING_BUFFERS, ring->buffers);
+
+        *ring = source_rings[--source_rings_count];
+    }
+    pthread_mutex_unlock(&source_rings_lock);
+}
+
+static void source_queue(ALuint source, const int16_t *data, int samples, uint8_t channels, unsigned int sample_rate) {
+    pthread_mutex_lock(&source_rings_lock);
+
+    SOURCE_RING *ring = source_ring_get(source);
+    if (!ring) {
+        pthread_mutex_unlock(&source_rings_lock);
+        return;
+    }
+
+    if (!channels || channels > 2) {
+        ring->stats.dropped++;
+        pthread_mutex_unlock(&source_rings_lock);
+        return;
+    }
+
+    const uint64_t now = get_time();
+    const bool check_state = now - ring->last_state_check >= SOURCE_STATE_INTERVAL;
+
+    if (!ring->free_count || check_state) {
+        source_ring_recycle(ring);
+    }
+
+    if (!ring->free_count) {
+        LOG_TRACE("uTox Audio", "dropped audio frame" );
+        ring->stats.overruns++;
+        ring->stats.dropped++;
+        pthread_mutex_unlock(&source_rings_lock);
+        return;
+    }
+
+    ALuint bufid = ring->free[--ring->free_count];
+    alBufferData(bufid, (channels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16, data, samples * 2 * channels,
+                 sample_rate);
+    alSourceQueueBuffers(source, 1, &bufid);
+    ring->stats.frames_queued++;
+
+    // LOG_TRACE("uTox Audio", "audio frame || samples == %i channels == %u rate == %u " , samples, channels, sample_rate);
+
+    if (check_state) {
+        ring->last_state_check = now;
+
+        ALint state;
+        alGetSourcei(source, AL_SOURCE_STATE, &state);
+        if (state != AL_PLAYING) {
+            if (state == AL_STOPPED) {
+                // Played everything we gave it before the next frame showed up.
+                ring->stats.underruns++;
+            }
+            alSourcePlay(source);
+            // LOG_TRACE("uTox Audio", "Starting source %u" , i);
+        }
+    }
+
+    pthread_mutex_unlock(&source_rings_lock);
+}
+
+/* Returns how many frames are still waiting to be played on source. */
+static int source_queued(ALuint source) {
+    pthread_mutex_lock(&source_rings_lock);
+
+    int queued = 0;
+    SOURCE_RING *ring = source_ring_get(source);
+    if (ring) {
+        source_ring_recycle(ring);
+        queued = SOURCE_RING_BUFFERS - ring->free_count;
+    }
+
+    pthread_mutex_unlock(&source_rings_lock);
+    return queued;
+}
+
+static ALuint friend_source(unsigned int f) {
+    if (f >= self.friend_list_size) {
+        return preview;
+    }
+
+    return get_friend(f)->audio_dest;
+}
+
+void sourceplaybuffer(unsigned int f, const int16_t *data, int samples, uint8_t channels, unsigned int sample_rate) {
+    source_queue(friend_source(f), data, samples, channels, sample_rate);
+}
+
+bool sourceplaybuffer_stats(unsigned int f, AUDIO_PLAYBACK_STATS *stats) {
+    pthread_mutex_lock(&source_rings_lock);
+
+    SOURCE_RING *ring = source_ring_find(friend_source(f));
+    if (ring) {
+        source_ring_recycle(ring);
+        *stats        = ring->stats;
+        stats->queued = SOURCE_RING_BUFFERS - ring->free_count;
+    }
+
+    pthread_mutex_unlock(&source_rings_lock);
+    return ring != NULL;
+}
+
+/* One buffer per tone, uploaded the first time the tone plays. Buffers belong to the context, so they're deleted when
+ * the output device is closed. */
+static ALuint tone_buffers[TONE_MAX];
+
+static ALuint tone_buffer(TONE tone) {
+    if (tone_buffers[tone]) {
+        return tone_buffers[tone];
+    }
+
+    const TONE_PCM *pcm = tone_get(tone);
+    if (!pcm) {
+        return 0;
+    }
+
+    ALint error;
+    alGetError(); /* clear errors */
+    alGenBuffers((ALuint)1, &tone_buffers[tone]);
+    if ((error = alGetError()) != AL_NO_ERROR) {
+        LOG_TRACE("uTox Audio", "Error generating buffer with err %i" , error);
+        tone_buffers[tone] = 0;
+        return 0;
+    }
+
+    alBufferData(tone_buffers[tone], (pcm->channels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16, pcm->samples,
+                 pcm->frames * pcm->channels * sizeof(int16_t), pcm->sample_rate);
+    return tone_buffers[tone];
+}
+
+static void tone_buffers_free(void) {
+    for (TONE i = 0; i < TONE_MAX; ++i) {
+        if (tone_buffers[i]) {
+            alDeleteBuffers((ALuint)1, &tone_buffers[i]);
+            tone_buffers[i] = 0;
+        }
+    }
+}
+
+/* Audio is captured and filtered in periods this long, the send thread puts them together into each call's frames. */
+#define CAPTURE_PERIOD_MS 10
+
+/* Rate audio_in_handle was opened at. Anything else than UTOX_DEFAULT_SAMPLE_RATE_A goes through capture_resampler. */
+static uint32_t   capture_rate = UTOX_DEFAULT_SAMPLE_RATE_A;
+static RESAMPLER *capture_resampler;
+
+static void audio_in_set_rate(uint32_t rate) {
+    if (rate == capture_rate) {
+        return;
+    }
+
+    resampler_free(capture_resampler);
+    capture_resampler = NULL;
+    capture_rate      = rate;
+
+    if (rate != UTOX_DEFAULT_SAMPLE_RATE_A) {
+        capture_resampler = resampler_create(rate, UTOX_DEFAULT_SAMPLE_RATE_A);
+    }
+}
 
 static bool audio_in_device_open(void) {
     if (!audio_in_device) {
@@ -71,15 +327,34 @@ static bool audio_in_device_open(void) {
     }
     if (audio_in_device == (void *)1) {
         audio_in_handle = (void *)1;
+        // The native capture always hands us 48kHz.
+        audio_in_set_rate(UTOX_DEFAULT_SAMPLE_RATE_A);
         return true;
     }
 
-    alGetError();
-    audio_in_handle = alcCaptureOpenDevice(audio_in_device, UTOX_DEFAULT_SAMPLE_RATE_A, AL_FORMAT_MONO16,
-                                           (UTOX_DEFAULT_FRAME_A * UTOX_DEFAULT_SAMPLE_RATE_A * 4) / 1000);
-    if (alGetError() == AL_NO_ERROR) {
-        return true;
+    /* Try the rate from the settings first, then whatever else the device will give us. */
+    const uint16_t rates[] = UTOX_AUDIO_CAPTURE_RATES;
+    const uint32_t wanted  = settings.audio_capture_rate ? settings.audio_capture_rate : UTOX_DEFAULT_SAMPLE_RATE_A;
+
+    for (size_t i = 0; i <= COUNTOF(rates); ++i) {
+        const uint32_t rate = i ? rates[i - 1] : wanted;
+        if (i && rate == wanted) {
+            continue;
+        }
+
+        alGetError();
+        audio_in_handle = alcCaptureOpenDevice(audio_in_device, rate, AL_FORMAT_MONO16,
+                                               (UTOX_DEFAULT_FRAME_A * rate * 4) / 1000);
+        if (audio_in_handle && alGetError() == AL_NO_ERROR) {
+            if (rate != wanted) {
+                LOG_WARN("uTox Audio", "Unable to capture at %u Hz, using %u Hz instead.", wanted, rate);
+            }
+            audio_in_set_rate(rate);
+            return true;
+        }
     }
+
+    audio_in_handle = NULL;
     return false;
 }
 
@@ -250,9 +525,11 @@ static bool audio_out_device_close(void) {
         return true;
     }
 
+    source_ring_free(preview);
     alDeleteSources((ALuint)1, &preview);
     alDeleteSources((ALuint)1, &ringtone);
     alDeleteSources((ALuint)1, &notifytone);
+    tone_buffers_free();
     alcMakeContextCurrent(NULL);
     alcDestroyContext(context);
     alcCloseDevice(audio_out_handle);
@@ -282,47 +559,19 @@ ALCdevice *utox_audio_out_device_get(void) {
     return NULL;
 }
 
-void sourceplaybuffer(unsigned int f, const int16_t *data, int samples, uint8_t channels, unsigned int sample_rate) {
-    if (!channels || channels > 2) {
-        return;
-    }
-
-    ALuint source;
-    if (f >= self.friend_list_size) {
-        source = preview;
-    } else {
-        source = get_friend(f)->audio_dest;
-    }
-
-    ALuint bufid;
-    ALint processed = 0, queued = 16;
-    alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
-    alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
-    alSourcei(source, AL_LOOPING, AL_FALSE);
-
-    if (processed) {
-        ALuint bufids[processed];
-        alSourceUnqueueBuffers(source, processed, bufids);
-        alDeleteBuffers(processed - 1, bufids + 1);
-        bufid = bufids[0];
-    } else if (queued < 16) {
-        alGenBuffers(1, &bufid);
-    } else {
-        LOG_TRACE("uTox Audio", "dropped audio frame" );
-        return;
-    }
-
-    alBufferData(bufid, (channels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16, data, samples * 2 * channels,
-                 sample_rate);
-    alSourceQueueBuffers(source, 1, &bufid);
+/* Frames of mixed group audio to keep queued on the group's source. Has to cover the 50ms the audio thread can
+ * sleep for. */
+#define GROUP_AUDIO_QUEUE_FRAMES 5
 
-    // LOG_TRACE("uTox Audio", "audio frame || samples == %i channels == %u rate == %u " , samples, channels, sample_rate);
+/* Keeps the group's source topped up with frames from its mixer. */
+static void group_audio_play(GROUPCHAT *g, int16_t *frame, int perframe) {
+    for (int queued = source_queued(g->audio_dest); queued < GROUP_AUDIO_QUEUE_FRAMES; ++queued) {
+        if (!audio_mixer_mix(g->mixer, frame)) {
+            // Nobody's talking, let the source run dry.
+            break;
+        }
 
-    ALint state;
-    alGetSourcei(source, AL_SOURCE_STATE, &state);
-    if (state != AL_PLAYING) {
-        alSourcePlay(source);
-        // LOG_TRACE("uTox Audio", "Starting source %u" , i);
+        source_queue(g->audio_dest, frame, perframe, 1, UTOX_DEFAULT_SAMPLE_RATE_A);
     }
 }
 
@@ -406,164 +655,175 @@ static bool audio_source_init(ALuint *source) {
 
 static void audio_source_raze(ALuint *source) {
     LOG_INFO("Audio", "Deleting source");
+    source_ring_free(*source);
     alDeleteSources((ALuint)1, source);
 }
 
-// clang-format off
-enum {
-    NOTE_none,
-    NOTE_c3_sharp,
-    NOTE_g3,
-    NOTE_b3,
-    NOTE_c4,
-    NOTE_a4,
-    NOTE_b4,
-    NOTE_e4,
-    NOTE_f4,
-    NOTE_c5,
-    NOTE_d5,
-    NOTE_e5,
-    NOTE_f5,
-    NOTE_g5,
-    NOTE_a5,
-    NOTE_c6_sharp,
-    NOTE_e6,
-};
-
-static struct {
-    uint8_t note;
-    double  freq;
-} notes[] = {
-    {NOTE_none,         1           }, /* Can't be 0 or openal will skip this note/time */
-    {NOTE_c3_sharp,     138.59      },
-    {NOTE_g3,           196.00      },
-    {NOTE_b3,           246.94      },
-    {NOTE_c4,           261.63      },
-    {NOTE_a4,           440.f       },
-    {NOTE_b4,           493.88      },
-    {NOTE_e4,           329.63      },
-    {NOTE_f4,           349.23      },
-    {NOTE_c5,           523.25      },
-    {NOTE_d5,           587.33      },
-    {NOTE_e5,           659.25      },
-    {NOTE_f5,           698.46      },
-    {NOTE_g5,           783.99      },
-    {NOTE_a5,           880.f       },
-    {NOTE_c6_sharp,     1108.73     },
-    {NOTE_e6,           1318.51     },
-};
-
-static struct melodies { /* C99 6.7.8/10 uninitialized arithmetic types are 0 this is what we want. */
-    uint8_t count;
-    uint8_t volume;
-    uint8_t fade;
-    uint8_t notes[8];
-} normal_ring[16] = {
-    {1, 14, 1, {NOTE_f5,        }},
-    {1, 14, 1, {NOTE_f5,        }},
-    {1, 14, 1, {NOTE_f5,        }},
-    {1, 14, 1, {NOTE_c6_sharp,  }},
-    {1, 14, 0, {NOTE_c5,        }},
-    {1, 14, 1, {NOTE_c5,        }},
-    {0, 0, 0,  {0,  }},
-}, friend_offline[4] = {
-    {1, 14, 1, {NOTE_c4, }},
-    {1, 14, 1, {NOTE_g3, }},
-    {1, 14, 1, {NOTE_g3, }},
-    {0, 0, 0,  {0, }},
-}, friend_online[4] = {
-    {1, 14, 0, {NOTE_g3, }},
-    {1, 14, 1, {NOTE_g3, }},
-    {1, 14, 1, {NOTE_a4, }},
-    {1, 14, 1, {NOTE_b4, }},
-}, friend_new_msg[8] = {
-    {1, 0, 0,  {0, }}, /* 3/8 sec of silence for spammy friends */
-    {1, 0, 0,  {0, }},
-    {1, 0, 0,  {0, }},
-    {1, 9,  0, {NOTE_g5, }},
-    {1, 9,  1, {NOTE_g5, }},
-    {1, 12, 1, {NOTE_a4, }},
-    {1, 10, 1, {NOTE_a4, }},
-    {1, 0, 0,  {0, }},
-}, friend_request[8] = {
-    {1, 9,  0, {NOTE_g5, }},
-    {1, 9,  1, {NOTE_g5, }},
-    {1, 12, 1, {NOTE_b3, }},
-    {1, 10, 1, {NOTE_b3, }},
-    {1, 9,  0, {NOTE_g5, }},
-    {1, 9,  1, {NOTE_g5, }},
-    {1, 12, 1, {NOTE_b3, }},
-    {1, 10, 0, {NOTE_b3, }},
-};
-// clang-format on
-
-typedef struct melodies MELODY;
-
-// TODO: These should be functions rather than macros that only work in a specific context.
-#define FADE_STEP_OUT() (1 - ((double)(index % (sample_rate / notes_per_sec)) / (sample_rate / notes_per_sec)))
-#define FADE_STEP_IN() (((double)(index % (sample_rate / notes_per_sec)) / (sample_rate / notes_per_sec)))
-
-// GEN_NOTE_RAW is unused. Delete?
-#define GEN_NOTE_RAW(x, a) ((a * base_amplitude) * (sin((tau * x) * index / sample_rate)))
-#define GEN_NOTE_NUM(x, a) ((a * base_amplitude) * (sin((tau * notes[x].freq) * index / sample_rate)))
-
-#define GEN_NOTE_NUM_FADE(x, a) \
-    ((a * base_amplitude * FADE_STEP_OUT()) * (sin((tau * notes[x].freq) * index / sample_rate)))
-// GEN_NOTE_NUM_FADE_IN is unused. Delete?
-#define GEN_NOTE_NUM_FADE_IN(x, a) \
-    ((a * base_amplitude * FADE_STEP_IN()) * (sin((tau * notes[x].freq) * index / sample_rate)))
-
-static void generate_melody(MELODY melody[], uint32_t seconds, uint32_t notes_per_sec, ALuint *target) {
-    ALint error;
-    alGetError(); /* clear errors */
+/* Frames the audio thread has captured, waiting for the send thread. */
+static AUDIO_RING capture_ring;
 
-    alGenBuffers((ALuint)1, target);
+static _Atomic(ToxAV *) send_av;
+static atomic_bool      send_thread_run, send_thread_running;
 
-    if ((error = alGetError()) != AL_NO_ERROR) {
-        LOG_TRACE("uTox Audio", "Error generating buffer with err %i" , error);
-        return;
+static pthread_mutex_t capture_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static AUDIO_HISTOGRAM capture_latency, capture_jitter;
+
+static uint8_t call_frame_ms(void) {
+    return settings.audio_frame_ms ? settings.audio_frame_ms : UTOX_DEFAULT_FRAME_A;
+}
+
+/* Sends pcm to every call using frame_ms long frames. With pcm NULL the frame was gated as silence, and is only
+ * counted as suppressed. */
+static void audio_send_frame(ToxAV *av, uint8_t frame_ms, const int16_t *pcm, uint32_t samples) {
+    size_t active_call_count = 0;
+    for (size_t i = 0; i < self.friend_list_count; i++) {
+        if (UTOX_SEND_AUDIO(i)) {
+            active_call_count++;
+            TOXAV_ERR_SEND_FRAME error = 0;
+            // LOG_TRACE("uTox Audio", "Sending audio frame!" );
+            FRIEND *f = get_friend(i);
+            if (!f) {
+                LOG_ERR("uToxAV", "Unable to get friend when sending audio frame %u", i);
+                continue;
+            }
+            if (f->audio_frame_ms != frame_ms) {
+                continue;
+            }
+            if (!pcm) {
+                f->audio_frames_suppressed++;
+                continue;
+            }
+            toxav_audio_send_frame(av, f->number, pcm, samples, UTOX_DEFAULT_AUDIO_CHANNELS,
+                                   UTOX_DEFAULT_SAMPLE_RATE_A, &error);
+            if (error) {
+                LOG_TRACE("uTox Audio", "toxav_send_audio error friend == %lu, error ==  %i" , i, error);
+            } else {
+                // LOG_TRACE("uTox Audio", "Send a frame to friend %i" ,i);
+                f->audio_frames_sent++;
+                if (active_call_count >= UTOX_MAX_CALLS) {
+                    LOG_TRACE("uTox Audio", "We're calling more peers than allowed by UTOX_MAX_CALLS, This is a bug" );
+                    break;
+                }
+            }
+        }
     }
 
-    const uint32_t sample_rate    = 22000;
-    const uint32_t base_amplitude = 1000;
-    const double tau = 6.283185307179586476925286766559;
+    Tox *tox = toxav_get_tox(av);
+    uint32_t num_chats = tox_conference_get_chatlist_size(tox);
 
-    const size_t buf_size = seconds * sample_rate * 2; // 16 bit (2 bytes per sample)
-    int16_t *samples  = calloc(buf_size, sizeof(int16_t));
+    if (num_chats) {
+        for (size_t i = 0 ; i < num_chats; ++i) {
+            GROUPCHAT *g = get_group(i);
+            if (g && g->active_call && g->audio_frame_ms == frame_ms) {
+                if (!pcm) {
+                    g->audio_frames_suppressed++;
+                    continue;
+                }
+                LOG_TRACE("uTox Audio", "Sending audio in groupchat %u", i);
+                toxav_group_send_audio(tox, i, pcm, samples, UTOX_DEFAULT_AUDIO_CHANNELS, UTOX_DEFAULT_SAMPLE_RATE_A);
+                g->audio_frames_sent++;
+            }
+        }
+    }
+}
 
-    if (!samples) {
-        LOG_TRACE("uTox Audio", "Unable to generate ringtone buffer!" );
-        return;
+/* A frame of every duration a call can pick, put together out of capture periods. */
+typedef struct {
+    uint8_t  frame_ms;
+    uint32_t samples, length;
+    bool     voice;   // Any of the periods so far had voice in them
+    bool     talking; // The last frame was sent as voice
+    int16_t  pcm[UTOX_DEFAULT_SAMPLE_RATE_A * 60 / 1000];
+} SEND_FRAME;
+
+/* Send stage: drains the capture ring and hands every frame to each call we're sending audio to. */
+static void utox_audio_send_thread(void *UNUSED(args)) {
+    const uint16_t frame_sizes[] = UTOX_AUDIO_FRAME_SIZES;
+    SEND_FRAME frames[COUNTOF(frame_sizes)];
+    for (size_t i = 0; i < COUNTOF(frames); ++i) {
+        frames[i].frame_ms = frame_sizes[i];
+        frames[i].samples  = UTOX_DEFAULT_SAMPLE_RATE_A * frame_sizes[i] / 1000;
+        frames[i].length   = 0;
+        frames[i].voice    = false;
+        frames[i].talking  = false;
     }
 
-    for (uint64_t index = 0; index < buf_size; ++index) {
-        /* index / sample rate `mod` seconds. will give you full second long notes
-         * you can change the length each tone is played by changing notes_per_sec
-         * but you'll need to add additional case to cover the entire span of time */
-        const int position = ((index / (sample_rate / notes_per_sec)) % (seconds * notes_per_sec));
+    uint64_t last_captured = 0, last_latency = 0;
+    uint32_t noise_seed = 0x5eed;
+
+    while (atomic_load(&send_thread_run)) {
+        const AUDIO_RING_FRAME *frame = audio_ring_read_begin(&capture_ring, 100);
+        if (!frame) {
+            continue;
+        }
+
+        const uint64_t period  = (uint64_t)frame->frame_samples * 1000 * 1000 * 1000 / frame->sample_rate;
+        const bool     gap     = !last_captured || frame->captured - last_captured > period * 2;
+
+        ToxAV *av = atomic_load(&send_av);
+        for (size_t i = 0; i < COUNTOF(frames); ++i) {
+            SEND_FRAME *f = &frames[i];
+            if (gap) {
+                // Don't glue audio from either side of a gap in the capture together.
+                f->length = 0;
+                f->voice  = false;
+            }
+
+            const uint32_t n = MIN(frame->frame_samples, f->samples - f->length);
+            memcpy(f->pcm + f->length, frame->samples, n * sizeof(int16_t));
+            f->length += n;
+            f->voice  |= frame->voice;
+
+            if (f->length < f->samples) {
+                continue;
+            }
 
-        for (int i = 0; i < melody[position].count; ++i) {
-            if (melody[position].fade) {
-                samples[index] += GEN_NOTE_NUM_FADE(melody[position].notes[i], melody[position].volume);
+            if (f->voice) {
+                f->talking = true;
+            } else if (f->talking && settings.audio_comfort_noise) {
+                /* Close every talkspurt with a frame of noise at the level of the background, so the other side fades
+                 * out into something like the room instead of concealing a frame that never comes. */
+                vad_comfort_noise(&noise_seed, frame->noise_level, f->pcm, f->samples);
+                f->talking = false;
+                f->voice   = true;
             } else {
-                samples[index] += GEN_NOTE_NUM(melody[position].notes[i], melody[position].volume);
+                f->talking = false;
             }
+
+            if (av) {
+                audio_send_frame(av, f->frame_ms, f->voice ? f->pcm : NULL, f->samples);
+            }
+            f->length = 0;
+            f->voice  = false;
         }
-    }
 
-    alBufferData(*target, AL_FORMAT_MONO16, samples, buf_size, sample_rate);
-    free(samples);
-}
+        const uint64_t now     = get_time();
+        const uint64_t latency = now > frame->captured ? now - frame->captured : 0;
 
-static void generate_tone_call_ringtone() { generate_melody(normal_ring, 4, 4, &RingBuffer); }
+        pthread_mutex_lock(&capture_stats_lock);
+        audio_histogram_add(&capture_latency, latency);
+        // Jitter is how much the latency moved between consecutive frames.
+        if (!gap) {
+            audio_histogram_add(&capture_jitter, latency > last_latency ? latency - last_latency : last_latency - latency);
+        }
+        pthread_mutex_unlock(&capture_stats_lock);
 
-static void generate_tone_friend_offline() { generate_melody(friend_offline, 1, 4, &ToneBuffer); }
+        last_captured = frame->captured;
+        last_latency  = latency;
+        audio_ring_read_end(&capture_ring);
+    }
 
-static void generate_tone_friend_online() { generate_melody(friend_online, 1, 4, &ToneBuffer); }
+    atomic_store(&send_thread_running, false);
+}
 
-static void generate_tone_friend_new_msg() { generate_melody(friend_new_msg, 1, 8, &ToneBuffer); }
+void utox_audio_capture_stats(AUDIO_CAPTURE_STATS *stats) {
+    pthread_mutex_lock(&capture_stats_lock);
+    stats->latency = capture_latency;
+    stats->jitter  = capture_jitter;
+    pthread_mutex_unlock(&capture_stats_lock);
 
-static void generate_tone_friend_request() { generate_melody(friend_request, 1, 8, &ToneBuffer); }
+    stats->overflows = atomic_load(&capture_ring.overflows);
+}
 
 void postmessage_audio(uint8_t msg, uint32_t param1, uint32_t param2, void *data) {
     while (audio_thread_msg && utox_audio_thread_init) {
@@ -593,9 +853,20 @@ void utox_audio_thread(void *args) {
     // bool call[MAX_CALLS] = {0}, preview = 0;
 
     const int perframe = (UTOX_DEFAULT_FRAME_A * UTOX_DEFAULT_SAMPLE_RATE_A) / 1000;
-    uint8_t buf[perframe * 2 * UTOX_DEFAULT_AUDIO_CHANNELS]; //, dest[perframe * 2 * UTOX_DEFAULT_AUDIO_CHANNELS];
+    /* One period straight from the device, at capture_rate. Big enough for a frame from audio_frame() too. */
+    int16_t buf[perframe * UTOX_DEFAULT_AUDIO_CHANNELS];
     memset(buf, 0, sizeof(buf));
 
+    /* Captured audio at UTOX_DEFAULT_SAMPLE_RATE_A, waiting to be cut into periods. */
+    const int chunk = (CAPTURE_PERIOD_MS * UTOX_DEFAULT_SAMPLE_RATE_A) / 1000;
+    int16_t   capture_fifo[perframe * 2];
+    uint32_t  capture_length = 0;
+
+    VAD vad;
+    vad_init(&vad, UTOX_DEFAULT_SAMPLE_RATE_A);
+
+    int16_t group_frame[perframe];
+
     LOG_TRACE("uTox Audio", "frame size: %u" , perframe);
 
     /* init Microphone */
@@ -605,6 +876,9 @@ void utox_audio_thread(void *args) {
 
     /* init Speakers */
     audio_out_init();
+
+    /* Build the ringtone and notification sounds once, they're replayed from their buffers from then on. */
+    tones_load();
     // audio_out_device_open();
     // audio_out_device_close();
 
@@ -617,6 +891,14 @@ void utox_audio_thread(void *args) {
     unsigned int preview_buffer_index = 0;
     bool preview_on = false;
 
+    audio_ring_init(&capture_ring);
+    atomic_store(&send_av, av);
+    atomic_store(&send_thread_run, true);
+    atomic_store(&send_thread_running, true);
+    thread(utox_audio_send_thread, NULL);
+
+    uint64_t last_filter_check = 0;
+
     utox_audio_thread_init = true;
     while (1) {
         if (audio_thread_msg) {
@@ -643,6 +925,12 @@ void utox_audio_thread(void *args) {
                     if (f && !f->audio_dest) {
                         audio_source_init(&f->audio_dest);
                     }
+                    if (f) {
+                        f->audio_frame_ms          = call_frame_ms();
+                        f->audio_frames_sent       = 0;
+                        f->audio_frames_suppressed = 0;
+                        call_stats_start(m->param1, get_time());
+                    }
                     audio_out_device_open();
                     audio_in_listen();
                     break;
@@ -653,6 +941,11 @@ void utox_audio_thread(void *args) {
                         audio_source_raze(&f->audio_dest);
                         f->audio_dest = 0;
                     }
+                    if (f) {
+                        LOG_INFO("uTox Audio", "Call with friend %u: %u audio frames sent, %u suppressed as silence.",
+                                 m->param1, f->audio_frames_sent, f->audio_frames_suppressed);
+                        call_stats_stop(m->param1);
+                    }
                     audio_in_ignore();
                     audio_out_device_close();
                     break;
@@ -668,6 +961,9 @@ void utox_audio_thread(void *args) {
                     if (!g->audio_dest) {
                         audio_source_init(&g->audio_dest);
                     }
+                    g->audio_frame_ms          = call_frame_ms();
+                    g->audio_frames_sent       = 0;
+                    g->audio_frames_suppressed = 0;
 
                     audio_out_device_open();
                     audio_in_listen();
@@ -686,6 +982,11 @@ void utox_audio_thread(void *args) {
                         g->audio_dest = 0;
                     }
 
+                    LOG_INFO("uTox Audio", "Groupchat %u call: %u audio frames sent, %u suppressed as silence.",
+                             m->param1, g->audio_frames_sent, g->audio_frames_suppressed);
+
+                    audio_mixer_clear(g->mixer);
+
                     audio_in_ignore();
                     audio_out_device_close();
                     break;
@@ -708,10 +1009,8 @@ void utox_audio_thread(void *args) {
 
                         audio_out_device_open();
 
-                        generate_tone_call_ringtone();
-
                         alSourcei(ringtone, AL_LOOPING, AL_TRUE);
-                        alSourcei(ringtone, AL_BUFFER, RingBuffer);
+                        alSourcei(ringtone, AL_BUFFER, tone_buffer(TONE_RINGTONE));
 
                         alSourcePlay(ringtone);
                         call_ringing++;
@@ -734,27 +1033,37 @@ void utox_audio_thread(void *args) {
                             audio_out_device_open();
                         }
 
+                        TONE tone;
                         switch (m->param1) {
                             case NOTIFY_TONE_FRIEND_ONLINE: {
-                                generate_tone_friend_online();
+                                tone = TONE_FRIEND_ONLINE;
                                 break;
                             }
                             case NOTIFY_TONE_FRIEND_OFFLINE: {
-                                generate_tone_friend_offline();
+                                tone = TONE_FRIEND_OFFLINE;
                                 break;
                             }
                             case NOTIFY_TONE_FRIEND_NEW_MSG: {
-                                generate_tone_friend_new_msg();
+                                tone = TONE_FRIEND_NEW_MSG;
                                 break;
                             }
                             case NOTIFY_TONE_FRIEND_REQUEST: {
-                                generate_tone_friend_request();
+                                tone = TONE_FRIEND_REQUEST;
                                 break;
                             }
+                            default: {
+                                tone = TONE_MAX;
+                                break;
+                            }
+                        }
+
+                        if (tone == TONE_MAX) {
+                            break;
                         }
 
+                        alSourceStop(notifytone);
                         alSourcei(notifytone, AL_LOOPING, AL_FALSE);
-                        alSourcei(notifytone, AL_BUFFER, ToneBuffer);
+                        alSourcei(notifytone, AL_BUFFER, tone_buffer(tone));
 
                         alSourcePlay(notifytone);
 
@@ -770,6 +1079,7 @@ void utox_audio_thread(void *args) {
 
                 case UTOXAUDIO_NEW_AV_INSTANCE: {
                     av = m->data;
+                    atomic_store(&send_av, av);
                     audio_in_init();
                     audio_out_init();
                 }
@@ -783,54 +1093,91 @@ void utox_audio_thread(void *args) {
             }
         }
 
-        settings.audiofilter_enabled = filter_audio_check();
+        const uint64_t now = get_time();
+        if (now - last_filter_check >= (uint64_t)1000 * 1000 * 1000) {
+            settings.audiofilter_enabled = filter_audio_check();
+            last_filter_check = now;
+        }
+
+        for (size_t i = 0; i < self.groups_list_size; ++i) {
+            GROUPCHAT *g = get_group(i);
+            if (g && g->active_call && g->audio_dest && g->mixer) {
+                group_audio_play(g, group_frame, perframe);
+            }
+        }
 
-        bool sleep = true;
+        /* With nothing to capture, only the group audio needs topping up. */
+        uint32_t sleep_ms = 50;
 
         if (microphone_on) {
             ALint samples;
-            bool frame = 0;
+            uint32_t captured_samples = 0;
+            uint64_t captured = now;
             /* If we have a device_in we're on linux so we can just call OpenAL, otherwise we're on something else so
              * we'll need to call audio_frame() to add to the buffer for us. */
             if (audio_in_handle == (void *)1) {
-                frame = audio_frame((void *)buf);
-                if (frame) {
-                    /* We have an audio frame to use, continue without sleeping. */
-                    sleep = false;
+                if (audio_frame(buf)) {
+                    captured_samples = perframe;
                 }
+                /* No way to know when the next frame is due, so check a few times per frame. */
+                sleep_ms = captured_samples ? 0 : UTOX_DEFAULT_FRAME_A / 4;
             } else {
+                const int period = (CAPTURE_PERIOD_MS * capture_rate) / 1000;
+
                 alcGetIntegerv(audio_in_handle, ALC_CAPTURE_SAMPLES, sizeof(samples), &samples);
-                if (samples >= perframe) {
-                    alcCaptureSamples(audio_in_handle, buf, perframe);
-                    frame = true;
-                    if (samples >= perframe * 2) {
-                        sleep = false;
-                    }
+                if (samples >= period) {
+                    alcCaptureSamples(audio_in_handle, buf, period);
+                    captured_samples = period;
+                    samples -= period;
+                    // The last sample we read was captured before everything still waiting in the device.
+                    captured -= (uint64_t)samples * 1000 * 1000 * 1000 / capture_rate;
+                }
+
+                /* Sleep until the device should have the next period ready. */
+                if (samples >= period) {
+                    sleep_ms = 0;
+                } else {
+                    sleep_ms = ((period - samples) * 1000 + capture_rate - 1) / capture_rate;
                 }
             }
 
-            #ifdef AUDIO_FILTERING
-            #ifdef ALC_LOOPBACK_CAPTURE_SAMPLES
-            if (f_a && settings.audiofilter_enabled) {
-                alcGetIntegerv(audio_out_device, ALC_LOOPBACK_CAPTURE_SAMPLES, sizeof(samples), &samples);
-                if (samples >= perframe) {
-                    int16_t buffer[perframe];
-                    alcCaptureSamplesLoopback(audio_out_handle, buffer, perframe);
-                    pass_audio_output(f_a, buffer, perframe);
-                    set_echo_delay_ms(f_a, UTOX_DEFAULT_FRAME_A);
-                    if (samples >= perframe * 2) {
-                        sleep = false;
-                    }
+            if (captured_samples) {
+                const uint32_t space = COUNTOF(capture_fifo) - capture_length;
+                if (capture_resampler) {
+                    capture_length += resampler_process(capture_resampler, buf, captured_samples,
+                                                        capture_fifo + capture_length, space);
+                } else {
+                    const uint32_t n = MIN(captured_samples, space);
+                    memcpy(capture_fifo + capture_length, buf, n * sizeof(int16_t));
+                    capture_length += n;
                 }
             }
-            #endif
-            #endif
 
-            if (frame) {
+            uint32_t offset = 0;
+            for (; capture_length - offset >= (uint32_t)chunk; offset += chunk) {
+                int16_t *pcm = capture_fifo + offset;
+
+                #ifdef AUDIO_FILTERING
+                #ifdef ALC_LOOPBACK_CAPTURE_SAMPLES
+                if (f_a && settings.audiofilter_enabled) {
+                    alcGetIntegerv(audio_out_device, ALC_LOOPBACK_CAPTURE_SAMPLES, sizeof(samples), &samples);
+                    if (samples >= chunk) {
+                        int16_t buffer[chunk];
+                        alcCaptureSamplesLoopback(audio_out_handle, buffer, chunk);
+                        pass_audio_output(f_a, buffer, chunk);
+                        set_echo_delay_ms(f_a, UTOX_DEFAULT_FRAME_A);
+                        if (samples >= chunk * 2) {
+                            sleep_ms = 0;
+                        }
+                    }
+                }
+                #endif
+                #endif
+
                 bool voice = true;
                 #ifdef AUDIO_FILTERING
                 if (f_a) {
-                    const int ret = filter_audio(f_a, (int16_t *)buf, perframe);
+                    const int ret = filter_audio(f_a, pcm, chunk);
 
                     if (ret == -1) {
                         LOG_TRACE("uTox Audio", "filter audio error" );
@@ -842,85 +1189,78 @@ void utox_audio_thread(void *args) {
                 }
                 #endif
 
+                /* Keep the VAD looking at everything so its idea of the background stays current. */
+                if (!vad_process(&vad, pcm, chunk) && settings.audio_vad_enabled) {
+                    voice = false;
+                }
+
                 /* If push to talk, we don't have to do anything */
                 if (!check_ptt_key()) {
                     voice = false; // PTT is up, send nothing.
                 }
 
                 if (preview_on) {
-                    if (preview_buffer_index + perframe > PREVIEW_BUFFER_SIZE) {
+                    if (preview_buffer_index + chunk > PREVIEW_BUFFER_SIZE) {
                         preview_buffer_index = 0;
                     }
-                    sourceplaybuffer(self.friend_list_size, preview_buffer + preview_buffer_index, perframe,
+                    sourceplaybuffer(self.friend_list_size, preview_buffer + preview_buffer_index, chunk,
                                      UTOX_DEFAULT_AUDIO_CHANNELS, UTOX_DEFAULT_SAMPLE_RATE_A);
                     if (voice) {
-                        memcpy(preview_buffer + preview_buffer_index, buf, perframe * sizeof(int16_t));
+                        memcpy(preview_buffer + preview_buffer_index, pcm, chunk * sizeof(int16_t));
                     } else {
-                        memset(preview_buffer + preview_buffer_index, 0, perframe * sizeof(int16_t));
+                        memset(preview_buffer + preview_buffer_index, 0, chunk * sizeof(int16_t));
                     }
-                    preview_buffer_index += perframe;
+                    preview_buffer_index += chunk;
                 }
 
-                if (voice) {
-                    size_t active_call_count = 0;
-                    for (size_t i = 0; i < self.friend_list_count; i++) {
-                        if (UTOX_SEND_AUDIO(i)) {
-                            active_call_count++;
-                            TOXAV_ERR_SEND_FRAME error = 0;
-                            // LOG_TRACE("uTox Audio", "Sending audio frame!" );
-                            FRIEND *f = get_friend(i);
-                            if (!f) {
-                                LOG_ERR("uToxAV", "Unable to get friend when sending audio frame %u", i);
-                                continue;
-                            }
-                            toxav_audio_send_frame(av, f->number, (const int16_t *)buf, perframe,
-                                                   UTOX_DEFAULT_AUDIO_CHANNELS, UTOX_DEFAULT_SAMPLE_RATE_A, &error);
-                            if (error) {
-                                LOG_TRACE("uTox Audio", "toxav_send_audio error friend == %lu, error ==  %i" , i, error);
-                            } else {
-                                // LOG_TRACE("uTox Audio", "Send a frame to friend %i" ,i);
-                                if (active_call_count >= UTOX_MAX_CALLS) {
-                                    LOG_TRACE("uTox Audio", "We're calling more peers than allowed by UTOX_MAX_CALLS, This is a bug" );
-                                    break;
-                                }
-                            }
-                        }
-                    }
-
-                    Tox *tox = toxav_get_tox(av);
-                    uint32_t num_chats = tox_conference_get_chatlist_size(tox);
-
-                    if (num_chats) {
-                        for (size_t i = 0 ; i < num_chats; ++i) {
-                            if (get_group(i) && get_group(i)->active_call) {
-                                LOG_TRACE("uTox Audio", "Sending audio in groupchat %u", i);
-                                toxav_group_send_audio(tox, i, (int16_t *)buf, perframe,
-                                                       UTOX_DEFAULT_AUDIO_CHANNELS, UTOX_DEFAULT_SAMPLE_RATE_A);
-                            }
-                        }
-                    }
+                /* Silent periods go through the ring too, so a frame that's only partly voice is still sent whole
+                 * and the send stage can count what it held back. */
+                AUDIO_RING_FRAME *slot = audio_ring_write_begin(&capture_ring);
+                if (slot) {
+                    memcpy(slot->samples, pcm, chunk * sizeof(int16_t));
+                    slot->frame_samples = chunk;
+                    slot->sample_rate   = UTOX_DEFAULT_SAMPLE_RATE_A;
+                    slot->channels      = UTOX_DEFAULT_AUDIO_CHANNELS;
+                    slot->captured      = captured;
+                    slot->voice         = voice;
+                    slot->noise_level   = vad_noise_level(&vad);
+                    audio_ring_write_end(&capture_ring);
                 }
             }
+
+            capture_length -= offset;
+            memmove(capture_fifo, capture_fifo + offset, capture_length * sizeof(int16_t));
+        } else {
+            capture_length = 0;
         }
 
-        if (sleep) {
-            yieldcpu(50);
+        if (sleep_ms) {
+            yieldcpu(sleep_ms);
         }
     }
 
+    atomic_store(&send_thread_run, false);
+    audio_ring_wake(&capture_ring);
+    while (atomic_load(&send_thread_running)) {
+        yieldcpu(1);
+    }
+    audio_ring_destroy(&capture_ring);
+
     utox_filter_audio_kill(f_a);
 
     // missing some cleanup ?
     alDeleteSources(1, &ringtone);
+    source_ring_free(preview);
     alDeleteSources(1, &preview);
-    alDeleteBuffers(1, &RingBuffer);
 
     while (audio_in_device_close()) { continue; }
     while (audio_out_device_close()) {continue; }
+    audio_in_set_rate(UTOX_DEFAULT_SAMPLE_RATE_A);
 
     audio_thread_msg       = 0;
     utox_audio_thread_init = false;
     free(preview_buffer);
+    tones_free();
     LOG_TRACE("uTox Audio", "Clean thread exit!");
 }
 
@@ -957,52 +1297,46 @@ void callback_av_group_audio(void *UNUSED(tox), uint32_t groupnumber, uint32_t p
         return;
     }
 
-    ALuint bufid;
-    ALint processed = 0, queued = 16;
-    alGetSourcei(g->source[peernumber], AL_BUFFERS_PROCESSED, &processed);
-    alGetSourcei(g->source[peernumber], AL_BUFFERS_QUEUED, &queued);
-    alSourcei(g->source[peernumber], AL_LOOPING, AL_FALSE);
-
-    if (processed) {
-        ALuint bufids[processed];
-        alSourceUnqueueBuffers(g->source[peernumber], processed, bufids);
-        alDeleteBuffers(processed - 1, bufids + 1);
-        bufid = bufids[0];
-    } else if(queued < 16) {
-        alGenBuffers(1, &bufid);
-    } else {
+    // Mixed and played by the audio thread, see group_audio_play().
+    if (!audio_mixer_push(g->mixer, peernumber, pcm, samples, channels, sample_rate)) {
         LOG_WARN("uTox Audio", "dropped audio frame %i %i" , groupnumber, peernumber);
-        return;
     }
+}
 
-    alBufferData(bufid, (channels == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16, pcm, samples * 2 * channels,
-                    sample_rate);
-    alSourceQueueBuffers(g->source[peernumber], 1, &bufid);
+void group_av_peer_add(GROUPCHAT *g, int peernumber) {
+    if (!g || peernumber < 0 || peernumber >= UTOX_MAX_GROUP_PEERS) {
+        LOG_ERR("uTox Audio", "Invalid groupchat or peer number");
+        return;
+    }
 
-    ALint state;
-    alGetSourcei(g->source[peernumber], AL_SOURCE_STATE, &state);
-    if (state != AL_PLAYING) {
-        alSourcePlay(g->source[peernumber]);
-        LOG_DEBUG("uTox Audio", "Starting source %i %i" , groupnumber, peernumber);
+    if (!g->mixer) {
+        const int perframe = (UTOX_DEFAULT_FRAME_A * UTOX_DEFAULT_SAMPLE_RATE_A) / 1000;
+        g->mixer = audio_mixer_create(UTOX_DEFAULT_SAMPLE_RATE_A, perframe, UTOX_MAX_GROUP_PEERS);
+        if (!g->mixer) {
+            LOG_ERR("uTox Audio", "Unable to create mixer for group %u", g->number);
+            return;
+        }
     }
+
+    LOG_INFO("uTox Audio", "Adding stream for peer %u in group %u", peernumber, g->number);
+    audio_mixer_reset_stream(g->mixer, peernumber);
 }
 
-void group_av_peer_add(GROUPCHAT *g, int peernumber) {
+void group_av_peer_remove(GROUPCHAT *g, int peernumber) {
     if (!g || peernumber < 0) {
         LOG_ERR("uTox Audio", "Invalid groupchat or peer number");
         return;
     }
 
-    LOG_INFO("uTox Audio", "Adding source for peer %u in group %u", peernumber, g->number);
-    alGenSources(1, &g->source[peernumber]);
+    LOG_INFO("uTox Audio", "Dropping stream for peer %u in group %u", peernumber, g->number);
+    audio_mixer_reset_stream(g->mixer, peernumber);
 }
 
-void group_av_peer_remove(GROUPCHAT *g, int peernumber) {
-    if (!g || peernumber < 0) {
+void group_av_peer_move(GROUPCHAT *g, int from, int to) {
+    if (!g || from < 0 || to < 0) {
         LOG_ERR("uTox Audio", "Invalid groupchat or peer number");
         return;
     }
 
-    LOG_INFO("uTox Audio", "Deleting source for peer %u in group %u", peernumber, g->number);
-    alDeleteSources(1, &g->source[peernumber]);
+    audio_mixer_move_stream(g->mixer, from, to);
 }
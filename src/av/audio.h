@@ -1,6 +1,8 @@
 #ifndef AUDIO_H
 #define AUDIO_H
 
+#include "audio_ring.h"
+
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -52,6 +54,11 @@ enum {
 #define UTOX_DEFAULT_SAMPLE_RATE_A 48000
 #define UTOX_DEFAULT_AUDIO_CHANNELS 1
 
+/* Frame durations (ms) and microphone sample rates (Hz) that can be picked in the settings, in dropdown order.
+ * Calls are always fed UTOX_DEFAULT_SAMPLE_RATE_A, other capture rates are resampled. */
+#define UTOX_AUDIO_FRAME_SIZES { 10, 20, 40, 60 }
+#define UTOX_AUDIO_CAPTURE_RATES { 48000, 44100, 32000, 16000 }
+
 /* Check self */
 #define UTOX_SENDING_AUDIO(f_number) (!!(get_friend(f_number)->call_state_self & TOXAV_FRIEND_CALL_STATE_SENDING_A))
 // UTOX_ACCEPTING_AUDIO is unused. Delete?
@@ -83,6 +90,27 @@ void utox_audio_in_ignore(void);
 
 void sourceplaybuffer(unsigned int i, const int16_t *data, int samples, uint8_t channels, unsigned int sample_rate);
 
+typedef struct audio_playback_stats {
+    uint32_t frames_queued;
+    uint32_t underruns; // Source ran out of frames and had to be restarted
+    uint32_t overruns;  // Every buffer was still queued when a new frame came in
+    uint32_t dropped;   // Frames that were never played, overruns included
+    uint32_t queued;    // Frames waiting to be played right now
+} AUDIO_PLAYBACK_STATS;
+
+/* Copies the playback counters for the source sourceplaybuffer(i, ...) plays on into stats.
+ * Returns false if that source hasn't played anything. */
+bool sourceplaybuffer_stats(unsigned int i, AUDIO_PLAYBACK_STATS *stats);
+
+typedef struct audio_capture_stats {
+    AUDIO_HISTOGRAM latency; // From the microphone to toxav
+    AUDIO_HISTOGRAM jitter;  // Change in latency between consecutive frames
+    uint32_t        overflows; // Frames dropped because the send stage fell behind
+} AUDIO_CAPTURE_STATS;
+
+/* Copies the capture to send latency and jitter seen since the audio thread started. */
+void utox_audio_capture_stats(AUDIO_CAPTURE_STATS *stats);
+
 /* send a message to the audio thread */
 void postmessage_audio(uint8_t msg, uint32_t param1, uint32_t param2, void *data);
 
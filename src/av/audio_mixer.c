@@ -0,0 +1,337 @@
+#include "audio_mixer.h"
+
+#include "../debug.h"
+#include "../macros.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+typedef struct {
+    int16_t *ring; // NULL until the stream's first packet
+    uint32_t read, count;
+
+    /* Trailing samples in the ring that are all silence. Once it covers everything buffered we can skip the stream. */
+    uint32_t silent_run;
+
+    int16_t gain;
+    bool    playing;
+} MIXER_STREAM;
+
+struct audio_mixer {
+    pthread_mutex_t lock;
+
+    uint32_t sample_rate;
+    uint32_t frame_samples;
+    uint32_t capacity;  // samples per ring
+    uint32_t prebuffer; // samples
+
+    uint16_t      max_streams;
+    MIXER_STREAM *streams;
+
+    int32_t *acc;
+
+    AUDIO_MIXER_STATS stats;
+};
+
+/* acc[i] += src[i] * gain (Q12) */
+static void mix_add(int32_t *acc, const int16_t *src, uint32_t n, int16_t gain) {
+    uint32_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i g = _mm_set1_epi16(gain);
+    for (; i + 8 <= n; i += 8) {
+        const __m128i s  = _mm_loadu_si128((const __m128i *)(src + i));
+        // SSE2 has no 16x16->32 multiply, so put the full products back together from their halves.
+        const __m128i lo = _mm_mullo_epi16(s, g);
+        const __m128i hi = _mm_mulhi_epi16(s, g);
+        const __m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 12);
+        const __m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 12);
+
+        __m128i *a = (__m128i *)(acc + i);
+        _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), p0));
+        _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), p1));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8 <= n; i += 8) {
+        const int16x8_t s  = vld1q_s16(src + i);
+        const int32x4_t p0 = vshrq_n_s32(vmull_n_s16(vget_low_s16(s), gain), 12);
+        const int32x4_t p1 = vshrq_n_s32(vmull_n_s16(vget_high_s16(s), gain), 12);
+
+        vst1q_s32(acc + i, vaddq_s32(vld1q_s32(acc + i), p0));
+        vst1q_s32(acc + i + 4, vaddq_s32(vld1q_s32(acc + i + 4), p1));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        acc[i] += ((int32_t)src[i] * gain) >> 12;
+    }
+}
+
+/* out[i] = saturate(acc[i]) */
+static void mix_pack(int16_t *out, const int32_t *acc, uint32_t n) {
+    uint32_t i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 8 <= n; i += 8) {
+        const __m128i a0 = _mm_loadu_si128((const __m128i *)(acc + i));
+        const __m128i a1 = _mm_loadu_si128((const __m128i *)(acc + i + 4));
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi32(a0, a1));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8 <= n; i += 8) {
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(vld1q_s32(acc + i)), vqmovn_s32(vld1q_s32(acc + i + 4))));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        out[i] = acc[i] > INT16_MAX ? INT16_MAX : acc[i] < INT16_MIN ? INT16_MIN : acc[i];
+    }
+}
+
+AUDIO_MIXER *audio_mixer_create(uint32_t sample_rate, uint32_t frame_samples, uint16_t max_streams) {
+    if (!sample_rate || !frame_samples || !max_streams) {
+        return NULL;
+    }
+
+    AUDIO_MIXER *mixer = calloc(1, sizeof(AUDIO_MIXER));
+    if (!mixer) {
+        LOG_ERR("Audio Mixer", "Unable to calloc for mixer.");
+        return NULL;
+    }
+
+    mixer->streams = calloc(max_streams, sizeof(MIXER_STREAM));
+    mixer->acc     = calloc(frame_samples, sizeof(int32_t));
+    if (!mixer->streams || !mixer->acc) {
+        LOG_ERR("Audio Mixer", "Unable to calloc for %u streams.", max_streams);
+        free(mixer->streams);
+        free(mixer->acc);
+        free(mixer);
+        return NULL;
+    }
+
+    pthread_mutex_init(&mixer->lock, NULL);
+    mixer->sample_rate   = sample_rate;
+    mixer->frame_samples = frame_samples;
+    mixer->capacity      = frame_samples * AUDIO_MIXER_JITTER_FRAMES;
+    mixer->prebuffer     = frame_samples * AUDIO_MIXER_PREBUFFER_FRAMES;
+    mixer->max_streams   = max_streams;
+
+    for (uint16_t i = 0; i < max_streams; ++i) {
+        mixer->streams[i].gain = AUDIO_MIXER_GAIN_UNITY;
+    }
+
+    return mixer;
+}
+
+void audio_mixer_free(AUDIO_MIXER *mixer) {
+    if (!mixer) {
+        return;
+    }
+
+    for (uint16_t i = 0; i < mixer->max_streams; ++i) {
+        free(mixer->streams[i].ring);
+    }
+
+    pthread_mutex_destroy(&mixer->lock);
+    free(mixer->streams);
+    free(mixer->acc);
+    free(mixer);
+}
+
+static void stream_write(AUDIO_MIXER *mixer, MIXER_STREAM *s, int16_t sample) {
+    s->ring[(s->read + s->count) % mixer->capacity] = sample;
+    s->count++;
+}
+
+bool audio_mixer_push(AUDIO_MIXER *mixer, uint16_t stream, const int16_t *pcm, uint32_t samples, uint8_t channels,
+                      uint32_t sample_rate) {
+    if (!mixer || stream >= mixer->max_streams || !samples) {
+        return false;
+    }
+
+    pthread_mutex_lock(&mixer->lock);
+
+    if (sample_rate != mixer->sample_rate || channels < 1 || channels > 2) {
+        LOG_TRACE("Audio Mixer", "Dropping packet for stream %u: %u Hz, %u channels", stream, sample_rate, channels);
+        mixer->stats.dropped++;
+        pthread_mutex_unlock(&mixer->lock);
+        return false;
+    }
+
+    MIXER_STREAM *s = &mixer->streams[stream];
+    if (!s->ring) {
+        s->ring = malloc(mixer->capacity * sizeof(int16_t));
+        if (!s->ring) {
+            LOG_ERR("Audio Mixer", "Unable to malloc jitter buffer for stream %u", stream);
+            pthread_mutex_unlock(&mixer->lock);
+            return false;
+        }
+    }
+
+    if (samples > mixer->capacity) {
+        pcm += (samples - mixer->capacity) * channels;
+        samples = mixer->capacity;
+    }
+
+    if (s->count + samples > mixer->capacity) {
+        // Drop the oldest samples, the peer is sending faster than we're playing.
+        const uint32_t excess = s->count + samples - mixer->capacity;
+        s->read   = (s->read + excess) % mixer->capacity;
+        s->count -= excess;
+        s->silent_run = MIN(s->silent_run, s->count);
+        mixer->stats.overruns++;
+    }
+
+    int16_t peak = 0;
+    for (uint32_t i = 0; i < samples; ++i) {
+        const int16_t sample = channels == 1 ? pcm[i] : (pcm[i * 2] + pcm[i * 2 + 1]) / 2;
+        const int16_t level  = sample < -INT16_MAX ? INT16_MAX : abs(sample);
+        peak = MAX(peak, level);
+        stream_write(mixer, s, sample);
+    }
+
+    if (peak < AUDIO_MIXER_SILENCE) {
+        s->silent_run += samples;
+    } else {
+        s->silent_run = 0;
+    }
+
+    pthread_mutex_unlock(&mixer->lock);
+    return true;
+}
+
+void audio_mixer_set_gain(AUDIO_MIXER *mixer, uint16_t stream, float gain) {
+    if (!mixer || stream >= mixer->max_streams) {
+        return;
+    }
+
+    if (gain < 0.0f) {
+        gain = 0.0f;
+    } else if (gain > (float)INT16_MAX / AUDIO_MIXER_GAIN_UNITY) {
+        gain = (float)INT16_MAX / AUDIO_MIXER_GAIN_UNITY;
+    }
+
+    pthread_mutex_lock(&mixer->lock);
+    mixer->streams[stream].gain = gain * AUDIO_MIXER_GAIN_UNITY;
+    pthread_mutex_unlock(&mixer->lock);
+}
+
+static void stream_reset(MIXER_STREAM *s) {
+    s->read       = 0;
+    s->count      = 0;
+    s->silent_run = 0;
+    s->gain       = AUDIO_MIXER_GAIN_UNITY;
+    s->playing    = false;
+}
+
+void audio_mixer_reset_stream(AUDIO_MIXER *mixer, uint16_t stream) {
+    if (!mixer || stream >= mixer->max_streams) {
+        return;
+    }
+
+    pthread_mutex_lock(&mixer->lock);
+    stream_reset(&mixer->streams[stream]);
+    pthread_mutex_unlock(&mixer->lock);
+}
+
+void audio_mixer_move_stream(AUDIO_MIXER *mixer, uint16_t from, uint16_t to) {
+    if (!mixer || from >= mixer->max_streams || to >= mixer->max_streams || from == to) {
+        return;
+    }
+
+    pthread_mutex_lock(&mixer->lock);
+    // Swap so both rings stay allocated and owned by exactly one stream.
+    MIXER_STREAM tmp       = mixer->streams[to];
+    mixer->streams[to]     = mixer->streams[from];
+    mixer->streams[from]   = tmp;
+    stream_reset(&mixer->streams[from]);
+    pthread_mutex_unlock(&mixer->lock);
+}
+
+void audio_mixer_clear(AUDIO_MIXER *mixer) {
+    if (!mixer) {
+        return;
+    }
+
+    pthread_mutex_lock(&mixer->lock);
+    for (uint16_t i = 0; i < mixer->max_streams; ++i) {
+        stream_reset(&mixer->streams[i]);
+    }
+    pthread_mutex_unlock(&mixer->lock);
+}
+
+uint32_t audio_mixer_mix(AUDIO_MIXER *mixer, int16_t *out) {
+    if (!mixer) {
+        return 0;
+    }
+
+    const uint32_t frame = mixer->frame_samples;
+    uint32_t mixed = 0;
+
+    pthread_mutex_lock(&mixer->lock);
+
+    memset(mixer->acc, 0, frame * sizeof(int32_t));
+
+    for (uint16_t i = 0; i < mixer->max_streams; ++i) {
+        MIXER_STREAM *s = &mixer->streams[i];
+        if (!s->count) {
+            if (s->playing) {
+                mixer->stats.underruns++;
+                s->playing = false;
+            }
+            continue;
+        }
+
+        if (!s->playing) {
+            if (s->count < mixer->prebuffer) {
+                continue;
+            }
+            s->playing = true;
+        }
+
+        const uint32_t n = MIN(s->count, frame);
+        if (n < frame) {
+            // Play out what's left and wait for the buffer to fill up again.
+            mixer->stats.underruns++;
+            s->playing = false;
+        }
+
+        if (s->silent_run >= s->count || !s->gain) {
+            mixer->stats.streams_silent++;
+        } else {
+            const uint32_t first = MIN(n, mixer->capacity - s->read);
+            mix_add(mixer->acc, s->ring + s->read, first, s->gain);
+            mix_add(mixer->acc + first, s->ring, n - first, s->gain);
+            mixed++;
+        }
+
+        s->read       = (s->read + n) % mixer->capacity;
+        s->count     -= n;
+        s->silent_run = MIN(s->silent_run, s->count);
+    }
+
+    mixer->stats.frames_mixed++;
+    mixer->stats.streams_mixed += mixed;
+
+    mix_pack(out, mixer->acc, frame);
+
+    pthread_mutex_unlock(&mixer->lock);
+    return mixed;
+}
+
+void audio_mixer_get_stats(AUDIO_MIXER *mixer, AUDIO_MIXER_STATS *stats) {
+    if (!mixer || !stats) {
+        return;
+    }
+
+    pthread_mutex_lock(&mixer->lock);
+    *stats = mixer->stats;
+    pthread_mutex_unlock(&mixer->lock);
+}
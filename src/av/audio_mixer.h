@@ -0,0 +1,68 @@
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Software mixer for groupchat audio.
+ *
+ * Every peer gets a stream with a small jitter buffer. Packets are pushed from the tox thread as they arrive and the
+ * audio thread pulls one mixed frame at a time to queue on a single OpenAL source, so a call costs one source no
+ * matter how many peers are in it.
+ *
+ * Streams are summed into 32 bit accumulators (SSE2/NEON where available) and saturated to int16 once at the end, so
+ * loud peers clip the same way regardless of the order they're mixed in. */
+
+typedef struct audio_mixer AUDIO_MIXER;
+
+/* Frames a stream can hold before the oldest samples are dropped. */
+#define AUDIO_MIXER_JITTER_FRAMES 10
+
+/* Frames a stream needs before it starts playing (or restarts after running dry). */
+#define AUDIO_MIXER_PREBUFFER_FRAMES 2
+
+/* Peak sample value below which a packet counts as silence. About -54 dBFS. */
+#define AUDIO_MIXER_SILENCE 64
+
+/* Gain is stored as Q12 fixed point. */
+#define AUDIO_MIXER_GAIN_UNITY (1 << 12)
+
+typedef struct audio_mixer_stats {
+    uint32_t frames_mixed;
+    uint32_t streams_mixed;  // Summed over every frame
+    uint32_t streams_silent; // Streams that had audio but were skipped as silent
+    uint32_t underruns;      // A playing stream ran out of samples mid frame
+    uint32_t overruns;       // Samples were dropped because a stream's buffer was full
+    uint32_t dropped;        // Packets we couldn't use (wrong sample rate or channel count)
+} AUDIO_MIXER_STATS;
+
+/* Creates a mixer for up to max_streams mono streams, mixing frame_samples samples at a time.
+ * Returns NULL on failure. */
+AUDIO_MIXER *audio_mixer_create(uint32_t sample_rate, uint32_t frame_samples, uint16_t max_streams);
+
+void audio_mixer_free(AUDIO_MIXER *mixer);
+
+/* Adds a packet to the end of stream's jitter buffer. Stereo is mixed down to mono.
+ * Returns false if the packet was dropped. */
+bool audio_mixer_push(AUDIO_MIXER *mixer, uint16_t stream, const int16_t *pcm, uint32_t samples, uint8_t channels,
+                      uint32_t sample_rate);
+
+/* Sets a stream's gain, 1.0 leaves it as is. Clamped to [0, 7.99]. */
+void audio_mixer_set_gain(AUDIO_MIXER *mixer, uint16_t stream, float gain);
+
+/* Drops everything buffered for stream and resets its gain. */
+void audio_mixer_reset_stream(AUDIO_MIXER *mixer, uint16_t stream);
+
+/* Moves stream from to stream to, resetting from. For when peers are renumbered. */
+void audio_mixer_move_stream(AUDIO_MIXER *mixer, uint16_t from, uint16_t to);
+
+/* Resets every stream. */
+void audio_mixer_clear(AUDIO_MIXER *mixer);
+
+/* Mixes the next frame of every playing stream into out (frame_samples mono samples).
+ * Returns the number of streams mixed in; if that's 0 out is silence and there's no need to play it. */
+uint32_t audio_mixer_mix(AUDIO_MIXER *mixer, int16_t *out);
+
+void audio_mixer_get_stats(AUDIO_MIXER *mixer, AUDIO_MIXER_STATS *stats);
+
+#endif
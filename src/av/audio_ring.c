@@ -0,0 +1,106 @@
+#include "audio_ring.h"
+
+#include <string.h>
+#include <sys/time.h>
+
+void audio_ring_init(AUDIO_RING *ring) {
+    memset(ring, 0, sizeof(AUDIO_RING));
+
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->waiting, false);
+    atomic_init(&ring->overflows, 0);
+
+    pthread_mutex_init(&ring->lock, NULL);
+    pthread_cond_init(&ring->cond, NULL);
+}
+
+void audio_ring_destroy(AUDIO_RING *ring) {
+    pthread_cond_destroy(&ring->cond);
+    pthread_mutex_destroy(&ring->lock);
+}
+
+AUDIO_RING_FRAME *audio_ring_write_begin(AUDIO_RING *ring) {
+    const uint_fast32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    const uint_fast32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail >= AUDIO_RING_FRAMES) {
+        atomic_fetch_add_explicit(&ring->overflows, 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    return &ring->frames[head % AUDIO_RING_FRAMES];
+}
+
+void audio_ring_write_end(AUDIO_RING *ring) {
+    atomic_fetch_add_explicit(&ring->head, 1, memory_order_seq_cst);
+
+    // Pairs with the consumer setting waiting and then checking head again, one of the two always sees the other.
+    if (atomic_load_explicit(&ring->waiting, memory_order_seq_cst)) {
+        audio_ring_wake(ring);
+    }
+}
+
+void audio_ring_wake(AUDIO_RING *ring) {
+    pthread_mutex_lock(&ring->lock);
+    pthread_cond_signal(&ring->cond);
+    pthread_mutex_unlock(&ring->lock);
+}
+
+static bool ring_empty(AUDIO_RING *ring) {
+    return atomic_load_explicit(&ring->head, memory_order_acquire)
+           == atomic_load_explicit(&ring->tail, memory_order_relaxed);
+}
+
+AUDIO_RING_FRAME *audio_ring_read_begin(AUDIO_RING *ring, uint32_t timeout_ms) {
+    if (ring_empty(ring) && timeout_ms) {
+        struct timeval now;
+        gettimeofday(&now, NULL);
+
+        const uint64_t deadline_us = (uint64_t)now.tv_sec * 1000000 + now.tv_usec + (uint64_t)timeout_ms * 1000;
+        const struct timespec deadline = {
+            .tv_sec  = deadline_us / 1000000,
+            .tv_nsec = (deadline_us % 1000000) * 1000,
+        };
+
+        pthread_mutex_lock(&ring->lock);
+        atomic_store_explicit(&ring->waiting, true, memory_order_seq_cst);
+        if (ring_empty(ring)) {
+            pthread_cond_timedwait(&ring->cond, &ring->lock, &deadline);
+        }
+        atomic_store_explicit(&ring->waiting, false, memory_order_relaxed);
+        pthread_mutex_unlock(&ring->lock);
+    }
+
+    if (ring_empty(ring)) {
+        return NULL;
+    }
+
+    return &ring->frames[atomic_load_explicit(&ring->tail, memory_order_relaxed) % AUDIO_RING_FRAMES];
+}
+
+void audio_ring_read_end(AUDIO_RING *ring) {
+    atomic_fetch_add_explicit(&ring->tail, 1, memory_order_release);
+}
+
+void audio_histogram_add(AUDIO_HISTOGRAM *h, uint64_t ns) {
+    uint8_t bucket = 0;
+    while (bucket < AUDIO_HISTOGRAM_BUCKETS - 1 && ns >= audio_histogram_bucket_limit(bucket)) {
+        ++bucket;
+    }
+
+    h->buckets[bucket]++;
+    h->count++;
+    h->total_ns += ns;
+    if (ns > h->max_ns) {
+        h->max_ns = ns;
+    }
+}
+
+uint64_t audio_histogram_bucket_limit(uint8_t bucket) {
+    if (bucket >= AUDIO_HISTOGRAM_BUCKETS - 1) {
+        return UINT64_MAX;
+    }
+
+    return (uint64_t)AUDIO_HISTOGRAM_FIRST_NS << bucket;
+}
@@ -0,0 +1,81 @@
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Single producer, single consumer ring of captured audio frames.
+ *
+ * The audio thread captures straight into the next free slot and publishes it, the send thread reads it back out and
+ * hands it to toxav. Neither side takes a lock to move frames, the mutex and condition are only there so the send
+ * thread can sleep while the ring is empty. */
+
+/* Slots in the ring. At 20ms frames that's 160ms of audio before capture has to start dropping frames. */
+#define AUDIO_RING_FRAMES 8
+
+/* Largest frame a slot can hold: 60ms of 48kHz stereo. */
+#define AUDIO_RING_MAX_SAMPLES (48000 * 60 / 1000 * 2)
+
+typedef struct {
+    int16_t  samples[AUDIO_RING_MAX_SAMPLES];
+    uint32_t frame_samples; // Per channel
+    uint32_t sample_rate;
+    uint8_t  channels;
+
+    uint64_t captured; // get_time() of the frame's last sample leaving the device
+
+    bool     voice;       // False if the frame was gated as silence and should only be counted, not sent
+    uint16_t noise_level; // RMS of the background noise, for comfort noise
+} AUDIO_RING_FRAME;
+
+typedef struct {
+    AUDIO_RING_FRAME frames[AUDIO_RING_FRAMES];
+
+    atomic_uint_fast32_t head; // Next slot the producer writes
+    atomic_uint_fast32_t tail; // Next slot the consumer reads
+
+    atomic_bool     waiting; // The consumer is asleep, or about to be
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+
+    atomic_uint_fast32_t overflows; // Frames the producer dropped because the ring was full
+} AUDIO_RING;
+
+void audio_ring_init(AUDIO_RING *ring);
+void audio_ring_destroy(AUDIO_RING *ring);
+
+/* Returns the slot to capture into, or NULL if the ring is full. Producer only. */
+AUDIO_RING_FRAME *audio_ring_write_begin(AUDIO_RING *ring);
+
+/* Publishes the slot from audio_ring_write_begin() and wakes the consumer. Producer only. */
+void audio_ring_write_end(AUDIO_RING *ring);
+
+/* Returns the oldest frame, waiting up to timeout_ms for one. NULL if there's still nothing. Consumer only. */
+AUDIO_RING_FRAME *audio_ring_read_begin(AUDIO_RING *ring, uint32_t timeout_ms);
+
+/* Hands the slot from audio_ring_read_begin() back to the producer. Consumer only. */
+void audio_ring_read_end(AUDIO_RING *ring);
+
+/* Wakes the consumer without publishing anything, for shutting it down. */
+void audio_ring_wake(AUDIO_RING *ring);
+
+/* Power of two histogram of durations. Bucket 0 holds everything under AUDIO_HISTOGRAM_FIRST_NS, every bucket after
+ * that is twice as wide as the last, and the final bucket holds everything that didn't fit. */
+#define AUDIO_HISTOGRAM_BUCKETS 12
+#define AUDIO_HISTOGRAM_FIRST_NS (250 * 1000)
+
+typedef struct {
+    uint32_t buckets[AUDIO_HISTOGRAM_BUCKETS];
+    uint32_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} AUDIO_HISTOGRAM;
+
+void audio_histogram_add(AUDIO_HISTOGRAM *h, uint64_t ns);
+
+/* Upper bound of bucket in ns, UINT64_MAX for the last one. */
+uint64_t audio_histogram_bucket_limit(uint8_t bucket);
+
+#endif
@@ -0,0 +1,255 @@
+#include "call_stats.h"
+
+#include "../macros.h"
+
+#include <pthread.h>
+#include <string.h>
+
+typedef struct {
+    bool     used, active;
+    uint32_t friend_number;
+    uint64_t started, last_sample;
+
+    /* Counted since the last sample. */
+    uint32_t sent, send_errors, received, displayed;
+    uint64_t encode_ns, latency_ns;
+
+    /* The running totals as of the last sample. */
+    uint32_t captured_mark;
+    uint64_t convert_mark;
+    uint32_t underruns_mark, dropped_mark;
+
+    uint32_t audio_bitrate, video_bitrate;
+
+    CALL_STATS_SAMPLE history[CALL_STATS_HISTORY];
+    uint32_t          samples; // Taken since the call started, the newest is history[(samples - 1) % HISTORY]
+} CALL_STATS;
+
+static CALL_STATS calls[CALL_STATS_MAX_CALLS];
+
+/* Capturing is shared by every call. */
+static uint32_t captured_total;
+static uint64_t convert_total;
+
+static pthread_mutex_t call_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static CALL_STATS *call_find(uint32_t friend_number) {
+    for (size_t i = 0; i < COUNTOF(calls); ++i) {
+        if (calls[i].used && calls[i].friend_number == friend_number) {
+            return &calls[i];
+        }
+    }
+
+    return NULL;
+}
+
+static CALL_STATS *call_find_active(uint32_t friend_number) {
+    CALL_STATS *c = call_find(friend_number);
+    return c && c->active ? c : NULL;
+}
+
+void call_stats_start(uint32_t friend_number, uint64_t now) {
+    pthread_mutex_lock(&call_stats_lock);
+
+    // The friend's last call, a free slot, or the call that ended the longest time ago.
+    CALL_STATS *c = call_find(friend_number);
+    for (size_t i = 0; !c && i < COUNTOF(calls); ++i) {
+        if (!calls[i].used) {
+            c = &calls[i];
+        }
+    }
+    if (!c) {
+        for (size_t i = 0; i < COUNTOF(calls); ++i) {
+            if (!calls[i].active && (!c || calls[i].last_sample < c->last_sample)) {
+                c = &calls[i];
+            }
+        }
+    }
+
+    if (c) {
+        memset(c, 0, sizeof(*c));
+        c->used          = true;
+        c->active        = true;
+        c->friend_number = friend_number;
+        c->started       = now;
+        c->last_sample   = now;
+        c->captured_mark = captured_total;
+        c->convert_mark  = convert_total;
+    }
+
+    pthread_mutex_unlock(&call_stats_lock);
+}
+
+void call_stats_stop(uint32_t friend_number) {
+    pthread_mutex_lock(&call_stats_lock);
+
+    CALL_STATS *c = call_find(friend_number);
+    if (c) {
+        c->active = false;
+    }
+
+    pthread_mutex_unlock(&call_stats_lock);
+}
+
+uint32_t call_stats_due(uint64_t now, uint32_t *friends, uint32_t max) {
+    uint32_t count = 0;
+
+    pthread_mutex_lock(&call_stats_lock);
+    for (size_t i = 0; i < COUNTOF(calls) && count < max; ++i) {
+        const CALL_STATS *c = &calls[i];
+        if (c->active && now - c->last_sample >= (uint64_t)CALL_STATS_INTERVAL_MS * 1000 * 1000) {
+            friends[count++] = c->friend_number;
+        }
+    }
+    pthread_mutex_unlock(&call_stats_lock);
+
+    return count;
+}
+
+static float per_second(uint64_t count, uint64_t ns) {
+    return ns ? count * 1e9f / ns : 0.0f;
+}
+
+static float average_ms(uint64_t total_ns, uint64_t count) {
+    return count ? total_ns / 1e6f / count : 0.0f;
+}
+
+void call_stats_sample(uint32_t friend_number, uint64_t now, const CALL_STATS_AUDIO *audio) {
+    pthread_mutex_lock(&call_stats_lock);
+
+    CALL_STATS *c = call_find_active(friend_number);
+    if (!c || now <= c->last_sample) {
+        pthread_mutex_unlock(&call_stats_lock);
+        return;
+    }
+
+    const uint64_t elapsed  = now - c->last_sample;
+    const uint32_t captured = captured_total - c->captured_mark;
+
+    CALL_STATS_SAMPLE *s = &c->history[c->samples++ % CALL_STATS_HISTORY];
+    *s = (CALL_STATS_SAMPLE){
+        .time_ms           = (now - c->started) / (1000 * 1000),
+        .capture_fps       = per_second(captured, elapsed),
+        .send_fps          = per_second(c->sent, elapsed),
+        .recv_fps          = per_second(c->received, elapsed),
+        .convert_ms        = average_ms(convert_total - c->convert_mark, captured),
+        .encode_ms         = average_ms(c->encode_ns, c->sent),
+        .latency_ms        = average_ms(c->latency_ns, c->displayed),
+        .video_send_errors = c->send_errors,
+        .audio_bitrate     = c->audio_bitrate,
+        .video_bitrate     = c->video_bitrate,
+    };
+
+    if (audio) {
+        s->audio_queued    = audio->queued;
+        s->audio_underruns = audio->underruns - c->underruns_mark;
+        s->audio_dropped   = audio->dropped - c->dropped_mark;
+        c->underruns_mark  = audio->underruns;
+        c->dropped_mark    = audio->dropped;
+    }
+
+    c->last_sample   = now;
+    c->captured_mark = captured_total;
+    c->convert_mark  = convert_total;
+    c->sent          = 0;
+    c->send_errors   = 0;
+    c->received      = 0;
+    c->displayed     = 0;
+    c->encode_ns     = 0;
+    c->latency_ns    = 0;
+
+    pthread_mutex_unlock(&call_stats_lock);
+}
+
+void call_stats_video_captured(uint64_t convert_ns) {
+    pthread_mutex_lock(&call_stats_lock);
+    captured_total++;
+    convert_total += convert_ns;
+    pthread_mutex_unlock(&call_stats_lock);
+}
+
+void call_stats_video_sent(uint32_t friend_number, uint64_t encode_ns, bool error) {
+    pthread_mutex_lock(&call_stats_lock);
+    CALL_STATS *c = call_find_active(friend_number);
+    if (c && error) {
+        c->send_errors++;
+    } else if (c) {
+        c->sent++;
+        c->encode_ns += encode_ns;
+    }
+    pthread_mutex_unlock(&call_stats_lock);
+}
+
+void call_stats_video_received(uint32_t friend_number) {
+    pthread_mutex_lock(&call_stats_lock);
+    CALL_STATS *c = call_find_active(friend_number);
+    if (c) {
+        c->received++;
+    }
+    pthread_mutex_unlock(&call_stats_lock);
+}
+
+void call_stats_video_displayed(uint32_t friend_number, uint64_t latency_ns) {
+    pthread_mutex_lock(&call_stats_lock);
+    CALL_STATS *c = call_find_active(friend_number);
+    if (c) {
+        c->displayed++;
+        c->latency_ns += latency_ns;
+    }
+    pthread_mutex_unlock(&call_stats_lock);
+}
+
+void call_stats_audio_bitrate(uint32_t friend_number, uint32_t bitrate) {
+    pthread_mutex_lock(&call_stats_lock);
+    CALL_STATS *c = call_find_active(friend_number);
+    if (c) {
+        c->audio_bitrate = bitrate;
+    }
+    pthread_mutex_unlock(&call_stats_lock);
+}
+
+void call_stats_video_bitrate(uint32_t friend_number, uint32_t bitrate) {
+    pthread_mutex_lock(&call_stats_lock);
+    CALL_STATS *c = call_find_active(friend_number);
+    if (c) {
+        c->video_bitrate = bitrate;
+    }
+    pthread_mutex_unlock(&call_stats_lock);
+}
+
+bool call_stats_latest(uint32_t friend_number, CALL_STATS_SAMPLE *sample) {
+    pthread_mutex_lock(&call_stats_lock);
+
+    const CALL_STATS *c = call_find(friend_number);
+    const bool found = c && c->samples;
+    if (found) {
+        *sample = c->history[(c->samples - 1) % CALL_STATS_HISTORY];
+    }
+
+    pthread_mutex_unlock(&call_stats_lock);
+    return found;
+}
+
+bool call_stats_write_csv(uint32_t friend_number, FILE *fp) {
+    pthread_mutex_lock(&call_stats_lock);
+
+    const CALL_STATS *c = call_find(friend_number);
+    if (!c || !c->samples) {
+        pthread_mutex_unlock(&call_stats_lock);
+        return false;
+    }
+
+    fprintf(fp, "time_ms,capture_fps,send_fps,recv_fps,convert_ms,encode_ms,latency_ms,audio_queued,"
+                "audio_underruns,audio_dropped,video_send_errors,audio_bitrate,video_bitrate\n");
+
+    const uint32_t count = MIN(c->samples, CALL_STATS_HISTORY);
+    for (uint32_t i = c->samples - count; i < c->samples; ++i) {
+        const CALL_STATS_SAMPLE *s = &c->history[i % CALL_STATS_HISTORY];
+        fprintf(fp, "%u,%.1f,%.1f,%.1f,%.2f,%.2f,%.2f,%u,%u,%u,%u,%u,%u\n", s->time_ms, s->capture_fps, s->send_fps,
+                s->recv_fps, s->convert_ms, s->encode_ms, s->latency_ms, s->audio_queued, s->audio_underruns,
+                s->audio_dropped, s->video_send_errors, s->audio_bitrate, s->video_bitrate);
+    }
+
+    pthread_mutex_unlock(&call_stats_lock);
+    return true;
+}
@@ -0,0 +1,64 @@
+#ifndef CALL_STATS_H
+#define CALL_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* How a call with a friend is doing, sampled every CALL_STATS_INTERVAL_MS into a ring of the last CALL_STATS_HISTORY
+ * samples. The A/V threads count what happens through the call_stats_video_* and bitrate functions, the toxav thread
+ * turns the counts into a sample when one is due. The history of a call is kept after it ends, until the slot is
+ * needed for another one, so it can still be written out. */
+
+#define CALL_STATS_INTERVAL_MS 1000
+#define CALL_STATS_HISTORY 300 // Five minutes
+#define CALL_STATS_MAX_CALLS 16
+
+typedef struct call_stats_sample {
+    uint32_t time_ms; // Since the call started
+
+    float capture_fps, send_fps, recv_fps;
+    float convert_ms, encode_ms; // Average per frame
+    float latency_ms;            // From decoding a frame to drawing it, average
+
+    uint32_t audio_queued; // Frames waiting to be played when the sample was taken
+    uint32_t audio_underruns, audio_dropped;
+    uint32_t video_send_errors;
+
+    uint32_t audio_bitrate, video_bitrate; // kbit/s, as last suggested by toxav
+} CALL_STATS_SAMPLE;
+
+/* The friend's playback counters, as kept by the audio thread. */
+typedef struct {
+    uint32_t queued;
+    uint32_t underruns, dropped; // Since the call started
+} CALL_STATS_AUDIO;
+
+void call_stats_start(uint32_t friend_number, uint64_t now);
+void call_stats_stop(uint32_t friend_number);
+
+/* Fills friends with up to max calls that are due for a sample at now and returns how many there are. */
+uint32_t call_stats_due(uint64_t now, uint32_t *friends, uint32_t max);
+
+/* Takes a sample for friend_number. */
+void call_stats_sample(uint32_t friend_number, uint64_t now, const CALL_STATS_AUDIO *audio);
+
+/* A frame came from the camera, converting it took convert_ns. It counts for every call. */
+void call_stats_video_captured(uint64_t convert_ns);
+
+/* A frame was encoded and sent to friend_number, or failed to. */
+void call_stats_video_sent(uint32_t friend_number, uint64_t encode_ns, bool error);
+
+void call_stats_video_received(uint32_t friend_number);
+void call_stats_video_displayed(uint32_t friend_number, uint64_t latency_ns);
+
+void call_stats_audio_bitrate(uint32_t friend_number, uint32_t bitrate);
+void call_stats_video_bitrate(uint32_t friend_number, uint32_t bitrate);
+
+/* Copies the newest sample for friend_number. Returns false if there's none. */
+bool call_stats_latest(uint32_t friend_number, CALL_STATS_SAMPLE *sample);
+
+/* Writes the history for friend_number, oldest first, as CSV with a header line. Returns false if there's none. */
+bool call_stats_write_csv(uint32_t friend_number, FILE *fp);
+
+#endif
@@ -0,0 +1,185 @@
+#include "resampler.h"
+
+#include "../debug.h"
+#include "../macros.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/* Past this many filter phases the rates are too awkward a ratio to be worth a table. */
+#define RESAMPLER_MAX_PHASES 1024
+
+struct resampler {
+    uint32_t up, down;
+
+    float *filters; // up phases of RESAMPLER_TAPS taps each
+
+    /* Input that hasn't been fully consumed yet, as floats. */
+    float   *history;
+    uint32_t history_length, history_capacity;
+
+    uint32_t phase; // Position of the next output sample between two input samples, in 1/up steps
+};
+
+static uint32_t gcd(uint32_t a, uint32_t b) {
+    while (b) {
+        const uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static void make_filters(RESAMPLER *r) {
+    const double pi     = 3.14159265358979323846;
+    const double half   = RESAMPLER_TAPS / 2;
+    // Cut off a little under the lower of the two Nyquist frequencies.
+    const double cutoff = (r->up < r->down ? (double)r->up / r->down : 1.0) * 0.97;
+
+    for (uint32_t p = 0; p < r->up; ++p) {
+        float *taps = r->filters + p * RESAMPLER_TAPS;
+        double sum  = 0;
+
+        for (uint32_t j = 0; j < RESAMPLER_TAPS; ++j) {
+            const double d = j - (half - 1) - (double)p / r->up;
+            const double x = pi * cutoff * d;
+            const double sinc   = d == 0 ? 1.0 : sin(x) / x;
+            const double window = 0.42 + 0.5 * cos(pi * d / half) + 0.08 * cos(2 * pi * d / half);
+
+            taps[j] = sinc * window;
+            sum += taps[j];
+        }
+
+        // Unity gain at DC for every phase, otherwise the phases beat against each other.
+        for (uint32_t j = 0; j < RESAMPLER_TAPS; ++j) {
+            taps[j] /= sum;
+        }
+    }
+}
+
+RESAMPLER *resampler_create(uint32_t in_rate, uint32_t out_rate) {
+    if (!in_rate || !out_rate) {
+        return NULL;
+    }
+
+    const uint32_t g  = gcd(in_rate, out_rate);
+    const uint32_t up = out_rate / g;
+    if (up > RESAMPLER_MAX_PHASES) {
+        LOG_ERR("Resampler", "Can't convert from %u Hz to %u Hz.", in_rate, out_rate);
+        return NULL;
+    }
+
+    RESAMPLER *r = calloc(1, sizeof(RESAMPLER));
+    if (!r) {
+        LOG_ERR("Resampler", "Unable to calloc for resampler.");
+        return NULL;
+    }
+
+    r->up   = up;
+    r->down = in_rate / g;
+
+    r->filters = malloc(up * RESAMPLER_TAPS * sizeof(float));
+    if (!r->filters) {
+        LOG_ERR("Resampler", "Unable to malloc for %u filter phases.", up);
+        free(r);
+        return NULL;
+    }
+    make_filters(r);
+
+    // Start half a filter into silence so the first output sample lines up with the first input sample.
+    r->history_capacity = RESAMPLER_TAPS;
+    r->history_length   = RESAMPLER_TAPS / 2 - 1;
+    r->history          = calloc(r->history_capacity, sizeof(float));
+    if (!r->history) {
+        LOG_ERR("Resampler", "Unable to calloc for resampler history.");
+        free(r->filters);
+        free(r);
+        return NULL;
+    }
+
+    return r;
+}
+
+void resampler_free(RESAMPLER *r) {
+    if (!r) {
+        return;
+    }
+
+    free(r->filters);
+    free(r->history);
+    free(r);
+}
+
+uint32_t resampler_max_output(const RESAMPLER *r, uint32_t in_samples) {
+    return ((uint64_t)r->history_length + in_samples) * r->up / r->down + 1;
+}
+
+static float dot(const float *a, const float *b) {
+    uint32_t i = 0;
+    float sum  = 0;
+
+#if defined(__SSE2__)
+    __m128 acc = _mm_setzero_ps();
+    for (; i < RESAMPLER_TAPS; i += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    sum = _mm_cvtss_f32(acc);
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    float32x4_t acc = vdupq_n_f32(0);
+    for (; i < RESAMPLER_TAPS; i += 4) {
+        acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    const float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+#endif
+
+    for (; i < RESAMPLER_TAPS; ++i) {
+        sum += a[i] * b[i];
+    }
+
+    return sum;
+}
+
+uint32_t resampler_process(RESAMPLER *r, const int16_t *in, uint32_t in_samples, int16_t *out, uint32_t out_max) {
+    if (r->history_length + in_samples > r->history_capacity) {
+        const uint32_t capacity = r->history_length + in_samples;
+        float *history = realloc(r->history, capacity * sizeof(float));
+        if (!history) {
+            LOG_ERR("Resampler", "Unable to realloc for %u samples.", capacity);
+            return 0;
+        }
+        r->history          = history;
+        r->history_capacity = capacity;
+    }
+
+    for (uint32_t i = 0; i < in_samples; ++i) {
+        r->history[r->history_length + i] = in[i];
+    }
+
+    const uint32_t available = r->history_length + in_samples;
+    uint32_t pos = 0, written = 0;
+
+    while (pos + RESAMPLER_TAPS <= available && written < out_max) {
+        const float v = dot(r->history + pos, r->filters + r->phase * RESAMPLER_TAPS);
+        out[written++] = v >= INT16_MAX ? INT16_MAX : v <= INT16_MIN ? INT16_MIN : (int16_t)(v + (v >= 0 ? 0.5f : -0.5f));
+
+        r->phase += r->down;
+        pos      += r->phase / r->up;
+        r->phase %= r->up;
+    }
+
+    pos = MIN(pos, available);
+    memmove(r->history, r->history + pos, (available - pos) * sizeof(float));
+    r->history_length = available - pos;
+
+    return written;
+}
@@ -0,0 +1,30 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <stdint.h>
+
+/* Mono sample rate converter.
+ *
+ * A polyphase windowed sinc filter: the ratio between the two rates is reduced to up/down factors and one filter
+ * phase is precomputed for every fractional position an output sample can land on, so converting is a single dot
+ * product per output sample (SSE2/NEON where available). Used to bring microphones that can't capture at 48kHz up to
+ * the rate ToxAV is fed at. */
+
+typedef struct resampler RESAMPLER;
+
+/* Taps per filter phase. Has to be a multiple of 4 for the SIMD dot product. */
+#define RESAMPLER_TAPS 32
+
+/* Creates a converter from in_rate to out_rate. Returns NULL on failure. */
+RESAMPLER *resampler_create(uint32_t in_rate, uint32_t out_rate);
+
+void resampler_free(RESAMPLER *r);
+
+/* Most samples resampler_process() can write for in_samples of input. */
+uint32_t resampler_max_output(const RESAMPLER *r, uint32_t in_samples);
+
+/* Converts in_samples samples from in, writing at most out_max samples to out.
+ * Output lags the input by RESAMPLER_TAPS / 2 input samples. Returns the number of samples written. */
+uint32_t resampler_process(RESAMPLER *r, const int16_t *in, uint32_t in_samples, int16_t *out, uint32_t out_max);
+
+#endif
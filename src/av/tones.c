@@ -0,0 +1,477 @@
+#include "tones.h"
+
+#include "../debug.h"
+#include "../filesys.h"
+#include "../macros.h"
+
+#include <math.h>
+#include <opus/opus.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static TONE_PCM tones[TONE_MAX];
+
+// clang-format off
+enum {
+    NOTE_none,
+    NOTE_c3_sharp,
+    NOTE_g3,
+    NOTE_b3,
+    NOTE_c4,
+    NOTE_a4,
+    NOTE_b4,
+    NOTE_e4,
+    NOTE_f4,
+    NOTE_c5,
+    NOTE_d5,
+    NOTE_e5,
+    NOTE_f5,
+    NOTE_g5,
+    NOTE_a5,
+    NOTE_c6_sharp,
+    NOTE_e6,
+};
+
+static const struct {
+    uint8_t note;
+    double  freq;
+} notes[] = {
+    {NOTE_none,         1           }, /* Can't be 0 or openal will skip this note/time */
+    {NOTE_c3_sharp,     138.59      },
+    {NOTE_g3,           196.00      },
+    {NOTE_b3,           246.94      },
+    {NOTE_c4,           261.63      },
+    {NOTE_a4,           440.f       },
+    {NOTE_b4,           493.88      },
+    {NOTE_e4,           329.63      },
+    {NOTE_f4,           349.23      },
+    {NOTE_c5,           523.25      },
+    {NOTE_d5,           587.33      },
+    {NOTE_e5,           659.25      },
+    {NOTE_f5,           698.46      },
+    {NOTE_g5,           783.99      },
+    {NOTE_a5,           880.f       },
+    {NOTE_c6_sharp,     1108.73     },
+    {NOTE_e6,           1318.51     },
+};
+
+static const struct melodies { /* C99 6.7.8/10 uninitialized arithmetic types are 0 this is what we want. */
+    uint8_t count;
+    uint8_t volume;
+    uint8_t fade;
+    uint8_t notes[8];
+} normal_ring[16] = {
+    {1, 14, 1, {NOTE_f5,        }},
+    {1, 14, 1, {NOTE_f5,        }},
+    {1, 14, 1, {NOTE_f5,        }},
+    {1, 14, 1, {NOTE_c6_sharp,  }},
+    {1, 14, 0, {NOTE_c5,        }},
+    {1, 14, 1, {NOTE_c5,        }},
+    {0, 0, 0,  {0,  }},
+}, friend_offline[4] = {
+    {1, 14, 1, {NOTE_c4, }},
+    {1, 14, 1, {NOTE_g3, }},
+    {1, 14, 1, {NOTE_g3, }},
+    {0, 0, 0,  {0, }},
+}, friend_online[4] = {
+    {1, 14, 0, {NOTE_g3, }},
+    {1, 14, 1, {NOTE_g3, }},
+    {1, 14, 1, {NOTE_a4, }},
+    {1, 14, 1, {NOTE_b4, }},
+}, friend_new_msg[8] = {
+    {1, 0, 0,  {0, }}, /* 3/8 sec of silence for spammy friends */
+    {1, 0, 0,  {0, }},
+    {1, 0, 0,  {0, }},
+    {1, 9,  0, {NOTE_g5, }},
+    {1, 9,  1, {NOTE_g5, }},
+    {1, 12, 1, {NOTE_a4, }},
+    {1, 10, 1, {NOTE_a4, }},
+    {1, 0, 0,  {0, }},
+}, friend_request[8] = {
+    {1, 9,  0, {NOTE_g5, }},
+    {1, 9,  1, {NOTE_g5, }},
+    {1, 12, 1, {NOTE_b3, }},
+    {1, 10, 1, {NOTE_b3, }},
+    {1, 9,  0, {NOTE_g5, }},
+    {1, 9,  1, {NOTE_g5, }},
+    {1, 12, 1, {NOTE_b3, }},
+    {1, 10, 0, {NOTE_b3, }},
+};
+// clang-format on
+
+
+typedef struct melodies MELODY;
+
+static const struct {
+    const MELODY *melody;
+    uint8_t       seconds;
+    uint8_t       notes_per_sec;
+} builtin_tones[TONE_MAX] = {
+    [TONE_RINGTONE]       = { normal_ring,    4, 4 },
+    [TONE_FRIEND_ONLINE]  = { friend_online,  1, 4 },
+    [TONE_FRIEND_OFFLINE] = { friend_offline, 1, 4 },
+    [TONE_FRIEND_NEW_MSG] = { friend_new_msg, 1, 8 },
+    [TONE_FRIEND_REQUEST] = { friend_request, 1, 8 },
+};
+
+static const char *tone_names[TONE_MAX] = {
+    [TONE_RINGTONE]       = "ringtone",
+    [TONE_FRIEND_ONLINE]  = "friend_online",
+    [TONE_FRIEND_OFFLINE] = "friend_offline",
+    [TONE_FRIEND_NEW_MSG] = "new_message",
+    [TONE_FRIEND_REQUEST] = "friend_request",
+};
+
+static bool tone_synthesize(const MELODY melody[], uint32_t seconds, uint32_t notes_per_sec, TONE_PCM *pcm) {
+    const uint32_t sample_rate    = 22000;
+    const uint32_t base_amplitude = 1000;
+    const double tau = 6.283185307179586476925286766559;
+
+    const uint32_t note_length = sample_rate / notes_per_sec;
+    const uint32_t frames      = seconds * sample_rate;
+
+    int16_t *samples = calloc(frames, sizeof(int16_t));
+    if (!samples) {
+        LOG_ERR("Tones", "Unable to calloc for a %u second tone.", seconds);
+        return false;
+    }
+
+    for (uint32_t index = 0; index < frames; ++index) {
+        /* Each note plays for note_length samples, the ones with fade set fade out over that time. */
+        const MELODY *note = &melody[index / note_length];
+        const double  fade = note->fade ? 1 - (double)(index % note_length) / note_length : 1;
+
+        for (int i = 0; i < note->count; ++i) {
+            samples[index] += note->volume * base_amplitude * fade
+                              * sin(tau * notes[note->notes[i]].freq * index / sample_rate);
+        }
+    }
+
+    pcm->samples     = samples;
+    pcm->frames      = frames;
+    pcm->sample_rate = sample_rate;
+    pcm->channels    = 1;
+    return true;
+}
+
+static uint16_t read_le16(const uint8_t *p) {
+    return p[0] | p[1] << 8;
+}
+
+static uint32_t read_le32(const uint8_t *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+bool tone_decode_wav(const uint8_t *data, size_t size, TONE_PCM *pcm) {
+    if (size < 12 || memcmp(data, "RIFF", 4) || memcmp(data + 8, "WAVE", 4)) {
+        return false;
+    }
+
+    const uint8_t *fmt  = NULL;
+    const uint8_t *body = NULL;
+    size_t body_size    = 0;
+
+    for (size_t pos = 12; pos + 8 <= size;) {
+        const uint8_t *chunk     = data + pos + 8;
+        const size_t   available = size - pos - 8;
+        const uint32_t length    = read_le32(data + pos + 4);
+
+        if (!memcmp(data + pos, "fmt ", 4) && length >= 16 && length <= available) {
+            fmt = chunk;
+        } else if (!memcmp(data + pos, "data", 4)) {
+            // Streaming writers can leave the length unset, so play whatever is there.
+            body      = chunk;
+            body_size = MIN(length, available);
+            break;
+        }
+
+        if (length > available) {
+            break;
+        }
+        pos += 8 + length + (length & 1);
+    }
+
+    if (!fmt || !body) {
+        LOG_WARN("Tones", "WAV file is missing its fmt or data chunk.");
+        return false;
+    }
+
+    const uint16_t format      = read_le16(fmt);
+    const uint16_t channels    = read_le16(fmt + 2);
+    const uint32_t sample_rate = read_le32(fmt + 4);
+    const uint16_t bits        = read_le16(fmt + 14);
+
+    if ((format != 1 && format != 0xFFFE) || bits != 16 || !channels || channels > 2 || !sample_rate
+        || sample_rate > 192000) {
+        LOG_WARN("Tones", "Unsupported WAV format %u: %u bit, %u channels, %u Hz", format, bits, channels, sample_rate);
+        return false;
+    }
+
+    const uint32_t frames = MIN(body_size / (2 * channels), sample_rate * TONE_MAX_SECONDS);
+    if (!frames) {
+        return false;
+    }
+
+    int16_t *samples = malloc(frames * channels * sizeof(int16_t));
+    if (!samples) {
+        LOG_ERR("Tones", "Unable to malloc for %u frames.", frames);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < frames * channels; ++i) {
+        samples[i] = read_le16(body + i * 2);
+    }
+
+    pcm->samples     = samples;
+    pcm->frames      = frames;
+    pcm->sample_rate = sample_rate;
+    pcm->channels    = channels;
+    return true;
+}
+
+/* Largest packet we'll put back together, Opus packets are far smaller than this. */
+#define OGG_MAX_PACKET (64 * 1024)
+
+/* Reads the packets of the first logical stream in an Ogg file. */
+typedef struct {
+    const uint8_t *data;
+    size_t         size, pos; // pos is the start of the next page
+
+    uint32_t serial;
+    bool     have_serial;
+
+    const uint8_t *lacing;
+    uint8_t        segments, segment;
+    const uint8_t *body;
+
+    int64_t granule; // Granule position of the last page read
+} OGG_READER;
+
+static bool ogg_next_page(OGG_READER *r) {
+    while (r->pos + 27 <= r->size) {
+        const uint8_t *page = r->data + r->pos;
+        if (memcmp(page, "OggS", 4) || page[4] != 0) {
+            return false;
+        }
+
+        const uint8_t segments = page[26];
+        if (r->pos + 27 + segments > r->size) {
+            return false;
+        }
+
+        size_t body_size = 0;
+        for (uint8_t i = 0; i < segments; ++i) {
+            body_size += page[27 + i];
+        }
+
+        if (r->pos + 27 + segments + body_size > r->size) {
+            return false;
+        }
+        r->pos += 27 + segments + body_size;
+
+        const uint32_t serial = read_le32(page + 14);
+        if (!r->have_serial) {
+            r->serial      = serial;
+            r->have_serial = true;
+        } else if (serial != r->serial) {
+            continue;
+        }
+
+        r->granule  = (int64_t)((uint64_t)read_le32(page + 6) | (uint64_t)read_le32(page + 10) << 32);
+        r->lacing   = page + 27;
+        r->segments = segments;
+        r->segment  = 0;
+        r->body     = page + 27 + segments;
+        return true;
+    }
+
+    return false;
+}
+
+static bool ogg_next_packet(OGG_READER *r, uint8_t *packet, size_t *length) {
+    *length = 0;
+
+    while (1) {
+        while (r->segment < r->segments) {
+            const uint8_t lace = r->lacing[r->segment++];
+            if (*length + lace > OGG_MAX_PACKET) {
+                return false;
+            }
+
+            memcpy(packet + *length, r->body, lace);
+            *length += lace;
+            r->body += lace;
+
+            if (lace < 255) {
+                return true;
+            }
+        }
+
+        if (!ogg_next_page(r)) {
+            return false;
+        }
+    }
+}
+
+bool tone_decode_opus(const uint8_t *data, size_t size, TONE_PCM *pcm) {
+    const uint32_t sample_rate = 48000;
+    const uint32_t max_packet_frames = sample_rate * 120 / 1000;
+
+    OGG_READER r = {.data = data, .size = size };
+
+    uint8_t *packet = malloc(OGG_MAX_PACKET);
+    if (!packet) {
+        LOG_ERR("Tones", "Unable to malloc for Ogg packet.");
+        return false;
+    }
+
+    size_t length;
+    if (!ogg_next_packet(&r, packet, &length) || length < 19 || memcmp(packet, "OpusHead", 8)
+        || packet[8] >> 4 != 0) {
+        free(packet);
+        return false;
+    }
+
+    const uint8_t  channels = packet[9];
+    const uint16_t pre_skip = read_le16(packet + 10);
+    if (!channels || channels > 2 || packet[18] != 0) {
+        LOG_WARN("Tones", "Unsupported Opus channel layout: %u channels, mapping %u", channels, packet[18]);
+        free(packet);
+        return false;
+    }
+
+    if (!ogg_next_packet(&r, packet, &length) || length < 8 || memcmp(packet, "OpusTags", 8)) {
+        free(packet);
+        return false;
+    }
+
+    int error;
+    OpusDecoder *decoder = opus_decoder_create(sample_rate, channels, &error);
+    if (error != OPUS_OK) {
+        LOG_ERR("Tones", "Unable to create Opus decoder: %s", opus_strerror(error));
+        free(packet);
+        return false;
+    }
+
+    const uint32_t max_frames = sample_rate * TONE_MAX_SECONDS + pre_skip;
+
+    int16_t *samples = NULL;
+    uint32_t frames = 0, capacity = 0;
+
+    while (frames < max_frames && ogg_next_packet(&r, packet, &length)) {
+        if (frames + max_packet_frames > capacity) {
+            capacity = MAX(capacity * 2, frames + max_packet_frames);
+            int16_t *new_samples = realloc(samples, capacity * channels * sizeof(int16_t));
+            if (!new_samples) {
+                LOG_ERR("Tones", "Unable to realloc for %u frames.", capacity);
+                break;
+            }
+            samples = new_samples;
+        }
+
+        const int decoded = opus_decode(decoder, packet, length, samples + frames * channels, max_packet_frames, 0);
+        if (decoded < 0) {
+            LOG_TRACE("Tones", "Skipping Opus packet: %s", opus_strerror(decoded));
+            continue;
+        }
+        frames += decoded;
+    }
+
+    opus_decoder_destroy(decoder);
+    free(packet);
+
+    // The last granule position marks where the audio really ends, the final packet is usually padded.
+    if (r.granule > 0 && (uint64_t)r.granule < frames) {
+        frames = r.granule;
+    }
+
+    if (frames <= pre_skip) {
+        free(samples);
+        return false;
+    }
+
+    frames = MIN(frames - pre_skip, sample_rate * TONE_MAX_SECONDS);
+    memmove(samples, samples + pre_skip * channels, frames * channels * sizeof(int16_t));
+
+    pcm->samples     = samples;
+    pcm->frames      = frames;
+    pcm->sample_rate = sample_rate;
+    pcm->channels    = channels;
+    return true;
+}
+
+static bool tone_load_file(TONE tone, TONE_PCM *pcm) {
+    static const struct {
+        const char *extension;
+        bool (*decode)(const uint8_t *data, size_t size, TONE_PCM *pcm);
+    } formats[] = {
+        { "wav",  tone_decode_wav  },
+        { "opus", tone_decode_opus },
+    };
+
+    for (size_t i = 0; i < COUNTOF(formats); ++i) {
+        char name[64];
+        snprintf(name, sizeof(name), "tones/%s.%s", tone_names[tone], formats[i].extension);
+
+        size_t size = 0;
+        FILE *fp = utox_get_file(name, &size, UTOX_FILE_OPTS_READ);
+        if (!fp) {
+            continue;
+        }
+
+        if (!size || size > TONE_MAX_FILE_SIZE) {
+            LOG_WARN("Tones", "Ignoring %s, it's %zu bytes.", name, size);
+            fclose(fp);
+            continue;
+        }
+
+        uint8_t *data = malloc(size);
+        if (!data) {
+            LOG_ERR("Tones", "Could not allocate memory for file of size %zu.", size);
+            fclose(fp);
+            return false;
+        }
+
+        const bool read = fread(data, size, 1, fp) == 1;
+        fclose(fp);
+
+        if (read && formats[i].decode(data, size, pcm)) {
+            LOG_INFO("Tones", "Using %s: %u frames at %u Hz", name, pcm->frames, pcm->sample_rate);
+            free(data);
+            return true;
+        }
+
+        LOG_WARN("Tones", "Unable to use %s", name);
+        free(data);
+    }
+
+    return false;
+}
+
+void tones_load(void) {
+    for (TONE i = 0; i < TONE_MAX; ++i) {
+        if (tones[i].samples) {
+            continue;
+        }
+
+        if (!tone_load_file(i, &tones[i])) {
+            tone_synthesize(builtin_tones[i].melody, builtin_tones[i].seconds, builtin_tones[i].notes_per_sec, &tones[i]);
+        }
+    }
+}
+
+void tones_free(void) {
+    for (TONE i = 0; i < TONE_MAX; ++i) {
+        free(tones[i].samples);
+    }
+    memset(tones, 0, sizeof(tones));
+}
+
+const TONE_PCM *tone_get(TONE tone) {
+    if (tone >= TONE_MAX || !tones[tone].samples) {
+        return NULL;
+    }
+
+    return &tones[tone];
+}
@@ -0,0 +1,55 @@
+#ifndef TONES_H
+#define TONES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Ringtone and notification sounds.
+ *
+ * Every tone is built once when the audio thread starts, either from a file the user put in the tones folder of the
+ * uTox data directory or synthesized from the built in melody. The audio thread keeps one OpenAL buffer per tone, so
+ * playing a notification doesn't allocate or synthesize anything.
+ *
+ * User tones are looked up as tones/<name>.wav (16 bit PCM) and then tones/<name>.opus (Ogg Opus), where name is one
+ * of ringtone, friend_online, friend_offline, new_message or friend_request. */
+
+typedef enum {
+    TONE_RINGTONE,
+    TONE_FRIEND_ONLINE,
+    TONE_FRIEND_OFFLINE,
+    TONE_FRIEND_NEW_MSG,
+    TONE_FRIEND_REQUEST,
+    TONE_MAX,
+} TONE;
+
+/* Longest user tone we'll keep, anything past this is cut off. */
+#define TONE_MAX_SECONDS 30
+
+/* Largest tone file we'll read. */
+#define TONE_MAX_FILE_SIZE (8 * 1024 * 1024)
+
+typedef struct {
+    int16_t *samples; // Interleaved
+    uint32_t frames;
+    uint32_t sample_rate;
+    uint8_t  channels;
+} TONE_PCM;
+
+/* Builds every tone. Tones that are already built are left alone. */
+void tones_load(void);
+
+void tones_free(void);
+
+/* Returns NULL if tone couldn't be built. */
+const TONE_PCM *tone_get(TONE tone);
+
+/* Decodes a RIFF WAVE file holding 16 bit PCM into pcm.
+ * Returns false if the file isn't one we can play. */
+bool tone_decode_wav(const uint8_t *data, size_t size, TONE_PCM *pcm);
+
+/* Decodes the first stream of an Ogg Opus file into pcm at 48kHz.
+ * Returns false if the file isn't one we can play. */
+bool tone_decode_opus(const uint8_t *data, size_t size, TONE_PCM *pcm);
+
+#endif
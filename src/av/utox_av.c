@@ -1,6 +1,7 @@
 #include "utox_av.h"
 
 #include "audio.h"
+#include "call_stats.h"
 #include "video.h"
 
 #include "../debug.h"
@@ -15,6 +16,7 @@
 
 #include "../native/audio.h"
 #include "../native/thread.h"
+#include "../native/time.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -36,6 +38,25 @@ void postmessage_utoxav(uint8_t msg, uint32_t param1, uint32_t param2, void *dat
     toxav_thread_msg = 1;
 }
 
+/* Takes a sample of every call whose stats are due for one. */
+static void utox_av_sample_stats(void) {
+    const uint64_t now = get_time();
+
+    uint32_t       friends[CALL_STATS_MAX_CALLS];
+    const uint32_t count = call_stats_due(now, friends, COUNTOF(friends));
+    for (uint32_t i = 0; i < count; ++i) {
+        AUDIO_PLAYBACK_STATS playback;
+        CALL_STATS_AUDIO     audio = { 0 };
+        if (sourceplaybuffer_stats(friends[i], &playback)) {
+            audio.queued    = playback.queued;
+            audio.underruns = playback.underruns;
+            audio.dropped   = playback.dropped;
+        }
+
+        call_stats_sample(friends[i], now, &audio);
+    }
+}
+
 void utox_av_ctrl_thread(void *UNUSED(args)) {
     ToxAV *av = NULL;
 
@@ -91,6 +112,7 @@ void utox_av_ctrl_thread(void *UNUSED(args)) {
                         utox_video_start(0);
                         f->call_state_self |= (TOXAV_FRIEND_CALL_STATE_SENDING_V | TOXAV_FRIEND_CALL_STATE_ACCEPTING_V);
                     }
+                    utox_video_call_update(msg->param1);
                     break;
                 }
 
@@ -112,6 +134,7 @@ void utox_av_ctrl_thread(void *UNUSED(args)) {
                         utox_video_start(0);
                         f->call_state_self |= (TOXAV_FRIEND_CALL_STATE_SENDING_V | TOXAV_FRIEND_CALL_STATE_ACCEPTING_V);
                     }
+                    utox_video_call_update(msg->param1);
                     break;
                 }
 
@@ -278,6 +301,8 @@ void utox_av_ctrl_thread(void *UNUSED(args)) {
 
         toxav_thread_msg = false;
 
+        utox_av_sample_stats();
+
         if (av) {
             toxav_iterate(av);
             yieldcpu(toxav_iteration_interval(av));
@@ -315,6 +340,7 @@ static void utox_av_incoming_call(ToxAV *UNUSED(av), uint32_t friend_number,
 
     f->call_state_self   = 0;
     f->call_state_friend = (audio << 2 | video << 3 | audio << 4 | video << 5);
+    utox_video_call_update(friend_number);
     LOG_TRACE("uToxAV", "uTox AV:\tcall friend (%u) state for incoming call: %i" , friend_number, f->call_state_friend);
     postmessage_utoxav(UTOXAV_INCOMING_CALL_PENDING, friend_number, 0, NULL);
     postmessage_utox(AV_CALL_INCOMING, friend_number, video, NULL);
@@ -331,6 +357,7 @@ static void utox_av_remote_disconnect(ToxAV *UNUSED(av), int32_t friend_number)
     postmessage_utoxav(UTOXAV_CALL_END, friend_number, 0, NULL);
     f->call_state_self   = 0;
     f->call_state_friend = 0;
+    utox_video_call_update(friend_number);
     postmessage_utox(AV_CLOSE_WINDOW, friend_number + 1, 0, NULL);
     postmessage_utox(AV_CALL_DISCONNECTED, friend_number, 0, NULL);
 }
@@ -376,6 +403,7 @@ void utox_av_local_disconnect(ToxAV *av, int32_t friend_number) {
 
     f->call_state_self   = 0;
     f->call_state_friend = 0;
+    utox_video_call_update(friend_number);
     postmessage_utox(AV_CLOSE_WINDOW, friend_number + 1, 0, NULL); /* TODO move all of this into a static function in that
                                                                  file !*/
     postmessage_utox(AV_CALL_DISCONNECTED, friend_number, 0, NULL);
@@ -422,6 +450,7 @@ void utox_av_local_call_control(ToxAV *av, uint32_t friend_number, TOXAV_CALL_CO
             // TOXAV_CALL_CONTROL_MUTE_AUDIO,
             // TOXAV_CALL_CONTROL_UNMUTE_AUDIO,
     }
+    utox_video_call_update(friend_number);
 
     if (bitrate_err) {
         LOG_ERR("uToxAV", "Error setting/changing video bitrate");
@@ -454,7 +483,20 @@ static void utox_av_incoming_frame_v(ToxAV *UNUSED(toxAV), uint32_t friend_numbe
     }
     f->video_width  = width;
     f->video_height = height;
-    size_t size     = width * height * 4;
+
+    const uint64_t decoded = get_time();
+    call_stats_video_received(friend_number);
+
+    if (f->video_inline) {
+        if (!inline_set_frame(friend_number, decoded, width, height, y, u, v, ystride, ustride, vstride)) {
+            LOG_ERR("uToxAV", "Error setting frame for inline video.");
+        }
+
+        postmessage_utox(AV_INLINE_FRAME, friend_number, 0, NULL);
+        return;
+    }
+
+    size_t size = width * height * 4;
 
     UTOX_FRAME_PKG *frame = calloc(1, sizeof(UTOX_FRAME_PKG));
 
@@ -463,9 +505,10 @@ static void utox_av_incoming_frame_v(ToxAV *UNUSED(toxAV), uint32_t friend_numbe
         return;
     }
 
-    frame->w    = width;
-    frame->h    = height;
-    frame->size = size;
+    frame->w       = width;
+    frame->h       = height;
+    frame->size    = size;
+    frame->decoded = decoded;
     frame->img  = malloc(size);
     if (!frame->img) {
         LOG_TRACE("uToxAV", "Could not allocate memory for image.");
@@ -474,17 +517,7 @@ static void utox_av_incoming_frame_v(ToxAV *UNUSED(toxAV), uint32_t friend_numbe
     }
 
     yuv420tobgr(width, height, y, u, v, ystride, ustride, vstride, frame->img);
-    if (f->video_inline) {
-        if (!inline_set_frame(width, height, size, frame->img)) {
-            LOG_ERR("uToxAV", "Error setting frame for inline video.");
-        }
-
-        postmessage_utox(AV_INLINE_FRAME, friend_number, 0, NULL);
-        free(frame->img);
-        free(frame);
-    } else {
-        postmessage_utox(AV_VIDEO_FRAME, friend_number, 0, (void *)frame);
-    }
+    postmessage_utox(AV_VIDEO_FRAME, friend_number, 0, (void *)frame);
 }
 
 static void utox_audio_friend_accepted(ToxAV *av, uint32_t friend_number, uint32_t state) {
@@ -495,6 +528,7 @@ static void utox_audio_friend_accepted(ToxAV *av, uint32_t friend_number, uint32
         LOG_FATAL_ERR(EXIT_FAILURE, "uToxAV", "Unable to get friend when A/V call accepted %u", friend_number);
     }
     f->call_state_friend = state;
+    utox_video_call_update(friend_number);
     if (SELF_SEND_VIDEO(friend_number) && !FRIEND_ACCEPTING_VIDEO(friend_number)) {
         utox_av_local_call_control(av, friend_number, TOXAV_CALL_CONTROL_HIDE_VIDEO);
     }
@@ -553,9 +587,14 @@ static void utox_callback_av_change_state(ToxAV *av, uint32_t friend_number, uin
     }
 
     f->call_state_friend = state;
+    utox_video_call_update(friend_number);
 }
 
 static void utox_incoming_video_rate_change(ToxAV *AV, uint32_t f_num, uint32_t v_bitrate, void *UNUSED(ud)) {
+    /* Let the video thread pick a frame rate and resolution the new rate can carry. */
+    utox_video_rate_change(f_num, v_bitrate);
+    call_stats_video_bitrate(f_num, v_bitrate);
+
     /* Just accept what toxav wants the bitrate to be... */
     if (v_bitrate > (uint32_t)UTOX_MIN_BITRATE_VIDEO) {
         TOXAV_ERR_BIT_RATE_SET error = 0;
@@ -571,6 +610,8 @@ static void utox_incoming_video_rate_change(ToxAV *AV, uint32_t f_num, uint32_t
 }
 
 static void utox_incoming_audio_rate_change(ToxAV *AV, uint32_t friend_number, uint32_t audio_bitrate, void *UNUSED(userdata)){
+    call_stats_audio_bitrate(friend_number, audio_bitrate);
+
     if (audio_bitrate > (uint32_t)UTOX_MIN_BITRATE_VIDEO) {
         TOXAV_ERR_BIT_RATE_SET error = 0;
         toxav_video_set_bit_rate(AV, friend_number, audio_bitrate, &error);
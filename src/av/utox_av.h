@@ -74,5 +74,7 @@ void callback_av_group_audio(void *tox, uint32_t groupnumber, uint32_t peernumbe
 
 void group_av_peer_add(GROUPCHAT *g, int peernumber);
 void group_av_peer_remove(GROUPCHAT *g, int peernumber);
+/* Moves peer from's audio to peer to, when toxcore renumbers peers. */
+void group_av_peer_move(GROUPCHAT *g, int from, int to);
 
 #endif
@@ -0,0 +1,79 @@
+#include "vad.h"
+
+#include <math.h>
+
+/* Share of a period's energy in its first difference above which it's too flat to be voice. White noise sits at 0.5,
+ * voiced speech well under 0.2. */
+#define VAD_MAX_HIGH_RATIO 0.35
+
+void vad_init(VAD *v, uint32_t sample_rate) {
+    v->sample_rate = sample_rate;
+    v->noise_floor = VAD_MIN_ENERGY;
+    v->hangover    = 0;
+    v->voice       = false;
+}
+
+bool vad_process(VAD *v, const int16_t *pcm, uint32_t samples) {
+    if (!samples) {
+        return v->voice;
+    }
+
+    /* Energy of the period and of its first difference, which is a cheap high pass. */
+    double energy = 0, high = 0;
+    int32_t last = pcm[0];
+    for (uint32_t i = 0; i < samples; ++i) {
+        const int32_t d = pcm[i] - last;
+        energy += (double)pcm[i] * pcm[i];
+        high   += (double)d * d;
+        last    = pcm[i];
+    }
+    energy /= samples;
+    high   /= samples;
+
+    // The first difference of white noise has twice the energy of the noise itself.
+    const double high_ratio = energy > 0 ? high / (energy * 4) : 0;
+
+    bool voice = energy > VAD_MIN_ENERGY && energy > v->noise_floor * VAD_THRESHOLD
+                 && (high_ratio < VAD_MAX_HIGH_RATIO || energy > v->noise_floor * VAD_THRESHOLD_LOUD);
+
+    if (!voice) {
+        // Follow drops in the noise quickly and rises slowly, so a word onset doesn't drag the floor up.
+        v->noise_floor += (energy - v->noise_floor) * (energy < v->noise_floor ? 0.5 : 0.05);
+    } else if (high_ratio >= VAD_MAX_HIGH_RATIO) {
+        // Loud enough to pass as voice but as flat as noise, a fan or traffic starting up. Learn it fairly quickly.
+        v->noise_floor += (energy - v->noise_floor) * 0.2;
+    } else {
+        // Let the floor creep up (about 1dB a second) in case the background got louder for good.
+        v->noise_floor *= 1.0 + 0.23 * samples / v->sample_rate;
+    }
+    if (v->noise_floor < VAD_MIN_ENERGY) {
+        v->noise_floor = VAD_MIN_ENERGY;
+    }
+
+    if (voice) {
+        v->hangover = (uint64_t)VAD_HANGOVER_MS * v->sample_rate / 1000;
+    } else if (v->hangover > samples) {
+        v->hangover -= samples;
+        voice = true;
+    } else {
+        v->hangover = 0;
+    }
+
+    v->voice = voice;
+    return voice;
+}
+
+uint16_t vad_noise_level(const VAD *v) {
+    const double rms = sqrt(v->noise_floor);
+    return rms > INT16_MAX ? INT16_MAX : rms;
+}
+
+void vad_comfort_noise(uint32_t *seed, uint16_t rms, int16_t *pcm, uint32_t samples) {
+    // Uniform noise between -a and a has an RMS of a / sqrt(3).
+    const int32_t amplitude = rms * 1.7320508 > INT16_MAX ? INT16_MAX : rms * 1.7320508;
+
+    for (uint32_t i = 0; i < samples; ++i) {
+        *seed  = *seed * 1664525 + 1013904223;
+        pcm[i] = (int16_t)(((int64_t)(*seed >> 16) * (amplitude * 2 + 1) >> 16) - amplitude);
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef VAD_H
+#define VAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Voice activity detection for the microphone, so silent frames don't have to be encoded and sent.
+ *
+ * Every period is compared against a running estimate of the background noise: speech has to be louder than the
+ * noise floor by VAD_THRESHOLD, and unless it's very loud, most of its energy has to be in the lower frequencies
+ * (hiss and fans are much flatter). Once voice is detected the gate stays open for VAD_HANGOVER_MS so word endings
+ * and short pauses aren't clipped. None of this needs filter_audio. */
+
+/* How long the gate stays open after the last period with voice in it. */
+#define VAD_HANGOVER_MS 300
+
+/* Energy over the noise floor a period needs to count as voice. 4 is about 6dB. */
+#define VAD_THRESHOLD 4
+
+/* Periods louder than the noise floor by this much (about 15dB) are voice no matter their spectrum. */
+#define VAD_THRESHOLD_LOUD 32
+
+/* Mean square sample value below which nothing counts as voice, and the lowest the noise floor goes. About -60dBFS. */
+#define VAD_MIN_ENERGY 1074
+
+typedef struct {
+    uint32_t sample_rate;
+
+    double   noise_floor; // Mean square of the background noise
+    uint32_t hangover;    // Samples left before the gate closes
+
+    bool voice; // Result for the last period
+} VAD;
+
+void vad_init(VAD *v, uint32_t sample_rate);
+
+/* Looks at one period of mono audio. Returns true while the gate is open. */
+bool vad_process(VAD *v, const int16_t *pcm, uint32_t samples);
+
+/* RMS of the background noise, for generating comfort noise. */
+uint16_t vad_noise_level(const VAD *v);
+
+/* Fills pcm with white noise at rms level. seed is the generator state and can start out as anything. */
+void vad_comfort_noise(uint32_t *seed, uint16_t rms, int16_t *pcm, uint32_t samples);
+
+#endif
@@ -1,6 +1,9 @@
 #include "video.h"
 
+#include "call_stats.h"
 #include "utox_av.h"
+#include "video_convert.h"
+#include "video_pacer.h"
 
 #include "../friend.h"
 #include "../debug.h"
@@ -11,16 +14,20 @@
 #include "../utox.h"
 
 #include "../native/thread.h"
+#include "../native/time.h"
 #include "../native/video.h"
 
 #include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 #include <tox/toxav.h>
 #include <vpx/vpx_codec.h>
 #include <vpx/vpx_image.h>
 
 bool utox_video_thread_init = false;
 
+uint64_t video_frame_time = 0;
+
 static void *   video_device[16]     = { NULL }; /* TODO; magic number */
 static int16_t  video_device_count   = 0;
 static uint32_t video_device_current = 0;
@@ -34,6 +41,375 @@ static vpx_image_t input;
 
 static pthread_mutex_t video_thread_lock;
 
+/* Calls we're sending video to, kept up to date by utox_video_call_update() whenever a call's state changes, each with
+ * the pacer picking what it gets. Touched by the toxav thread, the video thread, the encoders and the UI, so
+ * everything goes through video_pacer_lock. */
+typedef struct {
+    bool        used;
+    uint32_t    friend_number;
+    VIDEO_PACER pacer;
+} VIDEO_CALL;
+
+static VIDEO_CALL      video_calls[UTOX_MAX_CALLS];
+static pthread_mutex_t video_pacer_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* A captured frame scaled to one rung of the pacer's ladder. Rungs that come out the same size as the capture just
+ * point at rung 0. */
+typedef struct {
+    uint16_t width, height;
+    uint8_t *y, *u, *v;
+    bool     ready;
+
+    uint8_t *img; // Planes of the scaled frame, img_size bytes
+    size_t   img_size;
+} VIDEO_SCALED;
+
+/* Frames being encoded. While encoders read one, the video thread captures into the next, and only waits when every
+ * frame is still being read. Nothing touches a frame's planes between dispatching it and pending dropping to 0. */
+#define VIDEO_PIPELINE_FRAMES 2
+
+typedef struct {
+    VIDEO_SCALED scaled[VIDEO_PACER_SCALE_COUNT]; // Rung 0 holds a copy of the capture
+    uint32_t     pending; // Encodes still reading this frame
+} VIDEO_PIPELINE_FRAME;
+
+typedef struct {
+    ToxAV *av;
+    const VIDEO_SCALED *frame;
+    VIDEO_PIPELINE_FRAME *owner;
+    uint32_t friend_number;
+} VIDEO_ENCODE_JOB;
+
+/* Every encode runs on one of these. Each call always goes to the same one, taking its jobs in order, so a call's
+ * frames never encode at the same time or go out of order. Different calls encode in parallel. */
+#define VIDEO_ENCODE_THREADS 4
+
+static VIDEO_PIPELINE_FRAME video_pipeline[VIDEO_PIPELINE_FRAMES];
+
+/* Can't overflow, there's never more than one job per call per pipeline frame. */
+typedef struct {
+    VIDEO_ENCODE_JOB jobs[VIDEO_PIPELINE_FRAMES * UTOX_MAX_CALLS];
+    uint32_t         head, tail;
+} VIDEO_ENCODE_WORKER;
+
+static VIDEO_ENCODE_WORKER video_workers[VIDEO_ENCODE_THREADS];
+
+static pthread_mutex_t video_encode_lock       = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  video_encode_job_cond   = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  video_encode_done_cond  = PTHREAD_COND_INITIALIZER;
+static bool            video_encode_run        = false;
+static uint8_t         video_encode_threads_running;
+
+/* video_pacer_lock must be held. */
+static VIDEO_PACER *video_call_pacer(uint32_t friend_number, bool create) {
+    VIDEO_CALL *unused = NULL;
+    for (size_t i = 0; i < COUNTOF(video_calls); ++i) {
+        if (video_calls[i].used && video_calls[i].friend_number == friend_number) {
+            return &video_calls[i].pacer;
+        }
+        if (!video_calls[i].used && !unused) {
+            unused = &video_calls[i];
+        }
+    }
+
+    if (!create || !unused) {
+        if (create) {
+            LOG_ERR("uToxVideo", "Trying to send video to too many peers. Please report this bug!");
+        }
+        return NULL;
+    }
+
+    unused->used          = true;
+    unused->friend_number = friend_number;
+    video_pacer_init(&unused->pacer, UTOX_DEFAULT_BITRATE_V);
+    return &unused->pacer;
+}
+
+void utox_video_call_update(uint32_t friend_number) {
+    pthread_mutex_lock(&video_pacer_lock);
+    if (SEND_VIDEO_FRAME(friend_number)) {
+        video_call_pacer(friend_number, true);
+    } else {
+        for (size_t i = 0; i < COUNTOF(video_calls); ++i) {
+            if (video_calls[i].used && video_calls[i].friend_number == friend_number) {
+                video_calls[i].used = false;
+            }
+        }
+    }
+    pthread_mutex_unlock(&video_pacer_lock);
+}
+
+void utox_video_rate_change(uint32_t friend_number, uint32_t bitrate) {
+    pthread_mutex_lock(&video_pacer_lock);
+    VIDEO_PACER *p = video_call_pacer(friend_number, false);
+    if (p) {
+        video_pacer_set_bitrate(p, bitrate);
+    }
+    pthread_mutex_unlock(&video_pacer_lock);
+}
+
+bool utox_video_send_stats(uint32_t friend_number, UTOX_VIDEO_SEND_STATS *stats) {
+    pthread_mutex_lock(&video_pacer_lock);
+    const VIDEO_PACER *p = video_call_pacer(friend_number, false);
+    if (p && p->fps) {
+        stats->width          = p->width;
+        stats->height         = p->height;
+        stats->fps            = p->fps;
+        stats->bitrate        = p->bitrate;
+        stats->frames_sent    = p->frames_sent;
+        stats->frames_skipped = p->frames_skipped;
+        stats->send_errors    = p->send_errors;
+    }
+    pthread_mutex_unlock(&video_pacer_lock);
+
+    return p && p->fps;
+}
+
+static bool video_scaled_alloc(VIDEO_SCALED *s, uint16_t width, uint16_t height) {
+    const size_t size = (size_t)width * height * 3 / 2;
+    if (s->img_size < size) {
+        uint8_t *img = realloc(s->img, size);
+        if (!img) {
+            LOG_ERR("uToxVideo", "Unable to realloc for a %ux%u frame.", width, height);
+            return false;
+        }
+        s->img      = img;
+        s->img_size = size;
+    }
+
+    s->width  = width;
+    s->height = height;
+    s->y      = s->img;
+    s->u      = s->y + width * height;
+    s->v      = s->u + (width / 2) * (height / 2);
+    return true;
+}
+
+/* Returns the frame scaled down to rung scale, scaling it now if nobody needed that size yet. */
+static const VIDEO_SCALED *video_frame_scaled(VIDEO_PIPELINE_FRAME *frame, uint8_t scale) {
+    VIDEO_SCALED *s = &frame->scaled[scale];
+    if (s->ready) {
+        return s;
+    }
+
+    const VIDEO_SCALED *full = &frame->scaled[0];
+    uint16_t width, height;
+    video_pacer_scaled_size(scale, full->width, full->height, &width, &height);
+
+    if (width == full->width && height == full->height) {
+        s->width  = width;
+        s->height = height;
+        s->y      = full->y;
+        s->u      = full->u;
+        s->v      = full->v;
+        s->ready  = true;
+        return s;
+    }
+
+    if (!video_scaled_alloc(s, width, height)) {
+        return NULL;
+    }
+
+    yuv420_downscale(full->y, full->u, full->v, full->width, full->height, s->y, s->u, s->v, width, height);
+    s->ready = true;
+    return s;
+}
+
+static void video_encode_thread(void *args) {
+    VIDEO_ENCODE_WORKER *w = &video_workers[(uintptr_t)args];
+
+    pthread_mutex_lock(&video_encode_lock);
+    while (1) {
+        while (video_encode_run && w->head == w->tail) {
+            pthread_cond_wait(&video_encode_job_cond, &video_encode_lock);
+        }
+        if (w->head == w->tail) {
+            break;
+        }
+
+        const VIDEO_ENCODE_JOB job = w->jobs[w->tail++ % COUNTOF(w->jobs)];
+        pthread_mutex_unlock(&video_encode_lock);
+
+        LOG_TRACE("uToxVideo", "sending video frame to friend %u" , job.friend_number);
+        TOXAV_ERR_SEND_FRAME error = 0;
+        const uint64_t encode_start = get_time();
+        toxav_video_send_frame(job.av, job.friend_number, job.frame->width, job.frame->height, job.frame->y,
+                               job.frame->u, job.frame->v, &error);
+        call_stats_video_sent(job.friend_number, get_time() - encode_start, error);
+
+        if (error == TOXAV_ERR_SEND_FRAME_SYNC) {
+            LOG_ERR("uToxVideo", "Vid Frame sync error: w=%u h=%u", job.frame->width, job.frame->height);
+        } else if (error == TOXAV_ERR_SEND_FRAME_PAYLOAD_TYPE_DISABLED) {
+            LOG_ERR("uToxVideo", "ToxAV disagrees with our AV state for friend %u", job.friend_number);
+        } else if (error) {
+            LOG_ERR("uToxVideo", "toxav_send_video error friend: %u error: %u", job.friend_number, error);
+        }
+
+        pthread_mutex_lock(&video_pacer_lock);
+        VIDEO_PACER *p = video_call_pacer(job.friend_number, false);
+        if (p && !error) {
+            p->frames_sent++;
+        } else if (p && error != TOXAV_ERR_SEND_FRAME_SYNC && error != TOXAV_ERR_SEND_FRAME_PAYLOAD_TYPE_DISABLED) {
+            video_pacer_send_error(p);
+        }
+        pthread_mutex_unlock(&video_pacer_lock);
+
+        pthread_mutex_lock(&video_encode_lock);
+        if (--job.owner->pending == 0) {
+            pthread_cond_broadcast(&video_encode_done_cond);
+        }
+    }
+
+    video_encode_threads_running--;
+    pthread_cond_broadcast(&video_encode_done_cond);
+    pthread_mutex_unlock(&video_encode_lock);
+}
+
+static void video_encode_start(void) {
+    pthread_mutex_lock(&video_encode_lock);
+    video_encode_run = true;
+    pthread_mutex_unlock(&video_encode_lock);
+
+    for (uint8_t i = 0; i < VIDEO_ENCODE_THREADS; ++i) {
+        pthread_mutex_lock(&video_encode_lock);
+        video_encode_threads_running++;
+        pthread_mutex_unlock(&video_encode_lock);
+        thread(video_encode_thread, (void *)(uintptr_t)i);
+    }
+}
+
+/* Blocks until no encoder is reading any pipeline frame. */
+static void video_encode_drain(void) {
+    pthread_mutex_lock(&video_encode_lock);
+    for (size_t i = 0; i < COUNTOF(video_pipeline); ++i) {
+        while (video_pipeline[i].pending) {
+            pthread_cond_wait(&video_encode_done_cond, &video_encode_lock);
+        }
+    }
+    pthread_mutex_unlock(&video_encode_lock);
+}
+
+/* Finishes what's queued, stops the encoders and frees the pipeline. */
+static void video_encode_stop(void) {
+    pthread_mutex_lock(&video_encode_lock);
+    video_encode_run = false;
+    pthread_cond_broadcast(&video_encode_job_cond);
+    while (video_encode_threads_running) {
+        pthread_cond_wait(&video_encode_done_cond, &video_encode_lock);
+    }
+    pthread_mutex_unlock(&video_encode_lock);
+
+    for (size_t i = 0; i < COUNTOF(video_pipeline); ++i) {
+        for (size_t j = 0; j < COUNTOF(video_pipeline[i].scaled); ++j) {
+            free(video_pipeline[i].scaled[j].img);
+        }
+        video_pipeline[i] = (VIDEO_PIPELINE_FRAME){ 0 };
+    }
+}
+
+/* Returns a pipeline frame no encoder is reading, waiting for the slowest one if they all are. */
+static VIDEO_PIPELINE_FRAME *video_pipeline_frame(void) {
+    static uint8_t next;
+
+    VIDEO_PIPELINE_FRAME *frame = &video_pipeline[next];
+    next = (next + 1) % COUNTOF(video_pipeline);
+
+    pthread_mutex_lock(&video_encode_lock);
+    while (frame->pending) {
+        pthread_cond_wait(&video_encode_done_cond, &video_encode_lock);
+    }
+    pthread_mutex_unlock(&video_encode_lock);
+
+    for (size_t i = 0; i < COUNTOF(frame->scaled); ++i) {
+        frame->scaled[i].ready = false;
+    }
+    return frame;
+}
+
+/* Hands the frame just captured to the encoders for every call whose pacer wants one now. Returns the highest frame
+ * rate any call is paced at, 0 if there are none. */
+static uint8_t video_send_frame(ToxAV *av) {
+    const uint64_t now      = get_time();
+    const uint64_t captured = video_frame_time ? video_frame_time : now;
+    uint8_t max_fps = 0;
+
+    /* Work out who gets this frame first, so there's nothing to copy if nobody does. */
+    struct {
+        uint32_t friend_number;
+        uint8_t  scale;
+        uint8_t  worker;
+    } due[UTOX_MAX_CALLS];
+    size_t due_count = 0;
+
+    pthread_mutex_lock(&video_pacer_lock);
+    for (size_t i = 0; i < COUNTOF(video_calls); ++i) {
+        VIDEO_CALL *call = &video_calls[i];
+        if (!call->used) {
+            continue;
+        }
+
+        VIDEO_PACER *p = &call->pacer;
+        if (video_pacer_update(p, utox_video_frame.w, utox_video_frame.h, settings.video_fps, now)) {
+            LOG_INFO("uToxVideo", "Sending video to friend %u at %ux%u, %u fps (%u kbit/s)", call->friend_number,
+                     p->width, p->height, p->fps, p->bitrate);
+            postmessage_utox(REDRAW, 0, 0, NULL);
+        }
+        if (p->fps > max_fps) {
+            max_fps = p->fps;
+        }
+
+        if (video_pacer_due(p, now, captured)) {
+            due[due_count].friend_number = call->friend_number;
+            due[due_count].scale         = p->scale;
+            due[due_count].worker        = i % VIDEO_ENCODE_THREADS;
+            due_count++;
+        }
+    }
+    pthread_mutex_unlock(&video_pacer_lock);
+
+    if (!due_count) {
+        return max_fps;
+    }
+
+    /* The capture buffer is overwritten by the next capture, the encoders get a copy of their own. */
+    VIDEO_PIPELINE_FRAME *frame = video_pipeline_frame();
+    VIDEO_SCALED *full = &frame->scaled[0];
+    if (!video_scaled_alloc(full, utox_video_frame.w, utox_video_frame.h)) {
+        return max_fps;
+    }
+    memcpy(full->y, utox_video_frame.y, (size_t)full->width * full->height);
+    memcpy(full->u, utox_video_frame.u, (size_t)(full->width / 2) * (full->height / 2));
+    memcpy(full->v, utox_video_frame.v, (size_t)(full->width / 2) * (full->height / 2));
+    full->ready = true;
+
+    VIDEO_ENCODE_JOB jobs[UTOX_MAX_CALLS];
+    uint8_t workers[UTOX_MAX_CALLS];
+    size_t job_count = 0;
+    for (size_t i = 0; i < due_count; ++i) {
+        const VIDEO_SCALED *scaled = video_frame_scaled(frame, due[i].scale);
+        if (scaled) {
+            workers[job_count] = due[i].worker;
+            jobs[job_count++]  = (VIDEO_ENCODE_JOB){
+                .av            = av,
+                .frame         = scaled,
+                .owner         = frame,
+                .friend_number = due[i].friend_number,
+            };
+        }
+    }
+
+    pthread_mutex_lock(&video_encode_lock);
+    frame->pending = job_count;
+    for (size_t i = 0; i < job_count; ++i) {
+        VIDEO_ENCODE_WORKER *w = &video_workers[workers[i]];
+        w->jobs[w->head++ % COUNTOF(w->jobs)] = jobs[i];
+    }
+    pthread_cond_broadcast(&video_encode_job_cond);
+    pthread_mutex_unlock(&video_encode_lock);
+
+    return max_fps;
+}
+
 
 static bool video_device_init(void *handle) {
     // initialize video (will populate video_width and video_height)
@@ -249,6 +625,7 @@ void utox_video_thread(void *args) {
     pthread_mutex_init(&video_thread_lock, NULL);
 
     init_video_devices();
+    video_encode_start();
 
     utox_video_thread_init = 1;
 
@@ -260,6 +637,8 @@ void utox_video_thread(void *args) {
 
             switch (video_msg.msg) {
                 case UTOXVIDEO_NEW_AV_INSTANCE: {
+                    // Nothing can still be encoding for the old instance.
+                    video_encode_drain();
                     av = video_msg.data;
                     init_video_devices();
                     break;
@@ -269,11 +648,17 @@ void utox_video_thread(void *args) {
         }
 
         if (video_active) {
+            uint8_t call_fps = 0;
+
             pthread_mutex_lock(&video_thread_lock);
             // capturing is enabled, capture frames
+            video_frame_time = 0;
+            const uint64_t capture_start = get_time();
             const int r = native_video_getframe(utox_video_frame.y, utox_video_frame.u, utox_video_frame.v,
                                                 utox_video_frame.w, utox_video_frame.h);
             if (r == 1) {
+                call_stats_video_captured(get_time() - capture_start);
+
                 if (settings.video_preview) {
                     /* Make a copy of the video frame for uTox to display */
                     UTOX_FRAME_PKG *frame = malloc(sizeof(UTOX_FRAME_PKG));
@@ -288,39 +673,7 @@ void utox_video_thread(void *args) {
                     postmessage_utox(AV_VIDEO_FRAME, UINT16_MAX, 1, (void *)frame);
                 }
 
-                size_t active_video_count = 0;
-                for (size_t i = 0; i < self.friend_list_count; i++) {
-                    if (SEND_VIDEO_FRAME(i)) {
-                        LOG_TRACE("uToxVideo", "sending video frame to friend %lu" , i);
-                        active_video_count++;
-                        TOXAV_ERR_SEND_FRAME error = 0;
-
-                        FRIEND *f = get_friend(i);
-                        if (!f) {
-                            LOG_ERR("uToxVideo", "Could not get friend to send him video frame %lu", i);
-                            continue;
-                        }
-
-                        toxav_video_send_frame(av, f->number, utox_video_frame.w, utox_video_frame.h,
-                                               utox_video_frame.y, utox_video_frame.u, utox_video_frame.v, &error);
-                        // LOG_TRACE("uToxVideo", "Sent video frame to friend %u" , i);
-                        if (error) {
-                            if (error == TOXAV_ERR_SEND_FRAME_SYNC) {
-                                LOG_ERR("uToxVideo", "Vid Frame sync error: w=%u h=%u", utox_video_frame.w, utox_video_frame.h);
-                            } else if (error == TOXAV_ERR_SEND_FRAME_PAYLOAD_TYPE_DISABLED) {
-                                LOG_ERR("uToxVideo", "ToxAV disagrees with our AV state for friend %lu, self %u, friend %u",
-                                        i, f->call_state_self, f->call_state_friend);
-                            } else {
-                                LOG_ERR("uToxVideo", "toxav_send_video error friend: %i error: %u", f->number, error);
-                            }
-                        } else {
-                            if (active_video_count >= UTOX_MAX_CALLS) {
-                                LOG_ERR("uToxVideo", "Trying to send video frame to too many peers. Please report this bug!");
-                                break;
-                            }
-                        }
-                    }
-                }
+                call_fps = video_send_frame(av);
             } else if (r == -1) {
                 LOG_ERR("uToxVideo", "Err... something really bad happened trying to get this frame, I'm just going "
                             "to plots now!");
@@ -329,7 +682,10 @@ void utox_video_thread(void *args) {
             }
 
             pthread_mutex_unlock(&video_thread_lock);
-            yieldcpu(1000 / settings.video_fps); /* 60fps = 16.666ms || 25 fps = 40ms || the data quality is SO much better at 25... */
+
+            /* Capture only as fast as the fastest call is paced, the preview gets the full rate. */
+            const uint8_t fps = settings.video_preview || !call_fps ? settings.video_fps : call_fps;
+            yieldcpu(1000 / fps); /* 60fps = 16.666ms || 25 fps = 40ms || the data quality is SO much better at 25... */
             continue;     /* We're running video, so don't sleep for an extra 100 ms */
         }
 
@@ -344,6 +700,8 @@ void utox_video_thread(void *args) {
         video_device[i] = NULL;
     }
 
+    video_encode_stop();
+
     video_thread_msg       = 0;
     utox_video_thread_init = 0;
     LOG_TRACE("uToxVideo", "Clean thread exit!");
@@ -371,27 +729,42 @@ void yuv420tobgr(uint16_t width, uint16_t height, const uint8_t *y, const uint8_
     }
 }
 
-void yuv422to420(uint8_t *plane_y, uint8_t *plane_u, uint8_t *plane_v, uint8_t *input, uint16_t width, uint16_t height) {
-    const uint8_t *end = input + width * height * 2;
-    while (input != end) {
-        uint8_t *line_end = input + width * 2;
-        while (input != line_end) {
-            *plane_y++ = *input++;
-            *plane_v++ = *input++;
-            *plane_y++ = *input++;
-            *plane_u++ = *input++;
-        }
+static void plane_downscale(const uint8_t *old, uint16_t old_width, uint16_t old_height, uint8_t *new,
+                            uint16_t new_width, uint16_t new_height) {
+    for (uint16_t y = 0; y < new_height; ++y) {
+        const uint32_t y0 = y * old_height / new_height;
+        const uint32_t y1 = MAX((uint32_t)(y + 1) * old_height / new_height, y0 + 1);
+
+        for (uint16_t x = 0; x < new_width; ++x) {
+            const uint32_t x0 = x * old_width / new_width;
+            const uint32_t x1 = MAX((uint32_t)(x + 1) * old_width / new_width, x0 + 1);
+
+            uint32_t sum = 0;
+            for (uint32_t i = y0; i < y1; ++i) {
+                for (uint32_t j = x0; j < x1; ++j) {
+                    sum += old[i * old_width + j];
+                }
+            }
 
-        line_end = input + width * 2;
-        while (input != line_end) {
-            *plane_y++ = *input++;
-            input++; // u
-            *plane_y++ = *input++;
-            input++; // v
+            const uint32_t count = (y1 - y0) * (x1 - x0);
+            new[y * new_width + x] = (sum + count / 2) / count;
         }
     }
 }
 
+void yuv420_downscale(const uint8_t *old_y, const uint8_t *old_u, const uint8_t *old_v, uint16_t old_width,
+                      uint16_t old_height, uint8_t *new_y, uint8_t *new_u, uint8_t *new_v, uint16_t new_width,
+                      uint16_t new_height) {
+    plane_downscale(old_y, old_width, old_height, new_y, new_width, new_height);
+    plane_downscale(old_u, old_width / 2, old_height / 2, new_u, new_width / 2, new_height / 2);
+    plane_downscale(old_v, old_width / 2, old_height / 2, new_v, new_width / 2, new_height / 2);
+}
+
+void yuv422to420(uint8_t *plane_y, uint8_t *plane_u, uint8_t *plane_v, const uint8_t *input, uint16_t width,
+                 uint16_t height) {
+    yuyv_to_i420(plane_y, plane_u, plane_v, input, width * 2, width, height);
+}
+
 static uint8_t rgb_to_y(int r, int g, int b) {
     const int y = ((9798 * r + 19235 * g + 3736 * b) >> 15);
     return y > 255 ? 255 : y < 0 ? 0 : y;
@@ -447,47 +820,35 @@ void bgrtoyuv420(uint8_t *plane_y, uint8_t *plane_u, uint8_t *plane_v, uint8_t *
 }
 
 void bgrxtoyuv420(uint8_t *plane_y, uint8_t *plane_u, uint8_t *plane_v, uint8_t *rgb, uint16_t width, uint16_t height) {
-    uint8_t *p;
-    uint8_t  r, g, b;
-
-    for (uint16_t y = 0; y != height; y += 2) {
-        p = rgb;
-        for (uint16_t x = 0; x != width; x++) {
-            b = *rgb++;
-            g = *rgb++;
-            r = *rgb++;
-            rgb++;
-
-            *plane_y++ = rgb_to_y(r, g, b);
-        }
+    bgrxtoyuv420_rect(plane_y, plane_u, plane_v, width, rgb, width * 4, 0, 0, width, height);
+}
 
-        for (uint16_t x = 0; x != width / 2; x++) {
-            b = *rgb++;
-            g = *rgb++;
-            r = *rgb++;
-            rgb++;
+void bgrxtoyuv420_rect(uint8_t *plane_y, uint8_t *plane_u, uint8_t *plane_v, uint16_t width, const uint8_t *rgb,
+                       uint32_t stride, uint16_t x, uint16_t y, uint16_t rect_width, uint16_t rect_height) {
+    for (uint16_t row = 0; row < rect_height; row += 2) {
+        const uint8_t *in0 = rgb + (size_t)row * stride;
+        const uint8_t *in1 = in0 + stride;
 
-            *plane_y++ = rgb_to_y(r, g, b);
+        uint8_t *y0 = plane_y + (size_t)(y + row) * width + x;
+        uint8_t *y1 = y0 + width;
+        uint8_t *u  = plane_u + (size_t)((y + row) / 2) * (width / 2) + x / 2;
+        uint8_t *v  = plane_v + (size_t)((y + row) / 2) * (width / 2) + x / 2;
 
-            b = *rgb++;
-            g = *rgb++;
-            r = *rgb++;
-            rgb++;
+        for (uint16_t col = 0; col < rect_width; col += 2) {
+            const uint8_t *a = in0 + col * 4, *b = a + 4;
+            const uint8_t *c = in1 + col * 4, *d = c + 4;
 
-            *plane_y++ = rgb_to_y(r, g, b);
+            y0[col]     = rgb_to_y(a[2], a[1], a[0]);
+            y0[col + 1] = rgb_to_y(b[2], b[1], b[0]);
+            y1[col]     = rgb_to_y(c[2], c[1], c[0]);
+            y1[col + 1] = rgb_to_y(d[2], d[1], d[0]);
 
-            b = ((int)b + (int)*(rgb - 8) + (int)*p + (int)*(p + 4) + 2) / 4;
-            p++;
-            g = ((int)g + (int)*(rgb - 7) + (int)*p + (int)*(p + 4) + 2) / 4;
-            p++;
-            r = ((int)r + (int)*(rgb - 6) + (int)*p + (int)*(p + 4) + 2) / 4;
-            p++;
-            p++;
-
-            *plane_u++ = rgb_to_u(r, g, b);
-            *plane_v++ = rgb_to_v(r, g, b);
+            const int avg_b = (a[0] + b[0] + c[0] + d[0] + 2) / 4;
+            const int avg_g = (a[1] + b[1] + c[1] + d[1] + 2) / 4;
+            const int avg_r = (a[2] + b[2] + c[2] + d[2] + 2) / 4;
 
-            p += 4;
+            u[col / 2] = rgb_to_u(avg_r, avg_g, avg_b);
+            v[col / 2] = rgb_to_v(avg_r, avg_g, avg_b);
         }
     }
 }
@@ -9,6 +9,10 @@ uint16_t video_width, video_height, max_video_width, max_video_height;
 
 extern bool utox_video_thread_init;
 
+/* When the frame native_video_getframe() last returned was captured, in get_time() nanoseconds. Backends that can't
+ * tell leave it at 0. */
+extern uint64_t video_frame_time;
+
 #define UTOX_DEFAULT_BITRATE_V 5000
 #define UTOX_MIN_BITRATE_VIDEO 512
 // UTOX_DEFAULT_VID_WIDTH, HEIGHT are unused.
@@ -35,6 +39,8 @@ typedef struct utox_frame_pkg {
     size_t size;
 
     void *img;
+
+    uint64_t decoded; // get_time() when a friend's frame came out of the decoder
 } UTOX_FRAME_PKG;
 
 void utox_video_append_device(void *device, bool localized, void *name, bool default_);
@@ -46,6 +52,24 @@ bool utox_video_stop(bool preview);
 
 void utox_video_thread(void *args);
 
+/* What we're currently sending to a friend, as picked by the video pacer. */
+typedef struct {
+    uint16_t width, height;
+    uint8_t  fps;
+    uint32_t bitrate; // kbit/s
+    uint32_t frames_sent, frames_skipped, send_errors;
+} UTOX_VIDEO_SEND_STATS;
+
+/* Adds friend_number to the calls we send video to, or drops it, depending on SEND_VIDEO_FRAME(). Has to be called
+ * whenever either side's call state changes. */
+void utox_video_call_update(uint32_t friend_number);
+
+/* Passes a bitrate suggestion from toxav (kbit/s) on to the friend's video pacer. */
+void utox_video_rate_change(uint32_t friend_number, uint32_t bitrate);
+
+/* Fills stats and returns true if we're sending video to friend_number. */
+bool utox_video_send_stats(uint32_t friend_number, UTOX_VIDEO_SEND_STATS *stats);
+
 void postmessage_video(uint8_t msg, uint32_t param1, uint32_t param2, void *data);
 
 
@@ -53,9 +77,19 @@ void postmessage_video(uint8_t msg, uint32_t param1, uint32_t param2, void *data
 
 void yuv420tobgr(uint16_t width, uint16_t height, const uint8_t *y, const uint8_t *u, const uint8_t *v,
                  unsigned int ystride, unsigned int ustride, unsigned int vstride, uint8_t *out);
-void yuv422to420(uint8_t *plane_y, uint8_t *plane_u, uint8_t *plane_v, uint8_t *input, uint16_t width, uint16_t height);
+void yuv422to420(uint8_t *plane_y, uint8_t *plane_u, uint8_t *plane_v, const uint8_t *input, uint16_t width,
+                 uint16_t height);
 void bgrtoyuv420(uint8_t *plane_y, uint8_t *plane_u, uint8_t *plane_v, uint8_t *rgb, uint16_t width, uint16_t height);
 void bgrxtoyuv420(uint8_t *plane_y, uint8_t *plane_u, uint8_t *plane_v, uint8_t *rgb, uint16_t width, uint16_t height);
+/* Converts the rect_width x rect_height BGRX image in rgb into the I420 frame (width wide) at x, y. Everything has to be
+ * even. */
+void bgrxtoyuv420_rect(uint8_t *plane_y, uint8_t *plane_u, uint8_t *plane_v, uint16_t width, const uint8_t *rgb,
+                       uint32_t stride, uint16_t x, uint16_t y, uint16_t rect_width, uint16_t rect_height);
+
+/* Box filtered downscale of a packed I420 frame. new_width and new_height can't be larger than the old ones. */
+void yuv420_downscale(const uint8_t *old_y, const uint8_t *old_u, const uint8_t *old_v, uint16_t old_width,
+                      uint16_t old_height, uint8_t *new_y, uint8_t *new_u, uint8_t *new_v, uint16_t new_width,
+                      uint16_t new_height);
 
 // TODO: Documentation.
 void scale_rgbx_image(uint8_t *old_rgbx, uint16_t old_width, uint16_t old_height, uint8_t *new_rgbx, uint16_t new_width,
@@ -0,0 +1,133 @@
+#include "video_convert.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/* Converts one pair of YUYV rows starting at pixel x, returns the first pixel it didn't get to. */
+static uint16_t yuyv_rows_simd(uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, const uint8_t *row0,
+                               const uint8_t *row1, uint16_t width) {
+    uint16_t x = 0;
+
+#if defined(__SSE2__)
+    const __m128i low = _mm_set1_epi16(0x00FF);
+    for (; x + 16 <= width; x += 16) {
+        const __m128i a0 = _mm_loadu_si128((const __m128i *)(row0 + x * 2));
+        const __m128i b0 = _mm_loadu_si128((const __m128i *)(row0 + x * 2 + 16));
+        const __m128i a1 = _mm_loadu_si128((const __m128i *)(row1 + x * 2));
+        const __m128i b1 = _mm_loadu_si128((const __m128i *)(row1 + x * 2 + 16));
+
+        // Luma is every even byte.
+        _mm_storeu_si128((__m128i *)(y0 + x), _mm_packus_epi16(_mm_and_si128(a0, low), _mm_and_si128(b0, low)));
+        _mm_storeu_si128((__m128i *)(y1 + x), _mm_packus_epi16(_mm_and_si128(a1, low), _mm_and_si128(b1, low)));
+
+        // Chroma is every odd byte, U V U V..., averaged over both rows.
+        const __m128i uv0 = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(b0, 8));
+        const __m128i uv1 = _mm_packus_epi16(_mm_srli_epi16(a1, 8), _mm_srli_epi16(b1, 8));
+        const __m128i uv  = _mm_avg_epu8(uv0, uv1);
+
+        const __m128i us = _mm_and_si128(uv, low);
+        const __m128i vs = _mm_srli_epi16(uv, 8);
+        _mm_storel_epi64((__m128i *)(u + x / 2), _mm_packus_epi16(us, us));
+        _mm_storel_epi64((__m128i *)(v + x / 2), _mm_packus_epi16(vs, vs));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; x + 32 <= width; x += 32) {
+        const uint8x16x4_t a = vld4q_u8(row0 + x * 2);
+        const uint8x16x4_t b = vld4q_u8(row1 + x * 2);
+
+        vst2q_u8(y0 + x, (uint8x16x2_t){ { a.val[0], a.val[2] } });
+        vst2q_u8(y1 + x, (uint8x16x2_t){ { b.val[0], b.val[2] } });
+        vst1q_u8(u + x / 2, vrhaddq_u8(a.val[1], b.val[1]));
+        vst1q_u8(v + x / 2, vrhaddq_u8(a.val[3], b.val[3]));
+    }
+#else
+    (void)y0, (void)y1, (void)u, (void)v, (void)row0, (void)row1, (void)width;
+#endif
+
+    return x;
+}
+
+void yuyv_to_i420(uint8_t *y, uint8_t *u, uint8_t *v, const uint8_t *in, uint32_t stride, uint16_t width,
+                  uint16_t height) {
+    const uint16_t chroma_width = width / 2;
+
+    for (uint16_t r = 0; r < height; r += 2) {
+        const uint8_t *row0 = in + (size_t)r * stride;
+        // An odd last row is its own pair.
+        const uint8_t *row1 = r + 1 < height ? row0 + stride : row0;
+        uint8_t *y0 = y + (size_t)r * width;
+        uint8_t *y1 = r + 1 < height ? y0 + width : y0;
+        uint8_t *ur = u + (size_t)(r / 2) * chroma_width;
+        uint8_t *vr = v + (size_t)(r / 2) * chroma_width;
+
+        uint16_t x = yuyv_rows_simd(y0, y1, ur, vr, row0, row1, width);
+        for (; x + 1 < width; x += 2) {
+            const uint8_t *p0 = row0 + x * 2, *p1 = row1 + x * 2;
+            y0[x]     = p0[0];
+            y0[x + 1] = p0[2];
+            y1[x]     = p1[0];
+            y1[x + 1] = p1[2];
+            ur[x / 2] = (p0[1] + p1[1] + 1) >> 1;
+            vr[x / 2] = (p0[3] + p1[3] + 1) >> 1;
+        }
+    }
+}
+
+void nv12_to_i420(uint8_t *y, uint8_t *u, uint8_t *v, const uint8_t *in_y, uint32_t y_stride, const uint8_t *in_uv,
+                  uint32_t uv_stride, uint16_t width, uint16_t height) {
+    for (uint16_t r = 0; r < height; ++r) {
+        memcpy(y + (size_t)r * width, in_y + (size_t)r * y_stride, width);
+    }
+
+    const uint16_t chroma_width = width / 2;
+    for (uint16_t r = 0; r < height / 2; ++r) {
+        const uint8_t *uv = in_uv + (size_t)r * uv_stride;
+        uint8_t *ur = u + (size_t)r * chroma_width;
+        uint8_t *vr = v + (size_t)r * chroma_width;
+        uint16_t x = 0;
+
+#if defined(__SSE2__)
+        const __m128i low = _mm_set1_epi16(0x00FF);
+        for (; x + 16 <= chroma_width; x += 16) {
+            const __m128i a = _mm_loadu_si128((const __m128i *)(uv + x * 2));
+            const __m128i b = _mm_loadu_si128((const __m128i *)(uv + x * 2 + 16));
+            _mm_storeu_si128((__m128i *)(ur + x), _mm_packus_epi16(_mm_and_si128(a, low), _mm_and_si128(b, low)));
+            _mm_storeu_si128((__m128i *)(vr + x), _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+        }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        for (; x + 16 <= chroma_width; x += 16) {
+            const uint8x16x2_t a = vld2q_u8(uv + x * 2);
+            vst1q_u8(ur + x, a.val[0]);
+            vst1q_u8(vr + x, a.val[1]);
+        }
+#endif
+
+        for (; x < chroma_width; ++x) {
+            ur[x] = uv[x * 2];
+            vr[x] = uv[x * 2 + 1];
+        }
+    }
+}
+
+void i420_copy(uint8_t *y, uint8_t *u, uint8_t *v, const uint8_t *in_y, const uint8_t *in_u, const uint8_t *in_v,
+               uint32_t y_stride, uint16_t width, uint16_t height) {
+    if (y_stride == width) {
+        memcpy(y, in_y, (size_t)width * height);
+        memcpy(u, in_u, (size_t)(width / 2) * (height / 2));
+        memcpy(v, in_v, (size_t)(width / 2) * (height / 2));
+        return;
+    }
+
+    for (uint16_t r = 0; r < height; ++r) {
+        memcpy(y + (size_t)r * width, in_y + (size_t)r * y_stride, width);
+    }
+    for (uint16_t r = 0; r < height / 2; ++r) {
+        memcpy(u + (size_t)r * (width / 2), in_u + (size_t)r * (y_stride / 2), width / 2);
+        memcpy(v + (size_t)r * (width / 2), in_v + (size_t)r * (y_stride / 2), width / 2);
+    }
+}
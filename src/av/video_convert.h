@@ -0,0 +1,22 @@
+#ifndef VIDEO_CONVERT_H
+#define VIDEO_CONVERT_H
+
+#include <stdint.h>
+
+/* Conversions from the formats cameras hand us to the packed I420 ToxAV wants (a width x height Y plane followed by
+ * width/2 x height/2 U and V planes). The input strides are in bytes, so padded driver buffers can be read in place.
+ * Chroma is averaged over each pair of rows. Uses SSE2/NEON where available. */
+
+/* Packed 4:2:2, Y0 U Y1 V. */
+void yuyv_to_i420(uint8_t *y, uint8_t *u, uint8_t *v, const uint8_t *in, uint32_t stride, uint16_t width,
+                  uint16_t height);
+
+/* A Y plane followed by a plane of interleaved U and V at half resolution. */
+void nv12_to_i420(uint8_t *y, uint8_t *u, uint8_t *v, const uint8_t *in_y, uint32_t y_stride, const uint8_t *in_uv,
+                  uint32_t uv_stride, uint16_t width, uint16_t height);
+
+/* Planar I420 with padded rows, U and V rows are y_stride / 2 apart. */
+void i420_copy(uint8_t *y, uint8_t *u, uint8_t *v, const uint8_t *in_y, const uint8_t *in_u, const uint8_t *in_v,
+               uint32_t y_stride, uint16_t width, uint16_t height);
+
+#endif
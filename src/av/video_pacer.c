@@ -0,0 +1,105 @@
+#include "video_pacer.h"
+
+static const uint8_t scales[VIDEO_PACER_SCALE_COUNT] = VIDEO_PACER_SCALES;
+
+void video_pacer_init(VIDEO_PACER *p, uint32_t bitrate) {
+    *p = (VIDEO_PACER){ 0 };
+    video_pacer_set_bitrate(p, bitrate);
+}
+
+void video_pacer_set_bitrate(VIDEO_PACER *p, uint32_t bitrate) {
+    p->bitrate = bitrate < VIDEO_PACER_MIN_BITRATE ? VIDEO_PACER_MIN_BITRATE : bitrate;
+}
+
+void video_pacer_send_error(VIDEO_PACER *p) {
+    p->send_errors++;
+    video_pacer_set_bitrate(p, p->bitrate * 3 / 4);
+}
+
+void video_pacer_scaled_size(uint8_t scale, uint16_t src_width, uint16_t src_height, uint16_t *width,
+                             uint16_t *height) {
+    *width  = (src_width * scales[scale] / 8) & ~1;
+    *height = (src_height * scales[scale] / 8) & ~1;
+
+    // The encoder won't take anything smaller than a macroblock.
+    if (*width < 16 || *height < 16) {
+        *width  = src_width & ~1;
+        *height = src_height & ~1;
+    }
+}
+
+static uint32_t affordable_fps(uint32_t bitrate, uint16_t width, uint16_t height) {
+    const uint64_t millibits_per_frame = (uint64_t)width * height * VIDEO_PACER_MILLIBITS_PER_PIXEL;
+    return millibits_per_frame ? (uint64_t)bitrate * 1000 * 1000 / millibits_per_frame : 0;
+}
+
+bool video_pacer_update(VIDEO_PACER *p, uint16_t src_width, uint16_t src_height, uint8_t max_fps, uint64_t now) {
+    if (!max_fps) {
+        max_fps = 1;
+    }
+    const uint8_t preferred = max_fps < VIDEO_PACER_PREFERRED_FPS ? max_fps : VIDEO_PACER_PREFERRED_FPS;
+
+    uint8_t  scale = 0;
+    uint16_t width = 0, height = 0;
+    uint32_t fps   = 0;
+    for (; scale < VIDEO_PACER_SCALE_COUNT; ++scale) {
+        video_pacer_scaled_size(scale, src_width, src_height, &width, &height);
+        fps = affordable_fps(p->bitrate, width, height);
+        if (fps >= preferred || scale == VIDEO_PACER_SCALE_COUNT - 1) {
+            break;
+        }
+    }
+
+    if (fps < VIDEO_PACER_MIN_FPS) {
+        fps = VIDEO_PACER_MIN_FPS;
+    }
+    if (fps > max_fps) {
+        fps = max_fps;
+    }
+
+    if (scale == p->scale && width == p->width && height == p->height && fps == p->fps) {
+        return false;
+    }
+
+    const bool cheaper = (uint64_t)width * height * fps < (uint64_t)p->width * p->height * p->fps;
+
+    // The captured size changed under us (or this is the first frame), the old point means nothing any more.
+    uint16_t old_width, old_height;
+    video_pacer_scaled_size(p->scale, src_width, src_height, &old_width, &old_height);
+    const bool new_source = !p->fps || old_width != p->width || old_height != p->height;
+
+    if (!new_source && !cheaper && now - p->last_change < (uint64_t)VIDEO_PACER_HOLD_MS * 1000 * 1000) {
+        return false;
+    }
+
+    p->scale       = scale;
+    p->width       = width;
+    p->height      = height;
+    p->fps         = fps;
+    p->last_change = now;
+    return true;
+}
+
+bool video_pacer_due(VIDEO_PACER *p, uint64_t now, uint64_t captured) {
+    const uint64_t interval = 1000 * 1000 * 1000 / (p->fps ? p->fps : 1);
+
+    // It sat in a driver queue for too long, a fresher one is on its way.
+    if (captured < now && now - captured > interval * VIDEO_PACER_STALE_INTERVALS) {
+        p->frames_skipped++;
+        return false;
+    }
+
+    // Frames don't come in exactly on time, take one that's at most a quarter of an interval early.
+    if (now + interval / 4 < p->next_frame) {
+        p->frames_skipped++;
+        return false;
+    }
+
+    p->next_frame += interval;
+    if (p->next_frame + interval < now || p->next_frame > now + interval * 2) {
+        // We fell way behind (or started), don't try to catch up with a burst.
+        p->next_frame = now + interval;
+    }
+
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef VIDEO_PACER_H
+#define VIDEO_PACER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Picks the frame rate and resolution we send video to one friend at.
+ *
+ * ToxAV tells us how many kbit/s a call can take through its bitrate callbacks. The pacer spends that budget at
+ * roughly VIDEO_PACER_MILLIBITS_PER_PIXEL per pixel per frame: it keeps the full resolution as long as that still
+ * leaves VIDEO_PACER_PREFERRED_FPS, and otherwise walks down a ladder of smaller sizes. Send errors cut the budget
+ * until toxav suggests a new one. Dropping to a cheaper operating point happens right away, going back up waits
+ * VIDEO_PACER_HOLD_MS so a noisy link doesn't make the picture pump. */
+
+/* Bits per pixel per frame (in thousandths) VP8 needs to look reasonable. */
+#define VIDEO_PACER_MILLIBITS_PER_PIXEL 100
+
+#define VIDEO_PACER_MIN_FPS 5
+#define VIDEO_PACER_PREFERRED_FPS 15
+
+/* Budget a call never drops under, in kbit/s. */
+#define VIDEO_PACER_MIN_BITRATE 100
+
+#define VIDEO_PACER_HOLD_MS 2000
+
+/* A frame captured more than this many intervals ago is dropped rather than sent late. */
+#define VIDEO_PACER_STALE_INTERVALS 2
+
+/* Resolutions we scale down to, in eighths of the captured size. */
+#define VIDEO_PACER_SCALES { 8, 6, 4, 3, 2 }
+#define VIDEO_PACER_SCALE_COUNT 5
+
+typedef struct {
+    uint32_t bitrate; // kbit/s we're allowed to send
+
+    /* The operating point. */
+    uint8_t  scale; // Index into VIDEO_PACER_SCALES
+    uint16_t width, height;
+    uint8_t  fps;
+
+    uint64_t next_frame;  // Time the next frame is due, in ns
+    uint64_t last_change; // Time the operating point last changed
+
+    uint32_t frames_sent, frames_skipped, send_errors; // frames_sent is kept by the caller
+} VIDEO_PACER;
+
+void video_pacer_init(VIDEO_PACER *p, uint32_t bitrate);
+
+/* A new bitrate suggestion from toxav. */
+void video_pacer_set_bitrate(VIDEO_PACER *p, uint32_t bitrate);
+
+/* Sending a frame failed, back off. */
+void video_pacer_send_error(VIDEO_PACER *p);
+
+/* Re-picks the operating point for frames captured at src_width x src_height, sending at most max_fps.
+ * Returns true if it changed. */
+bool video_pacer_update(VIDEO_PACER *p, uint16_t src_width, uint16_t src_height, uint8_t max_fps, uint64_t now);
+
+/* Whether a frame captured at captured should be sent at now. Counts it as skipped if not. */
+bool video_pacer_due(VIDEO_PACER *p, uint64_t now, uint64_t captured);
+
+/* Size of src_width x src_height at VIDEO_PACER_SCALES[scale], rounded down to even. */
+void video_pacer_scaled_size(uint8_t scale, uint16_t src_width, uint16_t src_height, uint16_t *width,
+                             uint16_t *height);
+
+#endif
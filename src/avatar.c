@@ -132,19 +132,27 @@ bool avatar_set(AVATAR *avatar, const uint8_t *data, size_t size) {
         return false;
     }
 
-    avatar_free_image(avatar);
-    NATIVE_IMAGE *image = utox_image_to_native((UTOX_IMAGE)data, size, &avatar->width, &avatar->height, true);
+    uint16_t width, height;
+    NATIVE_IMAGE *image = utox_image_to_native((UTOX_IMAGE)data, size, &width, &height, true);
     if (!NATIVE_IMAGE_IS_VALID(image)) {
         LOG_DEBUG("Avatar", "avatar is invalid");
         return false;
     }
 
+    avatar_set_image(avatar, image, width, height, data, size);
+    return true;
+}
+
+void avatar_set_image(AVATAR *avatar, NATIVE_IMAGE *image, uint16_t width, uint16_t height, const uint8_t *data,
+                      size_t size) {
+    avatar_free_image(avatar);
+
     avatar->img    = image;
+    avatar->width  = width;
+    avatar->height = height;
     avatar->format = UTOX_AVATAR_FORMAT_PNG;
     avatar->size   = size;
     tox_hash(avatar->hash, data, size);
-
-    return true;
 }
 
 /* sets self avatar, see self_set_and_save_avatar */
@@ -50,6 +50,10 @@ bool avatar_init(char hexid[TOX_PUBLIC_KEY_SIZE * 2], AVATAR *avatar);
  */
 bool avatar_set(AVATAR *avatar, const uint8_t *data, size_t size);
 
+/* Same as avatar_set for a PNG that's already been converted (see image_decode.h). Takes ownership of image. */
+void avatar_set_image(AVATAR *avatar, NATIVE_IMAGE *image, uint16_t width, uint16_t height, const uint8_t *data,
+                      size_t size);
+
 /* Helper function to set the user's avatar. */
 bool avatar_set_self(const uint8_t *data, size_t size);
 
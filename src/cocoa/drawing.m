@@ -383,9 +383,10 @@ void setscale(void) {
 
     for (int i = 0; i < (sizeof(bitmaps) / sizeof(CGImageRef)); ++i) {
         RELEASE_CHK(CGImageRelease, bitmaps[i]);
+        bitmaps[i] = NULL;
     }
 
-    svg_draw(1);
+    svg_draw();
     // now we have 2x images, if applicable
     ui_scale = old_scale;
 
@@ -399,6 +400,8 @@ void cgdataprovider_is_finished(void *info, const void *data, size_t size) {
 void drawalpha(int bm, int x, int y, int width, int height, uint32_t color) {
     DRAW_TARGET_CHK()
 
+    svg_load(bm);
+
     [NSGraphicsContext saveGraphicsState];
 
     CGFloat sz   = currently_drawing_into_view.frame.size.height;
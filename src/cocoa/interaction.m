@@ -620,7 +620,7 @@ static inline void select_right_to_char(char c) {
     }
 
     edit_setselectedrange(replacementRange.location, replacementRange.length);
-    uint16_t insl = [aString lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    uint32_t insl = [aString lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
     edit_paste((char *)[aString UTF8String], insl, 0);
 
     [self unmarkText];
@@ -635,7 +635,7 @@ static inline void select_right_to_char(char c) {
 }
 
 - (NSRange)markedRange {
-    uint16_t loc, len;
+    uint32_t loc, len;
     BOOL     valid = edit_getmark(&loc, &len);
     if (!valid) {
         return (NSRange){ NSNotFound, 0 };
@@ -658,13 +658,13 @@ static inline void select_right_to_char(char c) {
 
 - (void)setMarkedText:(id)aString selectedRange:(NSRange)selectedRange replacementRange:(NSRange)replacementRange {
     NSLog(@"%@", NSStringFromRange(replacementRange));
-    uint16_t loc, len;
+    uint32_t loc, len;
     BOOL     valid;
     if ((valid = edit_getmark(&loc, &len)) && replacementRange.location != NSNotFound) {
         replacementRange.location += loc;
     } else if (valid) {
         replacementRange = NSMakeRange(loc, len);
-        NSLog(@"valid=1 replace %d %d", loc, len);
+        NSLog(@"valid=1 replace %u %u", loc, len);
     } else {
         replacementRange = NSMakeRange(edit_getcursorpos(), edit_selection(edit_get_active(), NULL, 0));
     }
@@ -674,7 +674,7 @@ static inline void select_right_to_char(char c) {
     }
 
     edit_setselectedrange(replacementRange.location, replacementRange.length);
-    uint16_t insl = [aString lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    uint32_t insl = [aString lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
     if (!insl) {
         edit_char(KEY_DEL, YES, 0);
     } else {
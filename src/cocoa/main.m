@@ -4,6 +4,7 @@
 #include "../debug.h"
 #include "../filesys.h"
 #include "../flist.h"
+#include "../macros.h"
 #include "../main.h"
 #include "../settings.h"
 #include "../theme.h"
@@ -61,6 +62,30 @@ NATIVE_IMAGE *utox_image_to_native(const UTOX_IMAGE data, size_t size, uint16_t
     }
 }
 
+static void rgba_release(void *info, const void *data, size_t size) {
+    free((void *)data);
+}
+
+NATIVE_IMAGE *utox_rgba_to_native(uint8_t *rgba_data, uint16_t width, uint16_t height, bool keep_alpha) {
+    CGDataProviderRef src = CGDataProviderCreateWithData(NULL, rgba_data, width * height * 4, rgba_release);
+    CGColorSpaceRef   rgb = CGColorSpaceCreateDeviceRGB();
+    CGImageRef underlying_img =
+        CGImageCreate(width, height, 8, 32, width * 4, rgb,
+                      keep_alpha ? kCGImageAlphaLast : kCGImageAlphaNoneSkipLast, src, NULL, YES,
+                      kCGRenderingIntentDefault);
+    CGColorSpaceRelease(rgb);
+    CGDataProviderRelease(src);
+
+    if (!underlying_img) {
+        return NULL;
+    }
+
+    NATIVE_IMAGE *ret = malloc(sizeof(NATIVE_IMAGE));
+    ret->scale        = 1.0;
+    ret->image        = underlying_img;
+    return ret;
+}
+
 void image_set_filter(NATIVE_IMAGE *image, uint8_t filter) {}
 
 void image_set_scale(NATIVE_IMAGE *image, double scale) {
@@ -261,6 +286,16 @@ void redraw(void) {
     [ad soilWindowContents];
 }
 
+void redraw_rect(int UNUSED(x), int UNUSED(y), int UNUSED(width), int UNUSED(height)) {
+    redraw();
+}
+
+#ifdef ENABLE_DEVELOPER_COMMANDS
+bool redraw_benchmark(uint16_t UNUSED(frames), uint64_t *UNUSED(frame_ns), uint32_t *UNUSED(requests)) {
+    return false;
+}
+#endif
+
 void openurl(char *str) {
     if (try_open_tox_uri(str)) {
         redraw();
@@ -1,11 +1,20 @@
 #include "command_funcs.h"
 
+#include "filesys.h"
+#include "flist.h"
 #include "friend.h"
 #include "groups.h"
 #include "debug.h"
+#include "messages.h"
 #include "tox.h"
 #include "macros.h"
+#include "ui.h"
 
+#include "av/call_stats.h"
+
+#include "native/ui.h"
+
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -70,3 +79,61 @@ bool slash_topic(void *object, char *arg, int arg_length) {
     LOG_ERR("slash_topic", " Could not allocate memory.");
     return false;
 }
+
+bool slash_callstats(void *UNUSED(object), char *UNUSED(arg), int UNUSED(arg_length)) {
+    FRIEND *f = flist_get_friend();
+    if (!f) {
+        return false;
+    }
+
+    char notice[256];
+    int  length;
+
+    CALL_STATS_SAMPLE latest;
+    if (!call_stats_latest(f->number, &latest)) {
+        length = snprintf(notice, sizeof(notice), "%s", S(CALL_STATS_NONE));
+        message_add_type_notice(&f->msg, notice, MIN(length, (int)sizeof(notice) - 1), false);
+        return true;
+    }
+
+    char name[sizeof("callstats/") + TOX_PUBLIC_KEY_SIZE * 2 + sizeof(".csv")];
+    snprintf(name, sizeof(name), "callstats/%.*s.csv", TOX_PUBLIC_KEY_SIZE * 2, f->id_str);
+
+    FILE *fp = utox_get_file(name, NULL, UTOX_FILE_OPTS_WRITE | UTOX_FILE_OPTS_MKDIR);
+    if (!fp) {
+        LOG_ERR("slash_callstats", "Could not open %s", name);
+        return false;
+    }
+
+    call_stats_write_csv(f->number, fp);
+    fclose(fp);
+
+    length = snprintf(notice, sizeof(notice), S(CALL_STATS_SAVED), name);
+    message_add_type_notice(&f->msg, notice, MIN(length, (int)sizeof(notice) - 1), false);
+    return true;
+}
+
+#ifdef ENABLE_DEVELOPER_COMMANDS
+#define DRAWBENCH_FRAMES 100
+
+bool slash_drawbench(void *UNUSED(object), char *UNUSED(arg), int UNUSED(arg_length)) {
+    FRIEND *f = flist_get_friend();
+    if (!f) {
+        return false;
+    }
+
+    char notice[256];
+    int  length;
+
+    uint64_t frame_ns;
+    uint32_t requests;
+    if (redraw_benchmark(DRAWBENCH_FRAMES, &frame_ns, &requests)) {
+        length = snprintf(notice, sizeof(notice), S(DRAW_BENCHMARK), DRAWBENCH_FRAMES, frame_ns / 1e6, requests);
+    } else {
+        length = snprintf(notice, sizeof(notice), "%s", S(DRAW_BENCHMARK_UNSUPPORTED));
+    }
+
+    message_add_type_notice(&f->msg, notice, MIN(length, (int)sizeof(notice) - 1), false);
+    return true;
+}
+#endif
@@ -31,4 +31,16 @@ bool slash_invite(void *f, char *arg, int arg_length);
  */
 bool slash_topic(void *object, char *arg, int arg_length);
 
+/**
+ * Writes the statistics of the call with the current friend to callstats/<public key>.csv
+ */
+bool slash_callstats(void *object, char *arg, int arg_length);
+
+#ifdef ENABLE_DEVELOPER_COMMANDS
+/**
+ * Draws the main window DRAWBENCH_FRAMES times over and tells how long and how many display server requests it took
+ */
+bool slash_drawbench(void *object, char *arg, int arg_length);
+#endif
+
 #endif
@@ -11,12 +11,16 @@
 #include <string.h>
 
 struct Command commands[MAX_NUM_CMDS] = {
-    { "alias",    5, slash_alias     },
-    { "invite",   6, slash_invite    },
-    { "d",        1, slash_device    },
-    { "sendfile", 8, slash_send_file },
-    { "topic",    5, slash_topic     },
-    { NULL,       0, NULL            },
+    { "alias",     5, slash_alias     },
+    { "invite",    6, slash_invite    },
+    { "d",         1, slash_device    },
+    { "sendfile",  8, slash_send_file },
+    { "topic",     5, slash_topic     },
+    { "callstats", 9, slash_callstats },
+#ifdef ENABLE_DEVELOPER_COMMANDS
+    { "drawbench", 9, slash_drawbench },
+#endif
+    { NULL,        0, NULL            },
 };
 
 uint16_t utox_run_command(char *string, uint16_t string_length, char **cmd, char **argument, int trusted) {
@@ -91,7 +95,7 @@ void do_tox_url(uint8_t *url_string, int len) {
 
     // wtf??
     uint8_t  *b = (uint8_t *)edit_add_new_friend_id.data, *a = url_string, *end = url_string + len;
-    uint16_t *l = &edit_add_new_friend_id.length;
+    uint32_t *l = &edit_add_new_friend_id.length;
     *l          = 0;
     while (a != end) {
         switch (*a) {
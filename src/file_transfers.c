@@ -2,6 +2,8 @@
 
 #include "avatar.h"
 #include "friend.h"
+#include "ft_scheduler.h"
+#include "image_decode.h"
 #include "debug.h"
 #include "macros.h"
 #include "self.h"
@@ -23,6 +25,18 @@
 
 #define MAX_INLINE_FILESIZE (1024 * 1024 * 4)
 
+/* Incoming inline images are buffered in memory until this many bytes are in flight across all transfers, anything
+ * past that is spilled to a temp file until it's complete. */
+#define MAX_INLINE_MEMORY (1024 * 1024 * 8)
+
+/* Largest image (in pixels) we'll accept inline. A small PNG can still decode to something huge. */
+#define MAX_INLINE_PIXELS (8192 * 4096)
+
+static size_t inline_memory_used;
+
+// Last transfer_id handed out, 0 is never used.
+static uint32_t inline_transfer_id;
+
 static void fid_to_string(char *dest, uint8_t *src) {
     to_hex(dest, src, TOX_FILE_ID_LENGTH);
 }
@@ -130,6 +144,18 @@ static void calculate_speed(FILE_TRANSFER *file) {
     postmessage_utox(FILE_STATUS_UPDATE, file->status, 0, msg);
 }
 
+/* Tells the UI to take down the placeholder for an inline image that isn't going to arrive. */
+static void inline_image_drop(FILE_TRANSFER *ft) {
+    FILE_TRANSFER *msg = calloc(1, sizeof(FILE_TRANSFER));
+    if (!msg) {
+        LOG_ERR("FileTransfer", "Unable to malloc for internal message. (This is bad!)");
+        return;
+    }
+
+    *msg = *ft;
+    postmessage_utox(FILE_INCOMING_INLINE_DROPPED, 0, 0, msg);
+}
+
 static void ft_decon(uint32_t friend_number, uint32_t file_number) {
     LOG_INFO("FileTransfer", "Cleaning up file transfers! (%u & %u)" , friend_number, file_number);
     FILE_TRANSFER *ft = get_file_transfer(friend_number, file_number);
@@ -147,13 +173,25 @@ static void ft_decon(uint32_t friend_number, uint32_t file_number) {
             get_friend(friend_number)->ft_incoming_active_count--;
         } else {
             get_friend(friend_number)->ft_outgoing_active_count--;
+            ft_sched_remove(friend_number, file_number);
         }
 
         if (ft->name) {
             free(ft->name);
         }
 
+        if (ft->incoming && ft->inline_img && ft->status != FILE_TRANSFER_STATUS_COMPLETED) {
+            inline_image_drop(ft);
+        }
+
         if (ft->in_memory) {
+            if (ft->incoming && ft->inline_img) {
+                inline_memory_used -= ft->target_size;
+                // Completed images are handed to the UI, see FILE_STATUS_UPDATE_DATA.
+                if (ft->status != FILE_TRANSFER_STATUS_COMPLETED) {
+                    free(ft->via.memory);
+                }
+            }
             // free(ft->via.memory)?
         } else if (ft->avatar) {
             // free(ft->via.avatar)?
@@ -528,25 +566,41 @@ static void run_file_remote(FILE_TRANSFER *file) {
     postmessage_utox(FILE_STATUS_UPDATE, file->status, 0, msg);
 }
 
-static void decode_inline_png(uint32_t friend_id, uint8_t *data, uint64_t size) {
-    // TODO: start a new thread and decode the png in it.
-    uint16_t width, height;
-    // TODO: move the decode out of file_transfers.c
-    NATIVE_IMAGE *native_image = utox_image_to_native((UTOX_IMAGE)data, size, &width, &height, 0);
-    if (NATIVE_IMAGE_IS_VALID(native_image)) {
-        uint8_t *msg = malloc(sizeof(uint16_t) * 2 + sizeof(NATIVE_IMAGE *));
-        if (!msg) {
-            LOG_ERR("decode_inline_png", "Unable to malloc for inline data.");
-            free(native_image);
-            return;
-        }
+/* Reads an inline image that was spilled to disk back into memory so it can be decoded and saved like any other. */
+static bool inline_image_load(FILE_TRANSFER *ft) {
+    uint8_t *data = malloc(ft->current_size);
+    if (!data) {
+        LOG_ERR("FileTransfer", "Unable to malloc to load spilled inline image of size %lu", ft->current_size);
+        return false;
+    }
+
+    fseeko(ft->via.file, 0, SEEK_SET);
+    if (fread(data, 1, ft->current_size, ft->via.file) != ft->current_size) {
+        LOG_ERR("FileTransfer", "Unable to read back spilled inline image (%u & %u)", ft->friend_number,
+                ft->file_number);
+        free(data);
+        return false;
+    }
 
-        memcpy(msg, &width, sizeof(uint16_t));
-        memcpy(msg + sizeof(uint16_t), &height, sizeof(uint16_t));
-        memcpy(msg + sizeof(uint16_t) * 2, &native_image, sizeof(NATIVE_IMAGE *));
+    fclose(ft->via.file);
+    ft->via.memory = data;
+    ft->in_memory  = true;
+    inline_memory_used += ft->target_size;
+    return true;
+}
 
-        postmessage_utox(FILE_INCOMING_NEW_INLINE, friend_id, 0, msg);
+static bool decode_inline_png(FILE_TRANSFER *ft) {
+    // The transfer keeps its copy so the user can still save the image.
+    uint8_t *png = malloc(ft->current_size);
+    if (!png) {
+        LOG_ERR("decode_inline_png", "Unable to malloc for inline data.");
+        return false;
     }
+    memcpy(png, ft->via.memory, ft->current_size);
+
+    // Decoded off thread, see IMAGE_DECODE_DONE.
+    return image_decode_queue(IMAGE_DECODE_INLINE_RECV, ft->friend_number, ft->transfer_id, png, ft->current_size,
+                              settings.window_width);
 }
 
 /* Complete active file, (when the whole file transfer is successful). */
@@ -564,10 +618,19 @@ static void utox_complete_file(FILE_TRANSFER *file) {
         file->status = FILE_TRANSFER_STATUS_COMPLETED;
         if (file->incoming) {
             if (file->inline_img) {
-                decode_inline_png(file->friend_number, file->via.memory, file->current_size);
+                if (!(file->in_memory || inline_image_load(file)) || !decode_inline_png(file)) {
+                    inline_image_drop(file);
+                }
                 postmessage_utox(FILE_INCOMING_NEW_INLINE_DONE, file->friend_number, 0, file);
             } else if (file->avatar) {
-                postmessage_utox(FRIEND_AVATAR_SET, file->friend_number, file->current_size, file->via.avatar);
+                // Checked again here since the decode doesn't go through avatar_set(), and the size has to fit param2.
+                if (file->current_size > UTOX_AVATAR_MAX_DATA_LENGTH || file->current_size > UINT16_MAX) {
+                    LOG_ERR("FileTransfer", "Avatar from friend %u is too large (%lu)", file->friend_number,
+                            file->current_size);
+                    free(file->via.avatar);
+                } else {
+                    postmessage_utox(FRIEND_AVATAR_SET, file->friend_number, file->current_size, file->via.avatar);
+                }
             }
         }
         file->decon_wait = true;
@@ -628,6 +691,8 @@ void ft_friend_offline(Tox *UNUSED(tox), uint32_t friend_number) {
     for (uint16_t i = 0; i < f->ft_incoming_size; ++i) {
         break_file(&f->ft_incoming[i]);
     }
+
+    ft_sched_remove_friend(friend_number);
 }
 
 /* Local command callback to change a file status. */
@@ -841,19 +906,34 @@ static void incoming_inline_image(Tox *tox, uint32_t friend_number, uint32_t fil
     ft->in_use      = true;
 
     ft->incoming    = true;
-    ft->in_memory   = true;
     ft->inline_img  = true;
 
     ft->friend_number = friend_number;
     ft->file_number = file_number;
+    if (!++inline_transfer_id) {
+        ++inline_transfer_id;
+    }
+    ft->transfer_id = inline_transfer_id;
 
     ft->target_size = size;
 
-    ft->via.memory = calloc(1, size);
-    if (!ft->via.memory) {
-        LOG_ERR("FileTransfer", "Unable to malloc enough memory for incoming inline image of size %lu" , size);
-        ft_local_control(tox, friend_number, file_number, TOX_FILE_CONTROL_CANCEL);
-        return;
+    if (inline_memory_used + size <= MAX_INLINE_MEMORY) {
+        ft->via.memory = calloc(1, size);
+        if (!ft->via.memory) {
+            LOG_ERR("FileTransfer", "Unable to malloc enough memory for incoming inline image of size %lu" , size);
+            ft_local_control(tox, friend_number, file_number, TOX_FILE_CONTROL_CANCEL);
+            return;
+        }
+        ft->in_memory = true;
+        inline_memory_used += size;
+    } else {
+        LOG_INFO("FileTransfer", "Inline images already use %lu bytes, spilling this one to disk", inline_memory_used);
+        ft->via.file = tmpfile();
+        if (!ft->via.file) {
+            LOG_ERR("FileTransfer", "Unable to open a temp file for incoming inline image of size %lu" , size);
+            ft_local_control(tox, friend_number, file_number, TOX_FILE_CONTROL_CANCEL);
+            return;
+        }
     }
 
     LOG_NOTE("FileTransfer", "Starting incoming inline image of size %lu" , size);
@@ -980,6 +1060,39 @@ static void incoming_file_callback_request(Tox *tox, uint32_t friend_number, uin
     /* Auto accept if it's a utox-inline image, with the correct size */
 }
 
+/* Checks the first chunk of an inline image and tells the UI how big it's going to be, so it can show a placeholder
+ * while the rest comes in. */
+static bool inline_image_start(FILE_TRANSFER *ft, const uint8_t *data, size_t length) {
+    const uint8_t png_header[] = {0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a };
+    const uint8_t ihdr[] = { 'I', 'H', 'D', 'R' };
+
+    // Signature, then the IHDR chunk: 4 byte length, 4 byte type, 4 byte width, 4 byte height.
+    if (length < 24 || memcmp(data, png_header, 8) != 0 || memcmp(data + 12, ihdr, 4) != 0) {
+        // this isn't a png header, just die
+        LOG_ERR("FileTransfer", "Friend %u sent an inline image thats' not a PNG" , ft->friend_number);
+        return false;
+    }
+
+    const uint32_t width  = (uint32_t)data[16] << 24 | data[17] << 16 | data[18] << 8 | data[19];
+    const uint32_t height = (uint32_t)data[20] << 24 | data[21] << 16 | data[22] << 8 | data[23];
+    if (!width || !height || width > UINT16_MAX || height > UINT16_MAX
+        || (uint64_t)width * height > MAX_INLINE_PIXELS) {
+        LOG_ERR("FileTransfer", "Friend %u sent an inline image that's too large: %ux%u", ft->friend_number, width,
+                height);
+        return false;
+    }
+
+    FILE_TRANSFER *msg = calloc(1, sizeof(FILE_TRANSFER));
+    if (!msg) {
+        LOG_ERR("FileTransfer", "Unable to malloc for internal message. (This is bad!)");
+        return true;
+    }
+
+    *msg = *ft;
+    postmessage_utox(FILE_INCOMING_NEW_INLINE, width, height, msg);
+    return true;
+}
+
 /* Called by toxcore to deliver the next chunk of incoming data. */
 static void incoming_file_callback_chunk(Tox *tox, uint32_t friend_number, uint32_t file_number,
                                          uint64_t position, const uint8_t *data, size_t length, void *UNUSED(user_data))
@@ -998,17 +1111,18 @@ static void incoming_file_callback_chunk(Tox *tox, uint32_t friend_number, uint3
         return;
     }
 
-    if (ft->inline_img && ft->via.memory) {
-        if (position == 0) {
-            uint8_t png_header[] = {0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a };
-            if (memcmp(data, png_header, 8) != 0) {
-                // this isn't a png header, just die
-                LOG_ERR("FileTransfer", "Friend %u sent an inline image thats' not a PNG" , friend_number);
-                ft_local_control(tox, friend_number, file_number, TOX_FILE_CONTROL_CANCEL);
-                return;
-            }
-        }
+    if (ft->inline_img && position == 0 && !inline_image_start(ft, data, length)) {
+        ft_local_control(tox, friend_number, file_number, TOX_FILE_CONTROL_CANCEL);
+        return;
+    }
+
+    if (ft->inline_img && ft->in_memory && ft->via.memory) {
         memcpy(ft->via.memory + position, data, length);
+        // The placeholder in the chat fills with these, a percent at a time is all it shows.
+        const uint64_t target = ft->target_size;
+        if (target && (ft->current_size + length) * 100 / target > ft->current_size * 100 / target) {
+            calculate_speed(ft);
+        }
     } else if (ft->avatar && ft->via.avatar) {
         memcpy(ft->via.avatar + position, data, length);
     } else if (ft->via.file) {
@@ -1039,7 +1153,9 @@ static void incoming_file_callback_chunk(Tox *tox, uint32_t friend_number, uint3
     }
 
     ft->current_size += length;
-    if (ft->resume_update) {
+    if (ft->inline_img) {
+        // Inline images are never resumed, even when they're kept in a temporary file.
+    } else if (ft->resume_update) {
         --ft->resume_update;
     } else {
         ft_update_resumable(ft);
@@ -1104,6 +1220,8 @@ uint32_t ft_send_avatar(Tox *tox, uint32_t friend_number) {
     ft->target_size = self.png_size;
     ft->status = FILE_TRANSFER_STATUS_PAUSED_THEM;
 
+    ft_sched_add(friend_number, file_number, FT_SCHED_PRIORITY_HIGH);
+
     LOG_INFO("FileTransfer", "File transfer #%u sent to friend %u", ft->file_number, ft->friend_number);
     return file_number;
 }
@@ -1196,6 +1314,8 @@ uint32_t ft_send_file(Tox *tox, uint32_t friend_number, FILE *file, uint8_t *pat
 
     ft->status = FILE_TRANSFER_STATUS_PAUSED_THEM;
 
+    ft_sched_add(friend_number, file_number, FT_SCHED_PRIORITY_BULK);
+
     FILE_TRANSFER *msg = calloc(1, sizeof(FILE_TRANSFER));
     if (!msg) {
         LOG_ERR("FileTransfer", "Unable to malloc for internal message. (This is bad!)");
@@ -1277,6 +1397,7 @@ uint32_t ft_send_data(Tox *tox, uint32_t friend_number, uint8_t *data, size_t si
     ft->target_size = size;
     ft->status = FILE_TRANSFER_STATUS_PAUSED_THEM;
 
+    ft_sched_add(friend_number, file_number, FT_SCHED_PRIORITY_HIGH);
 
     FILE_TRANSFER *msg = calloc(1, sizeof(FILE_TRANSFER));
     if (!msg) {
@@ -1303,46 +1424,26 @@ bool ft_set_ui_data(uint32_t friend_number, uint32_t file_number, MSG_HEADER *ui
     return true;
 }
 
-static void outgoing_file_callback_chunk(Tox *tox, uint32_t friend_number, uint32_t file_number, uint64_t position,
-                                         size_t length, void *UNUSED(user_data))
-{
-    LOG_INFO("FileTransfer", "Chunk requested for friend_id (%u), and file_id (%u). Start (%lu), End (%zu).\r",
-            friend_number, file_number, position, length);
-
-    FILE_TRANSFER *ft = get_file_transfer(friend_number, file_number);
-    if (!ft) {
-        LOG_ERR("FileTransfer", "Unabele to get file transfer (%u & %u)", friend_number, file_number);
-        return;
-    }
-
-    if (length == 0) {
-        LOG_NOTE("FileTransfer", "Outgoing transfer is done (%u & %u)", friend_number, file_number);
-        utox_complete_file(ft);
-        return;
-    }
-
-    if (position + length > ft->target_size) {
-        LOG_ERR("FileTransfer", "Outing transfer size mismatch!");
-        return;
-    }
+/* Sends one chunk of an outgoing transfer. Used directly and by the scheduler. */
+static FT_SCHED_SEND_RESULT ft_send_chunk(Tox *tox, FILE_TRANSFER *ft, uint64_t position, size_t length) {
+    const uint32_t friend_number = ft->friend_number;
+    const uint32_t file_number   = ft->file_number;
 
     TOX_ERR_FILE_SEND_CHUNK error = 0;
     if (ft->in_memory) {
         if (!ft->via.memory) {
             LOG_ERR("FileTransfer", "ERROR READING FROM MEMORY! (%u & %u)", friend_number, file_number);
-            return;
+            return FT_SCHED_SEND_DROP;
         }
 
         tox_file_send_chunk(tox, friend_number, file_number, position, ft->via.memory + position, length, &error);
         if (error) {
             LOG_ERR("FileTransfer", "Outgoing chunk error on memory (%u)", error);
         }
-
-        calculate_speed(ft);
     } else if (ft->avatar) {
         if (!self.png_data) {
             LOG_ERR("FileTransfer", "ERROR READING FROM AVATAR! (%u & %u)", friend_number, file_number);
-            return;
+            return FT_SCHED_SEND_DROP;
         }
 
         tox_file_send_chunk(tox, friend_number, file_number, position, self.png_data + position, length, &error);
@@ -1358,7 +1459,7 @@ static void outgoing_file_callback_chunk(Tox *tox, uint32_t friend_number, uint3
                 LOG_INFO("FileTransfer", "Size (%lu), Position (%lu), Length(%lu), size_transferred (%lu).",
                          ft->target_size, position, length, ft->current_size);
                 ft_local_control(tox, friend_number, file_number, TOX_FILE_CONTROL_CANCEL);
-                return;
+                return FT_SCHED_SEND_DROP;
             }
 
             tox_file_send_chunk(tox, friend_number, file_number, position, buffer, length, &error);
@@ -1366,10 +1467,82 @@ static void outgoing_file_callback_chunk(Tox *tox, uint32_t friend_number, uint3
                 LOG_ERR("FileTransfer", "Outgoing chunk error on file (%u)", error);
             }
         }
+    }
+
+    switch (error) {
+        case TOX_ERR_FILE_SEND_CHUNK_OK: {
+            break;
+        }
+
+        case TOX_ERR_FILE_SEND_CHUNK_SENDQ: {
+            // Toxcore will take it once the friend's queue drains.
+            return FT_SCHED_SEND_RETRY;
+        }
+
+        case TOX_ERR_FILE_SEND_CHUNK_NOT_TRANSFERRING: {
+            // Paused, toxcore still expects this chunk once the transfer resumes.
+            return FT_SCHED_SEND_HOLD;
+        }
+
+        default: {
+            return FT_SCHED_SEND_DROP;
+        }
+    }
+
+    if (!ft->avatar) {
         calculate_speed(ft);
     }
 
     ft->current_size += length;
+    return FT_SCHED_SEND_OK;
+}
+
+static FT_SCHED_SEND_RESULT ft_sched_send(void *tox, uint32_t friend_number, uint32_t file_number, uint64_t position,
+                                          size_t length)
+{
+    FILE_TRANSFER *ft = get_file_transfer(friend_number, file_number);
+    if (!ft || !ft->in_use) {
+        return FT_SCHED_SEND_DROP;
+    }
+
+    return ft_send_chunk(tox, ft, position, length);
+}
+
+void ft_send_queued_chunks(Tox *tox, uint64_t time) {
+    ft_sched_set_limits(settings.ft_rate_limit_global * 1024, settings.ft_rate_limit_friend * 1024);
+    ft_sched_run(time, ft_sched_send, tox);
+}
+
+static void outgoing_file_callback_chunk(Tox *tox, uint32_t friend_number, uint32_t file_number, uint64_t position,
+                                         size_t length, void *UNUSED(user_data))
+{
+    LOG_INFO("FileTransfer", "Chunk requested for friend_id (%u), and file_id (%u). Start (%lu), End (%zu).\r",
+            friend_number, file_number, position, length);
+
+    FILE_TRANSFER *ft = get_file_transfer(friend_number, file_number);
+    if (!ft) {
+        LOG_ERR("FileTransfer", "Unabele to get file transfer (%u & %u)", friend_number, file_number);
+        return;
+    }
+
+    if (length == 0) {
+        LOG_NOTE("FileTransfer", "Outgoing transfer is done (%u & %u)", friend_number, file_number);
+        utox_complete_file(ft);
+        return;
+    }
+
+    if (position + length > ft->target_size) {
+        LOG_ERR("FileTransfer", "Outing transfer size mismatch!");
+        return;
+    }
+
+    /* The scheduler decides when this chunk goes out, see ft_send_queued_chunks(). It only turns away transfers it
+     * doesn't track, and has nothing queued for those to overtake. */
+    if (ft_sched_enqueue(friend_number, file_number, position, length)) {
+        return;
+    }
+
+    ft_send_chunk(tox, ft, position, length);
 }
 
 bool utox_file_start_write(uint32_t friend_number, uint32_t file_number, const char *file) {
@@ -36,6 +36,7 @@ typedef struct file_transfer {
 
     uint32_t friend_number;
     uint32_t file_number;
+    uint32_t transfer_id; // Never reused, unlike file_number. Only set for incoming inline images.
 
     uint8_t  data_hash[TOX_HASH_LENGTH];
 
@@ -83,6 +84,9 @@ bool utox_file_start_write(uint32_t friend_number, uint32_t file_number, const c
 
 void utox_set_callbacks_file_transfer(Tox *tox);
 
+/* Sends the outgoing chunks the scheduler lets through. Call once per tox_iterate(), time is get_time(). */
+void ft_send_queued_chunks(Tox *tox, uint64_t time);
+
 void ft_friend_online(Tox *tox, uint32_t friend_number);
 void ft_friend_offline(Tox *tox, uint32_t friend_number);
 
@@ -12,6 +12,7 @@
 #include "text.h"
 #include "theme.h"
 #include "tox.h"
+#include "ui.h"
 #include "utox.h"
 
 #include "ui/contextmenu.h"
@@ -51,10 +52,12 @@ static uint32_t itemcount;
 // list of chats actually shown in the GUI after filtering
 // (actually indices pointing to chats in the chats array)
 static uint32_t *shown_list;
+static uint32_t *shown_index; // where each item is in shown_list, UINT32_MAX if it isn't
 static uint32_t showncount;
 
 // search and filter stuff
 static char *  search_string;
+static char *  search_key; // search_string folded to lowercase, to find in each friend's search key
 static uint8_t filter;
 
 static ITEM *mouseover_item;
@@ -236,12 +239,21 @@ static void drawitem(ITEM *i, int x, int y, int width) {
 
 // find index of given item in shown_list, or INT_MAX if it can't be found
 static unsigned int find_item_shown_index(ITEM *it) {
-    for (unsigned int i = 0; i < showncount; ++i) {
-        if (shown_list[i] == it - item) { // (it - item) returns the index of the item in the full items list
-            return i;
-        }
+    if (it < item || it >= item + itemcount || shown_index[it - item] >= showncount) {
+        return INT_MAX; // can't be found!
+    }
+
+    return shown_index[it - item];
+}
+
+static void index_shown_list(void) {
+    for (uint32_t i = 0; i < itemcount; ++i) {
+        shown_index[i] = UINT32_MAX;
+    }
+
+    for (uint32_t i = 0; i < showncount; ++i) {
+        shown_index[shown_list[i]] = i;
     }
-    return INT_MAX; // can't be found!
 }
 
 void flist_re_scale(void) {
@@ -252,11 +264,9 @@ void flist_re_scale(void) {
     }
 }
 
+// str has to be folded to lowercase already
 bool friend_matches_search_string(FRIEND *f, char *str) {
-    return !str
-           || strstr_case(f->name, str)
-           || (f->alias && strstr_case(f->alias, str))
-           || strstr_case(f->id_str, str);
+    return !str || (f->search_key && strstr(f->search_key, str));
 }
 
 void flist_update_shown_list(void) {
@@ -269,7 +279,7 @@ void flist_update_shown_list(void) {
         }
         FRIEND *f = get_friend(it->id_number);
         if (search_string) {
-            if (friend_matches_search_string(f, search_string)) {
+            if (friend_matches_search_string(f, search_key)) {
                 shown_list[j++] = i;
             }
         } else if ((!filter || f->online || f->unread_msg || it == selected_item)) {
@@ -278,14 +288,16 @@ void flist_update_shown_list(void) {
     }
 
     showncount = j;
+    index_shown_list();
     flist_re_scale();
 }
 
 /* returns address of item at current index and appends the group create entry */
 static ITEM *newitem(void) {
     item       = realloc(item, (itemcount + 1) * sizeof(ITEM));
-    shown_list = realloc(shown_list, (itemcount + 1) * sizeof(uint32_t));
-    if (!item || !shown_list) {
+    shown_list  = realloc(shown_list, (itemcount + 1) * sizeof(uint32_t));
+    shown_index = realloc(shown_index, (itemcount + 1) * sizeof(uint32_t));
+    if (!item || !shown_list || !shown_index) {
         LOG_FATAL_ERR(EXIT_MALLOC, "flist", "Could not allocate memory for friend list.");
     }
 
@@ -294,6 +306,10 @@ static ITEM *newitem(void) {
     item[index + 1].id_number = UINT32_MAX;
     itemcount++;
 
+    // Neither is shown until the shown list is updated, which could be held off.
+    shown_index[index]     = UINT32_MAX;
+    shown_index[index + 1] = UINT32_MAX;
+
     flist_update_shown_list();
 
     return &item[index];
@@ -336,9 +352,43 @@ void flist_set_filter(uint8_t new_filter) {
     flist_update_shown_list();
 }
 
+/* Everything that matches a longer search matched the one it grew from, so typing on only drops items from the list. */
+static void narrow_shown_list(void) {
+    uint32_t j = 0;
+    for (uint32_t i = 0; i < showncount; ++i) {
+        const ITEM *it = &item[shown_list[i]];
+        if (it->type != ITEM_FRIEND || friend_matches_search_string(get_friend(it->id_number), search_key)) {
+            shown_list[j++] = shown_list[i];
+        }
+    }
+
+    showncount = j;
+    index_shown_list();
+    flist_re_scale();
+}
+
 void flist_search(char *str) {
+    char *old_key = search_key;
+    search_key    = NULL;
+
+    if (str) {
+        const size_t length = strlen(str);
+        search_key = malloc(length + 1);
+        if (!search_key) {
+            LOG_FATAL_ERR(EXIT_MALLOC, "flist", "Could not allocate memory for the search string.");
+        }
+        *strcpy_lower(search_key, str, length) = '\0';
+    }
+
+    const bool narrowing = search_string && str && strstr(search_key, old_key);
     search_string = str;
-    flist_update_shown_list();
+    free(old_key);
+
+    if (narrowing) {
+        narrow_shown_list();
+    } else {
+        flist_update_shown_list();
+    }
 }
 
 // change the selected item by [offset] items in the shown list
@@ -399,9 +449,7 @@ static void page_close(ITEM *i) {
 
             f->msg.scroll = messages_friend.content_scroll->d;
 
-            f->edit_history        = edit_chat_msg_friend.history;
-            f->edit_history_cur    = edit_chat_msg_friend.history_cur;
-            f->edit_history_length = edit_chat_msg_friend.history_length;
+            f->edit_history = edit_chat_msg_friend.history;
 
             panel_chat.disabled                    = true;
             panel_friend.disabled                  = true;
@@ -438,9 +486,7 @@ static void page_close(ITEM *i) {
 
                 g->msg.scroll = messages_group.content_scroll->d;
 
-                g->edit_history        = edit_chat_msg_group.history;
-                g->edit_history_cur    = edit_chat_msg_group.history_cur;
-                g->edit_history_length = edit_chat_msg_group.history_length;
+                g->edit_history = edit_chat_msg_group.history;
             }
 
             panel_chat.disabled  = true;
@@ -506,8 +552,7 @@ static void page_open(ITEM *i) {
             }
             #endif
 
-            memcpy(edit_chat_msg_friend.data, f->typed, f->typed_length);
-            edit_chat_msg_friend.length = f->typed_length;
+            edit_restore(&edit_chat_msg_friend, (char *)f->typed, f->typed_length);
 
             f->msg.width  = current_width;
             f->msg.id     = f->number;
@@ -525,9 +570,7 @@ static void page_open(ITEM *i) {
             scrollbar_friend.content_height   = f->msg.height;
             messages_friend.content_scroll->d = f->msg.scroll;
 
-            edit_chat_msg_friend.history        = f->edit_history;
-            edit_chat_msg_friend.history_cur    = f->edit_history_cur;
-            edit_chat_msg_friend.history_length = f->edit_history_length;
+            edit_chat_msg_friend.history = f->edit_history;
             edit_setfocus(&edit_chat_msg_friend);
 
             panel_chat.disabled            = 0;
@@ -544,8 +587,7 @@ static void page_open(ITEM *i) {
                 LOG_FATAL_ERR(EXIT_FAILURE, "F-List", "Selected group no longer exists. Group number: %u", i->id_number);
             }
 
-            memcpy(edit_chat_msg_group.data, g->typed, g->typed_length);
-            edit_chat_msg_group.length = g->typed_length;
+            edit_restore(&edit_chat_msg_group, g->typed, g->typed_length);
 
             g->msg.width  = current_width;
             g->msg.id     = g->number;
@@ -564,9 +606,7 @@ static void page_open(ITEM *i) {
             messages_group.content_scroll->d              = g->msg.scroll;
             edit_setfocus(&edit_chat_msg_group);
 
-            edit_chat_msg_group.history        = g->edit_history;
-            edit_chat_msg_group.history_cur    = g->edit_history_cur;
-            edit_chat_msg_group.history_length = g->edit_history_length;
+            edit_chat_msg_group.history = g->edit_history;
 
             panel_chat.disabled           = false;
             panel_group.disabled          = false;
@@ -637,10 +677,15 @@ void flist_start(void) {
     itemcount += 1; /* for ITEM_GROUP_CREATE */
 
     item       = calloc(itemcount, sizeof(ITEM));
-    shown_list = calloc(itemcount, sizeof(uint32_t));
-    if (!item || !shown_list) {
+    shown_list  = calloc(itemcount, sizeof(uint32_t));
+    shown_index = malloc(itemcount * sizeof(uint32_t));
+    if (!item || !shown_list || !shown_index) {
         LOG_FATAL_ERR(EXIT_MALLOC, "flist", "Could not allocate memory for friend list.");
     }
+    for (uint32_t num = 0; num < itemcount; ++num) {
+        shown_index[num] = UINT32_MAX;
+    }
+
     ITEM *i = item;
     for (uint32_t num = 0; num < self.friend_list_count; ++num) {
         const FRIEND *f = get_friend(num);
@@ -667,8 +712,7 @@ void flist_start(void) {
     i->type = ITEM_GROUP_CREATE;
     i->id_number = UINT32_MAX;
 
-    search_string = NULL;
-    flist_update_shown_list();
+    flist_search(NULL);
 }
 
 void flist_add_friend(FRIEND *f, const char *msg, const int msg_length) {
@@ -783,6 +827,8 @@ static void deleteitem(ITEM *i) {
 
     int size = (&item[itemcount] - i) * sizeof(ITEM);
     memmove(i, i + 1, size);
+    // Keep it lined up with item in case the shown list update is held off.
+    memmove(&shown_index[i - item], &shown_index[i - item + 1], (&item[itemcount] - i) * sizeof(uint32_t));
 
     if (i != selected_item && selected_item > i && selected_item >= item && selected_item < item + countof_item) {
         selected_item--;
@@ -831,6 +877,7 @@ void flist_freeall(void) {
     showncount = 0;
     free(item);
     free(shown_list);
+    free(shown_index);
 }
 
 void flist_selectchat(int index) {
@@ -1019,7 +1066,7 @@ bool try_open_tox_uri(const char *str) {
  ****** UI functions                                                     ******
  ******************************************************************************/
 
-void flist_draw(void *UNUSED(n), int x, int y, int width, int UNUSED(height)) {
+void flist_draw(void *UNUSED(n), int x, int y, int width, int height) {
     int real_height = 0;
     if (settings.use_mini_flist) {
         real_height = SCALE(ROSTER_BOX_HEIGHT / 2);
@@ -1027,28 +1074,46 @@ void flist_draw(void *UNUSED(n), int x, int y, int width, int UNUSED(height)) {
         real_height = SCALE(ROSTER_BOX_HEIGHT);
     }
 
-    ITEM *mi = NULL; // item being dragged
-    int   my;        // y of item being dragged
+    // Every item is as tall as the others, so only the ones that can be seen are drawn.
+    int top    = y + scroll_gety(&scrollbar_flist, height);
+    int bottom = top + height;
+    panel_draw_bounds(&top, &bottom);
+    if (bottom <= top) {
+        return;
+    }
+
+    const uint32_t first = MAX(top - y, 0) / real_height;
+    const uint32_t end   = MIN((uint32_t)MAX(bottom - y + real_height - 1, 0) / real_height, showncount);
 
-    for (unsigned int i = 0; i < showncount; i++) {
+    const bool dragging = selected_item_dy >= 5 || selected_item_dy <= -5;
+    for (uint32_t i = first; i < end; i++) {
         ITEM *it = &item[shown_list[i]];
-        if (it == selected_item && (selected_item_dy >= 5 || selected_item_dy <= -5)) {
-            mi = it;
-            my = y + selected_item_dy;
-        } else {
-            drawitem(it, x, y, width);
+        if (it != selected_item || !dragging) {
+            drawitem(it, x, y + i * real_height, width);
+        }
+    }
+
+    const unsigned int dragged = find_item_shown_index(selected_item);
+    if (dragging && dragged != INT_MAX) {
+        const int my = y + dragged * real_height + selected_item_dy;
+        if (my < bottom && my + real_height > top) {
+            drawitem(selected_item, x, my, width);
         }
-        y += real_height;
     }
+}
 
-    if (mi) {
-        drawitem(mi, x, my, width);
+// Marks the shown item for drawing again, when it's the only one that changed.
+static void redraw_item(ITEM *it, int x, int y, int width) {
+    const unsigned int index = find_item_shown_index(it);
+    if (index == INT_MAX) {
+        return;
     }
+
+    const int real_height = settings.use_mini_flist ? SCALE(ROSTER_BOX_HEIGHT / 2) : SCALE(ROSTER_BOX_HEIGHT);
+    redraw_rect(x, y + index * real_height, width, real_height);
 }
 
-bool flist_mmove(void *UNUSED(n), int UNUSED(x), int UNUSED(y), int UNUSED(width), int height, int mx, int my,
-                 int UNUSED(dx), int dy)
-{
+bool flist_mmove(void *UNUSED(n), int x, int y, int width, int height, int mx, int my, int UNUSED(dx), int dy) {
     int real_height = 0;
 
     if (settings.use_mini_flist) {
@@ -1062,8 +1127,14 @@ bool flist_mmove(void *UNUSED(n), int UNUSED(x), int UNUSED(y), int UNUSED(width
     bool draw = false;
 
     if (i != mouseover_item) {
+        // Only the hover background moves, from one item to the other.
+        if (mouseover_item) {
+            redraw_item(mouseover_item, x, y, width);
+        }
+        if (i) {
+            redraw_item(i, x, y, width);
+        }
         mouseover_item = i;
-        draw = true;
     }
 
     if (selected_item_mousedown) {
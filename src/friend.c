@@ -5,6 +5,7 @@
 #include "debug.h"
 #include "filesys.h"
 #include "flist.h"
+#include "hash_index.h"
 #include "macros.h"
 #include "self.h"
 #include "settings.h"
@@ -35,6 +36,9 @@ FRIEND *get_friend(uint32_t friend_number) {
     return &friend[friend_number];
 }
 
+// Friend numbers by id_str and by name or alias, both with the case folded.
+static HASH_INDEX friends_by_id, friends_by_name;
+
 static FRIEND *friend_make(uint32_t friend_number) {
     if (friend_number >= self.friend_list_size) {
         LOG_INFO("Friend", "Reallocating friend array to %u. Current size: %u", (friend_number + 1), self.friend_list_size);
@@ -139,6 +143,9 @@ void free_friends(void) {
     if (friend) {
         free(friend);
     }
+
+    hash_index_clear(&friends_by_id);
+    hash_index_clear(&friends_by_name);
 }
 
 void utox_write_metadata(FRIEND *f) {
@@ -250,6 +257,7 @@ void utox_friend_init(Tox *tox, uint32_t friend_number) {
 
     // Set the friend number we got from toxcore
     f->number = friend_number;
+    hash_index_add(&friends_by_id, hash_index_case(f->id_str, TOX_FRIEND_ID_STR_SIZE), f->number);
 
     // Get and set friend name and length
     int size = tox_friend_get_name_size(tox, friend_number, 0);
@@ -303,12 +311,49 @@ void utox_friend_list_init(Tox *tox) {
         LOG_FATAL_ERR(EXIT_MALLOC, "Friend", "Could not allocate friend list with size: %u", self.friend_list_size);
     }
 
+    hash_index_clear(&friends_by_id);
+    hash_index_clear(&friends_by_name);
+
     for (uint32_t i = 0; i < self.friend_list_size; ++i) {
         utox_friend_init(tox, i);
     }
     LOG_INFO("Friend", "Friendlist successfully initialized with %u friends.", self.friend_list_size);
 }
 
+/* Searching the friend list happens on every key typed, so what it looks at is folded once, whenever it changes. */
+static void friend_update_search_key(FRIEND *f) {
+    const size_t size = f->name_length + 1 + f->alias_length + 1 + TOX_FRIEND_ID_STR_SIZE + 1;
+
+    char *key = realloc(f->search_key, size);
+    if (!key) {
+        LOG_FATAL_ERR(EXIT_MALLOC, "Friend", "Could not alloc space for friend search key (%uB)", size);
+    }
+
+    // The search can't match across the line breaks, it's a single line.
+    char *p = strcpy_lower(key, f->name, f->name_length);
+    *p++ = '\n';
+    if (f->alias) {
+        p = strcpy_lower(p, f->alias, f->alias_length);
+    }
+    *p++ = '\n';
+    p = strcpy_lower(p, f->id_str, TOX_FRIEND_ID_STR_SIZE);
+    *p = '\0';
+
+    if (f->search_key) {
+        hash_index_remove(&friends_by_name, f->name_hash, f->number);
+        hash_index_remove(&friends_by_name, f->alias_hash, f->number);
+    }
+
+    f->search_key = key;
+    f->name_hash  = hash_index_case(f->name, f->name_length);
+    f->alias_hash = f->alias ? hash_index_case(f->alias, f->alias_length) : f->name_hash;
+
+    hash_index_add(&friends_by_name, f->name_hash, f->number);
+    if (f->alias) {
+        hash_index_add(&friends_by_name, f->alias_hash, f->number);
+    }
+}
+
 void friend_setname(FRIEND *f, uint8_t *name, size_t length) {
     if (f->name && f->name_length) {
         char *p;
@@ -343,6 +388,7 @@ void friend_setname(FRIEND *f, uint8_t *name, size_t length) {
     }
 
     f->name[f->name_length] = '\0';
+    friend_update_search_key(f);
 
     if (!f->alias_length) {
         if (flist_get_type()== ITEM_FRIEND) {
@@ -386,6 +432,9 @@ void friend_set_alias(FRIEND *f, uint8_t *alias, uint16_t length) {
         memcpy(f->alias, alias, length);
         f->alias_length = length;
     }
+
+    friend_update_search_key(f);
+    flist_update_shown_list();
 }
 
 void friend_sendimage(FRIEND *f, NATIVE_IMAGE *native_image, uint16_t width, uint16_t height, UTOX_IMAGE png_image,
@@ -514,13 +563,19 @@ void friend_history_clear(FRIEND *f) {
 
 void friend_free(FRIEND *f) {
     LOG_INFO("Friend", "Freeing friend: %u", f->number);
-    for (uint16_t i = 0; i < f->edit_history_length; ++i) {
-        free(f->edit_history[i]);
-        f->edit_history[i] = NULL;
+    if (edit_chat_msg_friend.history == f->edit_history) {
+        edit_chat_msg_friend.history = NULL;
+    }
+    edit_history_free(f->edit_history);
+
+    hash_index_remove(&friends_by_id, hash_index_case(f->id_str, TOX_FRIEND_ID_STR_SIZE), f->number);
+    if (f->search_key) {
+        hash_index_remove(&friends_by_name, f->name_hash, f->number);
+        hash_index_remove(&friends_by_name, f->alias_hash, f->number);
     }
-    free(f->edit_history);
 
     free(f->name);
+    free(f->search_key);
     free(f->status_message);
     free(f->typed);
     free(f->avatar);
@@ -544,6 +599,19 @@ void friend_free(FRIEND *f) {
 }
 
 FRIEND *find_friend_by_name(uint8_t *name) {
+    const size_t length = strlen((char *)name);
+    const uint64_t hash = hash_index_case((char *)name, length);
+
+    uint32_t pos = 0, number;
+    while ((number = hash_index_next(&friends_by_name, hash, &pos)) != HASH_INDEX_NONE) {
+        FRIEND *f = get_friend(number);
+        if (f && ((f->alias && f->alias_length == length && !memcmp_case(f->alias, (char *)name, length))
+                  || (f->name_length == length && !memcmp_case(f->name, (char *)name, length)))) {
+            return f;
+        }
+    }
+
+    // Nobody is called exactly that, so take the first one whose name starts with it.
     for (size_t i = 0; i < self.friend_list_count; i++) {
         FRIEND *f = get_friend(i);
         if (!f) {
@@ -560,14 +628,16 @@ FRIEND *find_friend_by_name(uint8_t *name) {
 }
 
 FRIEND *get_friend_by_id(const char *id_str) {
-    for (size_t i = 0; i < self.friend_list_count; i++) {
-        FRIEND *f = get_friend(i);
-        if (!f) {
-            LOG_ERR("Friend", "Could not get friend %u", i);
-            continue;
-        }
+    if (strnlen(id_str, TOX_FRIEND_ID_STR_SIZE) < TOX_FRIEND_ID_STR_SIZE) {
+        return NULL;
+    }
+
+    const uint64_t hash = hash_index_case(id_str, TOX_FRIEND_ID_STR_SIZE);
 
-        if (strncmp(f->id_str, id_str, TOX_PUBLIC_KEY_SIZE * 2) == 0) {
+    uint32_t pos = 0, number;
+    while ((number = hash_index_next(&friends_by_id, hash, &pos)) != HASH_INDEX_NONE) {
+        FRIEND *f = get_friend(number);
+        if (f && !memcmp_case(f->id_str, id_str, TOX_FRIEND_ID_STR_SIZE)) {
             return f;
         }
     }
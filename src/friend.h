@@ -6,7 +6,7 @@
 #include <tox/tox.h>
 
 typedef struct avatar AVATAR;
-typedef struct edit_change EDIT_CHANGE;
+typedef struct edit_history EDIT_HISTORY;
 typedef struct file_transfer FILE_TRANSFER;
 typedef uint8_t *UTOX_IMAGE;
 typedef unsigned int ALuint;
@@ -56,13 +56,16 @@ typedef struct friend_meta_data_old {
 #define TOX_FRIEND_ID_STR_SIZE TOX_PUBLIC_KEY_SIZE * 2
 typedef struct utox_friend {
     uint8_t id_bin[TOX_PUBLIC_KEY_SIZE];
-    char    id_str[TOX_FRIEND_ID_STR_SIZE];
-    uint8_t number;
+    char     id_str[TOX_FRIEND_ID_STR_SIZE];
+    uint32_t number;
 
     char *name;
     char *alias;
     char *status_message;
 
+    char *search_key; // Name, alias and id folded to lowercase, what the friend list search looks at
+    uint64_t name_hash, alias_hash; // What they're found under by find_friend_by_name()
+
     uint8_t *typed;
 
     size_t name_length;
@@ -82,13 +85,14 @@ typedef struct utox_friend {
     bool          skip_msg_logging;
     bool          unread_msg;
     MESSAGES      msg;
-    EDIT_CHANGE **edit_history;
-    uint16_t      edit_history_cur, edit_history_length;
+    EDIT_HISTORY *edit_history;
 
     /* Audio / Video */
     int32_t  call_state_self, call_state_friend;
     uint16_t video_width, video_height;
     ALuint   audio_dest;
+    uint8_t  audio_frame_ms; // Duration of the audio frames we send during this call
+    uint32_t audio_frames_sent, audio_frames_suppressed; // Suppressed frames were gated as silence
     time_t call_started;
 
     /* File transfers */
@@ -122,6 +126,7 @@ uint8_t addfriend_status;
  */
 FRIEND *get_friend(uint32_t friend_number);
 
+/* Finds the friend with the public key that id_str starts with, in hex of any case */
 FRIEND *get_friend_by_id(const char *id_str);
 
 FREQUEST *get_frequest(uint16_t frequest_number);
@@ -159,7 +164,8 @@ void friend_history_clear(FRIEND *f);
 
 void friend_free(FRIEND *f);
 
-/* Searches for a friend using the specified name */
+/* Searches for a friend using the specified name, or alias, ignoring case. Falls back to the first friend the name
+ * is the start of */
 FRIEND *find_friend_by_name(uint8_t *name);
 
 /* Notifies the user that a friend is online or offline */
@@ -0,0 +1,390 @@
+#include "ft_scheduler.h"
+
+#include "debug.h"
+#include "macros.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NS_PER_SEC ((uint64_t)1000 * 1000 * 1000)
+
+typedef struct {
+    uint64_t position;
+    size_t   length;
+} SCHED_CHUNK;
+
+/* Per transfer throughput counters. */
+typedef struct {
+    uint64_t bytes_sent;
+    uint32_t chunks_sent;
+    uint32_t chunks_throttled; // Times a chunk had to wait on a token bucket.
+    uint32_t chunks_retried;   // Times toxcore's send queue was full.
+} SCHED_STATS;
+
+typedef struct {
+    bool in_use;
+
+    uint32_t friend_number;
+    uint32_t file_number;
+
+    FT_SCHED_PRIORITY priority;
+
+    /* Ring of chunks toxcore has requested but we haven't sent yet. Kept when the slot is reused. */
+    SCHED_CHUNK *queue;
+    uint32_t     size, head, count;
+
+    /* Set during a run when this transfer can't send right now. */
+    bool held;
+
+    SCHED_STATS stats;
+} SCHED_TRANSFER;
+
+typedef struct {
+    uint32_t rate;        // bytes per second, 0 is unlimited
+    int64_t  tokens;      // bytes, may go negative when a chunk is larger than what's left
+    uint64_t last_refill; // ns
+} TOKEN_BUCKET;
+
+typedef struct {
+    bool     in_use;
+    uint32_t friend_number;
+
+    TOKEN_BUCKET bucket;
+
+    /* Set during a run when this friend can't send anything more. */
+    bool blocked;
+
+    /* Index into transfers to start from, so a friend's own transfers take turns too. */
+    uint32_t cursor[FT_SCHED_PRIORITY_COUNT];
+} SCHED_FRIEND;
+
+static SCHED_TRANSFER *transfers;
+static uint32_t        transfers_size;
+
+static SCHED_FRIEND *friends;
+static uint32_t      friends_size;
+
+static TOKEN_BUCKET global_bucket;
+static uint32_t     friend_rate;
+
+/* Which friend gets to go first in each class, moved along every run. */
+static uint32_t friend_cursor[FT_SCHED_PRIORITY_COUNT];
+
+static void bucket_refill(TOKEN_BUCKET *b, uint64_t now) {
+    if (!b->rate) {
+        b->last_refill = now;
+        return;
+    }
+
+    if (!b->last_refill || now < b->last_refill) {
+        b->last_refill = now;
+        b->tokens      = 0;
+        return;
+    }
+
+    // Don't let a long pause overflow the math below, the cap would swallow it anyway.
+    uint64_t elapsed = MIN(now - b->last_refill, NS_PER_SEC);
+    b->tokens += (int64_t)((uint64_t)b->rate * elapsed / NS_PER_SEC);
+    b->last_refill = now;
+
+    // Allow bursts of up to a quarter second of traffic.
+    const int64_t capacity = MAX(b->rate / 4, 1);
+    if (b->tokens > capacity) {
+        b->tokens = capacity;
+    }
+}
+
+static bool bucket_ready(const TOKEN_BUCKET *b) {
+    return !b->rate || b->tokens > 0;
+}
+
+static void bucket_take(TOKEN_BUCKET *b, size_t length) {
+    if (b->rate) {
+        b->tokens -= length;
+    }
+}
+
+static SCHED_TRANSFER *find_transfer(uint32_t friend_number, uint32_t file_number) {
+    for (uint32_t i = 0; i < transfers_size; ++i) {
+        SCHED_TRANSFER *t = &transfers[i];
+        if (t->in_use && t->friend_number == friend_number && t->file_number == file_number) {
+            return t;
+        }
+    }
+
+    return NULL;
+}
+
+static SCHED_FRIEND *find_friend(uint32_t friend_number) {
+    for (uint32_t i = 0; i < friends_size; ++i) {
+        if (friends[i].in_use && friends[i].friend_number == friend_number) {
+            return &friends[i];
+        }
+    }
+
+    return NULL;
+}
+
+static SCHED_FRIEND *make_friend(uint32_t friend_number) {
+    SCHED_FRIEND *f = find_friend(friend_number);
+    if (f) {
+        return f;
+    }
+
+    for (uint32_t i = 0; i < friends_size; ++i) {
+        if (!friends[i].in_use) {
+            f = &friends[i];
+            break;
+        }
+    }
+
+    if (!f) {
+        SCHED_FRIEND *new_friends = realloc(friends, sizeof(SCHED_FRIEND) * (friends_size + 1));
+        if (!new_friends) {
+            LOG_ERR("FT Scheduler", "Unable to realloc for friend %u", friend_number);
+            return NULL;
+        }
+
+        friends = new_friends;
+        f = &friends[friends_size++];
+    }
+
+    memset(f, 0, sizeof(SCHED_FRIEND));
+    f->in_use        = true;
+    f->friend_number = friend_number;
+    f->bucket.rate   = friend_rate;
+    return f;
+}
+
+void ft_sched_set_limits(uint32_t global_rate, uint32_t new_friend_rate) {
+    global_bucket.rate = global_rate;
+    friend_rate        = new_friend_rate;
+
+    for (uint32_t i = 0; i < friends_size; ++i) {
+        friends[i].bucket.rate = friend_rate;
+    }
+}
+
+bool ft_sched_add(uint32_t friend_number, uint32_t file_number, FT_SCHED_PRIORITY priority) {
+    if (priority >= FT_SCHED_PRIORITY_COUNT) {
+        priority = FT_SCHED_PRIORITY_BULK;
+    }
+
+    if (!make_friend(friend_number)) {
+        return false;
+    }
+
+    SCHED_TRANSFER *t = find_transfer(friend_number, file_number);
+    if (!t) {
+        for (uint32_t i = 0; i < transfers_size; ++i) {
+            if (!transfers[i].in_use) {
+                t = &transfers[i];
+                break;
+            }
+        }
+    }
+
+    if (!t) {
+        SCHED_TRANSFER *new_transfers = realloc(transfers, sizeof(SCHED_TRANSFER) * (transfers_size + 1));
+        if (!new_transfers) {
+            LOG_ERR("FT Scheduler", "Unable to realloc for transfer %u & %u", friend_number, file_number);
+            return false;
+        }
+
+        transfers = new_transfers;
+        t = &transfers[transfers_size++];
+        t->queue = NULL;
+        t->size  = 0;
+    }
+
+    SCHED_CHUNK *queue = t->queue;
+    uint32_t     size  = t->size;
+
+    memset(t, 0, sizeof(SCHED_TRANSFER));
+    t->queue         = queue;
+    t->size          = size;
+    t->in_use        = true;
+    t->friend_number = friend_number;
+    t->file_number   = file_number;
+    t->priority      = priority;
+
+    LOG_TRACE("FT Scheduler", "Tracking %u & %u with priority %u", friend_number, file_number, priority);
+    return true;
+}
+
+void ft_sched_remove(uint32_t friend_number, uint32_t file_number) {
+    SCHED_TRANSFER *t = find_transfer(friend_number, file_number);
+    if (!t) {
+        return;
+    }
+
+    LOG_INFO("FT Scheduler", "Transfer %u & %u done: %" PRIu64 " bytes in %u chunks, throttled %u times, sendq full %u times",
+             friend_number, file_number, t->stats.bytes_sent, t->stats.chunks_sent, t->stats.chunks_throttled,
+             t->stats.chunks_retried);
+    t->in_use = false;
+}
+
+void ft_sched_remove_friend(uint32_t friend_number) {
+    for (uint32_t i = 0; i < transfers_size; ++i) {
+        if (transfers[i].in_use && transfers[i].friend_number == friend_number) {
+            transfers[i].in_use = false;
+        }
+    }
+
+    SCHED_FRIEND *f = find_friend(friend_number);
+    if (f) {
+        f->in_use = false;
+    }
+}
+
+bool ft_sched_enqueue(uint32_t friend_number, uint32_t file_number, uint64_t position, size_t length) {
+    SCHED_TRANSFER *t = find_transfer(friend_number, file_number);
+    if (!t) {
+        return false;
+    }
+
+    if (t->count == t->size) {
+        const uint32_t size = t->size ? t->size * 2 : FT_SCHED_QUEUE_SIZE;
+        SCHED_CHUNK *queue = malloc(sizeof(SCHED_CHUNK) * size);
+        if (!queue) {
+            LOG_FATAL_ERR(EXIT_MALLOC, "FT Scheduler", "Unable to malloc for %u chunks of %u & %u", size,
+                          friend_number, file_number);
+        }
+
+        // Unwrap the ring so the chunks stay in the order they were requested.
+        for (uint32_t i = 0; i < t->count; ++i) {
+            queue[i] = t->queue[(t->head + i) % t->size];
+        }
+
+        free(t->queue);
+        t->queue = queue;
+        t->size  = size;
+        t->head  = 0;
+    }
+
+    SCHED_CHUNK *c = &t->queue[(t->head + t->count) % t->size];
+    c->position = position;
+    c->length   = length;
+    ++t->count;
+    return true;
+}
+
+static void transfer_pop(SCHED_TRANSFER *t) {
+    t->head = (t->head + 1) % t->size;
+    --t->count;
+}
+
+static void transfer_count_sent(SCHED_TRANSFER *t, size_t length) {
+    t->stats.bytes_sent += length;
+    t->stats.chunks_sent++;
+}
+
+/* Finds the next transfer for f in class p that has a chunk waiting. */
+static SCHED_TRANSFER *friend_next_transfer(SCHED_FRIEND *f, FT_SCHED_PRIORITY p) {
+    for (uint32_t i = 0; i < transfers_size; ++i) {
+        uint32_t index = (f->cursor[p] + i) % transfers_size;
+        SCHED_TRANSFER *t = &transfers[index];
+        if (t->in_use && t->count && !t->held && t->priority == p && t->friend_number == f->friend_number) {
+            f->cursor[p] = index + 1;
+            return t;
+        }
+    }
+
+    return NULL;
+}
+
+void ft_sched_run(uint64_t now, ft_sched_send_cb *send, void *userdata) {
+    if (!friends_size) {
+        return;
+    }
+
+    bucket_refill(&global_bucket, now);
+    for (uint32_t i = 0; i < friends_size; ++i) {
+        bucket_refill(&friends[i].bucket, now);
+        friends[i].blocked = !friends[i].in_use;
+    }
+
+    for (uint32_t i = 0; i < transfers_size; ++i) {
+        transfers[i].held = false;
+    }
+
+    for (FT_SCHED_PRIORITY p = 0; p < FT_SCHED_PRIORITY_COUNT; ++p) {
+        const uint32_t start = friend_cursor[p]++ % friends_size;
+
+        bool progress = true;
+        while (progress) {
+            progress = false;
+
+            for (uint32_t i = 0; i < friends_size; ++i) {
+                SCHED_FRIEND *f = &friends[(start + i) % friends_size];
+                if (f->blocked) {
+                    continue;
+                }
+
+                SCHED_TRANSFER *t = friend_next_transfer(f, p);
+                if (!t) {
+                    continue;
+                }
+
+                if (!bucket_ready(&global_bucket)) {
+                    // Nobody can send anything more this run.
+                    t->stats.chunks_throttled++;
+                    return;
+                }
+
+                if (!bucket_ready(&f->bucket)) {
+                    t->stats.chunks_throttled++;
+                    f->blocked = true;
+                    continue;
+                }
+
+                const SCHED_CHUNK *c = &t->queue[t->head];
+                switch (send(userdata, t->friend_number, t->file_number, c->position, c->length)) {
+                    case FT_SCHED_SEND_OK: {
+                        bucket_take(&global_bucket, c->length);
+                        bucket_take(&f->bucket, c->length);
+                        transfer_count_sent(t, c->length);
+                        transfer_pop(t);
+                        progress = true;
+                        break;
+                    }
+
+                    case FT_SCHED_SEND_RETRY: {
+                        t->stats.chunks_retried++;
+                        f->blocked = true;
+                        break;
+                    }
+
+                    case FT_SCHED_SEND_HOLD: {
+                        t->held = true;
+                        break;
+                    }
+
+                    case FT_SCHED_SEND_DROP: {
+                        transfer_pop(t);
+                        progress = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ft_sched_raze(void) {
+    for (uint32_t i = 0; i < transfers_size; ++i) {
+        free(transfers[i].queue);
+    }
+
+    free(transfers);
+    transfers      = NULL;
+    transfers_size = 0;
+
+    free(friends);
+    friends      = NULL;
+    friends_size = 0;
+
+    memset(&global_bucket, 0, sizeof(global_bucket));
+    memset(friend_cursor, 0, sizeof(friend_cursor));
+}
@@ -0,0 +1,63 @@
+#ifndef FT_SCHEDULER_H
+#define FT_SCHEDULER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Outgoing chunk scheduler.
+ *
+ * Toxcore asks for outgoing chunks whenever it has room in a friend's send queue. Instead of answering those requests
+ * in whatever order they arrive, file_transfers.c queues them here and the tox thread drains the queues once per
+ * iteration. Higher priority classes are always drained first, friends within a class are served round robin (one
+ * chunk each per turn) and every chunk has to pass both the friend's and the global token bucket.
+ *
+ * All functions must be called from the tox thread. */
+
+/* Number of requested chunks a transfer's queue starts out with room for. Toxcore doesn't request many chunks ahead
+ * of what we've sent, but chunks have to go out in the order they were requested, so the queue grows when it has to
+ * rather than turning any away. */
+#define FT_SCHED_QUEUE_SIZE 64
+
+typedef enum {
+    FT_SCHED_PRIORITY_HIGH, // Avatars and inline images
+    FT_SCHED_PRIORITY_BULK, // Everything else
+    FT_SCHED_PRIORITY_COUNT,
+} FT_SCHED_PRIORITY;
+
+typedef enum {
+    FT_SCHED_SEND_OK,    // Chunk sent, remove it from the queue
+    FT_SCHED_SEND_RETRY, // Friend's send queue is full, try again next run
+    FT_SCHED_SEND_HOLD,  // Transfer is paused, keep the chunk but move on to other transfers
+    FT_SCHED_SEND_DROP,  // Chunk can never be sent, remove it from the queue
+} FT_SCHED_SEND_RESULT;
+
+/* Called by ft_sched_run() for every chunk that's allowed out. */
+typedef FT_SCHED_SEND_RESULT ft_sched_send_cb(void *userdata, uint32_t friend_number, uint32_t file_number,
+                                              uint64_t position, size_t length);
+
+/* Sets the token bucket rates, in bytes per second. 0 means unlimited. */
+void ft_sched_set_limits(uint32_t global_rate, uint32_t friend_rate);
+
+/* Starts tracking an outgoing transfer. Returns false if we're out of memory. */
+bool ft_sched_add(uint32_t friend_number, uint32_t file_number, FT_SCHED_PRIORITY priority);
+
+/* Stops tracking an outgoing transfer and drops any chunks queued for it. */
+void ft_sched_remove(uint32_t friend_number, uint32_t file_number);
+
+/* Drops all transfers for friend_number (e.g. when they go offline). */
+void ft_sched_remove_friend(uint32_t friend_number);
+
+/* Queues a chunk toxcore requested, behind the ones already queued for the transfer.
+ *
+ * Returns false if the transfer isn't tracked, then nothing is queued for it and the caller should send the chunk
+ * right away. */
+bool ft_sched_enqueue(uint32_t friend_number, uint32_t file_number, uint64_t position, size_t length);
+
+/* Sends as many queued chunks as the buckets allow. now is in nanoseconds (see get_time()). */
+void ft_sched_run(uint64_t now, ft_sched_send_cb *send, void *userdata);
+
+/* Frees everything. */
+void ft_sched_raze(void);
+
+#endif
@@ -8,6 +8,7 @@
 #include "text.h"
 
 #include "av/audio.h"
+#include "av/audio_mixer.h"
 #include "av/utox_av.h"
 
 #include "native/notify.h"
@@ -180,7 +181,7 @@ void group_peer_add(GROUPCHAT *g, uint32_t peer_id, bool UNUSED(our_peer_number)
     g->peer_count++;
 
     if (g->av_group) {
-        group_av_peer_add(g, peer_id); //add a source for the peer
+        group_av_peer_add(g, peer_id); //add a mixer stream for the peer
     }
 
     pthread_mutex_unlock(&messages_lock);
@@ -278,14 +279,15 @@ void group_reset_peerlist(GROUPCHAT *g) {
 
 void group_free(GROUPCHAT *g) {
     LOG_INFO("Groupchats", "Freeing group %u", g->number);
-    for (size_t i = 0; i < g->edit_history_length; ++i) {
-        free(g->edit_history[i]);
+    if (edit_chat_msg_group.history == g->edit_history) {
+        edit_chat_msg_group.history = NULL;
     }
-
-    free(g->edit_history);
+    edit_history_free(g->edit_history);
 
     group_reset_peerlist(g);
 
+    audio_mixer_free(g->mixer);
+
     for (size_t i = 0; i < g->msg.number; ++i) {
         free(g->msg.data[i]->via.grp.author);
 
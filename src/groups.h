@@ -6,7 +6,8 @@
 #include <tox/tox.h>
 
 typedef unsigned int ALuint;
-typedef struct edit_change EDIT_CHANGE;
+typedef struct audio_mixer AUDIO_MIXER;
+typedef struct edit_history EDIT_HISTORY;
 
 #define UTOX_MAX_GROUP_PEERS 256
 
@@ -35,8 +36,10 @@ typedef struct groupchat {
     bool active_call;
     bool muted;
     ALuint audio_dest;
-    /* Audio sources */
-    unsigned int source[UTOX_MAX_GROUP_PEERS];
+    uint8_t audio_frame_ms; // Duration of the audio frames we send during this call
+    uint32_t audio_frames_sent, audio_frames_suppressed; // Suppressed frames were gated as silence
+    /* Per peer audio, mixed down to audio_dest */
+    AUDIO_MIXER *mixer;
     /* TODO: thread safety (This should work fine but it isn't very clean.) */
     volatile uint64_t last_recv_audio[UTOX_MAX_GROUP_PEERS];
 
@@ -49,11 +52,10 @@ typedef struct groupchat {
     uint16_t topic_length;
 
     char *typed;
-    uint16_t typed_length;
+    uint32_t typed_length;
 
     MESSAGES      msg;
-    EDIT_CHANGE **edit_history;
-    uint16_t      edit_history_cur, edit_history_length;
+    EDIT_HISTORY *edit_history;
 
     uint32_t peer_count;
     GROUP_PEER **peer;
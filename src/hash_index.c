@@ -0,0 +1,135 @@
+#include "hash_index.h"
+
+#include "debug.h"
+
+#include <stdlib.h>
+
+#define HASH_INDEX_MIN_SIZE 16
+
+// FNV-1a, with the bits mixed at the end so the low ones used to pick a slot depend on all of them.
+static uint64_t hash_finish(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t hash_index_bytes(const void *data, size_t length) {
+    const uint8_t *p = data;
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < length; ++i) {
+        h = (h ^ p[i]) * 0x100000001B3ull;
+    }
+
+    return hash_finish(h);
+}
+
+uint64_t hash_index_case(const char *data, size_t length) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < length; ++i) {
+        uint8_t c = data[i];
+        if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        h = (h ^ c) * 0x100000001B3ull;
+    }
+
+    return hash_finish(h);
+}
+
+static void slot_put(HASH_INDEX *index, uint64_t hash, uint32_t value) {
+    const uint32_t mask = index->size - 1;
+    uint32_t i = hash & mask;
+    while (index->slots[i].value != HASH_INDEX_NONE) {
+        i = (i + 1) & mask;
+    }
+
+    index->slots[i].hash  = hash;
+    index->slots[i].value = value;
+}
+
+static void index_grow(HASH_INDEX *index) {
+    const uint32_t old_size = index->size;
+    struct hash_index_slot *old = index->slots;
+
+    index->size  = old_size ? old_size * 2 : HASH_INDEX_MIN_SIZE;
+    index->slots = malloc(index->size * sizeof(*index->slots));
+    if (!index->slots) {
+        LOG_FATAL_ERR(EXIT_MALLOC, "Hash Index", "Could not allocate %u slots.", index->size);
+    }
+
+    for (uint32_t i = 0; i < index->size; ++i) {
+        index->slots[i].value = HASH_INDEX_NONE;
+    }
+
+    for (uint32_t i = 0; i < old_size; ++i) {
+        if (old[i].value != HASH_INDEX_NONE) {
+            slot_put(index, old[i].hash, old[i].value);
+        }
+    }
+
+    free(old);
+}
+
+void hash_index_add(HASH_INDEX *index, uint64_t hash, uint32_t value) {
+    if ((index->count + 1) * 2 > index->size) {
+        index_grow(index);
+    }
+
+    slot_put(index, hash, value);
+    index->count++;
+}
+
+void hash_index_remove(HASH_INDEX *index, uint64_t hash, uint32_t value) {
+    if (!index->size) {
+        return;
+    }
+
+    const uint32_t mask = index->size - 1;
+    uint32_t i = hash & mask;
+    while (index->slots[i].hash != hash || index->slots[i].value != value) {
+        if (index->slots[i].value == HASH_INDEX_NONE) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+
+    // Move back whatever comes after it and could be in its place, so nothing gets cut off from where it belongs.
+    for (uint32_t j = (i + 1) & mask; index->slots[j].value != HASH_INDEX_NONE; j = (j + 1) & mask) {
+        const uint32_t home = index->slots[j].hash & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            index->slots[i] = index->slots[j];
+            i = j;
+        }
+    }
+
+    index->slots[i].value = HASH_INDEX_NONE;
+    index->count--;
+}
+
+uint32_t hash_index_next(const HASH_INDEX *index, uint64_t hash, uint32_t *pos) {
+    const uint32_t mask = index->size - 1;
+    for (; *pos < index->size; ++*pos) {
+        const struct hash_index_slot *s = &index->slots[(hash + *pos) & mask];
+        if (s->value == HASH_INDEX_NONE) {
+            *pos = index->size;
+            break;
+        }
+
+        if (s->hash == hash) {
+            ++*pos;
+            return s->value;
+        }
+    }
+
+    return HASH_INDEX_NONE;
+}
+
+void hash_index_clear(HASH_INDEX *index) {
+    free(index->slots);
+    index->slots = NULL;
+    index->size  = 0;
+    index->count = 0;
+}
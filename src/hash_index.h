@@ -0,0 +1,40 @@
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Index from 64 bit hashes to 32 bit values, like friend numbers. The keys stay with whoever owns the values: more
+ * than one value can be found under a hash, so callers compare the key of each one they get back.
+ *
+ * Open addressing with linear probing, kept at most half full. */
+
+#define HASH_INDEX_NONE UINT32_MAX
+
+typedef struct {
+    struct hash_index_slot {
+        uint64_t hash;
+        uint32_t value; // HASH_INDEX_NONE when the slot is empty
+    } *slots;
+
+    uint32_t size; // 0 or a power of 2
+    uint32_t count;
+} HASH_INDEX;
+
+uint64_t hash_index_bytes(const void *data, size_t length);
+
+/* Like hash_index_bytes(), but A-Z hash the same as a-z, to go with memcmp_case(). */
+uint64_t hash_index_case(const char *data, size_t length);
+
+void hash_index_add(HASH_INDEX *index, uint64_t hash, uint32_t value);
+
+/* Removes value from under hash, if it's there. */
+void hash_index_remove(HASH_INDEX *index, uint64_t hash, uint32_t value);
+
+/* Returns the values under hash one after another, starting with *pos set to 0, and then HASH_INDEX_NONE. The index
+ * must not change in between. */
+uint32_t hash_index_next(const HASH_INDEX *index, uint64_t hash, uint32_t *pos);
+
+void hash_index_clear(HASH_INDEX *index);
+
+#endif
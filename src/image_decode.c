@@ -0,0 +1,154 @@
+#include "image_decode.h"
+
+#include "debug.h"
+#include "macros.h"
+#include "stb.h"
+#include "utox.h"
+
+#include "native/thread.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+static pthread_mutex_t  queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   queue_cond = PTHREAD_COND_INITIALIZER;
+static IMAGE_DECODE_JOB *queue_head, *queue_tail;
+static bool              workers_started;
+
+void image_downscale_rgba(const uint8_t *src, uint16_t w, uint16_t h, uint8_t *dst, uint16_t dst_w, uint16_t dst_h) {
+    for (uint32_t dy = 0; dy < dst_h; ++dy) {
+        const uint32_t y0 = dy * h / dst_h;
+        const uint32_t y1 = MAX((dy + 1) * h / dst_h, y0 + 1);
+
+        for (uint32_t dx = 0; dx < dst_w; ++dx) {
+            const uint32_t x0 = dx * w / dst_w;
+            const uint32_t x1 = MAX((dx + 1) * w / dst_w, x0 + 1);
+
+            uint32_t sum[4] = { 0 };
+            for (uint32_t y = y0; y < y1; ++y) {
+                const uint8_t *p = src + (y * w + x0) * 4;
+                for (uint32_t x = x0; x < x1; ++x, p += 4) {
+                    sum[0] += p[0];
+                    sum[1] += p[1];
+                    sum[2] += p[2];
+                    sum[3] += p[3];
+                }
+            }
+
+            const uint32_t count = (x1 - x0) * (y1 - y0);
+            uint8_t *out = dst + (dy * dst_w + dx) * 4;
+            for (int i = 0; i < 4; ++i) {
+                out[i] = (sum[i] + count / 2) / count;
+            }
+        }
+    }
+}
+
+static void decode_job(IMAGE_DECODE_JOB *job) {
+    int width, height, bpp;
+    job->rgba = stbi_load_from_memory(job->png, job->png_size, &width, &height, &bpp, 4);
+    if (!job->rgba) {
+        LOG_WARN("Image Decode", "Unable to decode image for friend %u", job->friend_number);
+        return;
+    }
+
+    if (width <= 0 || height <= 0 || width > UINT16_MAX || height > UINT16_MAX) {
+        LOG_WARN("Image Decode", "Image for friend %u has an unusable size: %ix%i", job->friend_number, width, height);
+        free(job->rgba);
+        job->rgba = NULL;
+        return;
+    }
+
+    job->width     = width;
+    job->height    = height;
+    job->has_alpha = bpp == 4;
+
+    if (!job->thumb_max_width || job->width <= job->thumb_max_width) {
+        return;
+    }
+
+    const uint16_t thumb_w = job->thumb_max_width;
+    const uint16_t thumb_h = MAX((uint32_t)job->height * thumb_w / job->width, 1);
+
+    job->thumb_rgba = malloc(thumb_w * thumb_h * 4);
+    if (!job->thumb_rgba) {
+        // The full image can still be scaled while drawing, so this isn't fatal.
+        LOG_WARN("Image Decode", "Unable to malloc for a %ux%u thumbnail", thumb_w, thumb_h);
+        return;
+    }
+
+    image_downscale_rgba(job->rgba, job->width, job->height, job->thumb_rgba, thumb_w, thumb_h);
+    job->thumb_width  = thumb_w;
+    job->thumb_height = thumb_h;
+}
+
+static void image_decode_thread(void *UNUSED(args)) {
+    while (1) {
+        pthread_mutex_lock(&queue_lock);
+        while (!queue_head) {
+            pthread_cond_wait(&queue_cond, &queue_lock);
+        }
+
+        IMAGE_DECODE_JOB *job = queue_head;
+        queue_head = job->next;
+        if (!queue_head) {
+            queue_tail = NULL;
+        }
+        pthread_mutex_unlock(&queue_lock);
+
+        job->next = NULL;
+        decode_job(job);
+
+        LOG_TRACE("Image Decode", "Decoded %ux%u image for friend %u", job->width, job->height, job->friend_number);
+        postmessage_utox(IMAGE_DECODE_DONE, job->kind, 0, job);
+    }
+}
+
+bool image_decode_queue(IMAGE_DECODE_KIND kind, uint32_t friend_number, uint32_t transfer_id, uint8_t *png,
+                        size_t png_size, uint16_t thumb_max_width) {
+    IMAGE_DECODE_JOB *job = calloc(1, sizeof(IMAGE_DECODE_JOB));
+    if (!job) {
+        LOG_ERR("Image Decode", "Unable to calloc for decode job.");
+        free(png);
+        return false;
+    }
+
+    job->kind            = kind;
+    job->friend_number   = friend_number;
+    job->transfer_id     = transfer_id;
+    job->png             = png;
+    job->png_size        = png_size;
+    job->thumb_max_width = thumb_max_width;
+
+    pthread_mutex_lock(&queue_lock);
+    if (!workers_started) {
+        for (int i = 0; i < IMAGE_DECODE_THREADS; ++i) {
+            thread(image_decode_thread, NULL);
+        }
+        workers_started = true;
+    }
+
+    if (queue_tail) {
+        queue_tail->next = job;
+    } else {
+        queue_head = job;
+    }
+    queue_tail = job;
+
+    pthread_cond_signal(&queue_cond);
+    pthread_mutex_unlock(&queue_lock);
+
+    return true;
+}
+
+void image_decode_free(IMAGE_DECODE_JOB *job) {
+    if (!job) {
+        return;
+    }
+
+    free(job->png);
+    free(job->rgba);
+    free(job->thumb_rgba);
+    free(job);
+}
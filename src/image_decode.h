@@ -0,0 +1,59 @@
+#ifndef IMAGE_DECODE_H
+#define IMAGE_DECODE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Background image decoding.
+ *
+ * Decoding a large PNG (and scaling it down to something we can actually draw) takes long enough to stall the UI, so
+ * inline images and avatars are handed to a small pool of worker threads instead. Once a job is decoded the worker
+ * posts IMAGE_DECODE_DONE to the UI thread with the job as data, the UI thread turns the pixels into a NATIVE_IMAGE
+ * (see utox_rgba_to_native) and frees the job with image_decode_free(). */
+
+#define IMAGE_DECODE_THREADS 2
+
+typedef enum {
+    IMAGE_DECODE_INLINE_RECV,  // Inline image received from a friend
+    IMAGE_DECODE_INLINE_PASTE, // Inline image we're about to send to a friend
+    IMAGE_DECODE_AVATAR,       // Avatar received from a friend
+} IMAGE_DECODE_KIND;
+
+typedef struct image_decode_job {
+    IMAGE_DECODE_KIND kind;
+    uint32_t          friend_number;
+    uint32_t          transfer_id; // Incoming transfer the image came from, for IMAGE_DECODE_INLINE_RECV
+
+    /* PNG data, owned by the job until the UI thread takes it. */
+    uint8_t *png;
+    size_t   png_size;
+
+    /* Widest thumbnail to generate, 0 for none. */
+    uint16_t thumb_max_width;
+
+    /* Set by the worker. rgba is NULL if the PNG couldn't be decoded. */
+    uint8_t *rgba;
+    uint16_t width, height;
+    bool     has_alpha;
+
+    /* Downscaled copy of rgba, only set when the image is wider than thumb_max_width. */
+    uint8_t *thumb_rgba;
+    uint16_t thumb_width, thumb_height;
+
+    struct image_decode_job *next;
+} IMAGE_DECODE_JOB;
+
+/* Queues png (which the job takes ownership of) to be decoded.
+ * Returns false and frees png if the job couldn't be queued. */
+bool image_decode_queue(IMAGE_DECODE_KIND kind, uint32_t friend_number, uint32_t transfer_id, uint8_t *png,
+                        size_t png_size, uint16_t thumb_max_width);
+
+/* Scales src (w x h RGBA) down into dst (dst_w x dst_h RGBA) by averaging every source pixel under each target pixel.
+ * dst must be no larger than src in either dimension. */
+void image_downscale_rgba(const uint8_t *src, uint16_t w, uint16_t h, uint8_t *dst, uint16_t dst_w, uint16_t dst_h);
+
+/* Frees anything left in a finished job, along with the job itself. */
+void image_decode_free(IMAGE_DECODE_JOB *job);
+
+#endif
@@ -16,35 +16,91 @@
 #include "debug.h"
 #include "macros.h"
 #include "settings.h"
+#include "theme.h"
 #include "ui.h"
 
+#include "av/call_stats.h"
 #include "av/video.h"
 
 #include "native/image.h"
+#include "native/time.h"
 
+#include "ui/draw.h"
+
+#include <pthread.h>
+#include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 
-static UTOX_FRAME_PKG current_frame = { 0, 0, 0, 0 };
+/* Frames are decoded into the back buffer and the UI draws the front one. They only swap under frame_lock, which the UI
+ * holds while drawing, so it never sees a half written frame. The buffers are only reallocated when the size changes. */
+typedef struct {
+    uint8_t *img;
+    uint16_t w, h;
+    size_t   size;
+
+    uint32_t friend_number;
+    uint64_t decoded; // get_time() when it came out of the decoder
+    bool     shown;
+} INLINE_BUFFER;
+
+static INLINE_BUFFER   buffers[2];
+static uint8_t         front;
+static pthread_mutex_t frame_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Clicking the video toggles the call statistics over it. */
+static bool mouse_over, show_stats;
+
+bool inline_set_frame(uint32_t friend_number, uint64_t decoded, uint16_t w, uint16_t h, const uint8_t *y,
+                      const uint8_t *u, const uint8_t *v, int32_t ystride, int32_t ustride, int32_t vstride) {
+    // Only this thread ever changes front, so it can look without the lock.
+    INLINE_BUFFER *back = &buffers[!front];
+    const size_t   size = (size_t)w * h * 4;
+
+    if (back->size != size) {
+        uint8_t *tmp = realloc(back->img, size);
+        if (!size || !tmp) {
+            free(tmp ? tmp : back->img);
+            *back = (INLINE_BUFFER){ 0 };
+            return false;
+        }
+        back->img  = tmp;
+        back->size = size;
+    }
+    back->w             = w;
+    back->h             = h;
+    back->friend_number = friend_number;
+    back->decoded       = decoded;
+    back->shown         = false;
 
-bool inline_set_frame(uint16_t w, uint16_t h, size_t size, void *img) {
-    current_frame.w    = w;
-    current_frame.h    = h;
-    current_frame.size = size;
+    yuv420tobgr(w, h, y, u, v, ystride, ustride, vstride, back->img);
 
-    uint8_t *tmp = realloc(current_frame.img, size);
-    if (!size || !tmp) {
-        current_frame.w    = 0;
-        current_frame.h    = 0;
-        current_frame.size = 0;
-        tmp ? free(tmp) : free(current_frame.img);
+    pthread_mutex_lock(&frame_lock);
+    front = !front;
+    pthread_mutex_unlock(&frame_lock);
+    return true;
+}
 
-        return false;
+static void inline_video_draw_stats(uint32_t friend_number, int x, int y, int width) {
+    CALL_STATS_SAMPLE s;
+    if (!call_stats_latest(friend_number, &s)) {
+        return;
     }
 
-    current_frame.img = tmp;
-    memcpy(current_frame.img, img, size);
-    return true;
+    char lines[3][128];
+    int  lengths[3];
+    lengths[0] = snprintf(lines[0], sizeof(lines[0]), S(CALL_STATS_VIDEO), s.capture_fps, s.send_fps, s.recv_fps,
+                          s.video_bitrate);
+    lengths[1] = snprintf(lines[1], sizeof(lines[1]), S(CALL_STATS_TIMING), s.convert_ms, s.encode_ms, s.latency_ms);
+    lengths[2] = snprintf(lines[2], sizeof(lines[2]), S(CALL_STATS_AUDIO), s.audio_queued, s.audio_underruns,
+                          s.audio_dropped, s.audio_bitrate);
+
+    setfont(FONT_MISC);
+    drawrect(x, y, x + width, y + SCALE(10) + COUNTOF(lines) * font_small_lineheight, COLOR_BKGRND_MAIN);
+    setcolor(COLOR_MAIN_TEXT);
+    for (size_t i = 0; i < COUNTOF(lines); ++i) {
+        drawtextrange(x + SCALE(5), x + width - SCALE(5), y + SCALE(5) + i * font_small_lineheight, lines[i],
+                      MIN(lengths[i], (int)sizeof(lines[i]) - 1));
+    }
 }
 
 void inline_video_draw(INLINE_VID *UNUSED(p), int x, int y, int width, int height) {
@@ -54,20 +110,40 @@ void inline_video_draw(INLINE_VID *UNUSED(p), int x, int y, int width, int heigh
 
     LOG_TRACE("Inline Video", "Drawing new frame." );
 
-    if (current_frame.img && current_frame.size) {
-        draw_inline_image(current_frame.img, current_frame.size,
-                          MIN(current_frame.w, width), MIN(current_frame.h, height),
+    pthread_mutex_lock(&frame_lock);
+    INLINE_BUFFER *current_frame = &buffers[front];
+    const bool     have_frame    = current_frame->img && current_frame->size;
+    if (have_frame) {
+        draw_inline_image(current_frame->img, current_frame->size,
+                          MIN(current_frame->w, width), MIN(current_frame->h, height),
                           x, y + MAIN_TOP_FRAME_THICK);
+
+        if (!current_frame->shown) {
+            current_frame->shown = true;
+            call_stats_video_displayed(current_frame->friend_number, get_time() - current_frame->decoded);
+        }
+    }
+    const uint32_t friend_number = current_frame->friend_number;
+    pthread_mutex_unlock(&frame_lock);
+
+    if (have_frame && show_stats) {
+        inline_video_draw_stats(friend_number, x, y + MAIN_TOP_FRAME_THICK, width);
     }
 }
 
-bool inline_video_mmove(INLINE_VID *UNUSED(p), int UNUSED(x), int UNUSED(y), int UNUSED(width), int UNUSED(height),
-                        int UNUSED(mx), int UNUSED(my), int UNUSED(dx), int UNUSED(dy)) {
+bool inline_video_mmove(INLINE_VID *UNUSED(p), int UNUSED(x), int UNUSED(y), int width, int height, int mx, int my,
+                        int UNUSED(dx), int UNUSED(dy)) {
+    mouse_over = settings.inline_video && inrect(mx, my, 0, MAIN_TOP_FRAME_THICK, width, height);
     return 0;
 }
 
 bool inline_video_mdown(INLINE_VID *UNUSED(p)) {
-    return 0;
+    if (!mouse_over) {
+        return 0;
+    }
+
+    show_stats = !show_stats;
+    return 1;
 }
 
 bool inline_video_mright(INLINE_VID *UNUSED(p)) {
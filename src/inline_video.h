@@ -9,7 +9,9 @@
 
 typedef struct inline_vid { PANEL panel; } INLINE_VID;
 
-bool inline_set_frame(uint16_t w, uint16_t h, size_t size, void *img);
+/* Converts a decoded frame straight into the buffer inline video is drawn from. */
+bool inline_set_frame(uint32_t friend_number, uint64_t decoded, uint16_t w, uint16_t h, const uint8_t *y,
+                      const uint8_t *u, const uint8_t *v, int32_t ystride, int32_t ustride, int32_t vstride);
 
 void inline_video_draw(INLINE_VID *p, int x, int y, int width, int height);
 
@@ -9,9 +9,12 @@
 #include "../friend.h"
 #include "../macros.h"
 #include "../settings.h"
+#include "../text.h"
 #include "../theme.h"
 #include "../tox.h"
 
+#include "../av/video.h"
+
 #include "../native/dialog.h"
 
 #include "../ui/draw.h"
@@ -22,6 +25,7 @@
 
 #include "../main.h" // add friend status // TODO this is stupid wrong
 
+#include <stdio.h>
 #include <string.h>
 
 /* Header for friend chat window */
@@ -54,6 +58,18 @@ static void draw_friend(int x, int y, int w, int height) {
     drawtextrange(x + SCALE(60), settings.window_width - SCALE(128), SCALE(32), f->status_message,
                   f->status_length);
 
+    /* What the video pacer settled on for this call. */
+    UTOX_VIDEO_SEND_STATS video_stats;
+    if (utox_video_send_stats(f->number, &video_stats)) {
+        char stats[128];
+        const int length = snprintf(stats, sizeof(stats), S(VIDEO_SEND_STATS), video_stats.width,
+                                    video_stats.height, video_stats.fps, video_stats.bitrate);
+        setfont(FONT_MISC);
+        setcolor(COLOR_MAIN_TEXT_HINT);
+        drawtextrange(x + SCALE(60), settings.window_width - SCALE(128), SCALE(46), stats,
+                      MIN(length, (int)sizeof(stats) - 1));
+    }
+
     if (f->typing) {
         int typing_y = ((y + height) + SCALE(CHAT_BOX_TOP - 14));
         setfont(FONT_MISC);
@@ -786,7 +802,7 @@ EDIT edit_add_new_friend_msg = {
 #include "../commands.h"
 static void e_chat_msg_onenter(EDIT *edit) {
     char *   text   = edit->data;
-    uint16_t length = edit->length;
+    uint32_t length = edit->length;
 
     if (length <= 0) {
         return;
@@ -795,7 +811,7 @@ static void e_chat_msg_onenter(EDIT *edit) {
     uint16_t command_length = 0; //, argument_length = 0;
     char *   command = NULL, *argument = NULL;
 
-    command_length = utox_run_command(text, length, &command, &argument, 1);
+    command_length = utox_run_command(text, MIN(length, UINT16_MAX), &command, &argument, 1);
 
     // TODO: Magic number
     if (command_length == UINT16_MAX) {
@@ -823,13 +839,19 @@ static void e_chat_msg_onenter(EDIT *edit) {
     }
 
     FRIEND *f = flist_get_friend();
-    if (f) {
+    while (f && length) {
+        /* A message holds at most UINT16_MAX bytes, more than that is sent as several. */
+        const uint16_t part = length > UINT16_MAX ? safe_shrink(text, UINT16_MAX, UINT16_MAX) : length;
+
         /* Display locally */
         if (action) {
-            message_add_type_action(&f->msg, 1, text, length, 1, 1);
+            message_add_type_action(&f->msg, 1, text, part, 1, 1);
         } else {
-            message_add_type_text(&f->msg, 1, text, length, 1, 1);
+            message_add_type_text(&f->msg, 1, text, part, 1, 1);
         }
+
+        text += part;
+        length -= part;
     }
     edit->length      = 0;
 }
@@ -851,7 +873,6 @@ SCROLLABLE e_chat_msg_friend_scroll = {
     .color = C_SCROLL,
 };
 
-static char e_chat_msg_friend_data[65535];
 EDIT edit_chat_msg_friend = {
     .panel = {
         .type   = PANEL_EDIT,
@@ -860,8 +881,7 @@ EDIT edit_chat_msg_friend = {
         .width  = -64,
         .height =  40, /* text is 8 high. 8 * 2.5 = 20. */
     },
-    .data        = e_chat_msg_friend_data,
-    .data_size   = sizeof e_chat_msg_friend_data,
+    .resizable   = true,
     .multiline   = true,
     .onenter     = e_chat_msg_onenter,
     .onchange    = e_chat_msg_onchange,
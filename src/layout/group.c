@@ -261,7 +261,7 @@ static uint32_t peers_deduplicate(char **dedup, size_t *dedup_size, GROUP_PEER *
 }
 
 static struct {
-    uint16_t start, end, cursorpos;
+    uint32_t start, end, cursorpos;
     uint32_t length, spacing;
     bool     active;
     bool     edited;
@@ -329,12 +329,6 @@ static uint8_t nick_completion_search(EDIT *edit, char *found_nick, int directio
 }
 
 static void nick_completion_replace(EDIT *edit, char *nick, uint32_t size) {
-    char *   text      = edit->data;
-    uint16_t length    = edit->length;
-    uint16_t maxlength = edit->data_size - 1;
-
-    int offset;
-
     completion.spacing = 1;
     size += 1;
     if (!completion.start) {
@@ -344,37 +338,21 @@ static void nick_completion_replace(EDIT *edit, char *nick, uint32_t size) {
     }
 
     nick[size - 1] = ' ';
-    if (length > completion.end) {
+    if (edit->length > completion.end) {
         size -= 1;
         completion.spacing -= 1;
     }
 
-    if (completion.start + size > maxlength) {
-        size = maxlength - completion.start;
+    if (!edit_replace(edit, completion.start, completion.end - completion.start, nick, size)) {
+        return;
     }
 
-    offset = completion.end - completion.start - size;
-
-    edit_do(edit, completion.start, completion.end - completion.start, 1);
-
-    memmove(text + completion.end - offset, text + completion.end,
-            length - offset > maxlength ? maxlength - completion.end + offset : length - completion.end);
-
-    memcpy(text + completion.start, nick, size);
-
-    edit_do(edit, completion.start, size, 0);
-
-    if (length - offset > maxlength) {
-        edit->length = maxlength;
-    } else {
-        edit->length -= offset;
-    }
-    completion.end -= offset;
+    completion.end = completion.start + size;
 }
 
 static void e_chat_msg_ontab(EDIT *edit) {
     char *text = edit->data;
-    uint16_t length = edit->length;
+    uint32_t length = edit->length;
 
     if (flist_get_type() == ITEM_FRIEND || flist_get_type() == ITEM_GROUP) {
         char    nick[130];
@@ -392,9 +370,8 @@ static void e_chat_msg_ontab(EDIT *edit) {
                     return;
                 }
 
-                text[6] = ' ';
-                memcpy(text + 7, g->name, g->name_length);
-                edit->length = g->name_length + 7;
+                edit_replace(edit, 6, length - 6, " ", 1);
+                edit_replace(edit, 7, 0, g->name, g->name_length);
                 edit_setcursorpos(edit, edit->length);
 
                 return;
@@ -431,7 +408,7 @@ static void e_chat_msg_ontab(EDIT *edit) {
 
 void e_group_msg_onenter(EDIT *edit) {
     char *text = edit->data;
-    uint16_t length = edit->length;
+    uint32_t length = edit->length;
 
     if (length <= 0) {
         return;
@@ -441,7 +418,7 @@ void e_group_msg_onenter(EDIT *edit) {
     char *command = NULL;
     char *argument = NULL;
 
-    command_length = utox_run_command(text, length, &command, &argument, 1);
+    command_length = utox_run_command(text, MIN(length, UINT16_MAX), &command, &argument, 1);
 
     // TODO: Magic number
     if (command_length == UINT16_MAX) {
@@ -470,13 +447,21 @@ void e_group_msg_onenter(EDIT *edit) {
 
     GROUPCHAT *g = flist_get_groupchat();
     if (g) {
-        void *d = malloc(length);
-        if (!d) {
-            LOG_ERR("Layout Group", "edit_msg_onenter:\t Ran out of memory.");
-            return;
+        while (length) {
+            /* A message holds at most UINT16_MAX bytes, more than that is sent as several. */
+            const uint16_t part = length > UINT16_MAX ? safe_shrink(text, UINT16_MAX, UINT16_MAX) : length;
+
+            void *d = malloc(part);
+            if (!d) {
+                LOG_ERR("Layout Group", "edit_msg_onenter:\t Ran out of memory.");
+                return;
+            }
+            memcpy(d, text, part);
+            postmessage_toxcore((action ? TOX_GROUP_SEND_ACTION : TOX_GROUP_SEND_MESSAGE), g->number, part, d);
+
+            text += part;
+            length -= part;
         }
-        memcpy(d, text, length);
-        postmessage_toxcore((action ? TOX_GROUP_SEND_ACTION : TOX_GROUP_SEND_MESSAGE), g->number, length, d);
     } else {
         LOG_ERR("Groups", "No Group selected!");
     }
@@ -523,11 +508,9 @@ SCROLLABLE e_chat_msg_group_scroll = {
     .color = C_SCROLL,
 };
 
-static char e_chat_msg_group_data[65535];
 EDIT edit_chat_msg_group = {
     .multiline   = true,
-    .data_size   = sizeof e_chat_msg_group_data,
-    .data        = e_chat_msg_group_data,
+    .resizable   = true,
     .onenter     = e_group_msg_onenter,
     .ontab       = e_chat_msg_ontab,
     .onshifttab  = e_chat_msg_onshifttab,
@@ -4,10 +4,12 @@
 #include "../flist.h"
 #include "../macros.h"
 #include "../self.h"
+#include "../sized_string.h"
 #include "../theme.h"
 #include "../tox.h"
 #include "../updater.h"
 
+#include "../av/audio.h"
 #include "../av/video.h"
 
 #include "../native/clipboard.h"
@@ -245,11 +247,14 @@ static void draw_settings_text_av(int x, int y, int UNUSED(w), int UNUSED(height
     draw_pos_y += draw_pos_y_inc;
     drawstr(x + SCALE(10), y + SCALE(draw_pos_y - 7), AUDIOOUTPUTDEVICE);
     draw_pos_y += draw_pos_y_inc;
-    drawstr(x + SCALE(10), y + SCALE(draw_pos_y - 15), VIDEOFRAMERATE);
+    drawstr(x + SCALE(10), y + SCALE(draw_pos_y - 15), AUDIO_FRAME_SIZE);
+    drawstr(x + SCALE(200), y + SCALE(draw_pos_y - 15), AUDIO_SAMPLE_RATE);
     draw_pos_y += draw_pos_y_inc;
-    drawstr(x + SCALE(10), y + SCALE(draw_pos_y - 23), VIDEOINPUTDEVICE);
+    drawstr(x + SCALE(10), y + SCALE(draw_pos_y - 23), VIDEOFRAMERATE);
     draw_pos_y += draw_pos_y_inc;
-    drawstr(x + SCALE(10), y + SCALE(draw_pos_y - 30), PREVIEW);
+    drawstr(x + SCALE(10), y + SCALE(draw_pos_y - 31), VIDEOINPUTDEVICE);
+    draw_pos_y += draw_pos_y_inc;
+    drawstr(x + SCALE(10), y + SCALE(draw_pos_y - 38), PREVIEW);
 }
 
 // Notification settings page
@@ -434,6 +439,8 @@ panel_settings_master = {
             (PANEL*)&edit_video_fps,
             (PANEL*)&dropdown_audio_in,
             (PANEL*)&dropdown_audio_out,
+            (PANEL*)&dropdown_audio_frame_size,
+            (PANEL*)&dropdown_audio_capture_rate,
             (PANEL*)&dropdown_video,
             (PANEL*)&switch_audio_filtering,
             NULL
@@ -1341,6 +1348,22 @@ static void dropdown_audio_out_onselect(uint16_t i, const DROPDOWN *dm) {
     postmessage_utoxav(UTOXAV_SET_AUDIO_OUT, 0, 0, handle);
 }
 
+/* Only affects calls started after the change. */
+static void dropdown_audio_frame_size_onselect(uint16_t i, const DROPDOWN *UNUSED(dm)) {
+    const uint16_t frame_sizes[] = UTOX_AUDIO_FRAME_SIZES;
+    settings.audio_frame_ms = frame_sizes[i];
+}
+
+/* Used the next time the microphone is opened. */
+static void dropdown_audio_capture_rate_onselect(uint16_t i, const DROPDOWN *UNUSED(dm)) {
+    const uint16_t capture_rates[] = UTOX_AUDIO_CAPTURE_RATES;
+    settings.audio_capture_rate = capture_rates[i];
+}
+
+static STRING *dropdown_static_ondisplay(uint16_t i, const DROPDOWN *dm) {
+    return &((STRING *)dm->userdata)[i];
+}
+
 static void edit_video_fps_onlosefocus(EDIT *UNUSED(edit)) {
     edit_video_fps.data[edit_video_fps.length] = '\0';
 
@@ -1421,6 +1444,28 @@ DROPDOWN dropdown_audio_out = {
     .onselect = dropdown_audio_out_onselect
 };
 
+static STRING audio_frame_size_drops[] = {
+    STRING_INIT("10 ms"), STRING_INIT("20 ms"), STRING_INIT("40 ms"), STRING_INIT("60 ms"),
+};
+
+DROPDOWN dropdown_audio_frame_size = {
+    .ondisplay = dropdown_static_ondisplay,
+    .onselect  = dropdown_audio_frame_size_onselect,
+    .dropcount = COUNTOF(audio_frame_size_drops),
+    .userdata  = audio_frame_size_drops
+};
+
+static STRING audio_capture_rate_drops[] = {
+    STRING_INIT("48000 Hz"), STRING_INIT("44100 Hz"), STRING_INIT("32000 Hz"), STRING_INIT("16000 Hz"),
+};
+
+DROPDOWN dropdown_audio_capture_rate = {
+    .ondisplay = dropdown_static_ondisplay,
+    .onselect  = dropdown_audio_capture_rate_onselect,
+    .dropcount = COUNTOF(audio_capture_rate_drops),
+    .userdata  = audio_capture_rate_drops
+};
+
 DROPDOWN dropdown_video = {
     .ondisplay = dropdown_list_ondisplay,
     .onselect = dropdown_video_onselect,
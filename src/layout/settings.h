@@ -73,6 +73,8 @@ extern DROPDOWN /* Profile */
                 /* AV */
                 dropdown_audio_in,
                 dropdown_audio_out,
+                dropdown_audio_frame_size,
+                dropdown_audio_capture_rate,
                 dropdown_video,
                 /* Notifications */
                 dropdown_global_group_notifications;
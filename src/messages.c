@@ -392,6 +392,139 @@ uint32_t message_add_type_image(MESSAGES *m, bool auth, NATIVE_IMAGE *img, uint1
     return message_add(m, msg);
 }
 
+uint32_t message_add_type_image_pending(MESSAGES *m, uint32_t transfer_id, uint16_t width, uint16_t height) {
+    MSG_HEADER *msg = calloc(1, sizeof(MSG_HEADER));
+    if (!msg) {
+        LOG_FATAL_ERR(EXIT_MALLOC, "Messages", "Could not allocate memory for message header.");
+    }
+
+    time(&msg->time);
+    msg->our_msg  = false;
+    msg->msg_type = MSG_TYPE_IMAGE;
+
+    msg->via.img.w           = width;
+    msg->via.img.h           = height;
+    msg->via.img.transfer_id = transfer_id;
+
+    return message_add(m, msg);
+}
+
+static uint32_t find_pending_image(MESSAGES *m, uint32_t transfer_id) {
+    if (!transfer_id) {
+        return UINT32_MAX;
+    }
+
+    for (uint32_t i = m->number; i > 0; --i) {
+        MSG_HEADER *msg = m->data[i - 1];
+        if (msg->msg_type == MSG_TYPE_IMAGE && !msg->via.img.image && msg->via.img.transfer_id == transfer_id) {
+            return i - 1;
+        }
+    }
+
+    return UINT32_MAX;
+}
+
+// Moves a message index down past the removed message i, or off it.
+static void message_index_removed(uint32_t *index, uint32_t *position, uint32_t i) {
+    if (*index == UINT32_MAX || *index < i) {
+        return;
+    }
+
+    if (*index > i) {
+        --*index;
+    } else {
+        *position = 0;
+    }
+}
+
+static void message_remove(MESSAGES *m, uint32_t i) {
+    m->height -= m->data[i]->height;
+    message_free(m->data[i]);
+    memmove(&m->data[i], &m->data[i + 1], (m->number - i - 1) * sizeof(MSG_HEADER *));
+    m->number--;
+    m->extra++;
+
+    message_index_removed(&m->sel_start_msg, &m->sel_start_position, i);
+    message_index_removed(&m->sel_end_msg, &m->sel_end_position, i);
+    message_index_removed(&m->cursor_down_msg, &m->cursor_down_position, i);
+    message_index_removed(&m->cursor_over_msg, &m->cursor_over_position, i);
+
+    if (flist_get_friend() && !m->is_groupchat && flist_get_friend()->number == m->id) {
+        m->panel.content_scroll->content_height = m->height;
+    }
+}
+
+void message_set_image_progress(MESSAGES *m, uint32_t transfer_id, uint64_t progress, uint64_t total) {
+    if (!total) {
+        return;
+    }
+
+    pthread_mutex_lock(&messages_lock);
+    const uint32_t i = find_pending_image(m, transfer_id);
+    if (i != UINT32_MAX) {
+        m->data[i]->via.img.progress = MIN(progress * 1000 / total, 1000);
+    }
+    pthread_mutex_unlock(&messages_lock);
+}
+
+bool message_set_pending_image(MESSAGES *m, uint32_t transfer_id, NATIVE_IMAGE *image, uint16_t width, uint16_t height) {
+    if (!NATIVE_IMAGE_IS_VALID(image)) {
+        return false;
+    }
+
+    pthread_mutex_lock(&messages_lock);
+    const uint32_t i = find_pending_image(m, transfer_id);
+    if (i == UINT32_MAX) {
+        pthread_mutex_unlock(&messages_lock);
+        return false;
+    }
+
+    MSG_IMG *img = &m->data[i]->via.img;
+    // The header could lie about the size, fall back to a new message rather than redo the layout.
+    if (img->w != width || img->h != height) {
+        message_remove(m, i);
+        pthread_mutex_unlock(&messages_lock);
+        return false;
+    }
+
+    img->image    = image;
+    img->progress = 1000;
+    pthread_mutex_unlock(&messages_lock);
+
+    return true;
+}
+
+void message_remove_pending_image(MESSAGES *m, uint32_t transfer_id) {
+    pthread_mutex_lock(&messages_lock);
+    const uint32_t i = find_pending_image(m, transfer_id);
+    if (i != UINT32_MAX) {
+        message_remove(m, i);
+    }
+    pthread_mutex_unlock(&messages_lock);
+}
+
+bool message_add_image_thumb(MESSAGES *m, NATIVE_IMAGE *img, NATIVE_IMAGE *thumb, uint16_t width, uint16_t height) {
+    if (!NATIVE_IMAGE_IS_VALID(thumb)) {
+        return false;
+    }
+
+    pthread_mutex_lock(&messages_lock);
+    // The image was just added, so start looking from the newest message.
+    for (uint32_t i = m->number; i > 0; --i) {
+        MSG_HEADER *msg = m->data[i - 1];
+        if (msg->msg_type == MSG_TYPE_IMAGE && msg->via.img.image == img && !msg->via.img.thumb) {
+            msg->via.img.thumb   = thumb;
+            msg->via.img.thumb_w = width;
+            msg->via.img.thumb_h = height;
+            pthread_mutex_unlock(&messages_lock);
+            return true;
+        }
+    }
+    pthread_mutex_unlock(&messages_lock);
+
+    return false;
+}
+
 /* TODO FIX THIS SECTION TO MATCH ABOVE! */
 /* Called by new file transfer to add a new message to the msg list */
 MSG_HEADER *message_add_type_file(MESSAGES *m, uint32_t file_number, bool incoming, bool image, uint8_t status,
@@ -723,9 +856,28 @@ static int messages_draw_text(const char *msg, size_t length, uint32_t msg_heigh
  *  zoom is whether the image is currently zoomed in
  *  position is the y position along the image the player has scrolled */
 static int messages_draw_image(MSG_IMG *img, int x, int y, uint32_t maxwidth) {
+    if (!img->image) {
+        // Still coming in, show how much of it we have.
+        const uint32_t w = MIN(img->w, maxwidth);
+        const uint32_t h = (img->zoom || img->w <= maxwidth) ? img->h : img->h * maxwidth / img->w;
+
+        draw_rect_fill(x, y, w, h, COLOR_BKGRND_AUX);
+        draw_rect_fill(x, y, w * img->progress / 1000, h, COLOR_BKGRND_ALT);
+        draw_rect_frame(x, y, w, h, COLOR_EDGE_NORMAL);
+        return h;
+    }
+
     image_set_filter(img->image, FILTER_BILINEAR);
 
-    if (!img->zoom && img->w > maxwidth) {
+    if (!img->zoom && img->w > maxwidth && img->thumb && img->thumb_w >= maxwidth) {
+        // Scaling the thumbnail touches far fewer pixels than scaling the full image.
+        image_set_filter(img->thumb, FILTER_BILINEAR);
+        image_set_scale(img->thumb, (double)maxwidth / img->thumb_w);
+
+        draw_image(img->thumb, x, y, maxwidth, img->h * maxwidth / img->w, 0, 0);
+
+        image_set_scale(img->thumb, 1.0);
+    } else if (!img->zoom && img->w > maxwidth) {
         image_set_scale(img->image, (double)maxwidth / img->w);
 
         draw_image(img->image, x, y, maxwidth, img->h * maxwidth / img->w, 0, 0);
@@ -1865,6 +2017,7 @@ void message_free(MSG_HEADER *msg) {
 
         case MSG_TYPE_IMAGE: {
             image_free(msg->via.img.image);
+            image_free(msg->via.img.thumb);
             break;
         }
 
@@ -52,6 +52,15 @@ typedef struct {
     bool          zoom;
     double        position;
     NATIVE_IMAGE *image;
+
+    /* Optional downscaled copy drawn instead of image when it's not zoomed, see image_decode.h */
+    NATIVE_IMAGE *thumb;
+    uint32_t      thumb_w, thumb_h;
+
+    /* Incoming images get a placeholder (image == NULL) as soon as we know their size, this tracks the transfer
+     * that will fill it in. See FILE_TRANSFER.transfer_id. */
+    uint32_t transfer_id;
+    uint16_t progress; // Per mille
 } MSG_IMG;
 
 typedef struct msg_file {
@@ -146,6 +155,24 @@ uint32_t message_add_type_action(MESSAGES *m, bool auth, const char *msgtxt, uin
 uint32_t message_add_type_notice(MESSAGES *m, const char *msgtxt, uint16_t length, bool log);
 uint32_t message_add_type_image(MESSAGES *m, bool auth, NATIVE_IMAGE *img, uint16_t width, uint16_t height, bool log);
 
+/* Adds a placeholder for the inline image incoming as transfer_id, drawn as a progress box until
+ * message_set_pending_image() fills it in. */
+uint32_t message_add_type_image_pending(MESSAGES *m, uint32_t transfer_id, uint16_t width, uint16_t height);
+
+/* Updates the progress shown by the placeholder for transfer_id. */
+void message_set_image_progress(MESSAGES *m, uint32_t transfer_id, uint64_t progress, uint64_t total);
+
+/* Fills in the placeholder for transfer_id. Returns false if there isn't one, or if the image isn't the size the
+ * placeholder was made for, which takes the placeholder down. The caller still owns img in that case. */
+bool message_set_pending_image(MESSAGES *m, uint32_t transfer_id, NATIVE_IMAGE *img, uint16_t width, uint16_t height);
+
+/* Takes down the placeholder for transfer_id, if there is one, when the image isn't coming after all. */
+void message_remove_pending_image(MESSAGES *m, uint32_t transfer_id);
+
+/* Attaches a thumbnail to the image message showing img. Returns false if there's no such message, the caller still
+ * owns thumb in that case. */
+bool message_add_image_thumb(MESSAGES *m, NATIVE_IMAGE *img, NATIVE_IMAGE *thumb, uint16_t width, uint16_t height);
+
 MSG_HEADER *message_add_type_file(MESSAGES *m, uint32_t file_number, bool incoming, bool image, uint8_t status,
                                 const uint8_t *name, size_t name_size, size_t target_size, size_t current_size);
 // Returns true if data was logged.
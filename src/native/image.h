@@ -34,6 +34,10 @@ void draw_inline_image(uint8_t *img_data, size_t size, uint16_t w, uint16_t h, i
 /* converts a png to a NATIVE_IMAGE, returns a pointer to it, keeping alpha channel only if keep_alpha is 1 */
 NATIVE_IMAGE *utox_image_to_native(const UTOX_IMAGE, size_t size, uint16_t *w, uint16_t *h, bool keep_alpha);
 
+/* converts decoded RGBA pixels to a NATIVE_IMAGE, takes ownership of (and frees) rgba
+ * must be called from the UI thread, the decoding can be done elsewhere (see image_decode.h) */
+NATIVE_IMAGE *utox_rgba_to_native(uint8_t *rgba, uint16_t width, uint16_t height, bool keep_alpha);
+
 /* free an image created by utox_image_to_native */
 void image_free(NATIVE_IMAGE *image);
 
@@ -1,9 +1,21 @@
 #ifndef NATIVE_UI_H
 #define NATIVE_UI_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 void redraw(void);
 void force_redraw(void);
 
+/* Draws at least the given part of the main window again. */
+void redraw_rect(int x, int y, int width, int height);
+
+#ifdef ENABLE_DEVELOPER_COMMANDS
+/* Draws the whole main window frames times, waiting for each to be done. Gives the average time a frame took and the
+ * number of requests sent to the display server for it. Returns false if it's not supported. */
+bool redraw_benchmark(uint16_t frames, uint64_t *frame_ns, uint32_t *requests);
+#endif
+
 void setscale(void);
 void setscale_fonts(void);
 
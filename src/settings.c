@@ -3,8 +3,11 @@
 #include "debug.h"
 #include "flist.h"
 #include "groups.h"
+#include "macros.h"
 #include "tox.h"
 
+#include "av/audio.h"
+
 // TODO do we want to include the UI headers here?
 // Or would it be better to supply a callback after settings are loaded?
 #include "ui/edit.h"
@@ -71,6 +74,9 @@ SETTINGS settings = {
     .force_proxy    = false,
     .proxy_port     = 0,
 
+    .ft_rate_limit_global = 0,
+    .ft_rate_limit_friend = 0,
+
     // Tox level settings
     .block_friend_requests  = false,
     .save_encryption        = true,
@@ -104,6 +110,11 @@ SETTINGS settings = {
 
     .video_fps              = DEFAULT_FPS,
 
+    .audio_frame_ms         = UTOX_DEFAULT_FRAME_A,
+    .audio_capture_rate     = UTOX_DEFAULT_SAMPLE_RATE_A,
+    .audio_vad_enabled      = true,
+    .audio_comfort_noise    = true,
+
     // Notifications / Alerts
     .ringtone_enabled       = true,
     .status_notifications   = true,
@@ -200,6 +211,8 @@ static void parse_interface_section(UTOX_SAVE *config, const char* key, const ch
         config->magic_flist_enabled = STR_TO_BOOL(value);
     } else if (MATCH(NAMEOF(config->use_long_time_msg), key)) {
         config->use_long_time_msg = STR_TO_BOOL(value);
+    } else if (MATCH(NAMEOF(config->ui_fps_cap), key)) {
+        config->ui_fps_cap = atoi(value);
     }
 }
 
@@ -212,6 +225,14 @@ static void parse_av_section(UTOX_SAVE *config, const char* key, const char* val
         config->audio_device_in = atoi(value);
     } else if (MATCH(NAMEOF(config->audio_device_out), key)) {
         config->audio_device_out = atoi(value);
+    } else if (MATCH(NAMEOF(config->audio_frame_ms), key)) {
+        config->audio_frame_ms = atoi(value);
+    } else if (MATCH(NAMEOF(config->audio_capture_rate), key)) {
+        config->audio_capture_rate = atoi(value);
+    } else if (MATCH(NAMEOF(config->audio_vad_enabled), key)) {
+        config->audio_vad_enabled = STR_TO_BOOL(value);
+    } else if (MATCH(NAMEOF(config->audio_comfort_noise), key)) {
+        config->audio_comfort_noise = STR_TO_BOOL(value);
     } else if (MATCH(NAMEOF(config->video_fps), key)) {
         char *temp;
         uint16_t value_fps = strtol((char *)value, &temp, 0);
@@ -226,6 +247,24 @@ static void parse_av_section(UTOX_SAVE *config, const char* key, const char* val
     }
 }
 
+/* Index of value in options, or of fallback when value isn't one of them. */
+static uint8_t audio_option_index(const uint16_t *options, uint8_t count, uint16_t value, uint16_t fallback) {
+    uint8_t fallback_index = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        if (options[i] == value) {
+            return i;
+        }
+        if (options[i] == fallback) {
+            fallback_index = i;
+        }
+    }
+
+    if (value) {
+        LOG_WARN("Settings", "Audio setting %u is invalid, using %u instead.", value, options[fallback_index]);
+    }
+    return fallback_index;
+}
+
 static void parse_notifications_section(UTOX_SAVE *config, const char* key, const char* value) {
     if (MATCH(NAMEOF(config->audible_notifications_enabled), key)) {
         config->audible_notifications_enabled = STR_TO_BOOL(value);
@@ -253,6 +292,10 @@ static void parse_advanced_section(UTOX_SAVE *config, const char* key, const cha
         config->force_proxy = STR_TO_BOOL(value);
     } else if (MATCH(NAMEOF(config->auto_update), key)) {
         config->auto_update = STR_TO_BOOL(value);
+    } else if (MATCH(NAMEOF(config->ft_rate_limit_global), key)) {
+        config->ft_rate_limit_global = atoi(value);
+    } else if (MATCH(NAMEOF(config->ft_rate_limit_friend), key)) {
+        config->ft_rate_limit_friend = atoi(value);
     }
 }
 
@@ -304,6 +347,10 @@ static UTOX_SAVE *utox_load_config(void) {
         return NULL;
     }
 
+    // Configs written before these existed don't have them, so they start out at their defaults.
+    save->audio_vad_enabled   = true;
+    save->audio_comfort_noise = true;
+
     if (!ini_browse(config_parser, save, config_path)) {
         LOG_ERR("Settings", "Unable to parse %s.", config_file_name);
         free(config_path);
@@ -346,6 +393,7 @@ static bool utox_save_config(UTOX_SAVE *config) {
     write_config_value_bool(config_path, config_sections[INTERFACE_SECTION], NAMEOF(config->filter), config->filter);
     write_config_value_bool(config_path, config_sections[INTERFACE_SECTION], NAMEOF(config->magic_flist_enabled), config->magic_flist_enabled);
     write_config_value_bool(config_path, config_sections[INTERFACE_SECTION], NAMEOF(config->use_long_time_msg), config->use_long_time_msg);
+    write_config_value_int(config_path, config_sections[INTERFACE_SECTION], NAMEOF(config->ui_fps_cap), config->ui_fps_cap);
 
     // av
     write_config_value_bool(config_path, config_sections[AV_SECTION], NAMEOF(config->push_to_talk), config->push_to_talk);
@@ -353,6 +401,10 @@ static bool utox_save_config(UTOX_SAVE *config) {
     write_config_value_int(config_path, config_sections[AV_SECTION], NAMEOF(config->audio_device_in), config->audio_device_in);
     write_config_value_int(config_path, config_sections[AV_SECTION], NAMEOF(config->audio_device_out), config->audio_device_out);
     write_config_value_int(config_path, config_sections[AV_SECTION], NAMEOF(config->video_fps), config->video_fps);
+    write_config_value_int(config_path, config_sections[AV_SECTION], NAMEOF(config->audio_frame_ms), config->audio_frame_ms);
+    write_config_value_int(config_path, config_sections[AV_SECTION], NAMEOF(config->audio_capture_rate), config->audio_capture_rate);
+    write_config_value_bool(config_path, config_sections[AV_SECTION], NAMEOF(config->audio_vad_enabled), config->audio_vad_enabled);
+    write_config_value_bool(config_path, config_sections[AV_SECTION], NAMEOF(config->audio_comfort_noise), config->audio_comfort_noise);
     // TODO: video_input_device
 
     // notifications
@@ -369,6 +421,8 @@ static bool utox_save_config(UTOX_SAVE *config) {
     write_config_value_str(config_path, config_sections[ADVANCED_SECTION], NAMEOF(config->proxy_ip), (const char *)config->proxy_ip);
     write_config_value_bool(config_path, config_sections[ADVANCED_SECTION], NAMEOF(config->force_proxy), config->force_proxy);
     write_config_value_bool(config_path, config_sections[ADVANCED_SECTION], NAMEOF(config->auto_update), config->auto_update);
+    write_config_value_int(config_path, config_sections[ADVANCED_SECTION], NAMEOF(config->ft_rate_limit_global), config->ft_rate_limit_global);
+    write_config_value_int(config_path, config_sections[ADVANCED_SECTION], NAMEOF(config->ft_rate_limit_friend), config->ft_rate_limit_friend);
     // TODO: block_friend_requests
 
     free(config_path);
@@ -389,6 +443,8 @@ static UTOX_SAVE *init_default_settings(void) {
 
     save->audio_filtering_enabled       = true;
     save->audible_notifications_enabled = true;
+    save->audio_vad_enabled             = true;
+    save->audio_comfort_noise           = true;
 
     return save;
 }
@@ -464,6 +520,9 @@ UTOX_SAVE *config_load(void) {
     settings.proxy_port  = save->proxy_port;
     settings.force_proxy = save->force_proxy;
 
+    settings.ft_rate_limit_global = save->ft_rate_limit_global;
+    settings.ft_rate_limit_friend = save->ft_rate_limit_friend;
+
     if (strlen((char *)save->proxy_ip) <= proxy_address_size){
         strcpy((char *)proxy_address, (char *)save->proxy_ip);
     }
@@ -487,9 +546,12 @@ UTOX_SAVE *config_load(void) {
     settings.use_mini_flist       = save->use_mini_flist;
     settings.magic_flist_enabled  = save->magic_flist_enabled;
     settings.use_long_time_msg    = save->use_long_time_msg;
+    settings.ui_fps_cap           = save->ui_fps_cap;
 
     settings.ringtone_enabled     = save->audible_notifications_enabled;
     settings.audiofilter_enabled  = save->audio_filtering_enabled;
+    settings.audio_vad_enabled    = save->audio_vad_enabled;
+    settings.audio_comfort_noise  = save->audio_comfort_noise;
 
     settings.send_typing_status   = !save->no_typing_notifications;
     settings.status_notifications = save->status_notifications;
@@ -515,6 +577,18 @@ UTOX_SAVE *config_load(void) {
     edit_video_fps.length = strnlen((char *)edit_video_fps.data,
                                     edit_video_fps.data_size - 1);
 
+    const uint16_t frame_sizes[] = UTOX_AUDIO_FRAME_SIZES;
+    const uint8_t frame_size = audio_option_index(frame_sizes, COUNTOF(frame_sizes), save->audio_frame_ms,
+                                                  UTOX_DEFAULT_FRAME_A);
+    settings.audio_frame_ms = frame_sizes[frame_size];
+    dropdown_audio_frame_size.selected = dropdown_audio_frame_size.over = frame_size;
+
+    const uint16_t capture_rates[] = UTOX_AUDIO_CAPTURE_RATES;
+    const uint8_t capture_rate = audio_option_index(capture_rates, COUNTOF(capture_rates), save->audio_capture_rate,
+                                                    UTOX_DEFAULT_SAMPLE_RATE_A);
+    settings.audio_capture_rate = capture_rates[capture_rate];
+    dropdown_audio_capture_rate.selected = dropdown_audio_capture_rate.over = capture_rate;
+
     // TODO: Don't clobber (and start saving) commandline flags.
 
     // Allow users to override theme on the cmdline.
@@ -560,7 +634,12 @@ void config_save(UTOX_SAVE *save_in) {
     save->use_mini_flist                = settings.use_mini_flist;
     save->magic_flist_enabled           = settings.magic_flist_enabled;
     save->use_long_time_msg             = settings.use_long_time_msg;
+    save->ui_fps_cap                    = settings.ui_fps_cap;
     save->video_fps                     = settings.video_fps;
+    save->audio_frame_ms                = settings.audio_frame_ms;
+    save->audio_capture_rate            = settings.audio_capture_rate;
+    save->audio_vad_enabled             = settings.audio_vad_enabled;
+    save->audio_comfort_noise           = settings.audio_comfort_noise;
 
     save->disableudp                    = !settings.enable_udp;
     save->enableipv6                    = settings.enable_ipv6;
@@ -569,6 +648,8 @@ void config_save(UTOX_SAVE *save_in) {
     save->filter                        = flist_get_filter();
     save->proxy_port                    = settings.proxy_port;
     save->force_proxy                   = settings.force_proxy;
+    save->ft_rate_limit_global          = settings.ft_rate_limit_global;
+    save->ft_rate_limit_friend          = settings.ft_rate_limit_friend;
 
     save->audio_device_in               = dropdown_audio_in.selected;
     save->audio_device_out              = dropdown_audio_out.selected;
@@ -620,5 +701,12 @@ UTOX_SAVE *utox_data_load_utox(void) {
     }
 
     fclose(fp);
+
+    // The old format never had these.
+    if (size >= sizeof(UTOX_SAVE)) {
+        save->audio_vad_enabled   = true;
+        save->audio_comfort_noise = true;
+    }
+
     return save;
 }
@@ -6,9 +6,10 @@ typedef struct utox_save UTOX_SAVE;
 #include "debug.h"
 #include "../langs/i18n_decls.h"
 
-#include <stdio.h>
-#include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 
 #define DEFAULT_FPS 25
 
@@ -40,6 +41,10 @@ typedef struct utox_settings {
     bool use_proxy;
     uint16_t proxy_port;
 
+    // Outgoing file transfer bandwidth limits in KiB/s, 0 is unlimited
+    uint16_t ft_rate_limit_global;
+    uint16_t ft_rate_limit_friend;
+
     // User interface settings
     UTOX_LANG language;
     bool audiofilter_enabled;
@@ -78,6 +83,12 @@ typedef struct utox_settings {
 
     bool    window_maximized;
     uint8_t video_fps;
+    uint8_t ui_fps_cap; // The main window is painted at most this often, 0 follows the display
+
+    uint8_t  audio_frame_ms;     // Frame duration for new calls
+    uint16_t audio_capture_rate; // Rate the microphone is opened at, anything but 48kHz is resampled
+    bool     audio_vad_enabled;  // Don't send frames the voice activity detector thinks are silent
+    bool     audio_comfort_noise; // End every talkspurt with a frame of comfort noise
 } SETTINGS;
 
 extern SETTINGS settings;
@@ -129,10 +140,24 @@ typedef struct utox_save {
     uint8_t force_proxy;
     uint8_t use_long_time_msg;
 
-    uint8_t  unused[51];
+    // Fields below are placed so no padding is needed, proxy_ip has to stay where it was for older saves.
+    uint8_t  audio_frame_ms;
+    uint16_t ft_rate_limit_global;
+    uint16_t ft_rate_limit_friend;
+
+    uint16_t audio_capture_rate;
+    uint8_t  audio_vad_enabled   : 1;
+    uint8_t  audio_comfort_noise : 1;
+    uint8_t  zero_4              : 6;
+
+    uint8_t  ui_fps_cap;
+
+    uint8_t  unused[42];
     uint8_t  proxy_ip[];
 } UTOX_SAVE;
 
+_Static_assert(offsetof(UTOX_SAVE, proxy_ip) == 86, "proxy_ip moved, saves from older versions won't load");
+
 /*
  * Loads the config file and returns a settings struct
  */
@@ -29,10 +29,7 @@ int textwidth(const char *str, uint16_t length) {
         str += len;
         length -= len;
 
-        const GLYPH *g = font_getglyph(sfont, ch);
-        if (g) {
-            x += g->xadvance;
-        }
+        x += font_getadvance(sfont, ch);
     }
 
     return x;
@@ -57,12 +54,9 @@ int textfit(const char *str, uint16_t length, int width) {
         const uint8_t len = utf8_len_read(str, &ch);
         str += len;
 
-        const GLYPH *g = font_getglyph(sfont, ch);
-        if (g) {
-            x += g->xadvance;
-            if (x > width) {
-                return i;
-            }
+        x += font_getadvance(sfont, ch);
+        if (x > width) {
+            return i;
         }
 
         i += len;
@@ -297,6 +297,14 @@ bool strstr_case(const char *a, const char *b) {
     return 0;
 }
 
+char *strcpy_lower(char *dest, const char *src, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        *dest++ = tolower((unsigned char)src[i]);
+    }
+
+    return dest;
+}
+
 uint16_t safe_shrink(const char *string, uint16_t string_length, uint16_t shrink_length) {
     if (!string) {
         return 0;
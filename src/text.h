@@ -2,6 +2,7 @@
 #define TEXT_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /** convert number of bytes to human readable string
@@ -44,6 +45,10 @@ void to_hex(char *out, uint8_t *in, int size);
 /* returns non-zero if substring is found */
 bool strstr_case(const char *a, const char *b);
 
+/* copy length bytes from src to dest with the case folded the way strstr_case() ignores it, returns the end of dest
+ */
+char *strcpy_lower(char *dest, const char *src, size_t length);
+
 /**
  * @brief Shrink UTF-8 string down to provided length
  * without splitting last UTF-8 multi-bytes character.
@@ -4,6 +4,7 @@
 #include "file_transfers.h"
 #include "flist.h"
 #include "friend.h"
+#include "ft_scheduler.h"
 #include "groups.h"
 #include "debug.h"
 #include "macros.h"
@@ -553,6 +554,9 @@ void toxcore_thread(void *UNUSED(args)) {
                 typing_state.sent = (msg->msg == TOX_SEND_MESSAGE || msg->msg == TOX_SEND_ACTION);
             }
 
+            // Answer the chunk requests toxcore made during tox_iterate()
+            ft_send_queued_chunks(tox, time);
+
             if (settings.send_typing_status) {
                 // Thread active transfers and check if friend is typing
                 utox_thread_work_for_typing_notifications(tox, time);
@@ -570,6 +574,7 @@ void toxcore_thread(void *UNUSED(args)) {
         // Stop toxcore.
         LOG_TRACE("Toxcore", "tox thread ending");
         tox_kill(tox);
+        ft_sched_raze();
     }
 
     tox_thread_init = UTOX_TOX_THREAD_INIT_NONE;
@@ -1016,6 +1021,7 @@ static void tox_thread_message(Tox *tox, ToxAV *av, uint64_t time, uint8_t msg,
             LOG_TRACE("Toxcore", "Starting video for active call!" );
             utox_av_local_call_control(av, param1, TOXAV_CALL_CONTROL_SHOW_VIDEO);
             get_friend(param1)->call_state_self |= TOXAV_FRIEND_CALL_STATE_SENDING_V | TOXAV_FRIEND_CALL_STATE_ACCEPTING_V;
+            utox_video_call_update(param1);
             break;
         }
         case TOX_CALL_DISCONNECT: {
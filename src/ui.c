@@ -19,6 +19,7 @@
 
 #include "ui/button.h"
 #include "ui/contextmenu.h"
+#include "ui/damage.h"
 #include "ui/draw.h"
 #include "ui/dropdown.h"
 #include "ui/edit.h"
@@ -125,10 +126,10 @@ static void settings_AV(void) {
 
     #ifndef AUDIO_FILTERING
         const uint16_t start_draw_y = 30;
-        const uint16_t preview_button_pos_y = 245;
+        const uint16_t preview_button_pos_y = 297;
     #else
         const uint16_t start_draw_y = 60;
-        const uint16_t preview_button_pos_y = 275;
+        const uint16_t preview_button_pos_y = 327;
         CREATE_SWITCH(audio_filtering, 10, 40, _BM_SWITCH_WIDTH, _BM_SWITCH_HEIGHT);
     #endif
 
@@ -136,8 +137,10 @@ static void settings_AV(void) {
     const uint16_t draw_y_vect = 30;
     CREATE_DROPDOWN(audio_in,  10, (start_draw_y + draw_y_vect + 5), 24, 360);
     CREATE_DROPDOWN(audio_out, 10, (start_draw_y + draw_y_vect + 57), 24, 360);
-    CREATE_EDIT(video_fps,     10, (start_draw_y + draw_y_vect + 110), 360, 24);
-    CREATE_DROPDOWN(video,     10, (start_draw_y + draw_y_vect + 162), 24, 360);
+    CREATE_DROPDOWN(audio_frame_size,   10, (start_draw_y + draw_y_vect + 110), 24, 170);
+    CREATE_DROPDOWN(audio_capture_rate, 200, (start_draw_y + draw_y_vect + 110), 24, 170);
+    CREATE_EDIT(video_fps,     10, (start_draw_y + draw_y_vect + 162), 360, 24);
+    CREATE_DROPDOWN(video,     10, (start_draw_y + draw_y_vect + 214), 24, 360);
 
     CREATE_BUTTON(callpreview,  10, (preview_button_pos_y + 35), _BM_LBUTTON_WIDTH, _BM_LBUTTON_HEIGHT);
     CREATE_BUTTON(videopreview, 70, (preview_button_pos_y + 35), _BM_LBUTTON_WIDTH, _BM_LBUTTON_HEIGHT);
@@ -373,9 +376,21 @@ void ui_mouseleave(void) {
     redraw();
 }
 
+/* The part of the window being drawn, NULL when it's all of it. */
+static const DAMAGE_RECT *draw_damage;
+
 static void panel_draw_core(PANEL *p, int x, int y, int width, int height) {
     FIX_XY_CORDS_FOR_SUBPANELS();
 
+    p->drawn_x      = x;
+    p->drawn_y      = y;
+    p->drawn_width  = width;
+    p->drawn_height = height;
+
+    if (draw_damage && !damage_intersects(draw_damage, x, y, width, height)) {
+        return;
+    }
+
     if (p->content_scroll) {
         pushclip(x, y, width, height);
         y -= scroll_gety(p->content_scroll, height);
@@ -418,6 +433,48 @@ void panel_draw(PANEL *p, int x, int y, int width, int height) {
     enddraw(x, y, width, height);
 }
 
+uint64_t panel_draw_damaged(PANEL *p, int width, int height) {
+    DAMAGE_RECT rects[DAMAGE_MAX_RECTS];
+    const uint8_t count = damage_take(rects, width, height);
+
+    uint64_t pixels = 0;
+    for (uint8_t i = 0; i < count; ++i) {
+        const DAMAGE_RECT *r = &rects[i];
+
+        draw_damage = r;
+        pushclip(r->x, r->y, r->width, r->height);
+        panel_draw_core(p, 0, 0, width, height);
+
+        dropdown_drawactive();
+        contextmenu_draw();
+        tooltip_draw();
+
+        popclip();
+        draw_damage = NULL;
+
+        enddraw(r->x, r->y, r->width, r->height);
+        pixels += (uint64_t)r->width * r->height;
+    }
+
+    return pixels;
+}
+
+void panel_draw_bounds(int *top, int *bottom) {
+    if (draw_damage) {
+        *top    = MAX(*top, draw_damage->y);
+        *bottom = MIN(*bottom, draw_damage->y + draw_damage->height);
+    }
+}
+
+void redraw_panel(PANEL *p) {
+    if (!p->drawn_width || !p->drawn_height) {
+        redraw();
+        return;
+    }
+
+    redraw_rect(p->drawn_x, p->drawn_y, p->drawn_width, p->drawn_height);
+}
+
 bool panel_mmove(PANEL *p, int x, int y, int width, int height, int mx, int my, int dx, int dy) {
     if (p == &panel_root) {
         mouse.x = mx;
@@ -101,6 +101,16 @@ void ui_mouseleave(void);
 
 void panel_draw(PANEL *p, int x, int y, int width, int height);
 
+/* Draws only what was marked with redraw_rect() or redraw_panel() since the last frame, everything if it was redraw().
+ * Returns the number of pixels painted, 0 if there was nothing to do. */
+uint64_t panel_draw_damaged(PANEL *p, int width, int height);
+
+/* Marks the area p took up the last time it was drawn, or the whole window if it hasn't been yet. */
+void redraw_panel(PANEL *p);
+
+/* Narrows top and bottom down to the part of the window being drawn, for panels that skip what isn't. */
+void panel_draw_bounds(int *top, int *bottom);
+
 bool panel_mmove(PANEL *p, int x, int y, int width, int height, int mx, int my, int dx, int dy);
 void panel_mdown(PANEL *p);
 bool panel_dclick(PANEL *p, bool triclick);
@@ -0,0 +1,130 @@
+#include "damage.h"
+
+#include "../macros.h"
+
+#include <pthread.h>
+#include <string.h>
+
+static DAMAGE_RECT damage[DAMAGE_MAX_RECTS];
+static uint8_t     damage_count;
+static bool        damage_full = true;
+
+static DAMAGE_STATS counted;
+static uint64_t     last_report;
+
+// Things other than the UI thread may ask for a redraw.
+static pthread_mutex_t damage_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int64_t area(const DAMAGE_RECT *r) {
+    return (int64_t)r->width * r->height;
+}
+
+static DAMAGE_RECT rect_union(const DAMAGE_RECT *a, const DAMAGE_RECT *b) {
+    const int x = MIN(a->x, b->x), y = MIN(a->y, b->y);
+    return (DAMAGE_RECT){
+        .x      = x,
+        .y      = y,
+        .width  = MAX(a->x + a->width, b->x + b->width) - x,
+        .height = MAX(a->y + a->height, b->y + b->height) - y,
+    };
+}
+
+void damage_all(void) {
+    pthread_mutex_lock(&damage_lock);
+    damage_full  = true;
+    damage_count = 0;
+    pthread_mutex_unlock(&damage_lock);
+}
+
+void damage_add(int x, int y, int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&damage_lock);
+    if (damage_full) {
+        pthread_mutex_unlock(&damage_lock);
+        return;
+    }
+
+    DAMAGE_RECT r = { x, y, width, height };
+
+    // Every merge can make the new rectangle reach one it didn't before, so start over after each one.
+    for (uint8_t i = 0; i < damage_count;) {
+        const DAMAGE_RECT u = rect_union(&damage[i], &r);
+        if (area(&u) <= area(&damage[i]) + area(&r)) {
+            r = u;
+            damage[i] = damage[--damage_count];
+            i = 0;
+        } else {
+            ++i;
+        }
+    }
+
+    if (damage_count < DAMAGE_MAX_RECTS) {
+        damage[damage_count++] = r;
+    } else {
+        uint8_t best = 0;
+        int64_t best_growth = INT64_MAX;
+        for (uint8_t i = 0; i < damage_count; ++i) {
+            const DAMAGE_RECT u = rect_union(&damage[i], &r);
+            const int64_t growth = area(&u) - area(&damage[i]);
+            if (growth < best_growth) {
+                best        = i;
+                best_growth = growth;
+            }
+        }
+
+        damage[best] = rect_union(&damage[best], &r);
+    }
+
+    pthread_mutex_unlock(&damage_lock);
+}
+
+uint8_t damage_take(DAMAGE_RECT rects[DAMAGE_MAX_RECTS], int window_width, int window_height) {
+    pthread_mutex_lock(&damage_lock);
+
+    uint8_t count = 0;
+    if (damage_full) {
+        rects[count++] = (DAMAGE_RECT){ 0, 0, window_width, window_height };
+    } else {
+        for (uint8_t i = 0; i < damage_count; ++i) {
+            const DAMAGE_RECT *d = &damage[i];
+            const int x = MAX(d->x, 0), y = MAX(d->y, 0);
+            const int right = MIN(d->x + d->width, window_width), bottom = MIN(d->y + d->height, window_height);
+            if (right > x && bottom > y) {
+                rects[count++] = (DAMAGE_RECT){ x, y, right - x, bottom - y };
+            }
+        }
+    }
+
+    damage_full  = false;
+    damage_count = 0;
+
+    pthread_mutex_unlock(&damage_lock);
+    return count;
+}
+
+bool damage_intersects(const DAMAGE_RECT *rect, int x, int y, int width, int height) {
+    return x < rect->x + rect->width && rect->x < x + width && y < rect->y + rect->height && rect->y < y + height;
+}
+
+bool damage_count_frame(uint64_t now, uint64_t draw_ns, uint64_t pixels, DAMAGE_STATS *stats) {
+    counted.frames++;
+    counted.draw_ns += draw_ns;
+    counted.max_draw_ns = MAX(counted.max_draw_ns, draw_ns);
+    counted.pixels += pixels;
+
+    if (!last_report) {
+        last_report = now;
+    }
+
+    if (now - last_report < (uint64_t)DAMAGE_REPORT_INTERVAL_MS * 1000 * 1000) {
+        return false;
+    }
+
+    *stats      = counted;
+    last_report = now;
+    memset(&counted, 0, sizeof(counted));
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef UI_DAMAGE_H
+#define UI_DAMAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The parts of the main window that need to be drawn again. Everything that's marked between two frames is coalesced
+ * into at most DAMAGE_MAX_RECTS rectangles, rectangles that are cheaper drawn together than apart are merged and when
+ * there's no room left the new one goes into the rectangle it grows the least. */
+
+#define DAMAGE_MAX_RECTS 8
+#define DAMAGE_REPORT_INTERVAL_MS 10000
+
+typedef struct {
+    int x, y, width, height;
+} DAMAGE_RECT;
+
+/* Marks the whole window. */
+void damage_all(void);
+
+void damage_add(int x, int y, int width, int height);
+
+/* Moves everything that was marked into rects, cut to the window, and returns how many there are. */
+uint8_t damage_take(DAMAGE_RECT rects[DAMAGE_MAX_RECTS], int window_width, int window_height);
+
+bool damage_intersects(const DAMAGE_RECT *rect, int x, int y, int width, int height);
+
+typedef struct {
+    uint32_t frames;
+    uint64_t draw_ns, max_draw_ns;
+    uint64_t pixels; // Painted
+} DAMAGE_STATS;
+
+/* Counts a frame that took draw_ns to paint pixels. At most every DAMAGE_REPORT_INTERVAL_MS the frames counted since
+ * the last report are moved into stats and true is returned. */
+bool damage_count_frame(uint64_t now, uint64_t draw_ns, uint64_t pixels, DAMAGE_STATS *stats);
+
+#endif // UI_DAMAGE_H
@@ -24,14 +24,72 @@
 static EDIT *active_edit;
 
 static struct {
-    uint16_t start, length;
-    uint16_t p1, p2;
+    uint32_t start, length;
+    uint32_t p1, p2;
     // IME mark (underline)
-    uint16_t mark_start, mark_length;
+    uint32_t mark_start, mark_length;
 } edit_sel;
 
 static bool edit_select;
 
+/* Resizable edits start out with room for this much, and at least double when they grow. */
+#define EDIT_MIN_SIZE 256
+
+/* The most text data holds, one byte is kept for whoever puts a terminator after it. */
+static uint32_t text_capacity(const EDIT *edit) {
+    return edit->data_size ? MIN(edit->data_size - 1, (size_t)UINT32_MAX - 1) : 0;
+}
+
+/* Makes room for length more bytes of text, growing data if the edit is resizable. Returns false if it can't. */
+static bool text_reserve(EDIT *edit, uint32_t length) {
+    const uint32_t capacity = text_capacity(edit);
+    if (edit->data && edit->length <= capacity && length <= capacity - edit->length) {
+        return true;
+    }
+
+    if (!edit->resizable || length > UINT32_MAX - 1 - edit->length) {
+        return false;
+    }
+
+    size_t size = MAX((size_t)edit->length + length + 1, MAX(edit->data_size * 2, (size_t)EDIT_MIN_SIZE));
+    size        = MIN(size, (size_t)UINT32_MAX);
+
+    char *data = realloc(edit->data, size);
+    if (!data) {
+        LOG_FATAL_ERR(EXIT_MALLOC, "UI Edit", "Unable to realloc for %zu bytes of text.", size);
+    }
+
+    edit->data      = data;
+    edit->data_size = size;
+    return true;
+}
+
+/* Gives back what a resizable edit grew to once it's empty again, like after a long message was sent. */
+static void text_shrink(EDIT *edit) {
+    if (edit->resizable && !edit->length && edit->data_size > EDIT_MIN_SIZE) {
+        char *data = realloc(edit->data, EDIT_MIN_SIZE);
+        if (data) {
+            edit->data      = data;
+            edit->data_size = EDIT_MIN_SIZE;
+        }
+    }
+}
+
+/* Replaces length bytes at pos with str, the text after them is moved once. There has to be room for it. */
+static void text_splice(EDIT *edit, uint32_t pos, uint32_t length, const char *str, uint32_t str_length) {
+    if (!length && !str_length) {
+        return;
+    }
+
+    char *p = edit->data + pos;
+    memmove(p + str_length, p + length, edit->length - (pos + length));
+    if (str_length) {
+        memcpy(p, str, str_length);
+    }
+
+    edit->length = edit->length - length + str_length;
+}
+
 static void setactive(EDIT *edit) {
     if (edit != active_edit) {
         edit_will_deactivate();
@@ -40,6 +98,11 @@ static void setactive(EDIT *edit) {
             active_edit->onlosefocus(active_edit);
         }
 
+        // Keys like end read the text right away, even when there's none yet.
+        if (edit && edit->resizable && !edit->data) {
+            text_reserve(edit, 0);
+        }
+
         active_edit = edit;
     }
 }
@@ -125,8 +188,8 @@ void edit_draw(EDIT *edit, int x, int y, int width, int height) {
             x + width - SCALE(4) - (edit->multiline ? SCALE(SCROLL_WIDTH) : 0),
             y, y + height, font_small_lineheight,
             star ? star : edit->data, edit->length,
-            is_active ? edit_sel.start : UINT16_MAX,
-            is_active ? edit_sel.length : UINT16_MAX,
+            is_active ? edit_sel.start : UINT32_MAX,
+            is_active ? edit_sel.length : UINT32_MAX,
             is_active ? edit_sel.mark_start : 0,
             is_active ? edit_sel.mark_length : 0,
             edit->multiline);
@@ -173,7 +236,7 @@ bool edit_mmove(EDIT *edit, int px, int py, int width, int height, int x, int y,
             hittextmultiline(x - SCALE(4), width - SCALE(8) - (edit->multiline ? SCALE(SCROLL_WIDTH) : 0), y - SCALE(4),
                              INT_MAX, font_small_lineheight, edit->data, edit->length, edit->multiline);
 
-        uint16_t start, length;
+        uint32_t start, length;
         if (edit_sel.p2 > edit_sel.p1) {
             start  = edit_sel.p1;
             length = edit_sel.p2 - edit_sel.p1;
@@ -233,7 +296,7 @@ bool edit_dclick(EDIT *edit, bool triclick) {
         edit->mouseover_char = edit->length;
     }
 
-    uint16_t i = edit->mouseover_char;
+    uint32_t i = edit->mouseover_char;
     while (i != 0 && edit->data[i - 1] != '\n'
            /*  If it's a dclick, also set ' ' as boundary, else do nothing. */
            && (!triclick ? (edit->data[i - 1] != ' ') : 1)) {
@@ -331,77 +394,209 @@ bool edit_mleave(EDIT *edit) {
     return false;
 }
 
-static void edit_redraw(void) {
-    redraw();
+static void edit_redraw(EDIT *edit) {
+    redraw_panel(&edit->panel);
+}
+
+static EDIT_CHANGE *history_at(EDIT_HISTORY *h, uint16_t i) {
+    return &h->changes[(h->first + i) % EDIT_HISTORY_CHANGES];
+}
+
+static void change_reserve(EDIT_HISTORY *h, EDIT_CHANGE *c, uint32_t length) {
+    if (c->capacity >= length) {
+        return;
+    }
+
+    const uint32_t capacity = MAX(length, MAX(c->capacity * 2, 16u));
+    char *data = realloc(c->data, capacity);
+    if (!data) {
+        LOG_FATAL_ERR(EXIT_MALLOC, "UI Edit", "Unable to realloc for edit history, this should never happen!");
+    }
+
+    h->bytes += capacity - c->capacity;
+    c->data     = data;
+    c->capacity = capacity;
+}
+
+static void change_forget(EDIT_HISTORY *h, EDIT_CHANGE *c) {
+    h->bytes -= c->capacity;
+    free(c->data);
+    c->data     = NULL;
+    c->capacity = 0;
+}
+
+/* Forgets changes until what's kept fits in EDIT_HISTORY_BYTES: the oldest ones that can be undone go first, then
+ * the ones furthest away to redo. The changes on either side of the cursor stay. */
+static void history_trim(EDIT_HISTORY *h) {
+    while (h->bytes > EDIT_HISTORY_BYTES && h->applied > 1) {
+        change_forget(h, history_at(h, 0));
+        h->first = (h->first + 1) % EDIT_HISTORY_CHANGES;
+        h->applied--;
+        h->count--;
+    }
+
+    while (h->bytes > EDIT_HISTORY_BYTES && h->count > h->applied + 1) {
+        change_forget(h, history_at(h, --h->count));
+    }
+}
+
+void edit_history_clear(EDIT_HISTORY *h) {
+    if (!h) {
+        return;
+    }
+
+    for (size_t i = 0; i < COUNTOF(h->changes); ++i) {
+        change_forget(h, &h->changes[i]);
+    }
+
+    h->first   = 0;
+    h->applied = 0;
+    h->count   = 0;
 }
 
-static uint16_t edit_change_do(EDIT *edit, EDIT_CHANGE *c) {
-    uint16_t r = c->start;
+void edit_history_free(EDIT_HISTORY *h) {
+    edit_history_clear(h);
+    free(h);
+}
+
+/* Adds the change to c if it continues it: typing on at the end of what was typed, without starting a new word or
+ * line, or deleting the character right before or after what was deleted. Only single characters are added. */
+static bool change_coalesce(EDIT_HISTORY *h, EDIT_CHANGE *c, const char *text, uint32_t start, uint32_t length,
+                            bool remove) {
+    if (c->remove != remove || length > 4 || text[start] == '\n') {
+        return false;
+    }
+
+    if (!remove) {
+        if (c->start + c->length != start || !start) {
+            return false;
+        }
+
+        const bool new_word = text[start] != ' ' && (text[start - 1] == ' ' || text[start - 1] == '\n');
+        if (new_word) {
+            return false;
+        }
+    } else if (start + length == c->start) {
+        change_reserve(h, c, c->length + length);
+        memmove(c->data + length, c->data, c->length);
+        memcpy(c->data, text + start, length);
+        c->start = start;
+    } else if (start == c->start) {
+        change_reserve(h, c, c->length + length);
+        memcpy(c->data + c->length, text + start, length);
+    } else {
+        return false;
+    }
+
+    c->length += length;
+    return true;
+}
+
+/* Undoes c if it's applied, or else redoes it. Returns where the cursor goes, or UINT32_MAX if the text was changed
+ * from outside the edit so that c doesn't fit it anymore. */
+static uint32_t edit_change_do(EDIT *edit, EDIT_CHANGE *c) {
+    if (c->start > edit->length || (!c->remove && c->length > edit->length - c->start)) {
+        edit_history_clear(edit->history);
+        return UINT32_MAX;
+    }
+
+    uint32_t r = c->start;
     if (c->remove) {
-        memmove(edit->data + c->start + c->length, edit->data + c->start, edit->length - c->start);
-        memcpy(edit->data + c->start, c->data, c->length);
-        edit->length += c->length;
+        if (!text_reserve(edit, c->length)) {
+            edit_history_clear(edit->history);
+            return UINT32_MAX;
+        }
+        text_splice(edit, c->start, 0, c->data, c->length);
         r += c->length;
     } else {
-        edit->length -= c->length;
-        memmove(edit->data + c->start, edit->data + c->start + c->length, edit->length - c->start);
+        // Text that was typed is only kept once it's taken out again, so typing doesn't have to copy it.
+        change_reserve(edit->history, c, c->length);
+        memcpy(c->data, edit->data + c->start, c->length);
+        text_splice(edit, c->start, c->length, NULL, 0);
     }
 
     c->remove = !c->remove;
+    history_trim(edit->history);
     return r;
 }
 
-void edit_do(EDIT *edit, uint16_t start, uint16_t length, bool remove) {
-    EDIT_CHANGE *new, **history;
+void edit_do(EDIT *edit, uint32_t start, uint32_t length, bool remove) {
+    if (!edit->history) {
+        edit->history = calloc(1, sizeof(EDIT_HISTORY));
+        if (!edit->history) {
+            LOG_FATAL_ERR(EXIT_MALLOC, "UI Edit", "Unable to calloc for edit history, this should never happen!");
+        }
+    }
 
-    history = realloc(edit->history, (edit->history_cur + 1) * sizeof(void *));
-    if (!history) {
-        LOG_FATAL_ERR(EXIT_MALLOC, "UI Edit", "Unable to realloc for edit history, this should never happen!");
+    EDIT_HISTORY *h = edit->history;
+
+    // What was undone can't be redone after something else changed.
+    while (h->count > h->applied) {
+        change_forget(h, history_at(h, --h->count));
     }
-    /* Note: if we access edit->history after reallocing it, we're using
-       potentially freed memory.
-    */
-    edit->history = history;
 
-    new = calloc(1, sizeof(EDIT_CHANGE) + length);
-    if (!new) {
-        LOG_FATAL_ERR(EXIT_MALLOC, "UI Edit", "Unable to calloc for new EDIT_CHANGE, this should never happen!");
+    if (h->applied && change_coalesce(h, history_at(h, h->applied - 1), edit->data, start, length, remove)) {
+        history_trim(h);
+        return;
     }
 
-    new->remove = remove;
-    new->start  = start;
-    new->length = length;
-    memcpy(new->data, edit->data + start, length);
+    if (h->count == EDIT_HISTORY_CHANGES) {
+        // The oldest change makes room, and its memory is used for the new one.
+        h->first = (h->first + 1) % EDIT_HISTORY_CHANGES;
+        h->applied--;
+        h->count--;
+    }
 
-    if (edit->history_cur != edit->history_length) {
-        uint16_t i = edit->history_cur;
-        while (i != edit->history_length) {
-            free(edit->history[i++]);
-        }
+    EDIT_CHANGE *c = history_at(h, h->count);
+    c->remove      = remove;
+    c->start       = start;
+    c->length      = length;
+    if (remove) {
+        change_reserve(h, c, length);
+        memcpy(c->data, edit->data + start, length);
     }
 
-    history[edit->history_cur] = new;
+    h->applied++;
+    h->count++;
+    history_trim(h);
+}
 
-    edit->history_cur++;
-    edit->history_length = edit->history_cur;
+static uint32_t edit_undo(EDIT *edit) {
+    EDIT_HISTORY *h = edit->history;
+    if (!h || !h->applied) {
+        return UINT32_MAX;
+    }
+
+    h->applied--;
+    return edit_change_do(edit, history_at(h, h->applied));
 }
 
-static uint16_t edit_undo(EDIT *edit) {
-    uint16_t r = UINT16_MAX;
-    if (edit->history_cur) {
-        edit->history_cur--;
-        r = edit_change_do(edit, edit->history[edit->history_cur]);
+static uint32_t edit_redo(EDIT *edit) {
+    EDIT_HISTORY *h = edit->history;
+    if (!h || h->applied == h->count) {
+        return UINT32_MAX;
     }
-    return r;
+
+    h->applied++;
+    return edit_change_do(edit, history_at(h, h->applied - 1));
 }
 
-static uint16_t edit_redo(EDIT *edit) {
-    uint16_t r = UINT16_MAX;
-    if (edit->history_cur != edit->history_length) {
-        r = edit_change_do(edit, edit->history[edit->history_cur]);
-        edit->history_cur++;
+bool edit_replace(EDIT *edit, uint32_t start, uint32_t length, const char *str, uint32_t str_length) {
+    if (str_length > length && !text_reserve(edit, str_length - length)) {
+        return false;
     }
-    return r;
+
+    if (length) {
+        edit_do(edit, start, length, true);
+    }
+
+    text_splice(edit, start, length, str, str_length);
+
+    if (str_length) {
+        edit_do(edit, start, str_length, false);
+    }
+
+    return true;
 }
 
 static void edit_del(EDIT *edit) {
@@ -410,16 +605,13 @@ static void edit_del(EDIT *edit) {
         return;
     }
 
-    char *p = active_edit->data + edit_sel.start;
     if (edit_sel.length) {
         edit_do(edit, edit_sel.start, edit_sel.length, 1);
-        memmove(p, p + edit_sel.length, active_edit->length - (edit_sel.start + edit_sel.length));
-        active_edit->length -= edit_sel.length;
-    } else if (edit_sel.start < active_edit->length) {
-        uint8_t len = utf8_len(p);
+        text_splice(edit, edit_sel.start, edit_sel.length, NULL, 0);
+    } else if (edit_sel.start < edit->length) {
+        uint8_t len = utf8_len(edit->data + edit_sel.start);
         edit_do(edit, edit_sel.start, len, 1);
-        memmove(p, p + len, active_edit->length - edit_sel.start - len);
-        active_edit->length -= len;
+        text_splice(edit, edit_sel.start, len, NULL, 0);
     }
     edit_sel.p1     = edit_sel.start;
     edit_sel.p2     = edit_sel.start;
@@ -453,6 +645,7 @@ void edit_char(uint32_t ch, bool control, uint8_t flags) {
 
     if (control || (ch <= 0x1F && (!edit->multiline || ch != '\n')) || (ch >= 0x7f && ch <= 0x9F)) {
         bool modified = false;
+        bool callback = false; // Whatever it did may show outside of the edit
 
         switch (ch) {
             case KEY_BACK: {
@@ -461,7 +654,7 @@ void edit_char(uint32_t ch, bool control, uint8_t flags) {
                 }
 
                 if (edit_sel.length == 0) {
-                    uint16_t p = edit_sel.start;
+                    uint32_t p = edit_sel.start;
                     if (p == 0) {
                         break;
                     }
@@ -481,11 +674,9 @@ void edit_char(uint32_t ch, bool control, uint8_t flags) {
                         } while ((flags & EMOD_CTRL) && p != 0 && edit->data[p - 1] != ' ' && edit->data[p - 1] != '\n');
                     }
 
-                    uint16_t len = edit_sel.start - p;
-                    edit_do(edit, edit_sel.start - len, len, 1);
-                    memmove(edit->data + edit_sel.start - len, edit->data + edit_sel.start,
-                            edit->length - edit_sel.start);
-                    edit->length -= len;
+                    uint32_t len = edit_sel.start - p;
+                    edit_do(edit, p, len, 1);
+                    text_splice(edit, p, len, NULL, 0);
 
                     edit_sel.start -= len;
                     edit_sel.p1 = edit_sel.start;
@@ -505,7 +696,7 @@ void edit_char(uint32_t ch, bool control, uint8_t flags) {
             }
 
             case KEY_LEFT: {
-                uint16_t p = edit_sel.p2;
+                uint32_t p = edit_sel.p2;
                 if (p != 0) {
                     if (flags & EMOD_CTRL) {
                         while (p != 0 && edit->data[p - 1] == ' ') {
@@ -536,7 +727,7 @@ void edit_char(uint32_t ch, bool control, uint8_t flags) {
             }
 
             case KEY_RIGHT: {
-                uint16_t p = edit_sel.p2;
+                uint32_t p = edit_sel.p2;
                 if (flags & EMOD_CTRL) {
                     while (p != edit->length && edit->data[p] == ' ') {
                         p++;
@@ -614,7 +805,7 @@ void edit_char(uint32_t ch, bool control, uint8_t flags) {
             }
 
             case KEY_HOME: {
-                uint16_t p = edit_sel.p2;
+                uint32_t p = edit_sel.p2;
 
                 if (p == 0 && !edit_sel.length) {
                     break;
@@ -641,7 +832,7 @@ void edit_char(uint32_t ch, bool control, uint8_t flags) {
             }
 
             case KEY_END: {
-                uint16_t p = edit_sel.p2;
+                uint32_t p = edit_sel.p2;
 
                 if (p == edit->length && !edit_sel.length) {
                     break;
@@ -678,8 +869,8 @@ void edit_char(uint32_t ch, bool control, uint8_t flags) {
             }
 
             case 'z': {
-                uint16_t p = edit_undo(edit);
-                if (p != UINT16_MAX) {
+                uint32_t p = edit_undo(edit);
+                if (p != UINT32_MAX) {
                     edit_sel.p1     = p;
                     edit_sel.p2     = p;
                     edit_sel.start  = p;
@@ -692,8 +883,8 @@ void edit_char(uint32_t ch, bool control, uint8_t flags) {
             case 'Z':
             case 'y':
             case 'Y': {
-                uint16_t p = edit_redo(edit);
-                if (p != UINT16_MAX) {
+                uint32_t p = edit_redo(edit);
+                if (p != UINT32_MAX) {
                     edit_sel.p1     = p;
                     edit_sel.p2     = p;
                     edit_sel.start  = p;
@@ -707,16 +898,12 @@ void edit_char(uint32_t ch, bool control, uint8_t flags) {
                 modified = true;
 
                 if (edit->onenter && !(flags & EMOD_CTRL)) {
+                    callback = true;
                     edit->onenter(edit);
                     /*dirty*/
                     if (edit->length == 0) {
-                        for (uint16_t i = 0; i != edit->history_length; i++) {
-                            free(edit->history[i]);
-                        }
-                        free(edit->history);
-                        edit->history        = NULL;
-                        edit->history_cur    = 0;
-                        edit->history_length = 0;
+                        edit_history_clear(edit->history);
+                        text_shrink(edit);
 
                         edit_sel.p1     = 0;
                         edit_sel.p2     = 0;
@@ -729,8 +916,10 @@ void edit_char(uint32_t ch, bool control, uint8_t flags) {
 
             case KEY_TAB: {
                 if ((flags & EMOD_SHIFT) && !(flags & EMOD_CTRL) && edit->onshifttab) {
+                    callback = true;
                     edit->onshifttab(edit);
                 } else if (!(flags & EMOD_CTRL) && edit->ontab) {
+                    callback = true;
                     edit->ontab(edit);
                 }
 
@@ -743,12 +932,14 @@ void edit_char(uint32_t ch, bool control, uint8_t flags) {
             edit->onchange(edit);
         }
 
-        edit_redraw();
+        if (callback) {
+            redraw();
+        } else {
+            edit_redraw(edit);
+        }
     } else if (!edit->readonly) {
         uint8_t len = unicode_to_utf8_len(ch);
-        char *p = edit->data + edit_sel.start;
-
-        if ((size_t)edit->length - edit_sel.length + len >= edit->data_size) {
+        if (edit_sel.length < len && !text_reserve(edit, len - edit_sel.length)) {
             return;
         }
 
@@ -756,10 +947,9 @@ void edit_char(uint32_t ch, bool control, uint8_t flags) {
             edit_do(edit, edit_sel.start, edit_sel.length, 1);
         }
 
-        memmove(p + len, p + edit_sel.length, edit->length - (edit_sel.start + edit_sel.length));
-        edit->length -= edit_sel.length;
-        unicode_to_utf8(ch, edit->data + edit_sel.start);
-        edit->length += len;
+        char utf8[4];
+        unicode_to_utf8(ch, utf8);
+        text_splice(edit, edit_sel.start, edit_sel.length, utf8, len);
 
         edit_do(edit, edit_sel.start, len, 0);
 
@@ -772,7 +962,7 @@ void edit_char(uint32_t ch, bool control, uint8_t flags) {
             edit->onchange(edit);
         }
 
-        edit_redraw();
+        edit_redraw(edit);
     }
 }
 
@@ -798,9 +988,11 @@ void edit_paste(char *data, int length, bool select) {
 
     length = utf8_validate((uint8_t *)data, length);
 
-    const int maxlen = (active_edit->data_size - 1) - active_edit->length + edit_sel.length;
-    int newlen = 0, i = 0;
-    while (i < length) {
+    // Resizable edits grow to fit whatever is pasted.
+    const uint32_t kept   = active_edit->length - edit_sel.length;
+    const uint32_t maxlen = (active_edit->resizable ? UINT32_MAX - 1 : text_capacity(active_edit)) - kept;
+    uint32_t newlen = 0, i = 0;
+    while (i < (uint32_t)length) {
         const uint8_t len = utf8_len(data + i);
 
         const bool not_linebreak = !active_edit->multiline || data[i] != '\n';
@@ -827,19 +1019,17 @@ void edit_paste(char *data, int length, bool select) {
         return;
     }
 
-    char *p = active_edit->data + edit_sel.start;
+    if (newlen > edit_sel.length && !text_reserve(active_edit, newlen - edit_sel.length)) {
+        return;
+    }
 
     if (edit_sel.length) {
         edit_do(active_edit, edit_sel.start, edit_sel.length, 1);
     }
 
-    memmove(p + newlen, p + edit_sel.length, active_edit->length - (edit_sel.start + edit_sel.length));
-    memcpy(p, data, newlen);
-
+    text_splice(active_edit, edit_sel.start, edit_sel.length, data, newlen);
     edit_do(active_edit, edit_sel.start, newlen, 0);
 
-    active_edit->length += newlen - edit_sel.length;
-
     if (select) {
         edit_sel.length = newlen;
         setselection(active_edit->data + edit_sel.start, newlen);
@@ -855,7 +1045,7 @@ void edit_paste(char *data, int length, bool select) {
         active_edit->onchange(active_edit);
     }
 
-    edit_redraw();
+    edit_redraw(active_edit);
 }
 
 void edit_resetfocus(void) {
@@ -883,23 +1073,26 @@ EDIT *edit_get_active(void) {
     return active_edit;
 }
 
-void edit_setstr(EDIT *edit, char *str, uint16_t length) {
-	uint16_t maxlength;
+void edit_restore(EDIT *edit, const char *str, uint32_t length) {
+    edit->length = 0;
 
-	maxlength = edit->data_size - 1;
-    if (length >= maxlength) {
-        length = maxlength;
+    if (!text_reserve(edit, length)) {
+        length = text_capacity(edit);
     }
 
-    edit->length = length;
     memcpy(edit->data, str, length);
+    edit->length = length;
+}
+
+void edit_setstr(EDIT *edit, char *str, uint32_t length) {
+    edit_restore(edit, str, length);
 
     if (edit->onchange) {
         edit->onchange(edit);
     }
 }
 
-void edit_setcursorpos(EDIT *edit, uint16_t pos) {
+void edit_setcursorpos(EDIT *edit, uint32_t pos) {
     if (pos <= edit->length) {
         edit_sel.p1 = pos;
     } else {
@@ -910,11 +1103,11 @@ void edit_setcursorpos(EDIT *edit, uint16_t pos) {
     edit_sel.length              = 0;
 }
 
-uint16_t edit_getcursorpos(void) {
+uint32_t edit_getcursorpos(void) {
     return edit_sel.p1 < edit_sel.p2 ? edit_sel.p1 : edit_sel.p2;
 }
 
-bool edit_getmark(uint16_t *outloc, uint16_t *outlen) {
+bool edit_getmark(uint32_t *outloc, uint32_t *outlen) {
     if (outloc) {
         *outloc = edit_sel.mark_start;
     }
@@ -925,12 +1118,12 @@ bool edit_getmark(uint16_t *outloc, uint16_t *outlen) {
     return (active_edit && edit_sel.mark_length) ? 1 : 0;
 }
 
-void edit_setmark(uint16_t loc, uint16_t len) {
+void edit_setmark(uint32_t loc, uint32_t len) {
     edit_sel.mark_start  = loc;
     edit_sel.mark_length = len;
 }
 
-void edit_setselectedrange(uint16_t loc, uint16_t len) {
+void edit_setselectedrange(uint32_t loc, uint32_t len) {
     edit_sel.start = edit_sel.p1 = loc;
     edit_sel.length              = len;
     edit_sel.p2                  = loc + len;
@@ -12,23 +12,40 @@
 
 typedef struct scrollable SCROLLABLE;
 
+/* Undo history. Changes go into a ring of EDIT_HISTORY_CHANGES, and the oldest ones are forgotten once it's full or
+ * once the text they hold takes more than EDIT_HISTORY_BYTES. Typing a word, or deleting character after character,
+ * makes a single change. */
+#define EDIT_HISTORY_CHANGES 100
+#define EDIT_HISTORY_BYTES (64 * 1024)
+
 typedef struct edit_change {
-    bool     remove, padding;
-    uint16_t start, length;
-    char     data[];
+    bool     remove;    // Undoing it puts text back
+    uint32_t start, length;
+    uint32_t capacity;  // Of data
+    char *   data;      // What undoing puts back, or after that what redoing does
 } EDIT_CHANGE;
 
+typedef struct edit_history {
+    EDIT_CHANGE changes[EDIT_HISTORY_CHANGES];
+    uint16_t    first;   // The oldest change
+    uint16_t    applied; // Changes that can be undone
+    uint16_t    count;   // Those and the ones that can be redone
+    uint32_t    bytes;
+} EDIT_HISTORY;
+
 typedef struct edit EDIT;
 struct edit {
     PANEL panel;
 
     bool multiline, mouseover, noborder, readonly, select_completely, vcentered, password;
 
-    uint16_t mouseover_char, length;
+    /* data is allocated by the edit and grows as text is added, instead of being a fixed buffer of data_size. */
+    bool resizable;
+
+    uint32_t mouseover_char, length;
     uint16_t width, height;
 
-    uint16_t      history_cur, history_length;
-    EDIT_CHANGE **history;
+    EDIT_HISTORY *history;
 
     SCROLLABLE *scroll;
     char *      data;
@@ -54,7 +71,15 @@ bool edit_mwheel(EDIT *edit, int height, double d, bool smooth);
 bool edit_mup(EDIT *edit);
 bool edit_mleave(EDIT *edit);
 
-void edit_do(EDIT *edit, uint16_t start, uint16_t length, bool remove);
+/* Records a change for undo, text that's removed has to be recorded before it's taken out. */
+void edit_do(EDIT *edit, uint32_t start, uint32_t length, bool remove);
+
+/* Replaces length bytes at start with str, recording it for undo. Returns false, and changes nothing, if the edit
+ * can't hold the result. */
+bool edit_replace(EDIT *edit, uint32_t start, uint32_t length, const char *str, uint32_t str_length);
+
+void edit_history_clear(EDIT_HISTORY *history);
+void edit_history_free(EDIT_HISTORY *history);
 
 void edit_press(void);
 
@@ -69,17 +94,21 @@ EDIT *edit_get_active(void);
 
 void edit_resetfocus(void);
 void edit_setfocus(EDIT *edit);
-void edit_setstr(EDIT *edit, char *str, uint16_t length);
-void edit_setcursorpos(EDIT *edit, uint16_t pos);
-uint16_t edit_getcursorpos(void);
+void edit_setstr(EDIT *edit, char *str, uint32_t length);
+
+/* Same as edit_setstr(), without calling onchange, for putting back what was typed before. */
+void edit_restore(EDIT *edit, const char *str, uint32_t length);
+
+void edit_setcursorpos(EDIT *edit, uint32_t pos);
+uint32_t edit_getcursorpos(void);
 
 // set outloc and outlen to the mark range.
 // returns 1 if the mark range is valid for the current edit,
 // else 0.
 // a mark range is valid when *outlen != 0 and there is an active edit.
-bool edit_getmark(uint16_t *outloc, uint16_t *outlen);
-void edit_setmark(uint16_t loc, uint16_t len);
+bool edit_getmark(uint32_t *outloc, uint32_t *outlen);
+void edit_setmark(uint32_t loc, uint32_t len);
 
-void edit_setselectedrange(uint16_t loc, uint16_t len);
+void edit_setselectedrange(uint32_t loc, uint32_t len);
 
 #endif // UI_EDIT_H
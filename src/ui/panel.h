@@ -28,6 +28,9 @@ struct panel {
     bool disabled;
     int  x, y, width, height;
 
+    // Where it was last drawn, in window coordinates.
+    int drawn_x, drawn_y, drawn_width, drawn_height;
+
     SCROLLABLE *content_scroll;
 
     ui_draw_cb *drawfunc;
@@ -0,0 +1,40 @@
+#include "render_sched.h"
+
+void render_sched_set_fps(RENDER_SCHED *s, uint16_t fps) {
+    s->interval = (1000 * 1000 * 1000) / (fps ? fps : RENDER_SCHED_DEFAULT_FPS);
+}
+
+void render_sched_request(RENDER_SCHED *s) {
+    s->pending = true;
+    s->requested++;
+}
+
+void render_sched_hurry(RENDER_SCHED *s) {
+    if (s->pending) {
+        s->urgent = true;
+    }
+}
+
+uint64_t render_sched_due_in(const RENDER_SCHED *s, uint64_t now) {
+    if (!s->pending) {
+        return UINT64_MAX;
+    }
+
+    if (s->urgent || now - s->last_frame >= s->interval) {
+        return 0;
+    }
+
+    return s->last_frame + s->interval - now;
+}
+
+void render_sched_rendered(RENDER_SCHED *s, uint64_t now) {
+    s->pending    = false;
+    s->urgent     = false;
+    s->last_frame = now;
+}
+
+uint32_t render_sched_take_requested(RENDER_SCHED *s) {
+    const uint32_t requested = s->requested;
+    s->requested = 0;
+    return requested;
+}
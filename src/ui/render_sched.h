@@ -0,0 +1,35 @@
+#ifndef UI_RENDER_SCHED_H
+#define UI_RENDER_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Decides when the main window is painted. Everything asked for between two frames goes into the next one, and frames
+ * are at least 1/fps apart unless one is hurried along because the user is waiting on it. */
+
+#define RENDER_SCHED_DEFAULT_FPS 60
+
+typedef struct {
+    uint64_t interval; // ns
+    uint64_t last_frame;
+    bool     pending, urgent;
+
+    uint32_t requested; // Since the counter was last taken
+} RENDER_SCHED;
+
+void render_sched_set_fps(RENDER_SCHED *s, uint16_t fps);
+
+void render_sched_request(RENDER_SCHED *s);
+
+/* A pending frame is drawn as soon as possible instead of waiting for its turn. */
+void render_sched_hurry(RENDER_SCHED *s);
+
+/* Returns how many ns from now the next frame is due, 0 if it should be drawn now or UINT64_MAX if there's none. */
+uint64_t render_sched_due_in(const RENDER_SCHED *s, uint64_t now);
+
+void render_sched_rendered(RENDER_SCHED *s, uint64_t now);
+
+/* Returns the number of frames requested since the last call. */
+uint32_t render_sched_take_requested(RENDER_SCHED *s);
+
+#endif // UI_RENDER_SCHED_H
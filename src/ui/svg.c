@@ -8,63 +8,65 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define SQRT2 1.41421356237309504880168872420969807856967187537694807317667973799
 
-static uint8_t pixel(double d) {
-    if (d >= 1.0) {
-        return 0;
-    } else if (d <= 0.0) {
-        return 0xFF;
-    } else {
-        return (1.0 - d) * 255.0;
-    }
+/* The rasterizers work on floats and keep branches out of their inner loops, with whatever only depends on the row
+ * worked out once per row, so the compiler can do several pixels at a time. */
+
+static inline float clamp01(float v) {
+    v = v < 0.0f ? 0.0f : v;
+    return v > 1.0f ? 1.0f : v;
 }
 
-static uint8_t pixelmin(double d, uint8_t p) {
-    if (d >= 1.0) {
-        return p;
-    } else if (d <= 0.0) {
-        return 0;
-    } else {
-        uint8_t value = d * 255.0;
-        if (value >= p) {
-            return p;
-        } else {
-            return value;
-        }
-    }
+static inline uint8_t pixel(float d) {
+    return 255.0f * clamp01(1.0f - d);
 }
 
-static uint8_t pixelmax(double d, uint8_t p) {
-    if (d >= 1.0) {
-        return p;
-    } else if (d <= 0.0) {
-        return 0xFF;
-    } else {
-        uint8_t value = (1.0 - d) * 255.0;
-        if (value >= p) {
-            return value;
-        } else {
-            return p;
-        }
+static inline uint8_t pixelmin(float d, uint8_t p) {
+    const uint8_t value = 255.0f * clamp01(d);
+    return value < p ? value : p;
+}
+
+static inline uint8_t pixelmax(float d, uint8_t p) {
+    const uint8_t value = pixel(d);
+    return value > p ? value : p;
+}
+
+static inline float minf(float a, float b) {
+    return a < b ? a : b;
+}
+
+static inline float maxf(float a, float b) {
+    return a > b ? a : b;
+}
+
+/* Part of a row of a rounded rectangle's corners, from x0 to x1. */
+static void rounded_row(uint8_t *row, int x0, int x1, int width, int radius, float dy, bool negative) {
+    const float hw = (float)radius - 0.5f, dy2 = dy * dy;
+    for (int x = x0; x < x1; x++) {
+        const float   dx    = (x < radius) ? x - hw : x + hw - width + 1.0f;
+        const uint8_t value = pixel(sqrtf(dx * dx + dy2) - hw);
+        row[x]              = negative ? 0xFF - value : value;
     }
 }
 
-static void drawrectrounded(uint8_t *data, int width, int height, int radius) {
-    double hw = (double)radius - 0.5;
-    for (int y = 0; y != height; y++) {
-        for (int x = 0; x != width; x++) {
-            if ((x < radius || x >= width - radius) && (y < radius || y >= height - radius)) {
-                double dx, dy;
-                dx       = (x < radius) ? x - hw : x + hw - width + 1.0;
-                dy       = (y < radius) ? y - hw : y + hw - height + 1.0;
-                double d = sqrt(dx * dx + dy * dy) - hw;
-                *data++  = pixel(d);
-            } else {
-                *data++ = 0xFF;
-            }
-        }
+/* Rounds the corners of a row that's already filled in, if it's one of the rows they're in. */
+static void rounded_corners(uint8_t *row, int y, int width, int height, int radius, bool left, bool right, bool top,
+                            bool bottom, bool negative) {
+    if (!((top && y < radius) || (bottom && y >= height - radius))) {
+        return;
+    }
+
+    const float hw = (float)radius - 0.5f;
+    const float dy = (y < radius) ? y - hw : y + hw - height + 1.0f;
+    if (left) {
+        rounded_row(row, 0, MIN(radius, width), width, radius, dy, negative);
+    }
+
+    if (right) {
+        rounded_row(row, MAX(width - radius, 0), width, width, radius, dy, negative);
     }
 }
 
@@ -74,312 +76,225 @@ static void drawrectroundedex(uint8_t *data, int width, int height, int radius,
     bool top =    ((flags & 4) != 0); /* 0100 */
     bool bottom = ((flags & 8) != 0); /* 1000 */
 
-    double hw = (double)radius - 0.5;
-    for (int y = 0; y != height; y++) {
-        for (int x = 0; x != width; x++) {
-            if (((left && x < radius) || (right && x >= width - radius))
-                && ((top && y < radius) || (bottom && y >= height - radius))) {
-                double dx = (x < radius) ? x - hw : x + hw - width + 1.0;
-                double dy = (y < radius) ? y - hw : y + hw - height + 1.0;
-                double d = sqrt(dx * dx + dy * dy) - hw;
-                *data++  = pixel(d);
-            } else {
-                *data++ = 0xFF;
-            }
-        }
+    for (int y = 0; y < height; y++, data += width) {
+        memset(data, 0xFF, width);
+        rounded_corners(data, y, width, height, radius, left, right, top, bottom, false);
     }
 }
 
-static void drawrectroundedsub(uint8_t *p, int width, int UNUSED(height), int sx, int sy, int sw, int sh, int radius) {
-    double hw = (double)radius - 0.5;
-    for (int y = sy; y != sy + sh; y++) {
-        for (int x = sx; x != sx + sw; x++) {
-            uint8_t *data = &p[y * width + x];
-            x -= sx;
-            y -= sy;
-
-            if ((x < radius || x >= sw - radius) && (y < radius || y >= sh - radius)) {
-                double dx = (x < radius) ? x - hw : x + hw - sw + 1.0;
-                double dy = (y < radius) ? y - hw : y + hw - sh + 1.0;
-                double d = sqrt(dx * dx + dy * dy) - hw;
-                *data    = pixel(d);
-            } else {
-                *data = 0xFF;
-            }
+static void drawrectrounded(uint8_t *data, int width, int height, int radius) {
+    drawrectroundedex(data, width, height, radius, 15);
+}
 
-            x += sx;
-            y += sy;
-        }
+static void drawrectroundedsub(uint8_t *p, int width, int UNUSED(height), int sx, int sy, int sw, int sh, int radius) {
+    for (int y = 0; y < sh; y++) {
+        uint8_t *row = &p[(sy + y) * width + sx];
+        memset(row, 0xFF, sw);
+        rounded_corners(row, y, sw, sh, radius, true, true, true, true, false);
     }
 }
 
 static void drawrectroundedneg(uint8_t *p, int width, int UNUSED(height), int sx, int sy, int sw, int sh, int radius) {
-    double hw = (double)radius - 0.5;
-    for (int y = sy; y != sy + sh; y++) {
-        for (int x = sx; x != sx + sw; x++) {
-            uint8_t *data = &p[y * width + x];
-            x -= sx;
-            y -= sy;
-
-            if ((x < radius || x >= sw - radius) && (y < radius || y >= sh - radius)) {
-                double dx = (x < radius) ? x - hw : x + hw - sw + 1.0;
-                double dy = (y < radius) ? y - hw : y + hw - sh + 1.0;
-                double d = sqrt(dx * dx + dy * dy) - hw;
-                *data    = 0xFF - pixel(d);
-            } else {
-                *data = 0;
-            }
-
-            x += sx;
-            y += sy;
-        }
+    for (int y = 0; y < sh; y++) {
+        uint8_t *row = &p[(sy + y) * width + sx];
+        memset(row, 0, sw);
+        rounded_corners(row, y, sw, sh, radius, true, true, true, true, true);
     }
 }
 
 static void drawcircle(uint8_t *data, int width) {
-    double hw = (double)width / 2.0 - 0.5;
+    const float hw = (float)width / 2.0f - 0.5f;
     for (int y = 0; y != width; y++) {
+        const float dy2 = (y - hw) * (y - hw);
         for (int x = 0; x != width; x++) {
-            double dx = (x - hw), dy = (y - hw);
-            double d = sqrt(dx * dx + dy * dy) - hw + 0.5;
-            *data++  = pixel(d);
+            const float dx = x - hw;
+            *data++        = pixel(sqrtf(dx * dx + dy2) - hw + 0.5f);
         }
     }
 }
 
 static void drawnewcircle(uint8_t *data, int width, int height, double cx, double cy, double subwidth) {
-    double hw = cx - 0.5, vw = cy - 0.5, sw = (double)subwidth / 2.0;
+    const float hw = cx - 0.5, vw = cy - 0.5, sw = subwidth / 2.0;
     for (int y = 0; y != height; y++) {
+        const float dy2 = (y - vw) * (y - vw);
         for (int x = 0; x != width; x++) {
-            double dx = (x - hw), dy = (y - vw);
-            double d = sqrt(dx * dx + dy * dy) - sw;
-            *data    = pixelmax(d, *data);
+            const float dx = x - hw;
+            *data          = pixelmax(sqrtf(dx * dx + dy2) - sw, *data);
             data++;
         }
     }
 }
 
 static void drawnewcircle2(uint8_t *data, int width, int height, double cx, double cy, double subwidth, uint8_t flags) {
-    double hw = cx - 0.5, vw = cy - 0.5, sw = (double)subwidth / 2.0;
-    bool   b = (flags & 1) != 0;
+    const float hw = cx - 0.5, vw = cy - 0.5, sw = subwidth / 2.0;
+    const bool  b  = (flags & 1) != 0;
     for (int y = 0; y != height; y++) {
-        for (int x = 0; x != width; x++) {
-            double dx = (x - hw), dy = (y - vw);
-            if (b && dy > 0) {
-                dy *= 1.25;
-            }
+        float dy = y - vw;
+        if (b && dy > 0) {
+            dy *= 1.25f;
+        }
 
+        const float dy2 = dy * dy;
+        for (int x = 0; x != width; x++) {
+            float dx = x - hw;
             if (!b && dx > 0) {
-                dx *= 1.25;
+                dx *= 1.25f;
             }
 
-            double d = sqrt(dx * dx + dy * dy) - sw;
-
-            if ((b && dx < 0) || (!b && dy < 0)) {
-                *data++ = pixel(d);
-            } else {
-                *data = pixelmax(d, *data);
-                data++;
-            }
+            const float d = sqrtf(dx * dx + dy2) - sw;
+            *data         = ((b && dx < 0) || (!b && dy < 0)) ? pixel(d) : pixelmax(d, *data);
+            data++;
         }
     }
 }
 
 static void drawhead(uint8_t *data, int width, double cx, double cy, double subwidth) {
-    double hw = (double)cx - 0.5, vw = (double)cy - 0.5, sw = (double)subwidth / 2.0;
+    const float hw = cx - 0.5, vw = cy - 0.5, sw = subwidth / 2.0;
     for (int y = 0; y != width; y++) {
+        float dy = y - vw;
+        if (dy > 0) {
+            dy *= 0.75f;
+        }
+
+        const float dy2 = dy * dy;
         for (int x = 0; x != width; x++) {
-            double dx = (x - hw), dy = (y - vw);
-            if (dy > 0) {
-                dy *= 0.75;
-            }
-            double d = sqrt(dx * dx + dy * dy) - sw;
-            *data    = pixelmax(d, *data);
+            const float dx = x - hw;
+            *data          = pixelmax(sqrtf(dx * dx + dy2) - sw, *data);
             data++;
         }
     }
 }
 
 static void drawsubcircle(uint8_t *data, int width, int height, double cx, double cy, double subwidth) {
-    double hw = cx - 0.5, vw = cy - 0.5, sw = subwidth / 2.0;
+    const float hw = cx - 0.5, vw = cy - 0.5, sw = subwidth / 2.0;
     for (int y = 0; y != height; y++) {
+        const float dy2 = (y - vw) * (y - vw);
         for (int x = 0; x != width; x++) {
-            double dx = (x - hw), dy = (y - vw);
-            double d = sqrt(dx * dx + dy * dy) - sw;
-            *data    = pixelmin(d, *data);
+            const float dx = x - hw;
+            *data          = pixelmin(sqrtf(dx * dx + dy2) - sw, *data);
             data++;
         }
     }
 }
 
 static void drawcross(uint8_t *data, int width) {
-    double hw = 0.5 * (double)(width - 1);
-    double w  = 0.0625 * (double)width;
+    const float hw = 0.5f * (width - 1);
+    const float w  = 0.0625f * width;
     for (int y = 0; y != width; y++) {
+        const float dy = fabsf(y - hw);
         for (int x = 0; x != width; x++) {
-            double dx = fabs(x - hw), dy = fabs(y - hw);
-            double d = fmin(dx, dy) - w;
-            *data++  = pixel(d);
+            *data++ = pixel(minf(fabsf(x - hw), dy) - w);
         }
     }
 }
 
 static void drawxcross(uint8_t *data, int width, int height, int radius) {
-    double cx = 0.5 * (double)(width - 1);
-    double cy = 0.5 * (double)(height - 1);
-    double w  = 0.0625 * (double)radius;
+    const float cx = 0.5f * (width - 1);
+    const float cy = 0.5f * (height - 1);
+    const float w  = 0.0625f * radius;
+    const float h  = SQRT2 / 2.0;
     for (int y = 0; y != height; y++) {
+        const float dy = y - cy;
         for (int x = 0; x != width; x++) {
-            double dx = (double)x - cx, dy = (double)y - cy;
-            double d1 = (SQRT2 / 2.0) * fabs(dx + dy), d2 = (SQRT2 / 2.0) * fabs(dx - dy);
-            double d = fmin(d1, d2) - w;
-            d        = fmax(fabs(dx) + fabs(dy) - (SQRT2 / 2.0) * (double)height - w, d);
-            *data    = pixelmax(d, *data);
+            const float dx = x - cx;
+            const float d1 = h * fabsf(dx + dy), d2 = h * fabsf(dx - dy);
+            const float d  = maxf(fabsf(dx) + fabsf(dy) - h * height - w, minf(d1, d2) - w);
+            *data          = pixelmax(d, *data);
             data++;
         }
     }
 }
 
-static void drawline(uint8_t *data, int width, int height, double sx, double sy, double span, double radius) {
-    double cx = sx - 0.5, cy = sy - 0.5;
+/* A diagonal line, going up to the right or down to the right, drawn over what's there or cut out of it. */
+static void drawdiagonal(uint8_t *data, int width, int height, double sx, double sy, double span, double radius,
+                         bool down, bool cut) {
+    const float cx = sx - 0.5, cy = sy - 0.5;
+    const float h = SQRT2 / 2.0, r = radius, reach = h * span + r;
     for (int y = 0; y != height; y++) {
+        const float dy = y - cy;
         for (int x = 0; x != width; x++) {
-            double dx = (double)x - cx, dy = (double)y - cy;
-            double d = (SQRT2 / 2.0) * fabs(dx + dy) - radius;
-            d        = fmax(fabs(dx) + fabs(dy) - (SQRT2 / 2.0) * (double)span - radius, d);
-            *data    = pixelmax(d, *data);
+            const float dx = x - cx;
+            const float d  = maxf(fabsf(dx) + fabsf(dy) - reach, h * fabsf(down ? dx - dy : dx + dy) - r);
+            *data          = cut ? pixelmin(d, *data) : pixelmax(d, *data);
             data++;
         }
     }
 }
 
+static void drawline(uint8_t *data, int width, int height, double sx, double sy, double span, double radius) {
+    drawdiagonal(data, width, height, sx, sy, span, radius, false, false);
+}
+
 static void drawlinedown(uint8_t *data, int width, int height, double sx, double sy, double span, double radius) {
-    double cx = sx - 0.5, cy = sy - 0.5;
-    for (int y = 0; y != height; y++) {
-        for (int x = 0; x != width; x++) {
-            double dx = (double)x - cx, dy = (double)y - cy;
-            double d = (SQRT2 / 2.0) * fabs(dx - dy) - radius;
-            d        = fmax(fabs(dx) + fabs(dy) - (SQRT2 / 2.0) * (double)span - radius, d);
-            *data    = pixelmax(d, *data);
-            data++;
-        }
-    }
+    drawdiagonal(data, width, height, sx, sy, span, radius, true, false);
 }
 
 static void svgdraw_line_neg(uint8_t *data, int width, int height, double sx, double sy, double span, double radius) {
-    double cx = sx - 0.5, cy = sy - 0.5;
-    for (int y = 0; y != height; y++) {
-        for (int x = 0; x != width; x++) {
-            double dx = (double)x - cx, dy = (double)y - cy;
-            double d = (SQRT2 / 2.0) * fabs(dx + dy) - radius;
-            d        = fmax(fabs(dx) + fabs(dy) - (SQRT2 / 2.0) * (double)span - radius, d);
-            *data    = pixelmin(d, *data);
-            data++;
-        }
-    }
+    drawdiagonal(data, width, height, sx, sy, span, radius, false, true);
 }
 
 static void svgdraw_line_down_neg(uint8_t *data, int width, int height, double sx, double sy, double span,
                                   double radius) {
-    double cx = sx - 0.5, cy = sy - 0.5;
-    for (int y = 0; y != height; y++) {
-        for (int x = 0; x != width; x++) {
-            double dx = (double)x - cx, dy = (double)y - cy;
-            double d = (SQRT2 / 2.0) * fabs(dx - dy) - radius;
-            d        = fmax(fabs(dx) + fabs(dy) - (SQRT2 / 2.0) * (double)span - radius, d);
-            *data    = pixelmin(d, *data);
-            data++;
-        }
-    }
+    drawdiagonal(data, width, height, sx, sy, span, radius, true, true);
 }
 
 static void drawlinevert(uint8_t *data, int width, int height, double sx, double w) {
-    double cx = sx + w / 2.0 - 0.5;
+    const float cx = sx + w / 2.0 - 0.5, hw = w / 2.0;
     for (int y = 0; y != height; y++) {
         for (int x = 0; x != width; x++) {
-            double d = fabs((double)x - cx) - w / 2.0;
-            *data    = pixelmax(d, *data);
+            *data = pixelmax(fabsf(x - cx) - hw, *data);
             data++;
         }
     }
 }
 
 static void drawtri(uint8_t *data, int width, int height, double sx, double sy, double size, uint8_t dir) {
-    double cx = sx - 0.5, cy = sy - 0.5;
+    const float cx = sx - 0.5, cy = sy - 0.5, s = size;
     for (int y = 0; y != height; y++) {
+        const float dy = y - cy;
         for (int x = 0; x != width; x++) {
-            double dx = (double)x - cx, dy = (double)y - cy;
-            if (!dir) {
-                if (dx < 0.0 && dy > 0.0) {
-                    double d = -dx + dy - size;
-                    *data    = pixelmax(d, *data);
-                }
-            } else {
-                if (dx > 0.0 && dy < 0.0) {
-                    double d = dx - dy - size;
-                    *data    = pixelmax(d, *data);
-                }
-            }
+            const float dx     = x - cx;
+            const bool  inside = dir ? (dx > 0.0f && dy < 0.0f) : (dx < 0.0f && dy > 0.0f);
+            const float d      = dir ? dx - dy - s : -dx + dy - s;
+            *data              = inside ? pixelmax(d, *data) : *data;
             data++;
         }
     }
 }
 
-static void drawlineround(uint8_t *data, int width, int height, double sx, double sy, double span, double radius,
-                          double subwidth, uint8_t flags) {
-    double cx = sx - 0.5, cy = sy - 0.5, sw = (double)subwidth / 2.0;
+/* A diagonal line with a round cap at its lower left end and, if both_ends is set, at its upper right one. */
+static void drawlineends(uint8_t *data, int width, int height, double sx, double sy, double span, double radius,
+                         double subwidth, bool both_ends, bool cut) {
+    const float cx = sx - 0.5, cy = sy - 0.5, sw = subwidth / 2.0;
+    const float h = SQRT2 / 2.0, r = radius, reach = h * span + r, end = span * SQRT2;
     for (int y = 0; y != height; y++) {
+        const float dy = y - cy;
+        const float dy_upper = dy + end, dy_lower = dy - end;
         for (int x = 0; x != width; x++) {
-            double dx = (double)x - cx, dy = (double)y - cy;
-            double d  = (SQRT2 / 2.0) * fabs(dx + dy) - radius;
-            d         = fmax(fabs(dx) + fabs(dy) - (SQRT2 / 2.0) * (double)span - radius, d);
+            const float dx = x - cx;
+            float       d  = maxf(fabsf(dx) + fabsf(dy) - reach, h * fabsf(dx + dy) - r);
 
-            double ddx, ddy, d2;
-
-            if (!flags) {
-                ddx = (double)x - cx - span * SQRT2;
-                ddy = (double)y - cy + span * SQRT2;
-                d2  = sqrt(ddx * ddx + ddy * ddy) - sw;
-
-                d = fmin(d, d2);
-            }
+            const float ux = dx - end;
+            const float upper = sqrtf(ux * ux + dy_upper * dy_upper) - sw;
+            d                 = both_ends ? minf(d, upper) : d;
 
-            ddx = (double)x - cx + span * SQRT2;
-            ddy = (double)y - cy - span * SQRT2;
-            d2  = sqrt(ddx * ddx + ddy * ddy) - sw;
+            const float lx = dx + end;
+            d              = minf(d, sqrtf(lx * lx + dy_lower * dy_lower) - sw);
 
-            d = fmin(d, d2);
-
-            *data = pixelmax(d, *data);
+            *data = cut ? pixelmin(d, *data) : pixelmax(d, *data);
             data++;
         }
     }
 }
 
+static void drawlineround(uint8_t *data, int width, int height, double sx, double sy, double span, double radius,
+                          double subwidth, uint8_t flags) {
+    drawlineends(data, width, height, sx, sy, span, radius, subwidth, !flags, false);
+}
+
 static void drawlineroundempty(uint8_t *data, int width, int height, double sx, double sy, double span, double radius,
                                double subwidth) {
-    double cx = sx - 0.5, cy = sy - 0.5, sw = (double)subwidth / 2.0;
-    for (int y = 0; y != height; y++) {
-        for (int x = 0; x != width; x++) {
-            double dx = (double)x - cx, dy = (double)y - cy;
-            double d  = (SQRT2 / 2.0) * fabs(dx + dy) - radius;
-            d         = fmax(fabs(dx) + fabs(dy) - (SQRT2 / 2.0) * (double)span - radius, d);
-
-            double ddx = (double)x - cx - span * SQRT2, ddy = (double)y - cy + span * SQRT2;
-            double d2 = sqrt(ddx * ddx + ddy * ddy) - sw;
-
-            d = fmin(d, d2);
-
-            ddx = (double)x - cx + span * SQRT2;
-            ddy = (double)y - cy - span * SQRT2;
-            d2  = sqrt(ddx * ddx + ddy * ddy) - sw;
-
-            d = fmin(d, d2);
-
-            *data = pixelmin(d, *data);
-            data++;
-        }
-    }
+    drawlineends(data, width, height, sx, sy, span, radius, subwidth, true, true);
 }
 
 
@@ -398,330 +313,542 @@ static void drawgroup(uint8_t *data, int width) {
     drawhead(data, width, s * SCALE(20), s * SCALE(16), s * SCALE(15));
 }
 
-bool svg_draw(bool needmemory) {
-    static uint8_t *svg_data = NULL;
+typedef struct {
+    uint32_t offset, skip; // Where its pixels are, skip is where the bitmap starts in them
+    uint16_t width, height;
+    bool     drawn;
+} SVG_BITMAP;
+
+/* Sets the size of bm at the current scale and, unless p is NULL, rasterizes it into p. Returns how many bytes that
+ * takes, the halves of the scroll bar ends are cut out of a whole circle. */
+static size_t svg_icon(SVG_IMG bm, uint8_t *p, SVG_BITMAP *b) {
+    b->skip = 0;
+
+    switch (bm) {
+        /* Scroll bars top bottom halves */
+        case BM_SCROLLHALFTOP:
+        case BM_SCROLLHALFBOT: {
+            b->width  = SCROLL_WIDTH;
+            b->height = SCROLL_WIDTH / 2;
+            b->skip   = (bm == BM_SCROLLHALFBOT) ? SCROLL_WIDTH * SCROLL_WIDTH / 2 : 0;
+            if (p) {
+                drawcircle(p, SCROLL_WIDTH);
+            }
+            return SCROLL_WIDTH * SCROLL_WIDTH;
+        }
 
-    if (svg_data) {
-        free(svg_data);
-    }
+        /* Scroll bars top bottom halves (small)*/
+        case BM_SCROLLHALFTOP_SMALL:
+        case BM_SCROLLHALFBOT_SMALL: {
+            b->width  = SCROLL_WIDTH / 2;
+            b->height = SCROLL_WIDTH / 4;
+            b->skip   = (bm == BM_SCROLLHALFBOT_SMALL) ? SCROLL_WIDTH / 2 * SCROLL_WIDTH / 4 : 0;
+            if (p) {
+                drawcircle(p, SCROLL_WIDTH / 2);
+            }
+            return SCROLL_WIDTH / 2 * SCROLL_WIDTH / 2;
+        }
+
+        /* status area */
+        case BM_STATUSAREA: {
+            b->width  = BM_STATUSAREA_WIDTH;
+            b->height = BM_STATUSAREA_HEIGHT;
+            if (p) {
+                drawrectrounded(p, BM_STATUSAREA_WIDTH, BM_STATUSAREA_HEIGHT, SCALE(4));
+            }
+            break;
+        }
+
+        /* Draw panel Button: Add */
+        case BM_ADD: {
+            b->width = b->height = BM_ADD_WIDTH;
+            if (p) {
+                drawcross(p, BM_ADD_WIDTH);
+            }
+            break;
+        }
+
+        /* New group bitmap */
+        case BM_GROUPS: {
+            b->width = b->height = BM_ADD_WIDTH;
+            if (p) {
+                drawgroup(p, BM_ADD_WIDTH);
+            }
+            break;
+        }
+
+        /* Draw panel Button: Transfer */
+        case BM_TRANSFER: {
+            b->width = b->height = BM_ADD_WIDTH;
+            if (p) {
+                drawline(p, BM_ADD_WIDTH, BM_ADD_WIDTH, SCALE(6), SCALE(6), SCALE(10), SCALE(1.5));
+                drawline(p, BM_ADD_WIDTH, BM_ADD_WIDTH, SCALE(12), SCALE(12), SCALE(10), SCALE(1.5));
+                drawtri(p, BM_ADD_WIDTH, BM_ADD_WIDTH, SCALE(12), 0, SCALE(8), 0);
+                drawtri(p, BM_ADD_WIDTH, BM_ADD_WIDTH, SCALE(6), SCALE(18), SCALE(8), 1);
+            }
+            break;
+        }
 
-    /* Build what we expect the size to be.
-     * This section uses unnamed shortcuts, so it really serves no purpose and makes it harder to debug, it needs to be
-     * fixed, without shortcuts, and proper comments... TODO FIXME */
-    // comments behind the lines match with the comments of the code below that fills the memory
-    int size = SCROLL_WIDTH * SCROLL_WIDTH +     /* Scroll bars top bottom halves */
-               SCROLL_WIDTH * SCROLL_WIDTH / 2 + /* Scroll bars top bottom halves (small)*/
+        /* Settings gear bitmap */
+        case BM_SETTINGS: {
+            b->width = b->height = BM_ADD_WIDTH;
+            if (p) {
+                drawcross(p, BM_ADD_WIDTH);
+                drawxcross(p, BM_ADD_WIDTH, BM_ADD_WIDTH, BM_ADD_WIDTH);
+                drawnewcircle(p, BM_ADD_WIDTH, BM_ADD_WIDTH, 0.5 * BM_ADD_WIDTH, 0.5 * BM_ADD_WIDTH, SCALE(14));
+                drawsubcircle(p, BM_ADD_WIDTH, BM_ADD_WIDTH, 0.5 * BM_ADD_WIDTH, 0.5 * BM_ADD_WIDTH, SCALE(6));
+            }
+            break;
+        }
 
-               BM_STATUSAREA_WIDTH * BM_STATUSAREA_HEIGHT + /* status area */
-               /* Panel buttons */
-               BM_ADD_WIDTH * BM_ADD_WIDTH + /* Draw panel Button: Add */
-               BM_ADD_WIDTH * BM_ADD_WIDTH + /* New group bitmap */
-               BM_ADD_WIDTH * BM_ADD_WIDTH + /* Draw panel Button: Transfer */
-               BM_ADD_WIDTH * BM_ADD_WIDTH + /* Settings gear bitmap */
+        /* Contact avatar default bitmap */
+        case BM_CONTACT: {
+            b->width = b->height = BM_CONTACT_WIDTH;
+            if (p) {
+                drawnewcircle(p, BM_CONTACT_WIDTH, SCALE(36), SCALE(20), SCALE(36), SCALE(28));
+                drawsubcircle(p, BM_CONTACT_WIDTH, BM_CONTACT_WIDTH, SCALE(20), SCALE(20), SCALE(12));
+                drawhead(p, BM_CONTACT_WIDTH, SCALE(20), SCALE(12), SCALE(16));
+            }
+            break;
+        }
 
-               BM_CONTACT_WIDTH * BM_CONTACT_WIDTH +         /* Contact avatar default bitmap */
-               BM_CONTACT_WIDTH / 2 * BM_CONTACT_WIDTH / 2 + /* Contact avatar default bitmap for mini roster */
-               BM_CONTACT_WIDTH * BM_CONTACT_WIDTH +         /* Group heads default bitmap */
-               BM_CONTACT_WIDTH / 2 * BM_CONTACT_WIDTH / 2 + /* Group heads default bitmap for mini roster */
+        /* Contact avatar default bitmap for mini roster */
+        case BM_CONTACT_MINI: {
+            b->width = b->height = BM_CONTACT_WIDTH / 2;
+            if (p) {
+                drawnewcircle(p, BM_CONTACT_WIDTH / 2, SCALE(18), SCALE(10), SCALE(18), SCALE(14));
+                drawsubcircle(p, BM_CONTACT_WIDTH / 2, BM_CONTACT_WIDTH / 2, SCALE(10), SCALE(10), SCALE(6));
+                drawhead(p, BM_CONTACT_WIDTH / 2, SCALE(10), SCALE(6), SCALE(8));
+            }
+            break;
+        }
 
-               BM_FILE_WIDTH * BM_FILE_HEIGHT + /* Draw button icon overlays: file paper clip */
+        /* Group heads default bitmap */
+        case BM_GROUP: {
+            b->width = b->height = BM_CONTACT_WIDTH;
+            if (p) {
+                drawgroup(p, BM_CONTACT_WIDTH);
+            }
+            break;
+        }
 
-               BM_LBICON_WIDTH * BM_LBICON_HEIGHT + /* Call button icon */
-               BM_LBICON_WIDTH * BM_LBICON_HEIGHT + /* Call button icon */
-               BM_LBICON_WIDTH * BM_LBICON_HEIGHT + /* Video start end bitmap */
+        /* Group heads default bitmap for mini roster */
+        case BM_GROUP_MINI: {
+            b->width = b->height = BM_CONTACT_WIDTH / 2;
+            if (p) {
+                drawgroup(p, BM_CONTACT_WIDTH / 2);
+            }
+            break;
+        }
 
-               BM_STATUS_WIDTH * BM_STATUS_WIDTH + /* user status: online */
-               BM_STATUS_WIDTH * BM_STATUS_WIDTH + /* user status: away */
-               BM_STATUS_WIDTH * BM_STATUS_WIDTH + /* user status: busy */
-               BM_STATUS_WIDTH * BM_STATUS_WIDTH + /* user status: offline */
+        /* Draw button icon overlays. */
+        case BM_FILE: {
+            b->width  = BM_FILE_WIDTH;
+            b->height = BM_FILE_HEIGHT;
+            if (p) {
+                drawlineround(p, BM_FILE_WIDTH, BM_FILE_HEIGHT, UI_FSCALE(10), UI_FSCALE(10), UI_FSCALE(2),
+                              UI_FSCALE(8.3), UI_FSCALE(14), 0);
+                drawlineroundempty(p, BM_FILE_WIDTH, BM_FILE_HEIGHT, UI_FSCALE(10), UI_FSCALE(10), UI_FSCALE(2),
+                                   UI_FSCALE(6.5), UI_FSCALE(11));
+                drawsubcircle(p, BM_FILE_WIDTH, BM_FILE_HEIGHT, UI_FSCALE(11), UI_FSCALE(18), UI_FSCALE(6));
+                drawlineround(p, BM_FILE_WIDTH, BM_FILE_HEIGHT, UI_FSCALE(12), UI_FSCALE(12), UI_FSCALE(1),
+                              UI_FSCALE(4.5), UI_FSCALE(7.5), 1);
+                drawlineroundempty(p, BM_FILE_WIDTH, BM_FILE_HEIGHT, UI_FSCALE(13), UI_FSCALE(11), UI_FSCALE(1.5),
+                                   UI_FSCALE(3), UI_FSCALE(5.5));
+            }
+            break;
+        }
 
-               BM_STATUS_NOTIFY_WIDTH * BM_STATUS_NOTIFY_WIDTH + /* user status: notification */
+        /* Decline call button icon */
+        case BM_DECLINE: {
+            b->width  = BM_LBICON_WIDTH;
+            b->height = BM_LBICON_HEIGHT;
+            if (p) {
+                drawnewcircle(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(11), SCALE(25), SCALE(38));
+                drawsubcircle(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(11), SCALE(25), SCALE(30));
+                drawnewcircle(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(3), SCALE(11), SCALE(6));
+                drawnewcircle(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(19.5), SCALE(11), SCALE(6));
+            }
+            break;
+        }
 
-               BM_LBUTTON_WIDTH * BM_LBUTTON_HEIGHT + /* Generic Large Button */
-               BM_SBUTTON_WIDTH * BM_SBUTTON_HEIGHT + /* Generic Small Button */
+        /* Call button icon */
+        case BM_CALL: {
+            b->width  = BM_LBICON_WIDTH;
+            b->height = BM_LBICON_HEIGHT;
+            if (p) {
+                drawnewcircle(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(1), 0, SCALE(38));
+                drawsubcircle(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(1), 0, SCALE(30));
+                drawnewcircle2(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(18), SCALE(4), SCALE(6), 0);
+                drawnewcircle2(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(6), SCALE(16), SCALE(6), 1);
+            }
+            break;
+        }
 
-               BM_SWITCH_WIDTH * BM_SWITCH_HEIGHT +               /* Switch */
-               BM_SWITCH_TOGGLE_WIDTH * BM_SWITCH_TOGGLE_HEIGHT + /* Switch toggle */
+        /* Video start end bitmap */
+        case BM_VIDEO: {
+            b->width  = BM_LBICON_WIDTH;
+            b->height = BM_LBICON_HEIGHT;
+            if (p) {
+                uint8_t *data = p;
+                /* left triangle lens thing */
+                for (int y = 0; y != BM_LBICON_HEIGHT; y++) {
+                    for (int x = 0; x != SCALE(8); x++) {
+                        double d = abs(y - SCALE(9)) - 0.66 * (SCALE(8) - x);
+                        *data++  = pixel(d);
+                    }
+                    data += BM_LBICON_WIDTH - SCALE(8);
+                }
+                drawrectroundedsub(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(8), SCALE(1), SCALE(14), SCALE(14),
+                                   SCALE(1));
+            }
+            break;
+        }
 
-               /* File transfer */
-               BM_FT_CAP_WIDTH * BM_FTB_HEIGHT + BM_FT_WIDTH * BM_FT_HEIGHT + BM_FTM_WIDTH * BM_FT_HEIGHT +
-               (BM_FTB_WIDTH * (BM_FTB_HEIGHT + SCALE(1)) +
-               BM_FTB_WIDTH * BM_FTB_HEIGHT) + BM_FB_WIDTH * BM_FB_HEIGHT * 4 +
+        /* user status: online */
+        case BM_ONLINE: {
+            b->width = b->height = BM_STATUS_WIDTH;
+            if (p) {
+                drawcircle(p, BM_STATUS_WIDTH);
+            }
+            break;
+        }
 
-               /* Chat Buttons */
-               BM_CHAT_BUTTON_WIDTH * BM_CHAT_BUTTON_HEIGHT * 2 + // Chat button 1, 2
-               BM_CHAT_SEND_WIDTH * BM_CHAT_SEND_HEIGHT +
-               BM_CHAT_SEND_OVERLAY_WIDTH * BM_CHAT_SEND_OVERLAY_HEIGHT +
-               BM_CHAT_BUTTON_OVERLAY_WIDTH * BM_CHAT_BUTTON_OVERLAY_HEIGHT;
+        /* user status: away, busy */
+        case BM_AWAY:
+        case BM_BUSY: {
+            b->width = b->height = BM_STATUS_WIDTH;
+            if (p) {
+                drawcircle(p, BM_STATUS_WIDTH);
+                drawsubcircle(p, BM_STATUS_WIDTH, BM_STATUS_WIDTH / 2, 0.5 * BM_STATUS_WIDTH, 0.5 * BM_STATUS_WIDTH,
+                              SCALE(6));
+            }
+            break;
+        }
 
-    svg_data = calloc(1, size);
+        /* user status: offline */
+        case BM_OFFLINE: {
+            b->width = b->height = BM_STATUS_WIDTH;
+            if (p) {
+                drawcircle(p, BM_STATUS_WIDTH);
+                drawsubcircle(p, BM_STATUS_WIDTH, BM_STATUS_WIDTH, 0.5 * BM_STATUS_WIDTH, 0.5 * BM_STATUS_WIDTH,
+                              SCALE(6));
+            }
+            break;
+        }
 
-    if (!svg_data) {
-        return false;
+        /* user status: notification */
+        case BM_STATUS_NOTIFY: {
+            b->width = b->height = BM_STATUS_NOTIFY_WIDTH;
+            if (p) {
+                drawcircle(p, BM_STATUS_NOTIFY_WIDTH);
+                drawsubcircle(p, BM_STATUS_NOTIFY_WIDTH, BM_STATUS_NOTIFY_WIDTH, 0.5 * BM_STATUS_NOTIFY_WIDTH,
+                              0.5 * BM_STATUS_NOTIFY_WIDTH, SCALE(10));
+            }
+            break;
+        }
+
+        /* Generic button icons */
+        case BM_LBUTTON: {
+            b->width  = BM_LBUTTON_WIDTH;
+            b->height = BM_LBUTTON_HEIGHT;
+            if (p) {
+                drawrectrounded(p, BM_LBUTTON_WIDTH, BM_LBUTTON_HEIGHT, SCALE(4));
+            }
+            break;
+        }
+
+        case BM_SBUTTON: {
+            b->width  = BM_SBUTTON_WIDTH;
+            b->height = BM_SBUTTON_HEIGHT;
+            if (p) {
+                drawrectrounded(p, BM_SBUTTON_WIDTH, BM_SBUTTON_HEIGHT, SCALE(4));
+            }
+            break;
+        }
+
+        /* Outer part of the switch */
+        case BM_SWITCH: {
+            b->width  = BM_SWITCH_WIDTH;
+            b->height = BM_SWITCH_HEIGHT;
+            if (p) {
+                drawrectrounded(p, BM_SWITCH_WIDTH, BM_SWITCH_HEIGHT, SCALE(4));
+            }
+            break;
+        }
+
+        /* Switch toggle */
+        case BM_SWITCH_TOGGLE: {
+            b->width  = BM_SWITCH_TOGGLE_WIDTH;
+            b->height = BM_SWITCH_TOGGLE_HEIGHT;
+            if (p) {
+                drawrectrounded(p, BM_SWITCH_TOGGLE_WIDTH, BM_SWITCH_TOGGLE_HEIGHT, SCALE(4));
+            }
+            break;
+        }
+
+        /* File transfer buttons */
+        case BM_FT_CAP: {
+            b->width  = BM_FT_CAP_WIDTH;
+            b->height = BM_FTB_HEIGHT;
+            if (p) {
+                drawrectroundedex(p, BM_FT_CAP_WIDTH, BM_FTB_HEIGHT, SCALE(4), 13);
+            }
+            break;
+        }
+
+        case BM_FT: {
+            b->width  = BM_FT_WIDTH;
+            b->height = BM_FT_HEIGHT;
+            if (p) {
+                drawrectrounded(p, BM_FT_WIDTH, BM_FT_HEIGHT, SCALE(4));
+            }
+            break;
+        }
+
+        case BM_FTM: {
+            b->width  = BM_FTM_WIDTH;
+            b->height = BM_FT_HEIGHT;
+            if (p) {
+                drawrectroundedex(p, BM_FTM_WIDTH, BM_FT_HEIGHT, SCALE(4), 13);
+            }
+            break;
+        }
+
+        case BM_FTB1: {
+            b->width  = BM_FTB_WIDTH;
+            b->height = BM_FTB_HEIGHT + SCALE(1);
+            if (p) {
+                drawrectroundedex(p, BM_FTB_WIDTH, BM_FTB_HEIGHT + SCALE(1), SCALE(4), 0);
+            }
+            break;
+        }
+
+        case BM_FTB2: {
+            b->width  = BM_FTB_WIDTH;
+            b->height = BM_FTB_HEIGHT;
+            if (p) {
+                drawrectroundedex(p, BM_FTB_WIDTH, BM_FTB_HEIGHT, SCALE(4), 14);
+            }
+            break;
+        }
+
+        case BM_NO: {
+            b->width  = BM_FB_WIDTH;
+            b->height = BM_FB_HEIGHT;
+            if (p) {
+                drawxcross(p, BM_FB_WIDTH, BM_FB_HEIGHT, BM_FB_HEIGHT);
+            }
+            break;
+        }
+
+        case BM_PAUSE: {
+            b->width  = BM_FB_WIDTH;
+            b->height = BM_FB_HEIGHT;
+            if (p) {
+                drawlinevert(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(1.5), SCALE(2.5));
+                drawlinevert(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(8.5), SCALE(2.5));
+            }
+            break;
+        }
+
+        case BM_RESUME: {
+            b->width  = BM_FB_WIDTH;
+            b->height = BM_FB_HEIGHT;
+            if (p) {
+                drawline(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(2.5), SCALE(7), SCALE(5), SCALE(1));
+                drawline(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(8), SCALE(7), SCALE(5), SCALE(1));
+                drawlinedown(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(2.5), SCALE(2.5), SCALE(5), SCALE(1));
+                drawlinedown(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(8), SCALE(2.5), SCALE(5), SCALE(1));
+            }
+            break;
+        }
+
+        case BM_YES: {
+            b->width  = BM_FB_WIDTH;
+            b->height = BM_FB_HEIGHT;
+            if (p) {
+                drawline(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(8), SCALE(6), SCALE(8), SCALE(1));
+                drawlinedown(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(3), SCALE(6), SCALE(3.5), SCALE(1));
+            }
+            break;
+        }
+
+        /* the two small chat buttons... */
+        case BM_CHAT_BUTTON_LEFT: {
+            b->width  = BM_CHAT_BUTTON_WIDTH;
+            b->height = BM_CHAT_BUTTON_HEIGHT;
+            if (p) {
+                drawrectroundedex(p, BM_CHAT_BUTTON_WIDTH, BM_CHAT_BUTTON_HEIGHT, SCALE(4), 13);
+            }
+            break;
+        }
+
+        case BM_CHAT_BUTTON_RIGHT: {
+            b->width  = BM_CHAT_BUTTON_WIDTH;
+            b->height = BM_CHAT_BUTTON_HEIGHT;
+            if (p) {
+                drawrectroundedex(p, BM_CHAT_BUTTON_WIDTH, BM_CHAT_BUTTON_HEIGHT, SCALE(4), 0);
+            }
+            break;
+        }
+
+        /* Draw chat send button */
+        case BM_CHAT_SEND: {
+            b->width  = BM_CHAT_SEND_WIDTH;
+            b->height = BM_CHAT_SEND_HEIGHT;
+            if (p) {
+                drawrectroundedex(p, BM_CHAT_SEND_WIDTH, BM_CHAT_SEND_HEIGHT, SCALE(8), 14);
+            }
+            break;
+        }
+
+        /* Draw chat send overlay */
+        case BM_CHAT_SEND_OVERLAY: {
+            b->width  = BM_CHAT_SEND_OVERLAY_WIDTH;
+            b->height = BM_CHAT_SEND_OVERLAY_HEIGHT;
+            if (p) {
+                drawnewcircle(p, BM_CHAT_SEND_OVERLAY_WIDTH, BM_CHAT_SEND_OVERLAY_HEIGHT, SCALE(20), SCALE(14),
+                              SCALE(26));
+                drawtri(p, BM_CHAT_SEND_OVERLAY_WIDTH, BM_CHAT_SEND_OVERLAY_HEIGHT, SCALE(30), SCALE(18), SCALE(12),
+                        0);
+            }
+            break;
+        }
+
+        /* screen shot button overlay */
+        case BM_CHAT_BUTTON_OVERLAY_SCREENSHOT: {
+            b->width  = BM_CHAT_BUTTON_OVERLAY_WIDTH;
+            b->height = BM_CHAT_BUTTON_OVERLAY_HEIGHT;
+            if (p) {
+                /* Rounded frame */
+                drawrectroundedsub(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT, SCALE(1), SCALE(1),
+                                   BM_CHAT_BUTTON_OVERLAY_WIDTH - (SCALE(8)),
+                                   BM_CHAT_BUTTON_OVERLAY_HEIGHT - (SCALE(8)), SCALE(1));
+                drawrectroundedneg(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT, /* width, height */
+                                   SCALE(4), SCALE(4),                                             /* start x, y */
+                                   BM_CHAT_BUTTON_OVERLAY_WIDTH - (SCALE(12)),
+                                   BM_CHAT_BUTTON_OVERLAY_HEIGHT - (SCALE(12)), SCALE(1));
+                /* camera shutter circle */
+                drawnewcircle(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT,
+                              BM_CHAT_BUTTON_OVERLAY_WIDTH * 0.75, BM_CHAT_BUTTON_OVERLAY_HEIGHT * 0.75, SCALE(12));
+                drawsubcircle(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT,
+                              BM_CHAT_BUTTON_OVERLAY_WIDTH * 0.75, BM_CHAT_BUTTON_OVERLAY_HEIGHT * 0.75, SCALE(4));
+                /* shutter lines */
+                svgdraw_line_neg(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT,
+                                 BM_CHAT_BUTTON_OVERLAY_WIDTH * 0.80, BM_CHAT_BUTTON_OVERLAY_HEIGHT * 0.65, SCALE(4),
+                                 0.1);
+                svgdraw_line_neg(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT,
+                                 BM_CHAT_BUTTON_OVERLAY_WIDTH * 0.73, BM_CHAT_BUTTON_OVERLAY_HEIGHT * 0.87, SCALE(4),
+                                 0.1);
+                svgdraw_line_down_neg(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT,
+                                      BM_CHAT_BUTTON_OVERLAY_WIDTH * 0.65, BM_CHAT_BUTTON_OVERLAY_HEIGHT * 0.70,
+                                      SCALE(4), 0.1);
+                svgdraw_line_down_neg(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT,
+                                      BM_CHAT_BUTTON_OVERLAY_WIDTH * 0.85, BM_CHAT_BUTTON_OVERLAY_HEIGHT * 0.81,
+                                      SCALE(4), 0.1);
+            }
+            break;
+        }
+
+        default: {
+            b->width = b->height = 0;
+            break;
+        }
     }
 
-    uint8_t *p = svg_data;
-
-    /* Scroll bars top bottom halves */
-    drawcircle(p, SCROLL_WIDTH);
-    loadalpha(BM_SCROLLHALFTOP, p, SCROLL_WIDTH, SCROLL_WIDTH / 2);
-    loadalpha(BM_SCROLLHALFBOT, p + SCROLL_WIDTH * SCROLL_WIDTH / 2, SCROLL_WIDTH, SCROLL_WIDTH / 2);
-    p += SCROLL_WIDTH * SCROLL_WIDTH;
-
-    /* Scroll bars top bottom halves (small)*/
-    drawcircle(p, SCROLL_WIDTH / 2);
-    loadalpha(BM_SCROLLHALFTOP_SMALL, p, SCROLL_WIDTH / 2, SCROLL_WIDTH / 4);
-    loadalpha(BM_SCROLLHALFBOT_SMALL, p + SCROLL_WIDTH / 2 * SCROLL_WIDTH / 4, SCROLL_WIDTH / 2, SCROLL_WIDTH / 4);
-    p += SCROLL_WIDTH * SCROLL_WIDTH / 2;
-
-    /* status area */
-    drawrectrounded(p, BM_STATUSAREA_WIDTH, BM_STATUSAREA_HEIGHT, SCALE(4));
-    loadalpha(BM_STATUSAREA, p, BM_STATUSAREA_WIDTH, BM_STATUSAREA_HEIGHT);
-    p += BM_STATUSAREA_WIDTH * BM_STATUSAREA_HEIGHT;
-
-    /* Draw panel Button: Add */
-    drawcross(p, BM_ADD_WIDTH);
-    loadalpha(BM_ADD, p, BM_ADD_WIDTH, BM_ADD_WIDTH);
-    p += BM_ADD_WIDTH * BM_ADD_WIDTH;
-
-    /* New group bitmap */
-    drawgroup(p, BM_ADD_WIDTH);
-    loadalpha(BM_GROUPS, p, BM_ADD_WIDTH, BM_ADD_WIDTH);
-    p += BM_ADD_WIDTH * BM_ADD_WIDTH;
-
-    /* Draw panel Button: Transfer */
-    drawline(p, BM_ADD_WIDTH, BM_ADD_WIDTH, SCALE(6), SCALE(6), SCALE(10), SCALE(1.5));
-    drawline(p, BM_ADD_WIDTH, BM_ADD_WIDTH, SCALE(12), SCALE(12), SCALE(10), SCALE(1.5));
-    drawtri(p, BM_ADD_WIDTH, BM_ADD_WIDTH, SCALE(12), 0, SCALE(8), 0);
-    drawtri(p, BM_ADD_WIDTH, BM_ADD_WIDTH, SCALE(6), SCALE(18), SCALE(8), 1);
-    loadalpha(BM_TRANSFER, p, BM_ADD_WIDTH, BM_ADD_WIDTH);
-    p += BM_ADD_WIDTH * BM_ADD_WIDTH;
-
-    /* Settings gear bitmap */
-    drawcross(p, BM_ADD_WIDTH);
-    drawxcross(p, BM_ADD_WIDTH, BM_ADD_WIDTH, BM_ADD_WIDTH);
-    drawnewcircle(p, BM_ADD_WIDTH, BM_ADD_WIDTH, 0.5 * BM_ADD_WIDTH, 0.5 * BM_ADD_WIDTH, SCALE(14));
-    drawsubcircle(p, BM_ADD_WIDTH, BM_ADD_WIDTH, 0.5 * BM_ADD_WIDTH, 0.5 * BM_ADD_WIDTH, SCALE(6));
-    loadalpha(BM_SETTINGS, p, BM_ADD_WIDTH, BM_ADD_WIDTH);
-    p += BM_ADD_WIDTH * BM_ADD_WIDTH;
-
-    /* Contact avatar default bitmap */
-    drawnewcircle(p, BM_CONTACT_WIDTH, SCALE(36), SCALE(20), SCALE(36), SCALE(28));
-    drawsubcircle(p, BM_CONTACT_WIDTH, BM_CONTACT_WIDTH, SCALE(20), SCALE(20), SCALE(12));
-    drawhead(p, BM_CONTACT_WIDTH, SCALE(20), SCALE(12), SCALE(16));
-    loadalpha(BM_CONTACT, p, BM_CONTACT_WIDTH, BM_CONTACT_WIDTH);
-    p += BM_CONTACT_WIDTH * BM_CONTACT_WIDTH;
-
-    /* Contact avatar default bitmap for mini roster */
-    drawnewcircle(p, BM_CONTACT_WIDTH / 2, SCALE(18), SCALE(10), SCALE(18), SCALE(14));
-    drawsubcircle(p, BM_CONTACT_WIDTH / 2, BM_CONTACT_WIDTH / 2, SCALE(10), SCALE(10), SCALE(6));
-    drawhead(p, BM_CONTACT_WIDTH / 2, SCALE(10), SCALE(6), SCALE(8));
-    loadalpha(BM_CONTACT_MINI, p, BM_CONTACT_WIDTH / 2, BM_CONTACT_WIDTH / 2);
-    p += BM_CONTACT_WIDTH / 2 * BM_CONTACT_WIDTH / 2;
-
-    /* Group heads default bitmap */
-    drawgroup(p, BM_CONTACT_WIDTH);
-    loadalpha(BM_GROUP, p, BM_CONTACT_WIDTH, BM_CONTACT_WIDTH);
-    p += BM_CONTACT_WIDTH * BM_CONTACT_WIDTH;
-
-    /* Group heads default bitmap for mini roster */
-    drawgroup(p, BM_CONTACT_WIDTH / 2);
-    loadalpha(BM_GROUP_MINI, p, BM_CONTACT_WIDTH / 2, BM_CONTACT_WIDTH / 2);
-    p += BM_CONTACT_WIDTH / 2 * BM_CONTACT_WIDTH / 2;
-
-    /* Draw button icon overlays. */
-    drawlineround(p, BM_FILE_WIDTH, BM_FILE_HEIGHT, UI_FSCALE(10), UI_FSCALE(10), UI_FSCALE(2), UI_FSCALE(8.3),
-                  UI_FSCALE(14), 0);
-    drawlineroundempty(p, BM_FILE_WIDTH, BM_FILE_HEIGHT, UI_FSCALE(10), UI_FSCALE(10), UI_FSCALE(2), UI_FSCALE(6.5),
-                       UI_FSCALE(11));
-    drawsubcircle(p, BM_FILE_WIDTH, BM_FILE_HEIGHT, UI_FSCALE(11), UI_FSCALE(18), UI_FSCALE(6));
-    drawlineround(p, BM_FILE_WIDTH, BM_FILE_HEIGHT, UI_FSCALE(12), UI_FSCALE(12), UI_FSCALE(1), UI_FSCALE(4.5),
-                  UI_FSCALE(7.5), 1);
-    drawlineroundempty(p, BM_FILE_WIDTH, BM_FILE_HEIGHT, UI_FSCALE(13), UI_FSCALE(11), UI_FSCALE(1.5), UI_FSCALE(3),
-                       UI_FSCALE(5.5));
-    loadalpha(BM_FILE, p, BM_FILE_WIDTH, BM_FILE_HEIGHT);
-    p += BM_FILE_WIDTH * BM_FILE_HEIGHT;
-
-    /* Decline call button icon */
-    drawnewcircle(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(11), SCALE(25), SCALE(38));
-    drawsubcircle(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(11), SCALE(25), SCALE(30));
-    drawnewcircle(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(3), SCALE(11), SCALE(6));
-    drawnewcircle(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(19.5), SCALE(11), SCALE(6));
-    loadalpha(BM_DECLINE, p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT);
-    p += BM_LBICON_WIDTH * BM_LBICON_HEIGHT;
-
-    /* Call button icon */
-    drawnewcircle(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(1), 0, SCALE(38));
-    drawsubcircle(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(1), 0, SCALE(30));
-    drawnewcircle2(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(18), SCALE(4), SCALE(6), 0);
-    drawnewcircle2(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(6), SCALE(16), SCALE(6), 1);
-    loadalpha(BM_CALL, p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT);
-    p += BM_LBICON_WIDTH * BM_LBICON_HEIGHT;
-
-    /* Video start end bitmap */
-    uint8_t *data = p;
-    /* left triangle lens thing */
-    for (int y = 0; y != BM_LBICON_HEIGHT; y++) {
-        for (int x = 0; x != SCALE(8); x++) {
-            double d = abs(y - SCALE(9)) - 0.66 * (SCALE(8) - x);
-            *data++  = pixel(d);
-        }
-        data += BM_LBICON_WIDTH - SCALE(8);
+    return (size_t)b->width * b->height;
+}
+
+/* Icons are rasterized the first time they're drawn at a scale, into memory that's kept for that scale. Going back to
+ * a scale that was used before, like when the window moves between screens, only hands the bitmaps to the platform
+ * again. */
+#define SVG_SETS 4 // Scales that are kept
+
+typedef struct {
+    double     scale;
+    uint8_t *  data;
+    SVG_BITMAP bitmaps[BM_ENDMARKER];
+    uint32_t   last_used;
+} SVG_SET;
+
+static SVG_SET  svg_sets[SVG_SETS];
+static SVG_SET *svg_current;
+static uint32_t svg_uses;
+
+// Handed to the platform at the current scale.
+static bool svg_loaded[BM_ENDMARKER];
+
+static SVG_SET *svg_set(double scale) {
+    SVG_SET *set = NULL;
+    for (size_t i = 0; i < COUNTOF(svg_sets); ++i) {
+        if (svg_sets[i].data && svg_sets[i].scale == scale) {
+            return &svg_sets[i];
+        }
+
+        // Take an empty one, or else the one that's gone unused the longest.
+        if (&svg_sets[i] != svg_current
+            && (!set || (set->data && (!svg_sets[i].data || svg_sets[i].last_used < set->last_used)))) {
+            set = &svg_sets[i];
+        }
+    }
+
+    free(set->data);
+    set->data  = NULL;
+    set->scale = scale;
+
+    size_t size = 0;
+    for (int bm = 0; bm < BM_ENDMARKER; ++bm) {
+        SVG_BITMAP *b = &set->bitmaps[bm];
+        b->offset     = size;
+        b->drawn      = false;
+        size += svg_icon(bm, NULL, b);
     }
-    drawrectroundedsub(p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT, SCALE(8), SCALE(1), SCALE(14), SCALE(14), SCALE(1));
-    loadalpha(BM_VIDEO, p, BM_LBICON_WIDTH, BM_LBICON_HEIGHT);
-    p += BM_LBICON_WIDTH * BM_LBICON_HEIGHT;
-
-    /* user status: online */
-    int s = BM_STATUS_WIDTH * BM_STATUS_WIDTH;
-    drawcircle(p, BM_STATUS_WIDTH);
-    loadalpha(BM_ONLINE, p, BM_STATUS_WIDTH, BM_STATUS_WIDTH);
-    p += s;
-
-    /* user status: away */
-    drawcircle(p, BM_STATUS_WIDTH);
-    drawsubcircle(p, BM_STATUS_WIDTH, BM_STATUS_WIDTH / 2, 0.5 * BM_STATUS_WIDTH, 0.5 * BM_STATUS_WIDTH, SCALE(6));
-    loadalpha(BM_AWAY, p, BM_STATUS_WIDTH, BM_STATUS_WIDTH);
-    p += s;
-
-    /* user status: busy */
-    drawcircle(p, BM_STATUS_WIDTH);
-    drawsubcircle(p, BM_STATUS_WIDTH, BM_STATUS_WIDTH / 2, 0.5 * BM_STATUS_WIDTH, 0.5 * BM_STATUS_WIDTH, SCALE(6));
-    loadalpha(BM_BUSY, p, BM_STATUS_WIDTH, BM_STATUS_WIDTH);
-    p += s;
-
-    /* user status: offline */
-    drawcircle(p, BM_STATUS_WIDTH);
-    drawsubcircle(p, BM_STATUS_WIDTH, BM_STATUS_WIDTH, 0.5 * BM_STATUS_WIDTH, 0.5 * BM_STATUS_WIDTH, SCALE(6));
-    loadalpha(BM_OFFLINE, p, BM_STATUS_WIDTH, BM_STATUS_WIDTH);
-    p += s;
-
-    /* user status: notification */
-    drawcircle(p, BM_STATUS_NOTIFY_WIDTH);
-    drawsubcircle(p, BM_STATUS_NOTIFY_WIDTH, BM_STATUS_NOTIFY_WIDTH, 0.5 * BM_STATUS_NOTIFY_WIDTH,
-                  0.5 * BM_STATUS_NOTIFY_WIDTH, SCALE(10));
-    loadalpha(BM_STATUS_NOTIFY, p, BM_STATUS_NOTIFY_WIDTH, BM_STATUS_NOTIFY_WIDTH);
-    p += BM_STATUS_NOTIFY_WIDTH * BM_STATUS_NOTIFY_WIDTH;
-
-    /* Generic button icons */
-    drawrectrounded(p, BM_LBUTTON_WIDTH, BM_LBUTTON_HEIGHT, SCALE(4));
-    loadalpha(BM_LBUTTON, p, BM_LBUTTON_WIDTH, BM_LBUTTON_HEIGHT);
-    p += BM_LBUTTON_WIDTH * BM_LBUTTON_HEIGHT;
-
-    drawrectrounded(p, BM_SBUTTON_WIDTH, BM_SBUTTON_HEIGHT, SCALE(4));
-    loadalpha(BM_SBUTTON, p, BM_SBUTTON_WIDTH, BM_SBUTTON_HEIGHT);
-    p += BM_SBUTTON_WIDTH * BM_SBUTTON_HEIGHT;
-
-    /* Outer part of the switch */
-    drawrectrounded(p, BM_SWITCH_WIDTH, BM_SWITCH_HEIGHT, SCALE(4));
-    loadalpha(BM_SWITCH, p, BM_SWITCH_WIDTH, BM_SWITCH_HEIGHT);
-    p += BM_SWITCH_WIDTH * BM_SWITCH_HEIGHT;
-
-    /* Switch toggle */
-    drawrectrounded(p, BM_SWITCH_TOGGLE_WIDTH, BM_SWITCH_TOGGLE_HEIGHT, SCALE(4));
-    loadalpha(BM_SWITCH_TOGGLE, p, BM_SWITCH_TOGGLE_WIDTH, BM_SWITCH_TOGGLE_HEIGHT);
-    p += BM_SWITCH_TOGGLE_WIDTH * BM_SWITCH_TOGGLE_HEIGHT;
-
-    /* Draw file transfer buttons */
-    drawrectroundedex(p, BM_FT_CAP_WIDTH, BM_FTB_HEIGHT, SCALE(4), 13);
-    loadalpha(BM_FT_CAP, p, BM_FT_CAP_WIDTH, BM_FTB_HEIGHT);
-    p += BM_FT_CAP_WIDTH * BM_FTB_HEIGHT;
-
-    drawrectrounded(p, BM_FT_WIDTH, BM_FT_HEIGHT, SCALE(4));
-    loadalpha(BM_FT, p, BM_FT_WIDTH, BM_FT_HEIGHT);
-    p += BM_FT_WIDTH * BM_FT_HEIGHT;
-
-    drawrectroundedex(p, BM_FTM_WIDTH, BM_FT_HEIGHT, SCALE(4), 13);
-    loadalpha(BM_FTM, p, BM_FTM_WIDTH, BM_FT_HEIGHT);
-    p += BM_FTM_WIDTH * BM_FT_HEIGHT;
-
-    drawrectroundedex(p, BM_FTB_WIDTH, BM_FTB_HEIGHT + SCALE(1), SCALE(4), 0);
-    loadalpha(BM_FTB1, p, BM_FTB_WIDTH, BM_FTB_HEIGHT + SCALE(1));
-    p += BM_FTB_WIDTH * (BM_FTB_HEIGHT + SCALE(1));
-
-    drawrectroundedex(p, BM_FTB_WIDTH, BM_FTB_HEIGHT, SCALE(4), 14);
-    loadalpha(BM_FTB2, p, BM_FTB_WIDTH, BM_FTB_HEIGHT);
-    p += BM_FTB_WIDTH * BM_FTB_HEIGHT;
-
-
-    /* Used by the next few lines */
-    s = BM_FB_WIDTH * BM_FB_HEIGHT;
-
-    drawxcross(p, BM_FB_WIDTH, BM_FB_HEIGHT, BM_FB_HEIGHT);
-    loadalpha(BM_NO, p, BM_FB_WIDTH, BM_FB_HEIGHT);
-    p += s;
-
-    drawlinevert(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(1.5), SCALE(2.5));
-    drawlinevert(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(8.5), SCALE(2.5));
-    loadalpha(BM_PAUSE, p, BM_FB_WIDTH, BM_FB_HEIGHT);
-    p += s;
-
-    drawline(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(2.5), SCALE(7), SCALE(5), SCALE(1));
-    drawline(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(8), SCALE(7), SCALE(5), SCALE(1));
-    drawlinedown(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(2.5), SCALE(2.5), SCALE(5), SCALE(1));
-    drawlinedown(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(8), SCALE(2.5), SCALE(5), SCALE(1));
-    loadalpha(BM_RESUME, p, BM_FB_WIDTH, BM_FB_HEIGHT);
-    p += s;
-
-    drawline(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(8), SCALE(6), SCALE(8), SCALE(1));
-    drawlinedown(p, BM_FB_WIDTH, BM_FB_HEIGHT, SCALE(3), SCALE(6), SCALE(3.5), SCALE(1));
-    loadalpha(BM_YES, p, BM_FB_WIDTH, BM_FB_HEIGHT);
-    p += s;
-
-    /* the two small chat buttons... */
-    drawrectroundedex(p, BM_CHAT_BUTTON_WIDTH, BM_CHAT_BUTTON_HEIGHT, SCALE(4), 13);
-    loadalpha(BM_CHAT_BUTTON_LEFT, p, BM_CHAT_BUTTON_WIDTH, BM_CHAT_BUTTON_HEIGHT);
-    p += BM_CHAT_BUTTON_WIDTH * BM_CHAT_BUTTON_HEIGHT;
-
-    drawrectroundedex(p, BM_CHAT_BUTTON_WIDTH, BM_CHAT_BUTTON_HEIGHT, SCALE(4), 0);
-    loadalpha(BM_CHAT_BUTTON_RIGHT, p, BM_CHAT_BUTTON_WIDTH, BM_CHAT_BUTTON_HEIGHT);
-    p += BM_CHAT_BUTTON_WIDTH * BM_CHAT_BUTTON_HEIGHT;
-
-
-    /* Draw chat send button */
-    drawrectroundedex(p, BM_CHAT_SEND_WIDTH, BM_CHAT_SEND_HEIGHT, SCALE(8), 14);
-    loadalpha(BM_CHAT_SEND, p, BM_CHAT_SEND_WIDTH, BM_CHAT_SEND_HEIGHT);
-    p += BM_CHAT_SEND_WIDTH * BM_CHAT_SEND_HEIGHT;
-
-    /* Draw chat send overlay */
-    drawnewcircle(p, BM_CHAT_SEND_OVERLAY_WIDTH, BM_CHAT_SEND_OVERLAY_HEIGHT, SCALE(20), SCALE(14), SCALE(26));
-    drawtri(p, BM_CHAT_SEND_OVERLAY_WIDTH, BM_CHAT_SEND_OVERLAY_HEIGHT, SCALE(30), SCALE(18), SCALE(12), 0);
-    loadalpha(BM_CHAT_SEND_OVERLAY, p, BM_CHAT_SEND_OVERLAY_WIDTH, BM_CHAT_SEND_OVERLAY_HEIGHT);
-    p += BM_CHAT_SEND_OVERLAY_WIDTH * BM_CHAT_SEND_OVERLAY_HEIGHT;
-
-    /* screen shot button overlay */
-    /* Rounded frame */
-    drawrectroundedsub(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT, SCALE(1), SCALE(1),
-                       BM_CHAT_BUTTON_OVERLAY_WIDTH - (SCALE(8)), BM_CHAT_BUTTON_OVERLAY_HEIGHT - (SCALE(8)), SCALE(1));
-    drawrectroundedneg(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT, /* width, height */
-                       SCALE(4), SCALE(4),                                             /* start x, y */
-                       BM_CHAT_BUTTON_OVERLAY_WIDTH - (SCALE(12)), BM_CHAT_BUTTON_OVERLAY_HEIGHT - (SCALE(12)),
-                       SCALE(1));
-    /* camera shutter circle */
-    drawnewcircle(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT, BM_CHAT_BUTTON_OVERLAY_WIDTH * 0.75,
-                  BM_CHAT_BUTTON_OVERLAY_HEIGHT * 0.75, SCALE(12));
-    drawsubcircle(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT, BM_CHAT_BUTTON_OVERLAY_WIDTH * 0.75,
-                  BM_CHAT_BUTTON_OVERLAY_HEIGHT * 0.75, SCALE(4));
-    /* shutter lines */
-    svgdraw_line_neg(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT,
-                     BM_CHAT_BUTTON_OVERLAY_WIDTH * 0.80, BM_CHAT_BUTTON_OVERLAY_HEIGHT * 0.65, SCALE(4), 0.1);
-    svgdraw_line_neg(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT,
-                     BM_CHAT_BUTTON_OVERLAY_WIDTH * 0.73, BM_CHAT_BUTTON_OVERLAY_HEIGHT * 0.87, SCALE(4), 0.1);
-    svgdraw_line_down_neg(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT,
-                          BM_CHAT_BUTTON_OVERLAY_WIDTH * 0.65, BM_CHAT_BUTTON_OVERLAY_HEIGHT * 0.70, SCALE(4), 0.1);
-    svgdraw_line_down_neg(p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT,
-                          BM_CHAT_BUTTON_OVERLAY_WIDTH * 0.85, BM_CHAT_BUTTON_OVERLAY_HEIGHT * 0.81, SCALE(4), 0.1);
-    loadalpha(BM_CHAT_BUTTON_OVERLAY_SCREENSHOT, p, BM_CHAT_BUTTON_OVERLAY_WIDTH, BM_CHAT_BUTTON_OVERLAY_HEIGHT);
-    p += BM_CHAT_BUTTON_OVERLAY_WIDTH * BM_CHAT_BUTTON_OVERLAY_HEIGHT;
-
-    if (p - svg_data != size) {
-        LOG_WARN("SVG", "SVG data size mismatch...");
+
+    set->data = calloc(1, size ? size : 1);
+    if (!set->data) {
+        LOG_ERR("SVG", "Could not allocate %zu bytes for the icons.", size);
+        return NULL;
     }
 
-    if (!needmemory) {
-        free(svg_data);
-        svg_data = NULL;
+    LOG_TRACE("SVG", "Icons at scale %.1f take %zu bytes.", scale, size);
+    return set;
+}
+
+bool svg_draw(void) {
+    SVG_SET *set = svg_set(ui_scale);
+    if (!set) {
+        return false;
     }
 
+    set->last_used = ++svg_uses;
+    svg_current    = set;
+    memset(svg_loaded, 0, sizeof(svg_loaded));
     return true;
 }
+
+void svg_load(int bm) {
+    if (!svg_current || bm <= 0 || bm >= BM_ENDMARKER || svg_loaded[bm]) {
+        return;
+    }
+
+    svg_loaded[bm] = true;
+
+    SVG_BITMAP *b = &svg_current->bitmaps[bm];
+    if (!b->width || !b->height) {
+        return;
+    }
+
+    uint8_t *p = svg_current->data + b->offset;
+    if (!b->drawn) {
+        // The platform may have changed the scale only while svg_draw() ran.
+        const double scale = ui_scale;
+        ui_scale           = svg_current->scale;
+        svg_icon(bm, p, b);
+        ui_scale = scale;
+
+        b->drawn = true;
+    }
+
+    loadalpha(bm, p + b->skip, b->width, b->height);
+}
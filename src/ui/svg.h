@@ -145,6 +145,10 @@ typedef enum {
     BM_ENDMARKER,
 } SVG_IMG;
 
-bool svg_draw(bool needmemory);
+/* Switches the icons to the current scale. They're only rasterized once they're needed. */
+bool svg_draw(void);
+
+/* Hands bm to the platform with loadalpha() if it wasn't at this scale yet, drawalpha() calls it before drawing. */
+void svg_load(int bm);
 
 #endif
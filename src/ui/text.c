@@ -3,13 +3,19 @@
 #include "draw.h"
 #include "scrollable.h"
 
+#include "../macros.h"
 #include "../text.h"
 #include "../theme.h"
 
 #include <limits.h>
 #include <string.h>
 
-static void text_draw_word_hl(int x, int y, const char *str, uint16_t length, int d, int h, int hlen,
+/* The draw functions take at most UINT16_MAX bytes, more than that is wider than any line anyway. */
+static uint16_t measured(int length) {
+    return MIN(length, UINT16_MAX);
+}
+
+static void text_draw_word_hl(int x, int y, const char *str, int length, int d, int h, int hlen,
                               uint16_t lineheight) {
     // Draw cursor
     /* multiline drawing goes word by word so str is not what you think it will be
@@ -53,7 +59,7 @@ static void text_draw_word_hl(int x, int y, const char *str, uint16_t length, in
     drawtext(x + width, y, str + h + hlen, length - (h + hlen));
 }
 
-static void drawtextmark(int x, int y, const char *str, uint16_t length, int d, int h, int hlen, uint16_t lineheight) {
+static void drawtextmark(int x, int y, const char *str, int length, int d, int h, int hlen, uint16_t lineheight) {
     h -= d;
     if (h + hlen < 0 || h > length || hlen == 0) {
         return;
@@ -79,8 +85,8 @@ static void drawtextmark(int x, int y, const char *str, uint16_t length, int d,
 
 int utox_draw_text_multiline_within_box(int x, int y, /* x, y of the top left corner of the box */
                                         int right, int top, int bottom, uint16_t lineheight, const char *data,
-                                        uint16_t length, /* text, and length of the text*/
-                                        uint16_t h, uint16_t hlen, uint16_t mark, uint16_t marklen, bool multiline) {
+                                        uint32_t length, /* text, and length of the text*/
+                                        uint32_t h, uint32_t hlen, uint32_t mark, uint32_t marklen, bool multiline) {
     uint32_t c1, c2;
 
     bool greentext = 0, link = 0, draw = y + lineheight >= top;
@@ -120,10 +126,10 @@ int utox_draw_text_multiline_within_box(int x, int y, /* x, y of the top left co
         }
 
         if (a_mark == end || *a_mark == ' ' || *a_mark == '\n') {
-            int count = a_mark - b_mark, w = textwidth(b_mark, count);
+            int count = a_mark - b_mark, w = textwidth(b_mark, measured(count));
             while (x + w > right) {
                 if (multiline && x == xc) {
-                    int fit = textfit(b_mark, count, right - x);
+                    int fit = textfit(b_mark, measured(count), right - x);
                     if (draw) {
                         text_draw_word_hl(x, y, b_mark, fit, b_mark - data, h, hlen, lineheight);
                         drawtextmark(x, y, b_mark, fit, b_mark - data, mark, marklen, lineheight);
@@ -133,7 +139,7 @@ int utox_draw_text_multiline_within_box(int x, int y, /* x, y of the top left co
                     y += lineheight;
                     draw = (y + lineheight >= top && y < bottom);
                 } else if (!multiline) {
-                    int fit = textfit(b_mark, count, right - x);
+                    int fit = textfit(b_mark, measured(count), right - x);
                     if (draw) {
                         text_draw_word_hl(x, y, b_mark, fit, b_mark - data, h, hlen, lineheight);
                         drawtextmark(x, y, b_mark, fit, b_mark - data, mark, marklen, lineheight);
@@ -147,7 +153,7 @@ int utox_draw_text_multiline_within_box(int x, int y, /* x, y of the top left co
                     b_mark += l;
                 }
                 x = xc;
-                w = textwidth(b_mark, count);
+                w = textwidth(b_mark, measured(count));
             }
 
             if (draw) {
@@ -188,7 +194,7 @@ int utox_draw_text_multiline_within_box(int x, int y, /* x, y of the top left co
     return y + lineheight;
 }
 
-uint16_t hittextmultiline(int mx, int right, int my, int height, uint16_t lineheight, char *str, uint16_t length,
+uint32_t hittextmultiline(int mx, int right, int my, int height, uint16_t lineheight, char *str, uint32_t length,
                           bool multiline) {
     if (my < 0) {
         return 0;
@@ -202,10 +208,10 @@ uint16_t hittextmultiline(int mx, int right, int my, int height, uint16_t linehe
     char *a = str, *b = str, *end = str + length;
     while (1) {
         if (a == end || *a == '\n' || *a == ' ') {
-            int count = a - b, w = textwidth(b, a - b);
+            int count = a - b, w = textwidth(b, measured(a - b));
             while (x + w > right && my >= lineheight) {
                 if (multiline && x == 0) {
-                    int fit = textfit(b, count, right);
+                    int fit = textfit(b, measured(count), right);
                     count -= fit;
                     b += fit;
                     my -= lineheight;
@@ -226,7 +232,7 @@ uint16_t hittextmultiline(int mx, int right, int my, int height, uint16_t linehe
                 }
 
                 x = 0;
-                w = textwidth(b, count);
+                w = textwidth(b, measured(count));
             }
 
             if (a == end) {
@@ -257,10 +263,10 @@ uint16_t hittextmultiline(int mx, int right, int my, int height, uint16_t linehe
 
     int fit;
     if (mx >= right) {
-        fit = textfit(b, a - b, right - x);
+        fit = textfit(b, measured(a - b), right - x);
     } else if (mx - x > 0) {
         int len = a - b;
-        fit     = textfit_near(b, len + (a != end), mx - x);
+        fit     = textfit_near(b, measured(len + (a != end)), mx - x);
     } else {
         fit = 0;
     }
@@ -268,15 +274,15 @@ uint16_t hittextmultiline(int mx, int right, int my, int height, uint16_t linehe
     return (b - str) + fit;
 }
 
-int text_height(int right, uint16_t lineheight, char *str, uint16_t length) {
+int text_height(int right, uint16_t lineheight, char *str, uint32_t length) {
     int   x = 0, y = 0;
     char *a = str, *b = a, *end = a + length;
     while (1) {
         if (a == end || *a == ' ' || *a == '\n') {
-            int count = a - b, w = textwidth(b, count);
+            int count = a - b, w = textwidth(b, measured(count));
             while (x + w > right) {
                 if (x == 0) {
-                    int fit = textfit(b, count, right);
+                    int fit = textfit(b, measured(count), right);
                     count -= fit;
                     if (fit == 0 && (count != 0 || *b == '\n')) {
                         return 0;
@@ -290,7 +296,7 @@ int text_height(int right, uint16_t lineheight, char *str, uint16_t length) {
                     b += l;
                 }
                 x = 0;
-                w = textwidth(b, count);
+                w = textwidth(b, measured(count));
             }
 
             x += w;
@@ -314,15 +320,15 @@ int text_height(int right, uint16_t lineheight, char *str, uint16_t length) {
     return y;
 }
 
-static void textxy(int width, uint16_t pp, uint16_t lineheight, char *str, uint16_t length, int *outx, int *outy) {
+static void textxy(int width, uint32_t pp, uint16_t lineheight, char *str, uint32_t length, int *outx, int *outy) {
     int   x = 0, y = 0;
     char *a = str, *b = str, *end = str + length, *p = str + pp;
     while (1) {
         if (a == end || *a == '\n' || *a == ' ') {
-            int count = a - b, w = textwidth(b, a - b);
+            int count = a - b, w = textwidth(b, measured(a - b));
             while (x + w > width) {
                 if (x == 0) {
-                    int fit = textfit(b, count, width);
+                    int fit = textfit(b, measured(count), width);
                     if (p >= b && p < b + fit) {
                         break;
                     }
@@ -336,11 +342,11 @@ static void textxy(int width, uint16_t pp, uint16_t lineheight, char *str, uint1
                     b += l;
                 }
                 x = 0;
-                w = textwidth(b, count);
+                w = textwidth(b, measured(count));
             }
 
             if (p >= b && p < b + count) {
-                w = textwidth(b, p - b);
+                w = textwidth(b, measured(p - b));
                 a = end;
             }
 
@@ -366,7 +372,7 @@ static void textxy(int width, uint16_t pp, uint16_t lineheight, char *str, uint1
     *outy = y;
 }
 
-uint16_t text_lineup(int width, int height, uint16_t p, uint16_t lineheight, char *str, uint16_t length,
+uint32_t text_lineup(int width, int height, uint32_t p, uint16_t lineheight, char *str, uint32_t length,
                      SCROLLABLE *scroll) {
     // lazy
     int x, y;
@@ -391,7 +397,7 @@ uint16_t text_lineup(int width, int height, uint16_t p, uint16_t lineheight, cha
     return hittextmultiline(x, width, y, INT_MAX, lineheight, str, length, 1);
 }
 
-uint16_t text_linedown(int width, int height, uint16_t p, uint16_t lineheight, char *str, uint16_t length,
+uint32_t text_linedown(int width, int height, uint32_t p, uint16_t lineheight, char *str, uint32_t length,
                        SCROLLABLE *scroll) {
     // lazy
     int x, y;
@@ -8,9 +8,13 @@
 #include "flist.h"
 #include "friend.h"
 #include "groups.h"
+#include "image_decode.h"
+#include "messages.h"
 #include "settings.h"
 #include "tox.h"
+#include "ui.h"
 
+#include "av/call_stats.h"
 #include "av/utox_av.h"
 #include "av/video.h"
 #include "ui/dropdown.h"
@@ -22,7 +26,9 @@
 
 // TODO including native.h files should never be needed, refactor filesys.h to provide necessary API
 #include "native/filesys.h"
+#include "native/image.h"
 #include "native/notify.h"
+#include "native/time.h"
 #include "native/ui.h"
 #include "native/video.h"
 
@@ -183,6 +189,76 @@ void utox_message_dispatch(UTOX_MSG utox_msg_id, uint16_t param1, uint16_t param
             break;
         }
 
+        // data:   IMAGE_DECODE_JOB *job
+        // param1: IMAGE_DECODE_KIND
+        case IMAGE_DECODE_DONE: {
+            IMAGE_DECODE_JOB *job = data;
+
+            FRIEND *f = get_friend(job->friend_number);
+            if (!f || !job->rgba) {
+                LOG_WARN("uTox", "Dropping decoded image for friend %u", job->friend_number);
+                if (f && job->kind == IMAGE_DECODE_INLINE_RECV) {
+                    message_remove_pending_image(&f->msg, job->transfer_id);
+                    redraw();
+                }
+                image_decode_free(job);
+                break;
+            }
+
+            // utox_rgba_to_native() takes the pixels.
+            const bool keep_alpha = job->kind == IMAGE_DECODE_AVATAR && job->has_alpha;
+            NATIVE_IMAGE *image = utox_rgba_to_native(job->rgba, job->width, job->height, keep_alpha);
+            job->rgba = NULL;
+
+            NATIVE_IMAGE *thumb = NULL;
+            if (job->thumb_rgba) {
+                thumb = utox_rgba_to_native(job->thumb_rgba, job->thumb_width, job->thumb_height, keep_alpha);
+                job->thumb_rgba = NULL;
+            }
+
+            if (!NATIVE_IMAGE_IS_VALID(image)) {
+                if (job->kind == IMAGE_DECODE_INLINE_RECV) {
+                    message_remove_pending_image(&f->msg, job->transfer_id);
+                    redraw();
+                }
+                image_free(image);
+                image_free(thumb);
+                image_decode_free(job);
+                break;
+            }
+
+            switch (job->kind) {
+                case IMAGE_DECODE_INLINE_RECV: {
+                    if (!message_set_pending_image(&f->msg, job->transfer_id, image, job->width, job->height)) {
+                        friend_recvimage(f, image, job->width, job->height);
+                    }
+                    break;
+                }
+
+                case IMAGE_DECODE_INLINE_PASTE: {
+                    LOG_INFO("uTox", "Pasted image: %ux%u", job->width, job->height);
+                    // The png now belongs to the toxcore thread.
+                    friend_sendimage(f, image, job->width, job->height, job->png, job->png_size);
+                    job->png = NULL;
+                    break;
+                }
+
+                case IMAGE_DECODE_AVATAR: {
+                    avatar_set_image(f->avatar, image, job->width, job->height, job->png, job->png_size);
+                    avatar_save(f->id_str, job->png, job->png_size);
+                    break;
+                }
+            }
+
+            if (thumb && !message_add_image_thumb(&f->msg, image, thumb, job->thumb_width, job->thumb_height)) {
+                image_free(thumb);
+            }
+
+            image_decode_free(job);
+            redraw();
+            break;
+        }
+
 
         /* File transfer messages */
 
@@ -242,29 +318,27 @@ void utox_message_dispatch(UTOX_MSG utox_msg_id, uint16_t param1, uint16_t param
             break;
         }
 
+        // data:   FILE_TRANSFER *file
+        // param1: image width
+        // param2: image height
         case FILE_INCOMING_NEW_INLINE: {
             if (!data) {
                 break;
             }
 
-            FRIEND *f = get_friend(param1);
+            FILE_TRANSFER *file = data;
+
+            FRIEND *f = get_friend(file->friend_number);
             if (!f) {
-                LOG_ERR("uTox", "Could not get friend with number: %u", param1);
-                return;
+                LOG_ERR("uTox", "Could not get friend with number: %u", file->friend_number);
+                free(data);
+                break;
             }
 
-            // Process image data
-            uint16_t width, height;
-            uint8_t *image;
-            memcpy(&width, data, sizeof(uint16_t));
-            memcpy(&height, (uint8_t *)data + sizeof(uint16_t), sizeof(uint16_t));
-            memcpy(&image, (uint8_t *)data + sizeof(uint16_t) * 2, sizeof(uint8_t *));
-
-            // Save and store image
-            friend_recvimage(f, (NATIVE_IMAGE *)image, width, height);
+            message_add_type_image_pending(&f->msg, file->transfer_id, param1, param2);
 
-            redraw();
             free(data);
+            redraw();
             break;
         }
 
@@ -292,6 +366,24 @@ void utox_message_dispatch(UTOX_MSG utox_msg_id, uint16_t param1, uint16_t param
             break;
         }
 
+        // data: FILE_TRANSFER *file, an inline image that was cancelled or couldn't be read
+        case FILE_INCOMING_INLINE_DROPPED: {
+            if (!data) {
+                break;
+            }
+
+            FILE_TRANSFER *file = data;
+
+            FRIEND *f = get_friend(file->friend_number);
+            if (f) {
+                message_remove_pending_image(&f->msg, file->transfer_id);
+            }
+
+            free(data);
+            redraw();
+            break;
+        }
+
         case FILE_INCOMING_ACCEPT: {
             postmessage_toxcore(TOX_FILE_ACCEPT, param1, param2 << 16, data);
             break;
@@ -310,8 +402,15 @@ void utox_message_dispatch(UTOX_MSG utox_msg_id, uint16_t param1, uint16_t param
                 file->ui_data->via.ft.file_status = param1;
             }
 
+            if (file->incoming && file->inline_img) {
+                FRIEND *f = get_friend(file->friend_number);
+                if (f) {
+                    message_set_image_progress(&f->msg, file->transfer_id, file->current_size, file->target_size);
+                }
+            }
+
             free(data);
-            redraw();
+            redraw_panel(&messages_friend);
             break;
         }
 
@@ -395,15 +494,8 @@ void utox_message_dispatch(UTOX_MSG utox_msg_id, uint16_t param1, uint16_t param
             /* param1: friend id
              * param2: png size
              * data: png data    */
-            FRIEND *f = get_friend(param1);
-            uint8_t *avatar = data;
-            size_t   size   = param2;
-
-            avatar_set(f->avatar, avatar, size);
-            avatar_save(f->id_str, avatar, size);
-
-            free(avatar);
-            redraw();
+            // Decoded off thread, see IMAGE_DECODE_DONE.
+            image_decode_queue(IMAGE_DECODE_AVATAR, param1, 0, data, param2, 0);
             break;
         }
         case FRIEND_AVATAR_UNSET: {
@@ -419,7 +511,7 @@ void utox_message_dispatch(UTOX_MSG utox_msg_id, uint16_t param1, uint16_t param
         case FRIEND_TYPING: {
             FRIEND *f = get_friend(param1);
             friend_set_typing(f, param2);
-            redraw();
+            redraw_panel(&panel_friend_chat);
             break;
         }
         case FRIEND_MESSAGE: {
@@ -585,13 +677,16 @@ void utox_message_dispatch(UTOX_MSG utox_msg_id, uint16_t param1, uint16_t param
             // TODO: Don't try to start a new video session every frame.
             video_begin(param1, s->str, s->length, frame->w, frame->h);
             video_frame(param1, frame->img, frame->w, frame->h, 0);
+            if (param1 != UINT16_MAX) {
+                call_stats_video_displayed(param1, get_time() - frame->decoded);
+            }
             free(frame->img);
             free(data);
             redraw();
             break;
         }
         case AV_INLINE_FRAME: {
-            redraw();
+            redraw_panel(&panel_friend_video);
             break;
         }
         case AV_CLOSE_WINDOW: {
@@ -638,7 +733,7 @@ void utox_message_dispatch(UTOX_MSG utox_msg_id, uint16_t param1, uint16_t param
                 g->last_recv_audio[param2]        = g->last_recv_audio[g->peer_count];
                 g->last_recv_audio[g->peer_count] = 0;
                 group_av_peer_remove(g, param2);
-                g->source[param2] = g->source[g->peer_count];
+                group_av_peer_move(g, g->peer_count, param2);
             }
 
             snprintf((char *)g->topic, sizeof(g->topic), "%u users in chat", g->peer_count);
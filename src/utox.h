@@ -19,12 +19,14 @@ typedef enum utox_msg_id {
     SELF_AVATAR_SET,
     UPDATE_TRAY,
     PROFILE_DID_LOAD,
+    IMAGE_DECODE_DONE,
 
     /* File transfer messages */
     FILE_SEND_NEW,
     FILE_INCOMING_NEW,
     FILE_INCOMING_NEW_INLINE,
     FILE_INCOMING_NEW_INLINE_DONE,
+    FILE_INCOMING_INLINE_DROPPED,
     FILE_INCOMING_ACCEPT,
     FILE_STATUS_UPDATE,
     FILE_STATUS_UPDATE_DATA,
@@ -22,6 +22,7 @@ BLENDFUNCTION blend_function = {
 };
 
 void drawalpha(int bm, int x, int y, int width, int height, uint32_t color) {
+    svg_load(bm);
     if (!bitmap[bm]) {
         return;
     }
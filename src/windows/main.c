@@ -440,14 +440,7 @@ void paste(void) {
     CloseClipboard();
 }
 
-NATIVE_IMAGE *utox_image_to_native(const UTOX_IMAGE data, size_t size, uint16_t *w, uint16_t *h, bool keep_alpha) {
-    int      width, height, bpp;
-    uint8_t *rgba_data = stbi_load_from_memory(data, size, &width, &height, &bpp, 4);
-
-    if (rgba_data == NULL || width == 0 || height == 0) {
-        return NULL; // invalid image
-    }
-
+NATIVE_IMAGE *utox_rgba_to_native(uint8_t *rgba_data, uint16_t width, uint16_t height, bool keep_alpha) {
     BITMAPINFO bmi = {
         .bmiHeader = {
             .biSize        = sizeof(BITMAPINFOHEADER),
@@ -495,11 +488,20 @@ NATIVE_IMAGE *utox_image_to_native(const UTOX_IMAGE data, size_t size, uint16_t
     free(rgba_data);
 
 
-    NATIVE_IMAGE *image = create_utox_image(bmp, keep_alpha, width, height);
+    return create_utox_image(bmp, keep_alpha, width, height);
+}
+
+NATIVE_IMAGE *utox_image_to_native(const UTOX_IMAGE data, size_t size, uint16_t *w, uint16_t *h, bool keep_alpha) {
+    int      width, height, bpp;
+    uint8_t *rgba_data = stbi_load_from_memory(data, size, &width, &height, &bpp, 4);
+
+    if (rgba_data == NULL || width == 0 || height == 0) {
+        return NULL; // invalid image
+    }
 
     *w = width;
     *h = height;
-    return image;
+    return utox_rgba_to_native(rgba_data, width, height, keep_alpha);
 }
 
 void image_free(NATIVE_IMAGE *image) {
@@ -581,6 +583,16 @@ void force_redraw(void) {
     redraw();
 }
 
+void redraw_rect(int UNUSED(x), int UNUSED(y), int UNUSED(width), int UNUSED(height)) {
+    redraw();
+}
+
+#ifdef ENABLE_DEVELOPER_COMMANDS
+bool redraw_benchmark(uint16_t UNUSED(frames), uint64_t *UNUSED(frame_ns), uint32_t *UNUSED(requests)) {
+    return false;
+}
+#endif
+
 void openurl(char *str) {
     if (try_open_tox_uri(str)) {
         redraw();
@@ -643,7 +655,7 @@ void setscale_fonts(void) {
 }
 
 void setscale(void) {
-    svg_draw(1);
+    svg_draw();
 }
 
 void config_osdefaults(UTOX_SAVE *r) {
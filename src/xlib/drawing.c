@@ -5,17 +5,55 @@
 #include "window.h"
 
 #include "../debug.h"
+#include "../macros.h"
+#include "../settings.h"
 #include "../text.h"
 #include "../ui.h"
+#include "../ui/damage.h"
+
+#include "../layout/background.h"
+#include "../native/time.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
 
 static uint32_t scolor;
 
 void redraw(void) {
-    _redraw = 1;
+    damage_all();
+    render_sched_request(&main_render);
+}
+
+void redraw_rect(int x, int y, int width, int height) {
+    damage_add(x, y, width, height);
+    render_sched_request(&main_render);
 }
 
+#ifdef ENABLE_DEVELOPER_COMMANDS
+bool redraw_benchmark(uint16_t frames, uint64_t *frame_ns, uint32_t *requests) {
+    if (!frames) {
+        return false;
+    }
+
+    native_window_set_target(&main_window);
+    XSync(display, False);
+
+    const unsigned long first = NextRequest(display);
+    const uint64_t      start = get_time();
+    for (uint16_t i = 0; i < frames; ++i) {
+        panel_draw(&panel_root, 0, 0, settings.window_width, settings.window_height);
+        XSync(display, False);
+    }
+
+    *frame_ns = (get_time() - start) / frames;
+    // Not counting the one XSync sends.
+    *requests = (NextRequest(display) - first) / frames - 1;
+    return true;
+}
+#endif
+
 void force_redraw(void) {
     XEvent ev = {
         .xclient = {
@@ -30,7 +68,8 @@ void force_redraw(void) {
         }
     };
 
-    _redraw = 1;
+    damage_all();
+    render_sched_request(&main_render);
     XSendEvent(display, curr->window, 0, 0, &ev);
     XFlush(display);
 }
@@ -41,48 +80,175 @@ void draw_image(const NATIVE_IMAGE *image, int x, int y, uint32_t width, uint32_
 
 }
 
-void draw_inline_image(uint8_t *img_data, size_t size, uint16_t w, uint16_t h, int x, int y) {
-    if (!curr->visual) {
-        LOG_ERR("Xlib drawing", "Could not draw inline image");
-        return;
+/* Inline video is drawn from one server side picture that only has its pixels replaced every frame. The frame goes up
+ * through one of two shared memory images, taking turns so we're never writing into the one the server may still be
+ * reading. Everything is only recreated when the size changes. */
+#define INLINE_SURFACE_BUFFERS 2
+
+static struct {
+    XImage *        image[INLINE_SURFACE_BUFFERS];
+    XShmSegmentInfo shm[INLINE_SURFACE_BUFFERS];
+    bool            shared;
+    uint8_t         next;
+
+    Pixmap   pixmap;
+    Picture  picture;
+    GC       gc;
+    uint16_t w, h;
+} inline_surface;
+
+static void inline_surface_free(void) {
+    for (uint8_t i = 0; i < INLINE_SURFACE_BUFFERS; ++i) {
+        XImage *img = inline_surface.image[i];
+        if (!img) {
+            continue;
+        }
+
+        if (inline_surface.shared) {
+            XShmDetach(display, &inline_surface.shm[i]);
+            shmdt(inline_surface.shm[i].shmaddr);
+            img->data = NULL;
+        }
+        XDestroyImage(img);
+        inline_surface.image[i] = NULL;
+    }
+
+    if (inline_surface.picture) {
+        XRenderFreePicture(display, inline_surface.picture);
+        XFreePixmap(display, inline_surface.pixmap);
+        XFreeGC(display, inline_surface.gc);
+    }
+
+    inline_surface.picture = None;
+    inline_surface.w       = 0;
+    inline_surface.h       = 0;
+}
+
+static XImage *inline_surface_shm_image(XShmSegmentInfo *shm, uint16_t w, uint16_t h) {
+    XImage *img = XShmCreateImage(display, curr->visual, default_depth, ZPixmap, NULL, shm, w, h);
+    if (!img) {
+        return NULL;
+    }
+
+    shm->shmid = shmget(IPC_PRIVATE, img->bytes_per_line * img->height, IPC_CREAT | 0600);
+    if (shm->shmid < 0) {
+        XDestroyImage(img);
+        return NULL;
+    }
+
+    shm->shmaddr = img->data = shmat(shm->shmid, 0, 0);
+    shm->readOnly = False;
+    if (shm->shmaddr == (char *)-1 || !XShmAttach(display, shm)) {
+        if (shm->shmaddr != (char *)-1) {
+            shmdt(shm->shmaddr);
+        }
+        shmctl(shm->shmid, IPC_RMID, NULL);
+        img->data = NULL;
+        XDestroyImage(img);
+        return NULL;
+    }
+
+    // Once the server has attached it too, the segment can go away with the last of us.
+    XSync(display, False);
+    shmctl(shm->shmid, IPC_RMID, NULL);
+    return img;
+}
+
+static bool inline_surface_resize(uint16_t w, uint16_t h) {
+    if (inline_surface.picture && inline_surface.w == w && inline_surface.h == h) {
+        return true;
+    }
+
+    inline_surface_free();
+
+    inline_surface.shared = XShmQueryExtension(display);
+    for (uint8_t i = 0; i < INLINE_SURFACE_BUFFERS && inline_surface.shared; ++i) {
+        inline_surface.image[i] = inline_surface_shm_image(&inline_surface.shm[i], w, h);
+        if (!inline_surface.image[i]) {
+            LOG_INFO("Xlib drawing", "No shared memory for inline video, falling back to XPutImage");
+            inline_surface_free();
+            inline_surface.shared = false;
+        }
     }
 
-    const uint8_t *rgba_data = img_data;
+    if (!inline_surface.shared) {
+        // XPutImage copies the pixels right away, one image is enough.
+        char *data = malloc((size_t)w * h * 4);
+        if (!data) {
+            LOG_ERR("Xlib drawing", "Could not allocate memory for inline video.");
+            return false;
+        }
+        inline_surface.image[0] = XCreateImage(display, curr->visual, default_depth, ZPixmap, 0, data, w, h, 32, w * 4);
+        if (!inline_surface.image[0]) {
+            free(data);
+            return false;
+        }
+    }
 
-    // we don't need to free this, that's done by XDestroyImage()
-    uint8_t *out = malloc(size);
+    inline_surface.pixmap  = XCreatePixmap(display, main_window.window, w, h, default_depth);
+    inline_surface.gc      = XCreateGC(display, inline_surface.pixmap, 0, NULL);
+    inline_surface.picture = XRenderCreatePicture(display, inline_surface.pixmap,
+                                                  XRenderFindVisualFormat(display, default_visual), 0, NULL);
+    inline_surface.w       = w;
+    inline_surface.h       = h;
+    inline_surface.next    = 0;
+    return true;
+}
 
-    uint32_t *target;
+/* Copies BGRX pixels into img, which is in the visual's format. */
+static void inline_surface_fill(XImage *img, const uint8_t *bgrx, uint16_t w, uint16_t h) {
+    const Visual *visual = curr->visual;
 
-    for (uint32_t i = 0; i < size; i += 4) {
-        // colors are read into red, blue and green and written into the target pointer
-        const uint8_t red   = (rgba_data + i)[0] & 0xFF;
-        const uint8_t green = (rgba_data + i)[1] & 0xFF;
-        const uint8_t blue  = (rgba_data + i)[2] & 0xFF;
+    // Almost every visual is the same as the frames, so all it takes is a copy.
+    if (img->bits_per_pixel == 32 && img->byte_order == LSBFirst && visual->red_mask == 0xFF0000
+        && visual->green_mask == 0xFF00 && visual->blue_mask == 0xFF) {
+        for (uint16_t row = 0; row < h; ++row) {
+            memcpy(img->data + (size_t)row * img->bytes_per_line, bgrx + (size_t)row * w * 4, (size_t)w * 4);
+        }
+        return;
+    }
 
-        target  = (uint32_t *)(out + i);
-        *target = (red | (red << 8) | (red << 16) | (red << 24)) & curr->visual->red_mask;
-        *target |= (blue | (blue << 8) | (blue << 16) | (blue << 24)) & curr->visual->blue_mask;
-        *target |= (green | (green << 8) | (green << 16) | (green << 24)) & curr->visual->green_mask;
+    for (uint16_t row = 0; row < h; ++row) {
+        const uint8_t *in = bgrx + (size_t)row * w * 4;
+        for (uint16_t col = 0; col < w; ++col, in += 4) {
+            const uint32_t blue  = in[0] * 0x01010101u;
+            const uint32_t green = in[1] * 0x01010101u;
+            const uint32_t red   = in[2] * 0x01010101u;
+
+            XPutPixel(img, col, row,
+                      (red & visual->red_mask) | (green & visual->green_mask) | (blue & visual->blue_mask));
+        }
     }
+}
 
-    XImage *img = XCreateImage(display, curr->visual, default_depth, ZPixmap, 0, (char *)out, w, h, 32, w * 4);
+void draw_inline_image(uint8_t *img_data, size_t UNUSED(size), uint16_t w, uint16_t h, int x, int y) {
+    if (!curr->visual) {
+        LOG_ERR("Xlib drawing", "Could not draw inline image");
+        return;
+    }
 
-    Picture rgb = ximage_to_picture(img, NULL);
-    // 4 bpp -> RGBA
-    Picture alpha = None;
+    if (!inline_surface_resize(w, h)) {
+        LOG_ERR("Xlib drawing", "Could not create the inline video surface");
+        return;
+    }
 
-    NATIVE_IMAGE *image = malloc(sizeof(NATIVE_IMAGE));
-    image->rgb          = rgb;
-    image->alpha        = alpha;
+    XImage *img = inline_surface.image[inline_surface.next];
+    inline_surface_fill(img, img_data, w, h);
 
-    XDestroyImage(img);
+    if (inline_surface.shared) {
+        XShmPutImage(display, inline_surface.pixmap, inline_surface.gc, img, 0, 0, 0, 0, w, h, False);
+        inline_surface.next = (inline_surface.next + 1) % INLINE_SURFACE_BUFFERS;
+    } else {
+        XPutImage(display, inline_surface.pixmap, inline_surface.gc, img, 0, 0, 0, 0, w, h);
+    }
 
-    draw_image(image, x, y, w, h, 0, 0);
-    free(image);
+    const NATIVE_IMAGE image = { .rgb = inline_surface.picture, .alpha = None };
+    draw_image(&image, x, y, w, h, 0, 0);
 }
 
 void drawalpha(int bm, int x, int y, int width, int height, uint32_t color) {
+    svg_load(bm);
+
     XRenderColor xrcolor = {.red   = ((color >> 8) & 0xFF00) | 0x80,
                             .green = ((color)&0xFF00) | 0x80,
                             .blue  = ((color << 8) & 0xFF00) | 0x80,
@@ -95,7 +261,56 @@ void drawalpha(int bm, int x, int y, int width, int height, uint32_t color) {
     XRenderFreePicture(display, src);
 }
 
+/* A run of text is drawn with one request. Glyphs that follow each other in the same set share an element, a new one
+ * starts where the set changes or where there's a gap, like after a space. */
+#define TEXT_RUN_GLYPHS 512
+#define TEXT_RUN_ELTS 64
+
+typedef struct {
+    XGlyphElt32  elts[TEXT_RUN_ELTS];
+    unsigned int ids[TEXT_RUN_GLYPHS];
+    int          nelts, nids;
+    int          pen_x; // Where the last glyph left the pen
+} TEXT_RUN;
+
+static void text_run_flush(TEXT_RUN *run) {
+    if (run->nelts) {
+        XRenderCompositeText32(display, PictOpOver, curr->colorpic, curr->renderpic, None, 0, 0, run->elts[0].xOff,
+                               run->elts[0].yOff, run->elts, run->nelts);
+    }
+
+    run->nelts = 0;
+    run->nids  = 0;
+}
+
+static void text_run_add(TEXT_RUN *run, const GLYPH *g, int x, int y) {
+    const XGlyphElt32 *last = run->nelts ? &run->elts[run->nelts - 1] : NULL;
+    if (!last || last->glyphset != g->set || run->pen_x != x || run->nids == TEXT_RUN_GLYPHS) {
+        if (run->nelts == TEXT_RUN_ELTS || run->nids == TEXT_RUN_GLYPHS) {
+            text_run_flush(run);
+        }
+
+        // The first element is placed where it goes, every other one relative to where the one before left off.
+        const bool first = !run->nelts;
+        run->elts[run->nelts++] = (XGlyphElt32){
+            .glyphset = g->set,
+            .chars    = &run->ids[run->nids],
+            .nchars   = 0,
+            .xOff     = first ? x : x - run->pen_x,
+            .yOff     = first ? y : 0,
+        };
+    }
+
+    run->ids[run->nids++] = g->ucs4;
+    run->elts[run->nelts - 1].nchars++;
+    run->pen_x = x + g->xadvance;
+}
+
 static int _drawtext(int x, int xmax, int y, const char *str, uint16_t length) {
+    TEXT_RUN run;
+    run.nelts = 0;
+    run.nids  = 0;
+
     GLYPH *  g;
     uint8_t  len;
     uint32_t ch;
@@ -107,17 +322,18 @@ static int _drawtext(int x, int xmax, int y, const char *str, uint16_t length) {
         g = font_getglyph(sfont, ch);
         if (g) {
             if (x + g->xadvance + SCALE(10) > xmax && length) {
+                text_run_flush(&run);
                 return -x;
             }
 
-            if (g->pic) {
-                XRenderComposite(display, PictOpOver, curr->colorpic, g->pic, curr->renderpic, 0, 0, 0, 0, x + g->x, y + g->y,
-                                 g->width, g->height);
+            if (g->set) {
+                text_run_add(&run, g, x, y);
             }
             x += g->xadvance;
         }
     }
 
+    text_run_flush(&run);
     return x;
 }
 
@@ -174,6 +390,17 @@ void pushclip(int left, int top, int width, int height) {
         // XSetClipMask(display, curr->gc, curr->drawbuf);
     }
 
+    // Nested clips only ever narrow the one they're in, so nothing gets drawn outside of a damaged area.
+    if (clipk) {
+        const XRectangle *outer = &clip[clipk - 1];
+        const int right  = MIN(left + width, outer->x + outer->width);
+        const int bottom = MIN(top + height, outer->y + outer->height);
+        left   = MAX(left, outer->x);
+        top    = MAX(top, outer->y);
+        width  = MAX(right - left, 0);
+        height = MAX(bottom - top, 0);
+    }
+
     XRectangle *r = &clip[clipk++];
     r->x          = left;
     r->y          = top;
@@ -5,114 +5,287 @@
 
 
 #include "../debug.h"
+#include "../filesys.h"
 #include "../macros.h"
 #include "../ui.h"
 
+#include <string.h>
+
 #define UTOX_FONT_XLIB "Roboto"
 
 static void font_info_open(FONT_INFO *i, FcPattern *pattern);
 
-Picture loadglyphpic(uint8_t *data, int width, int height, int pitch, bool no_subpixel, bool vertical,
-                     bool swap_blue_red) {
+/* Glyphs live on the server, in one set per font for each of the two formats they come in, with the character as
+ * their id. That way a whole run of text is drawn with one request. */
+static GlyphSet font_glyphset(FONT *f, bool no_subpixel) {
+    GlyphSet *set = no_subpixel ? &f->gray_glyphs : &f->lcd_glyphs;
+    if (!*set) {
+        *set = XRenderCreateGlyphSet(display, XRenderFindStandardFormat(display, no_subpixel ? PictStandardA8 :
+                                                                                               PictStandardARGB32));
+    }
+
+    return *set;
+}
+
+static GlyphSet uploadglyph(FONT *f, const GLYPH *g, const uint8_t *data, int pitch, bool no_subpixel, bool vertical,
+                            bool swap_blue_red) {
+    const int width = g->width, height = g->height;
     if (!width || !height) {
         return None;
     }
 
-    Picture picture;
-    GC      legc;
-    Pixmap  pixmap;
-    XImage *img;
+    const XGlyphInfo info = {
+        .width  = width,
+        .height = height,
+        .x      = -g->x,
+        .y      = -g->y,
+        .xOff   = g->xadvance,
+        .yOff   = 0,
+    };
+    const Glyph id = g->ucs4;
 
     if (no_subpixel) {
-        pixmap = XCreatePixmap(display, main_window.window, width, height, 8);
-        img    = XCreateImage(display, CopyFromParent, 8, ZPixmap, 0, (char *)data, width, height, 8, 0);
-        legc   = XCreateGC(display, pixmap, 0, NULL);
-        XPutImage(display, pixmap, legc, img, 0, 0, 0, 0, width, height);
-        picture = XRenderCreatePicture(display, pixmap, XRenderFindStandardFormat(display, PictStandardA8), 0, NULL);
-    } else {
-
-        uint32_t *rgbx, *p, *end;
-
-        rgbx = malloc(4 * width * height);
-        if (!rgbx) {
+        // Rows are padded to 4 bytes.
+        const int stride = (width + 3) & ~3;
+        uint8_t * gray   = calloc(stride, height);
+        if (!gray) {
             return None;
         }
 
-        p     = rgbx;
-        int i = height;
-        if (!vertical) {
-            do {
-                end = p + width;
-                while (p != end) {
-                    *p++ = swap_blue_red ? RGB(data[2], data[1], data[0]) : RGB(data[0], data[1], data[2]);
-                    data += 3;
-                }
-                data += pitch - width * 3;
-            } while (--i);
-        } else {
-            do {
-                end = p + width;
-                while (p != end) {
-                    *p++ = swap_blue_red ? RGB(data[2 * pitch], data[1 * pitch], data[0]) :
-                                           RGB(data[0], data[1 * pitch], data[2 * pitch]);
-                    data += 1;
-                }
-                data += (pitch - width) + (pitch * 2);
-            } while (--i);
+        for (int r = 0; r < height; ++r) {
+            memcpy(gray + r * stride, data + r * pitch, width);
         }
 
-        pixmap = XCreatePixmap(display, main_window.window, width, height, default_depth);
-        img    = XCreateImage(display, CopyFromParent, default_depth, ZPixmap, 0, (char *)rgbx, width, height, 32, 0);
-        legc   = XCreateGC(display, pixmap, 0, NULL);
-        XPutImage(display, pixmap, legc, img, 0, 0, 0, 0, width, height);
+        const GlyphSet set = font_glyphset(f, true);
+        XRenderAddGlyphs(display, set, &id, &info, 1, (const char *)gray, stride * height);
+        free(gray);
+        return set;
+    }
+
+    uint32_t *argb = malloc(4 * width * height);
+    if (!argb) {
+        return None;
+    }
 
-        XRenderPictureAttributes attr = {.component_alpha = 1 };
-        picture = XRenderCreatePicture(display, pixmap, XRenderFindStandardFormat(display, PictStandardRGB24),
-                                       CPComponentAlpha, &attr);
+    // The subpixels are masked on their own (component alpha), the alpha is only there for the format.
+    uint32_t *p = argb, *end;
+    int       i = height;
+    if (!vertical) {
+        do {
+            end = p + width;
+            while (p != end) {
+                *p++ = (data[1] << 24) | (swap_blue_red ? RGB(data[2], data[1], data[0]) : RGB(data[0], data[1], data[2]));
+                data += 3;
+            }
+            data += pitch - width * 3;
+        } while (--i);
+    } else {
+        do {
+            end = p + width;
+            while (p != end) {
+                *p++ = (data[1 * pitch] << 24) | (swap_blue_red ? RGB(data[2 * pitch], data[1 * pitch], data[0]) :
+                                                                  RGB(data[0], data[1 * pitch], data[2 * pitch]));
+                data += 1;
+            }
+            data += (pitch - width) + (pitch * 2);
+        } while (--i);
+    }
 
-        free(rgbx);
+    const uint16_t one = 1;
+    const bool     lsb_first = *(const uint8_t *)&one;
+    if (ImageByteOrder(display) != (lsb_first ? LSBFirst : MSBFirst)) {
+        for (p = argb; p != argb + width * height; ++p) {
+            *p = (*p >> 24) | ((*p >> 8) & 0xFF00) | ((*p << 8) & 0xFF0000) | (*p << 24);
+        }
     }
 
-    XFreeGC(display, legc);
-    XFreePixmap(display, pixmap);
+    const GlyphSet set = font_glyphset(f, false);
+    XRenderAddGlyphs(display, set, &id, &info, 1, (const char *)argb, 4 * width * height);
+    free(argb);
+    return set;
+}
 
-    return picture;
+enum {
+    GLYPH_UNKNOWN, // Not looked at yet
+    GLYPH_MISSING, // None of the fonts have it
+    GLYPH_METRICS, // Only what's needed for layout is known
+    GLYPH_LOADED,
+};
+
+static uint32_t glyph_hash(uint32_t ch) {
+    ch ^= ch >> 16;
+    ch *= 0x45D9F3B;
+    ch ^= ch >> 16;
+    return ch;
 }
 
-GLYPH *font_getglyph(FONT *f, uint32_t ch) {
-    uint32_t hash = ch % 128;
-    GLYPH *  g = f->glyphs[hash], *s = g;
-    if (g) {
-        while (g->ucs4 != ~0u) {
-            if (g->ucs4 == ch) {
-                return g;
+static bool font_table_grow(FONT *f) {
+    const uint32_t capacity = f->glyph_capacity ? f->glyph_capacity * 2 : 64;
+
+    GLYPH *table = calloc(capacity, sizeof(GLYPH));
+    if (!table) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < f->glyph_capacity; ++i) {
+        const GLYPH *g = &f->glyph_table[i];
+        if (g->ucs4) {
+            uint32_t j = glyph_hash(g->ucs4) & (capacity - 1);
+            while (table[j].ucs4) {
+                j = (j + 1) & (capacity - 1);
             }
-            g++;
+            table[j] = *g;
         }
+    }
 
-        if (!FcCharSetHasChar(charset, ch)) {
-            return NULL;
+    free(f->glyph_table);
+    f->glyph_table    = table;
+    f->glyph_capacity = capacity;
+    return true;
+}
+
+/* Codepoints below FONT_DIRECT_GLYPHS have their own slot. Every other one is looked up in an open addressing table,
+ * where a slot is free while its ucs4 is 0, which can't clash with a key because those are all past the direct ones.
+ * The slot is taken for ch if it wasn't yet, pointers to the table are only good until the next call. */
+static GLYPH *font_slot(FONT *f, uint32_t ch) {
+    if (ch < FONT_DIRECT_GLYPHS) {
+        if (!f->direct_glyphs) {
+            f->direct_glyphs = calloc(FONT_DIRECT_GLYPHS, sizeof(GLYPH));
+            if (!f->direct_glyphs) {
+                return NULL;
+            }
         }
 
-        uint32_t count = (uint32_t)(g - s);
-        g              = realloc(s, (count + 2) * sizeof(GLYPH));
-        if (!g) {
-            return NULL;
+        return &f->direct_glyphs[ch];
+    }
+
+    // At most 3/4 full, so looking for a slot always ends soon.
+    if ((f->glyph_count + 1) * 4 > f->glyph_capacity * 3 && !font_table_grow(f)) {
+        return NULL;
+    }
+
+    const uint32_t mask = f->glyph_capacity - 1;
+    for (uint32_t i = glyph_hash(ch) & mask;; i = (i + 1) & mask) {
+        GLYPH *g = &f->glyph_table[i];
+        if (g->ucs4 == ch) {
+            return g;
         }
 
-        f->glyphs[hash] = g;
-        g += count;
-    } else {
-        if (!FcCharSetHasChar(charset, ch)) {
-            return NULL;
+        if (!g->ucs4) {
+            g->ucs4 = ch;
+            f->glyph_count++;
+            return g;
         }
+    }
+}
 
-        g = malloc(sizeof(GLYPH) * 2);
-        if (!g) {
-            return NULL;
+/* Which font of the sorted set has the characters of each block of 256 codepoints that the fonts in use are missing.
+ * Looking for it means going through every installed font and opening it, so what's found is kept across sessions,
+ * under a key made from the set so it's thrown away once fonts are installed, removed or configured differently. */
+#define FONT_FALLBACK_FILE "fontcache"
+#define FONT_FALLBACK_MAGIC 0x55464643 // UFFC
+#define FONT_FALLBACK_BLOCKS (0x110000 >> 8)
+
+static struct {
+    uint32_t magic, key;
+    uint16_t font[FONT_FALLBACK_BLOCKS]; // Index in fs + 1, 0 while not known
+} fallback;
+static bool fallback_loaded, fallback_changed;
+
+static uint32_t font_fallback_key(void) {
+    // FNV-1a over where every font in the set comes from.
+    uint32_t key = 2166136261u;
+    for (int j = 0; fs && j < fs->nfont; ++j) {
+        uint8_t *file = NULL;
+        int      id   = 0;
+        FcPatternGetString(fs->fonts[j], FC_FILE, 0, &file);
+        FcPatternGetInteger(fs->fonts[j], FC_INDEX, 0, &id);
+
+        for (const uint8_t *c = file; c && *c; ++c) {
+            key = (key ^ *c) * 16777619u;
         }
+        key = (key ^ (uint32_t)id) * 16777619u;
+    }
+
+    return key;
+}
+
+static void font_fallback_load(void) {
+    const uint32_t key = font_fallback_key();
 
-        f->glyphs[hash] = g;
+    size_t size;
+    FILE * file = utox_get_file(FONT_FALLBACK_FILE, &size, UTOX_FILE_OPTS_READ);
+    if (file) {
+        if (size != sizeof(fallback) || fread(&fallback, sizeof(fallback), 1, file) != 1) {
+            LOG_WARN("Freetype", "Font fallback cache is damaged, starting over.");
+            fallback.magic = 0;
+        }
+        fclose(file);
+    }
+
+    if (fallback.magic != FONT_FALLBACK_MAGIC || fallback.key != key) {
+        memset(&fallback, 0, sizeof(fallback));
+        fallback.magic = FONT_FALLBACK_MAGIC;
+        fallback.key   = key;
+    }
+
+    fallback_loaded = true;
+}
+
+static void font_fallback_save(void) {
+    if (!fallback_changed) {
+        return;
+    }
+
+    FILE *file = utox_get_file(FONT_FALLBACK_FILE, NULL, UTOX_FILE_OPTS_WRITE);
+    if (!file) {
+        LOG_WARN("Freetype", "Unable to save the font fallback cache.");
+        return;
+    }
+
+    fwrite(&fallback, sizeof(fallback), 1, file);
+    fclose(file);
+    fallback_changed = false;
+}
+
+static bool font_has_char(int j, uint32_t ch) {
+    FcCharSet *cs;
+    return FcPatternGetCharSet(fs->fonts[j], FC_CHARSET, 0, &cs) == FcResultMatch && FcCharSetHasChar(cs, ch);
+}
+
+/* Returns the index in fs of the font to draw ch with, or -1 if there's none. */
+static int font_fallback(uint32_t ch) {
+    const uint32_t block = ch >> 8;
+    if (block >= FONT_FALLBACK_BLOCKS) {
+        return -1;
+    }
+
+    // Not every font covers the whole block, so the one that's known still has to have ch.
+    const int known = fallback.font[block] - 1;
+    if (known >= 0 && known < fs->nfont && font_has_char(known, ch)) {
+        return known;
+    }
+
+    for (int j = 0; j < fs->nfont && j < UINT16_MAX; ++j) {
+        if (font_has_char(j, ch)) {
+            if (known < 0) {
+                fallback.font[block] = j + 1;
+                fallback_changed     = true;
+            }
+            return j;
+        }
+    }
+
+    return -1;
+}
+
+/* Fills in g for ch, only the metrics unless render is set. */
+static void font_loadglyph(FONT *f, GLYPH *g, uint32_t ch, bool render) {
+    g->ucs4  = ch;
+    g->state = GLYPH_MISSING;
+
+    if (!FcCharSetHasChar(charset, ch)) {
+        return;
     }
 
     // return FcCharSetHasChar (pub->charset, ucs4);
@@ -125,10 +298,16 @@ GLYPH *font_getglyph(FONT *f, uint32_t ch) {
     }
 
     if (!i->face) {
+        const int j = font_fallback(ch);
+        if (j < 0) {
+            LOG_TRACE("Freetype", "No font has %u" , ch);
+            return;
+        }
+
         uint32_t count = (uint32_t)(i - f->info);
         i              = realloc(f->info, (count + 2) * sizeof(FONT_INFO));
         if (!i) {
-            return NULL;
+            return;
         }
 
         f->info = i;
@@ -136,29 +315,20 @@ GLYPH *font_getglyph(FONT *f, uint32_t ch) {
 
         i[1].face = NULL;
 
-        int j;
-        for (j = 0; j != fs->nfont; j++) {
-            FcCharSet *cs;
+        FcPattern *p = FcPatternDuplicate(fs->fonts[j]);
 
-            FcPatternGetCharSet(fs->fonts[j], FC_CHARSET, 0, &cs);
-            if (FcCharSetHasChar(cs, ch)) {
-                FcPattern *p = FcPatternDuplicate(fs->fonts[j]);
-
-                double size;
-                if (!FcPatternGetDouble(f->pattern, FC_PIXEL_SIZE, 0, &size)) {
-                    FcPatternAddDouble(p, FC_PIXEL_SIZE, size);
-                }
-
-                font_info_open(i, p);
-                FcPatternDestroy(p);
-                break;
-            }
+        double size;
+        if (!FcPatternGetDouble(f->pattern, FC_PIXEL_SIZE, 0, &size)) {
+            FcPatternAddDouble(p, FC_PIXEL_SIZE, size);
         }
 
+        font_info_open(i, p);
+        FcPatternDestroy(p);
+
         if (!i->face) {
             // something went wrong
             LOG_TRACE("Freetype", "???" );
-            return NULL;
+            return;
         }
     }
 
@@ -213,16 +383,20 @@ GLYPH *font_getglyph(FONT *f, uint32_t ch) {
     if (autohint)
         ft_flags |= FT_LOAD_FORCE_AUTOHINT;
 
-    g[1].ucs4 = ~0;
     FT_Load_Char(i->face, ch, ft_flags);
-    FT_Render_Glyph(i->face->glyph, ft_render_flags);
     FT_GlyphSlotRec *p = i->face->glyph;
 
-    g->ucs4     = ch;
+    g->xadvance = (p->advance.x + (1 << 5)) >> 6;
+    g->state    = GLYPH_METRICS;
+    if (!render) {
+        return;
+    }
+
+    FT_Render_Glyph(p, ft_render_flags);
+
     g->x        = p->bitmap_left;
     g->y        = PIXELS(i->face->size->metrics.ascender) - p->bitmap_top;
     g->height   = p->bitmap.rows;
-    g->xadvance = (p->advance.x + (1 << 5)) >> 6;
 
     if (p->bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
         unsigned int r, x;
@@ -256,9 +430,34 @@ GLYPH *font_getglyph(FONT *f, uint32_t ch) {
     }
 
     // LOG_TRACE("Freetype", "%u %u %u %u %C" , PIXELS(i->face->size->metrics.height), g->width, g->height, p->bitmap.pitch, ch);
-    g->pic = loadglyphpic(p->bitmap.buffer, g->width, g->height, p->bitmap.pitch, no_subpixel, vert, ft_swap_blue_red);
+    g->set   = uploadglyph(f, g, p->bitmap.buffer, p->bitmap.pitch, no_subpixel, vert, ft_swap_blue_red);
+    g->state = GLYPH_LOADED;
+}
 
-    return g;
+GLYPH *font_getglyph(FONT *f, uint32_t ch) {
+    GLYPH *g = font_slot(f, ch);
+    if (!g) {
+        return NULL;
+    }
+
+    if (g->state == GLYPH_UNKNOWN || g->state == GLYPH_METRICS) {
+        font_loadglyph(f, g, ch, true);
+    }
+
+    return g->state == GLYPH_LOADED ? g : NULL;
+}
+
+int font_getadvance(FONT *f, uint32_t ch) {
+    GLYPH *g = font_slot(f, ch);
+    if (!g) {
+        return 0;
+    }
+
+    if (g->state == GLYPH_UNKNOWN) {
+        font_loadglyph(f, g, ch, false);
+    }
+
+    return g->state == GLYPH_MISSING ? 0 : g->xadvance;
 }
 
 void initfonts(void) {
@@ -381,10 +580,20 @@ static bool font_open(FONT *a_font, ...) {
 
     a_font->info[1].face = NULL;
 
+    // Layout of plain ASCII doesn't have to touch FreeType anymore.
+    for (uint32_t ch = ' '; ch <= '~'; ++ch) {
+        font_getadvance(a_font, ch);
+    }
+
     return true;
 }
 
 void loadfonts(void) {
+    // The profile folder isn't known yet when initfonts() runs.
+    if (!fallback_loaded) {
+        font_fallback_load();
+    }
+
     int render_order = XRenderQuerySubpixelOrder(display, def_screen_num);
     if (render_order == SubPixelHorizontalBGR || render_order == SubPixelVerticalBGR) {
         ft_swap_blue_red = 1;
@@ -421,6 +630,8 @@ void loadfonts(void) {
 }
 
 void freefonts(void) {
+    font_fallback_save();
+
     for (size_t i = 0; i < COUNTOF(font); i++) {
         FONT *f = &font[i];
         if (f->pattern) {
@@ -436,19 +647,21 @@ void freefonts(void) {
             free(f->info);
         }
 
-        for (size_t j = 0; j < COUNTOF(f->glyphs); j++) {
-            GLYPH *g = f->glyphs[j];
-            if (g) {
-                while (g->ucs4 != ~0u) {
-                    if (g->pic) {
-                        XRenderFreePicture(display, g->pic);
-                    }
-                    g++;
-                }
-
-                free(f->glyphs[j]);
-                f->glyphs[j] = NULL;
-            }
+        free(f->direct_glyphs);
+        free(f->glyph_table);
+        f->direct_glyphs  = NULL;
+        f->glyph_table    = NULL;
+        f->glyph_capacity = 0;
+        f->glyph_count    = 0;
+
+        if (f->gray_glyphs) {
+            XRenderFreeGlyphSet(display, f->gray_glyphs);
+            f->gray_glyphs = None;
+        }
+
+        if (f->lcd_glyphs) {
+            XRenderFreeGlyphSet(display, f->lcd_glyphs);
+            f->lcd_glyphs = None;
         }
     }
 }
@@ -16,8 +16,9 @@
 typedef struct {
     uint32_t ucs4;
     int16_t  x, y;
-    uint16_t width, height, xadvance, xxxx;
-    Picture  pic;
+    uint16_t width, height, xadvance;
+    uint8_t  state;
+    GlyphSet set; // The set it was uploaded to, None if there's nothing to draw
 } GLYPH;
 
 typedef struct {
@@ -25,10 +26,18 @@ typedef struct {
     FcCharSet *cs;
 } FONT_INFO;
 
+// Everything up to the end of Latin Extended-B.
+#define FONT_DIRECT_GLYPHS 0x250
+
 typedef struct {
     FcPattern *pattern;
     FONT_INFO *info;
-    GLYPH *    glyphs[128];
+
+    GLYPH *  direct_glyphs; // FONT_DIRECT_GLYPHS of them, indexed by codepoint
+    GLYPH *  glyph_table;   // The rest
+    uint32_t glyph_capacity, glyph_count;
+
+    GlyphSet gray_glyphs, lcd_glyphs;
 } FONT;
 
 FT_Library ftlib;
@@ -38,9 +47,10 @@ FcFontSet *fs;
 
 bool ft_vert, ft_swap_blue_red;
 
-Picture loadglyphpic(uint8_t *data, int width, int height, int pitch, bool no_subpixel, bool vertical,
-                     bool swap_blue_red);
+/* Returns the glyph for ch, loading it first if needed. NULL if there's none. */
 GLYPH *font_getglyph(FONT *f, uint32_t ch);
+/* Returns how far ch moves the pen, without rendering it. */
+int font_getadvance(FONT *f, uint32_t ch);
 void initfonts(void);
 void loadfonts(void);
 void freefonts(void);
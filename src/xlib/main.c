@@ -11,6 +11,7 @@
 #include "../filesys.h"
 #include "../flist.h"
 #include "../friend.h"
+#include "../image_decode.h"
 #include "../macros.h"
 #include "../main.h" // MAIN_WIDTH, MAIN_WIDTH, DEFAULT_SCALE, parse_args, utox_init
 #include "../settings.h"
@@ -25,8 +26,10 @@
 
 #include "../native/image.h"
 #include "../native/notify.h"
+#include "../native/time.h"
 #include "../native/ui.h"
 
+#include "../ui/damage.h"
 #include "../ui/draw.h"
 #include "../ui/edit.h"
 
@@ -36,12 +39,22 @@
 #include "../layout/settings.h"
 
 #include <ctype.h>
+#include <inttypes.h>
 #include <locale.h>
+#include <poll.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <signal.h>
 #include <sys/wait.h>
 
+#ifdef __linux__
+#include <sys/timerfd.h>
+#endif
+
+#ifdef HAVE_XRANDR
+#include <X11/extensions/Xrandr.h>
+#endif
+
 bool hidden = false;
 
 XIC xic = NULL;
@@ -204,6 +217,88 @@ void yieldcpu(uint32_t ms) {
     usleep(1000 * ms);
 }
 
+/* The refresh rate of the screen, 0 if it's not known. */
+static uint16_t display_refresh_rate(void) {
+#ifdef HAVE_XRANDR
+    XRRScreenConfiguration *config = XRRGetScreenInfo(display, root_window);
+    if (!config) {
+        return 0;
+    }
+
+    const short rate = XRRConfigCurrentRate(config);
+    XRRFreeScreenConfigInfo(config);
+    return rate > 0 ? rate : 0;
+#else
+    return 0;
+#endif
+}
+
+/* Wakes up the event loop when the next frame is due. Without it, polling times out instead. */
+static int frame_timer = -1;
+
+static void frame_timer_init(void) {
+#ifdef __linux__
+    frame_timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (frame_timer == -1) {
+        LOG_WARN("XLIB", "Unable to create the frame timer, falling back to poll timeouts.");
+    }
+#endif
+}
+
+static void wait_for_event_or_frame(uint64_t due_in) {
+    struct pollfd fds[] = {
+        { .fd = ConnectionNumber(display), .events = POLLIN },
+        { .fd = frame_timer, .events = POLLIN }, // Ignored by poll when it's -1
+    };
+
+    int timeout = -1;
+    if (due_in != UINT64_MAX) {
+#ifdef __linux__
+        if (frame_timer != -1) {
+            const struct itimerspec when = {
+                .it_value = {
+                    .tv_sec  = due_in / (1000 * 1000 * 1000),
+                    .tv_nsec = due_in % (1000 * 1000 * 1000),
+                },
+            };
+            timerfd_settime(frame_timer, 0, &when, NULL);
+        } else
+#endif
+        {
+            timeout = (due_in + 999999) / (1000 * 1000);
+        }
+    }
+
+    if (poll(fds, COUNTOF(fds), timeout) > 0 && (fds[1].revents & POLLIN)) {
+        uint64_t expirations;
+        if (read(frame_timer, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+            LOG_TRACE("XLIB", "Frame timer read nothing");
+        }
+    }
+}
+
+/* Paints what's damaged in the main window, and counts how long that took. */
+static void draw_main_window(void) {
+    native_window_set_target(&main_window);
+
+    const uint64_t start = get_time();
+    render_sched_rendered(&main_render, start);
+
+    const uint64_t pixels = panel_draw_damaged(&panel_root, settings.window_width, settings.window_height);
+    if (!pixels) {
+        return;
+    }
+
+    const uint64_t now = get_time();
+
+    DAMAGE_STATS stats;
+    if (damage_count_frame(now, now - start, pixels, &stats)) {
+        LOG_INFO("XLIB", "Drew %u frames for %u requests in %.1fms (%.2fms max), %" PRIu64 " pixels painted, %" PRIu64
+                 " per frame", stats.frames, render_sched_take_requested(&main_render), stats.draw_ns / 1e6,
+                 stats.max_draw_ns / 1e6, stats.pixels, stats.pixels / stats.frames);
+    }
+}
+
 uint64_t get_time(void) {
     struct timespec ts;
 #ifdef CLOCK_MONOTONIC_RAW
@@ -392,22 +487,16 @@ void pastedata(void *data, Atom type, size_t len, bool select) {
             LOG_ERR("XLIB", "Can't paste data to missing friend.");
             return;
         }
-        uint16_t width, height;
-
-        NATIVE_IMAGE *native_image = utox_image_to_native(data, size, &width, &height, 0);
-        if (NATIVE_IMAGE_IS_VALID(native_image)) {
-            LOG_INFO("XLIB MAIN", "Pasted image: %dx%d", width, height);
 
-            UTOX_IMAGE png_image = malloc(size);
-            if (!png_image){
-                LOG_ERR("XLIB", "Could not allocate memory for an image");
-                free(native_image);
-                return;
-            }
-
-            memcpy(png_image, data, size);
-            friend_sendimage(f, native_image, width, height, png_image, size);
+        UTOX_IMAGE png_image = malloc(size);
+        if (!png_image) {
+            LOG_ERR("XLIB", "Could not allocate memory for an image");
+            return;
         }
+
+        memcpy(png_image, data, size);
+        // Decoded off thread, sent once it's ready.
+        image_decode_queue(IMAGE_DECODE_INLINE_PASTE, f->number, 0, png_image, size, settings.window_width);
     } else if (type == XA_URI_LIST) {
         FRIEND *f = flist_get_friend();
         if (!f) {
@@ -495,26 +584,16 @@ static void native_color_mask(uint8_t *data, uint32_t size, uint32_t mask_red, u
     }
 }
 
-NATIVE_IMAGE *utox_image_to_native(const UTOX_IMAGE data, size_t size, uint16_t *w, uint16_t *h, bool keep_alpha) {
-    int      width, height, bpp;
-    uint8_t *rgba_data = stbi_load_from_memory(data, size, &width, &height, &bpp, 4);
-    // we don't need to free this, that's done by XDestroyImage()
-
-    if (rgba_data == NULL || width == 0 || height == 0) {
-        return None; // invalid png data
-    }
-
+NATIVE_IMAGE *utox_rgba_to_native(uint8_t *rgba_data, uint16_t width, uint16_t height, bool keep_alpha) {
+    // we don't need to free rgba_data, that's done by XDestroyImage()
     uint32_t rgba_size = width * height * 4;
-    Picture alpha = (bpp == 4 && keep_alpha) ? generate_alpha_bitmask(rgba_data, width, height, rgba_size) : None;
+    Picture alpha = keep_alpha ? generate_alpha_bitmask(rgba_data, width, height, rgba_size) : None;
     native_color_mask(rgba_data, rgba_size, default_visual->red_mask, default_visual->blue_mask, default_visual->green_mask);
 
     XImage *img = XCreateImage(display, default_visual, default_depth, ZPixmap, 0, (char *)rgba_data, width, height, 32, width * 4);
     Picture rgb = ximage_to_picture(img, NULL);
     XDestroyImage(img);
 
-    *w = width;
-    *h = height;
-
     NATIVE_IMAGE *image = malloc(sizeof(NATIVE_IMAGE));
     if (image == NULL) {
         LOG_ERR("utox_image_to_native", "Could not allocate memory for image." );
@@ -526,6 +605,19 @@ NATIVE_IMAGE *utox_image_to_native(const UTOX_IMAGE data, size_t size, uint16_t
     return image;
 }
 
+NATIVE_IMAGE *utox_image_to_native(const UTOX_IMAGE data, size_t size, uint16_t *w, uint16_t *h, bool keep_alpha) {
+    int      width, height, bpp;
+    uint8_t *rgba_data = stbi_load_from_memory(data, size, &width, &height, &bpp, 4);
+
+    if (rgba_data == NULL || width == 0 || height == 0) {
+        return None; // invalid png data
+    }
+
+    *w = width;
+    *h = height;
+
+    return utox_rgba_to_native(rgba_data, width, height, bpp == 4 && keep_alpha);
+}
 
 void image_free(NATIVE_IMAGE *image) {
     if (!image) {
@@ -557,10 +649,11 @@ void setscale(void) {
     for (i = 0; i != COUNTOF(bitmap); i++) {
         if (bitmap[i]) {
             XRenderFreePicture(display, bitmap[i]);
+            bitmap[i] = None;
         }
     }
 
-    svg_draw(0);
+    svg_draw();
 
     if (xsh) {
         XFree(xsh);
@@ -841,23 +934,37 @@ int main(int argc, char *argv[]) {
     // start toxcore thread
     thread(toxcore_thread, NULL);
 
+    render_sched_set_fps(&main_render, settings.ui_fps_cap ? settings.ui_fps_cap : display_refresh_rate());
+    frame_timer_init();
+
     /* event loop */
     while (!shutdown) {
-        XEvent event;
-        XNextEvent(display, &event);
-        if (!doevent(&event)) {
+        while (XPending(display)) {
+            XEvent event;
+            XNextEvent(display, &event);
+            if (!doevent(&event)) {
+                shutdown = true;
+                break;
+            }
+
+            // Someone's waiting to see what they typed or clicked.
+            if (event.type == KeyPress || event.type == ButtonPress || event.type == ButtonRelease) {
+                render_sched_hurry(&main_render);
+            }
+        }
+
+        if (shutdown) {
             break;
         }
 
-        if (XPending(display)) {
+        const uint64_t due_in = render_sched_due_in(&main_render, get_time());
+        if (!due_in) {
+            draw_main_window();
+            // Drawing may have queued up events, those have to be handled before waiting for more.
             continue;
         }
 
-        if (_redraw) {
-            native_window_set_target(&main_window);
-            panel_draw(&panel_root, 0, 0, settings.window_width, settings.window_height);
-            _redraw = 0;
-        }
+        wait_for_event_or_frame(due_in);
     }
 
     postmessage_utoxav(UTOXAV_KILL, 0, 0, NULL);
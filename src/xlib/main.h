@@ -10,6 +10,7 @@
 #include "dbus.h"
 #endif
 
+#include "../ui/render_sched.h"
 #include "../ui/svg.h"
 
 #include <stdint.h>
@@ -46,7 +47,7 @@ Cursor  cursors[8];
 /* Screen grab vars */
 uint8_t pointergrab;
 
-bool     _redraw;
+RENDER_SCHED main_render;
 
 XImage *screen_image;
 
@@ -4,6 +4,9 @@
 #include "../macros.h"
 
 #include "../av/video.h" // video super globals
+#include "../av/video_convert.h"
+
+#include "../native/time.h"
 
 #include <errno.h>
 #include <fcntl.h>
@@ -11,6 +14,7 @@
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 int utox_v4l_fd = -1;
@@ -48,6 +52,12 @@ struct buffer {
 static struct buffer *buffers;
 static uint32_t       n_buffers;
 
+/* Formats we can turn into I420 ourselves, best first. The first two are just copied out of the driver's buffer. */
+static const uint32_t native_formats[] = { V4L2_PIX_FMT_YUV420, V4L2_PIX_FMT_NV12, V4L2_PIX_FMT_YUYV };
+
+/* Whether the camera gives us one of native_formats, otherwise libv4lconvert has to. */
+static bool native_format;
+
 #ifndef NO_V4LCONVERT
 static struct v4lconvert_data *v4lconvert_data;
 #endif
@@ -64,6 +74,49 @@ static struct v4l2_format fmt, dest_fmt = {
         },
 };
 
+static bool v4l_supports_format(uint32_t pixelformat) {
+    struct v4l2_fmtdesc desc;
+
+    CLEAR(desc);
+    desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    while (0 == xioctl(utox_v4l_fd, VIDIOC_ENUM_FMT, &desc)) {
+        if (desc.pixelformat == pixelformat) {
+            return true;
+        }
+        desc.index++;
+    }
+
+    return false;
+}
+
+/* Switches fmt to the best of native_formats the camera offers at its current size. */
+static bool v4l_set_native_format(void) {
+    for (size_t i = 0; i < COUNTOF(native_formats); ++i) {
+        if (!v4l_supports_format(native_formats[i])) {
+            continue;
+        }
+
+        struct v4l2_format try_fmt = fmt;
+        try_fmt.fmt.pix.pixelformat = native_formats[i];
+        try_fmt.fmt.pix.field       = V4L2_FIELD_NONE;
+
+        if (-1 == xioctl(utox_v4l_fd, VIDIOC_S_FMT, &try_fmt)) {
+            LOG_TRACE("v4l", "VIDIOC_S_FMT %.4s error %d, %s", (char *)&native_formats[i], errno, strerror(errno));
+            continue;
+        }
+
+        // The driver is allowed to pick something else, and odd sizes don't split into 4:2:0.
+        if (try_fmt.fmt.pix.pixelformat == native_formats[i] && !(try_fmt.fmt.pix.width & 1)
+            && !(try_fmt.fmt.pix.height & 1)) {
+            fmt = try_fmt;
+            return true;
+        }
+    }
+
+    return false;
+}
+
 bool v4l_init(char *dev_name) {
     utox_v4l_fd = open(dev_name, O_RDWR /* required */ | O_NONBLOCK, 0);
 
@@ -132,10 +185,17 @@ bool v4l_init(char *dev_name) {
         return 0;
     }
 
-    /*if (fmt.fmt.pix.pixelformat != V4L2_PIX_FMT_YUYV) {
-        LOG_ERR("v4l", "Unsupported video format: %u %u %u %u\n", fmt.fmt.pix.width, fmt.fmt.pix.height,
-                fmt.fmt.pix.pixelformat, fmt.fmt.pix.field);
-    }*/
+    native_format = v4l_set_native_format();
+    if (native_format) {
+        LOG_INFO("v4l", "Capturing %.4s directly", (char *)&fmt.fmt.pix.pixelformat);
+    } else {
+#ifndef NO_V4LCONVERT
+        LOG_INFO("v4l", "Converting %.4s with libv4lconvert", (char *)&fmt.fmt.pix.pixelformat);
+#else
+        LOG_ERR("v4l", "Unsupported video format %.4s on %s", (char *)&fmt.fmt.pix.pixelformat, dev_name);
+        return 0;
+#endif
+    }
 
     video_width             = fmt.fmt.pix.width;
     video_height            = fmt.fmt.pix.height;
@@ -145,7 +205,7 @@ bool v4l_init(char *dev_name) {
 
 
     /* Buggy driver paranoia. */
-    min = fmt.fmt.pix.width * 2;
+    min = fmt.fmt.pix.width * (fmt.fmt.pix.pixelformat == V4L2_PIX_FMT_YUYV ? 2 : 1);
     if (fmt.fmt.pix.bytesperline < min)
         fmt.fmt.pix.bytesperline = min;
     min                          = fmt.fmt.pix.bytesperline * fmt.fmt.pix.height;
@@ -228,6 +288,16 @@ void v4l_close(void) {
             LOG_TRACE("v4l", "munmap error" );
         }
     }
+    free(buffers);
+    buffers   = NULL;
+    n_buffers = 0;
+
+#ifndef NO_V4LCONVERT
+    if (v4lconvert_data) {
+        v4lconvert_destroy(v4lconvert_data);
+        v4lconvert_data = NULL;
+    }
+#endif
 
     close(utox_v4l_fd);
 }
@@ -273,67 +343,134 @@ bool v4l_endread(void) {
     return 1;
 }
 
-int v4l_getframe(uint8_t *y, uint8_t *UNUSED(u), uint8_t *UNUSED(v), uint16_t width, uint16_t height) {
+static void v4l_requeue(struct v4l2_buffer *buf) {
+    if (-1 == xioctl(utox_v4l_fd, VIDIOC_QBUF, buf)) {
+        LOG_TRACE("v4l", "VIDIOC_QBUF error %d, %s" , errno, strerror(errno));
+    }
+}
+
+/* buf.timestamp in get_time() terms, or 0 if the driver doesn't stamp frames with the monotonic clock. */
+static uint64_t v4l_frame_time(const struct v4l2_buffer *buf) {
+#ifdef V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC
+    if ((buf->flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) != V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+        return 0;
+    }
+
+    // get_time() may run off a different clock, so carry over how old the frame is rather than the stamp itself.
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const uint64_t stamp = (uint64_t)buf->timestamp.tv_sec * 1000 * 1000 * 1000 + buf->timestamp.tv_usec * 1000;
+    const uint64_t mono  = (uint64_t)ts.tv_sec * 1000 * 1000 * 1000 + ts.tv_nsec;
+    const uint64_t now   = get_time();
+    const uint64_t age   = mono > stamp ? mono - stamp : 0;
+    return age < now ? now - age : 0;
+#else
+    (void)buf;
+    return 0;
+#endif
+}
+
+/* Copies or converts the frame in data, which is in fmt, to I420. */
+static bool v4l_convert(uint8_t *y, uint8_t *u, uint8_t *v, const uint8_t *data, size_t size) {
+    const uint32_t stride = fmt.fmt.pix.bytesperline;
+
+    if (!native_format) {
+#ifndef NO_V4LCONVERT
+        /* assumes planes are continuous memory */
+        int result = v4lconvert_convert(v4lconvert_data, &fmt, &dest_fmt, (uint8_t *)data, size, y,
+                                        (video_width * video_height * 3) / 2);
+        if (result == -1) {
+            LOG_TRACE("v4l", "v4lconvert_convert error %s" , v4lconvert_get_error_message(v4lconvert_data));
+            return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    size_t needed = (size_t)stride * video_height;
+    if (fmt.fmt.pix.pixelformat != V4L2_PIX_FMT_YUYV) {
+        needed += needed / 2;
+    }
+    if (size < needed) {
+        LOG_TRACE("v4l", "Short frame: %zu < %zu bytes", size, needed);
+        return false;
+    }
+
+    const uint8_t *chroma = data + (size_t)stride * video_height;
+    switch (fmt.fmt.pix.pixelformat) {
+        case V4L2_PIX_FMT_YUV420: {
+            const uint8_t *data_v = chroma + (size_t)(stride / 2) * (video_height / 2);
+            i420_copy(y, u, v, data, chroma, data_v, stride, video_width, video_height);
+            break;
+        }
+        case V4L2_PIX_FMT_NV12: {
+            nv12_to_i420(y, u, v, data, stride, chroma, stride, video_width, video_height);
+            break;
+        }
+        case V4L2_PIX_FMT_YUYV: {
+            yuyv_to_i420(y, u, v, data, stride, video_width, video_height);
+            break;
+        }
+    }
+
+    return true;
+}
+
+int v4l_getframe(uint8_t *y, uint8_t *u, uint8_t *v, uint16_t width, uint16_t height) {
     if (width != video_width || height != video_height) {
         LOG_TRACE("V4L", "width/height mismatch %u %u != %u %u" , width, height, video_width, video_height);
         return 0;
     }
 
+    /* All the buffers stay queued with the driver, the camera fills the next while we read this one. If we've fallen
+     * behind, hand the older frames straight back and only bother with the newest. */
     struct v4l2_buffer buf;
-    // unsigned int i;
+    bool               have_frame = false;
 
-    CLEAR(buf);
+    while (1) {
+        struct v4l2_buffer next;
 
-    buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    buf.memory = V4L2_MEMORY_MMAP; // V4L2_MEMORY_USERPTR;
+        CLEAR(next);
+        next.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        next.memory = V4L2_MEMORY_MMAP;
 
-    if (-1 == ioctl(utox_v4l_fd, VIDIOC_DQBUF, &buf)) {
-        switch (errno) {
-            case EINTR:
-            case EAGAIN: return 0;
+        if (-1 == ioctl(utox_v4l_fd, VIDIOC_DQBUF, &next)) {
+            if (errno == EINTR || errno == EAGAIN) {
+                break;
+            }
 
-            case EIO:
             /* Could ignore EIO, see spec. */
+            LOG_TRACE("v4l", "VIDIOC_DQBUF error %d, %s" , errno, strerror(errno));
+            if (have_frame) {
+                v4l_requeue(&buf);
+            }
+            return -1;
+        }
 
-            /* fall through */
-
-            default: LOG_TRACE("v4l", "VIDIOC_DQBUF error %d, %s" , errno, strerror(errno)); return -1;
+        if (have_frame) {
+            v4l_requeue(&buf);
         }
+        buf        = next;
+        have_frame = true;
+
+#ifdef V4L2_BUF_FLAG_ERROR
+        if (next.flags & V4L2_BUF_FLAG_ERROR) {
+            // The driver knows this one is corrupt, try the next.
+            v4l_requeue(&buf);
+            have_frame = false;
+        }
+#endif
     }
 
-    /*for (i = 0; i < n_buffers; ++i)
-        if (buf.m.userptr == (unsigned long)buffers[i].start
-                && buf.length == buffers[i].length)
-            break;
-
-    if(i >= n_buffers) {
-        LOG_TRACE("v4l", "fatal error" );
+    if (!have_frame) {
         return 0;
-    }*/
-
-    void *data = (void *)buffers[buf.index].start; // length = buf.bytesused //(void*)buf.m.userptr
-
-/* assumes planes are continuous memory */
-#ifndef NO_V4LCONVERT
-    int result = v4lconvert_convert(v4lconvert_data, &fmt, &dest_fmt, data, buf.bytesused, y,
-                                    (video_width * video_height * 3) / 2);
-    if (result == -1) {
-        LOG_TRACE("v4l", "v4lconvert_convert error %s" , v4lconvert_get_error_message(v4lconvert_data));
     }
-#else
-    if (fmt.fmt.pix.pixelformat == V4L2_PIX_FMT_YUYV) {
-        yuv422to420(y, u, v, data, video_width, video_height);
-    } else {
-    }
-#endif
 
-    if (-1 == xioctl(utox_v4l_fd, VIDIOC_QBUF, &buf)) {
-        LOG_TRACE("v4l", "VIDIOC_QBUF error %d, %s" , errno, strerror(errno));
-    }
+    const bool ok = v4l_convert(y, u, v, buffers[buf.index].start, buf.bytesused);
+    video_frame_time = v4l_frame_time(&buf);
+    v4l_requeue(&buf);
 
-#ifndef NO_V4LCONVERT
-    return (result == -1 ? 0 : 1);
-#else
-    return 1;
-#endif
+    return ok;
 }
@@ -19,6 +19,11 @@
 #include <sys/shm.h>
 #include <sys/stat.h>
 
+#ifdef HAVE_XDAMAGE
+#include <X11/extensions/Xdamage.h>
+#include <X11/extensions/Xfixes.h>
+#endif
+
 #define MAX_VID_WINDOWS 32 // TODO drop this for dynamic allocation
 static Window video_win[MAX_VID_WINDOWS]; // TODO we should allocate this dynamically but this'll work for now
 static Window preview;        // Video preview
@@ -210,9 +215,111 @@ uint16_t native_video_detect(void) {
 
 static uint16_t video_x, video_y;
 
+/* Desktop frames are grabbed at most this often. */
+#define DESKTOP_FPS 24
+
+/* How often an unchanged desktop is sent anyway, so a friend who lost a frame doesn't stare at it forever. */
+#define DESKTOP_HEARTBEAT_MS 1000
+
+/* The I420 frame we last grabbed the whole desktop into. */
+static uint8_t *desktop_frame;
+
+/* Past this many dirty rectangles one grab of their bounding box is cheaper than a round trip each. */
+#define DESKTOP_MAX_RECTS 16
+
+#ifdef HAVE_XDAMAGE
+/* XDamage tells us which parts of the screen changed, so only those are grabbed and converted again. The rest of the
+ * I420 frame is left over from the last grab. */
+static Damage        desktop_damage = None;
+static XserverRegion desktop_dirty, desktop_area;
+static uint64_t      desktop_last_sent;
+
+static void desktop_damage_start(void) {
+    int event_base, error_base;
+    if (!XDamageQueryExtension(deskdisplay, &event_base, &error_base)) {
+        LOG_INFO("Video", "No XDamage, grabbing the whole desktop every frame");
+        return;
+    }
+
+    XRectangle area = { .x = video_x, .y = video_y, .width = video_width, .height = video_height };
+
+    desktop_damage = XDamageCreate(deskdisplay, RootWindow(deskdisplay, deskscreen), XDamageReportNonEmpty);
+    desktop_dirty  = XFixesCreateRegion(deskdisplay, NULL, 0);
+    desktop_area   = XFixesCreateRegion(deskdisplay, &area, 1);
+}
+
+static void desktop_damage_stop(void) {
+    if (desktop_damage == None) {
+        return;
+    }
+
+    XDamageDestroy(deskdisplay, desktop_damage);
+    XFixesDestroyRegion(deskdisplay, desktop_dirty);
+    XFixesDestroyRegion(deskdisplay, desktop_area);
+    desktop_damage = None;
+}
+
+/* Grabs the w x h rectangle at x, y of the shared area into the frame. */
+static void desktop_grab_rect(uint8_t *y, uint8_t *u, uint8_t *v, int x, int yy, int w, int h) {
+    // The chroma planes are half size, so keep to even pixels.
+    const int x0 = MAX(x, 0) & ~1;
+    const int y0 = MAX(yy, 0) & ~1;
+    const int x1 = MIN((x + w + 1) & ~1, video_width);
+    const int y1 = MIN((yy + h + 1) & ~1, video_height);
+    if (x1 <= x0 || y1 <= y0) {
+        return;
+    }
+
+    // A smaller image on the same shared memory as screen_image, which is always big enough.
+    XImage *img = XShmCreateImage(deskdisplay, DefaultVisual(deskdisplay, deskscreen),
+                                  DefaultDepth(deskdisplay, deskscreen), ZPixmap, shminfo.shmaddr, &shminfo, x1 - x0,
+                                  y1 - y0);
+    if (!img) {
+        return;
+    }
+
+    XShmGetImage(deskdisplay, RootWindow(deskdisplay, deskscreen), img, video_x + x0, video_y + y0, AllPlanes);
+    bgrxtoyuv420_rect(y, u, v, video_width, (uint8_t *)img->data, img->bytes_per_line, x0, y0, x1 - x0, y1 - y0);
+
+    XFree(img);
+}
+
+/* Grabs whatever changed since last time. Returns false if nothing did. */
+static bool desktop_grab_damage(uint8_t *y, uint8_t *u, uint8_t *v) {
+    XDamageSubtract(deskdisplay, desktop_damage, None, desktop_dirty);
+    XFixesIntersectRegion(deskdisplay, desktop_dirty, desktop_dirty, desktop_area);
+
+    int        count  = 0;
+    XRectangle bounds = { 0 };
+    XRectangle *rects = XFixesFetchRegionAndBounds(deskdisplay, desktop_dirty, &count, &bounds);
+
+    // Nobody reads the notifications, they only tell us something is waiting in desktop_damage.
+    while (XPending(deskdisplay)) {
+        XEvent event;
+        XNextEvent(deskdisplay, &event);
+    }
+
+    if (count > DESKTOP_MAX_RECTS) {
+        rects[0] = bounds;
+        count    = 1;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        desktop_grab_rect(y, u, v, rects[i].x - video_x, rects[i].y - video_y, rects[i].width, rects[i].height);
+    }
+
+    if (rects) {
+        XFree(rects);
+    }
+
+    return count;
+}
+#endif
+
 bool native_video_init(void *handle) {
     if (isdesktop(handle)) {
-        utox_v4l_fd = -1;
+        utox_v4l_fd   = -1;
+        desktop_frame = NULL;
 
         GRAB_POS grab = grab_pos();
         video_x      = MIN(grab.dn_x, grab.up_x);
@@ -254,6 +361,9 @@ bool native_video_init(void *handle) {
             return false;
         }
 
+#ifdef HAVE_XDAMAGE
+        desktop_damage_start();
+#endif
         return true;
     }
 
@@ -262,6 +372,9 @@ bool native_video_init(void *handle) {
 
 void native_video_close(void *handle) {
     if (isdesktop(handle)) {
+#ifdef HAVE_XDAMAGE
+        desktop_damage_stop();
+#endif
         XShmDetach(deskdisplay, &shminfo);
         return;
     }
@@ -285,24 +398,50 @@ bool native_video_endread(void) {
     return v4l_endread();
 }
 
-int native_video_getframe(uint8_t *y, uint8_t *u, uint8_t *v, uint16_t width, uint16_t height) {
-    if (utox_v4l_fd == -1) {
-        static uint64_t lasttime;
-        uint64_t        t = get_time();
-        if (t - lasttime >= (uint64_t)1000 * 1000 * 1000 / 24) {
-            XShmGetImage(deskdisplay, RootWindow(deskdisplay, deskscreen), screen_image, video_x, video_y, AllPlanes);
-            if (width != video_width || height != video_height) {
-                LOG_ERR("v4l", "width/height mismatch %u %u != %u %u", width, height, screen_image->width,
-                      screen_image->height);
-                return 0;
-            }
+static int desktop_getframe(uint8_t *y, uint8_t *u, uint8_t *v, uint16_t width, uint16_t height) {
+    static uint64_t lasttime;
 
-            bgrxtoyuv420(y, u, v, (uint8_t *)screen_image->data, screen_image->width, screen_image->height);
-            lasttime = t;
-            return 1;
-        }
+    const uint64_t t = get_time();
+    if (t - lasttime < (uint64_t)1000 * 1000 * 1000 / DESKTOP_FPS) {
         return 0;
     }
+    lasttime = t;
+
+    if (width != video_width || height != video_height) {
+        LOG_ERR("v4l", "width/height mismatch %u %u != %u %u", width, height, screen_image->width,
+              screen_image->height);
+        return 0;
+    }
+
+#ifdef HAVE_XDAMAGE
+    // The rest of the frame can only be reused if it's still the one we drew into.
+    if (desktop_damage != None && desktop_frame == y) {
+        if (!desktop_grab_damage(y, u, v) && t - desktop_last_sent < (uint64_t)DESKTOP_HEARTBEAT_MS * 1000 * 1000) {
+            return 0;
+        }
+
+        desktop_last_sent = t;
+        return 1;
+    }
+
+    if (desktop_damage != None) {
+        // We're grabbing everything, forget what changed until now.
+        XDamageSubtract(deskdisplay, desktop_damage, None, None);
+        desktop_last_sent = t;
+    }
+#endif
+
+    XShmGetImage(deskdisplay, RootWindow(deskdisplay, deskscreen), screen_image, video_x, video_y, AllPlanes);
+    bgrxtoyuv420(y, u, v, (uint8_t *)screen_image->data, screen_image->width, screen_image->height);
+
+    desktop_frame = y;
+    return 1;
+}
+
+int native_video_getframe(uint8_t *y, uint8_t *u, uint8_t *v, uint16_t width, uint16_t height) {
+    if (utox_v4l_fd == -1) {
+        return desktop_getframe(y, u, v, width, height);
+    }
 
     return v4l_getframe(y, u, v, width, height);
 }
@@ -0,0 +1,189 @@
+#include "../src/av/audio_mixer.c"
+
+#include "test.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#define RATE 48000
+#define FRAME 960 // 20ms
+
+static void fill(int16_t *pcm, uint32_t samples, int16_t value) {
+    for (uint32_t i = 0; i < samples; ++i) {
+        pcm[i] = value;
+    }
+}
+
+START_TEST(test_prebuffer)
+{
+    AUDIO_MIXER *m = audio_mixer_create(RATE, FRAME, 4);
+    ck_assert(m);
+
+    int16_t pcm[FRAME], out[FRAME];
+    fill(pcm, FRAME, 1000);
+
+    audio_mixer_push(m, 0, pcm, FRAME, 1, RATE);
+    ck_assert_msg(audio_mixer_mix(m, out) == 0, "Expected the stream to wait for its prebuffer");
+
+    audio_mixer_push(m, 0, pcm, FRAME, 1, RATE);
+    ck_assert_msg(audio_mixer_mix(m, out) == 1, "Expected the stream to start once prebuffered");
+    ck_assert_msg(out[0] == 1000 && out[FRAME - 1] == 1000, "Expected unity gain, got %i", out[0]);
+
+    audio_mixer_free(m);
+}
+END_TEST
+
+START_TEST(test_saturation)
+{
+    AUDIO_MIXER *m = audio_mixer_create(RATE, FRAME, 4);
+
+    int16_t loud[FRAME], quiet[FRAME], out[FRAME];
+    fill(loud, FRAME, 30000);
+    fill(quiet, FRAME, -30000);
+
+    for (int i = 0; i < 2; ++i) {
+        audio_mixer_push(m, 0, loud, FRAME, 1, RATE);
+        audio_mixer_push(m, 1, loud, FRAME, 1, RATE);
+        audio_mixer_push(m, 2, quiet, FRAME, 1, RATE);
+        audio_mixer_push(m, 3, quiet, FRAME, 1, RATE);
+    }
+
+    audio_mixer_set_gain(m, 3, 0.0);
+
+    ck_assert(audio_mixer_mix(m, out) == 3);
+    // 30000 + 30000 - 30000, the sum is only clipped once at the end.
+    ck_assert_msg(out[0] == 30000 && out[FRAME - 1] == 30000, "Expected 30000, got %i", out[0]);
+
+    ck_assert(audio_mixer_mix(m, out) == 3);
+    audio_mixer_reset_stream(m, 2);
+    audio_mixer_push(m, 0, loud, FRAME, 1, RATE);
+    audio_mixer_push(m, 0, loud, FRAME, 1, RATE);
+    audio_mixer_push(m, 1, loud, FRAME, 1, RATE);
+    audio_mixer_push(m, 1, loud, FRAME, 1, RATE);
+    ck_assert(audio_mixer_mix(m, out) == 2);
+    ck_assert_msg(out[0] == INT16_MAX && out[FRAME - 1] == INT16_MAX, "Expected saturation, got %i", out[0]);
+
+    audio_mixer_free(m);
+}
+END_TEST
+
+START_TEST(test_gain)
+{
+    AUDIO_MIXER *m = audio_mixer_create(RATE, FRAME, 1);
+
+    int16_t pcm[FRAME], out[FRAME];
+    fill(pcm, FRAME, -1000);
+
+    audio_mixer_set_gain(m, 0, 0.5);
+    audio_mixer_push(m, 0, pcm, FRAME, 1, RATE);
+    audio_mixer_push(m, 0, pcm, FRAME, 1, RATE);
+
+    audio_mixer_mix(m, out);
+    ck_assert_msg(out[0] == -500 && out[FRAME - 1] == -500, "Expected -500, got %i", out[0]);
+
+    audio_mixer_free(m);
+}
+END_TEST
+
+START_TEST(test_silence_and_underrun)
+{
+    AUDIO_MIXER *m = audio_mixer_create(RATE, FRAME, 2);
+
+    int16_t silent[FRAME], out[FRAME];
+    fill(silent, FRAME, 3);
+
+    audio_mixer_push(m, 0, silent, FRAME, 1, RATE);
+    audio_mixer_push(m, 0, silent, FRAME, 1, RATE);
+    ck_assert_msg(audio_mixer_mix(m, out) == 0, "Expected the silent stream to be skipped");
+    ck_assert(audio_mixer_mix(m, out) == 0);
+
+    // Ran dry, the stream has to prebuffer again.
+    ck_assert(audio_mixer_mix(m, out) == 0);
+
+    AUDIO_MIXER_STATS stats;
+    audio_mixer_get_stats(m, &stats);
+    ck_assert_msg(stats.streams_silent == 2, "Expected 2 silent frames, got %u", stats.streams_silent);
+    ck_assert_msg(stats.underruns == 1, "Expected 1 underrun, got %u", stats.underruns);
+
+    int16_t voice[FRAME / 2];
+    fill(voice, FRAME / 2, 2000);
+    for (int i = 0; i < 3; ++i) {
+        audio_mixer_push(m, 0, voice, FRAME / 2, 1, RATE);
+    }
+    ck_assert_msg(audio_mixer_mix(m, out) == 0, "Expected the stream to wait for its prebuffer");
+
+    audio_mixer_push(m, 0, voice, FRAME / 2, 1, RATE);
+    audio_mixer_push(m, 0, voice, FRAME / 2, 1, RATE);
+    ck_assert(audio_mixer_mix(m, out) == 1);
+    ck_assert(audio_mixer_mix(m, out) == 1);
+
+    // Half a frame left, it should be played out and counted as an underrun.
+    ck_assert(audio_mixer_mix(m, out) == 1);
+    ck_assert_msg(out[0] == 2000 && out[FRAME / 2] == 0, "Expected a half frame, got %i and %i", out[0], out[FRAME / 2]);
+
+    audio_mixer_get_stats(m, &stats);
+    ck_assert_msg(stats.underruns == 2, "Expected 2 underruns, got %u", stats.underruns);
+
+    audio_mixer_free(m);
+}
+END_TEST
+
+START_TEST(test_benchmark)
+{
+    enum { STREAMS = 64, FRAMES = 500 };
+
+    AUDIO_MIXER *m = audio_mixer_create(RATE, FRAME, STREAMS);
+
+    int16_t pcm[FRAME], out[FRAME];
+    for (uint32_t i = 0; i < FRAME; ++i) {
+        pcm[i] = (i % 200) * 50 - 5000;
+    }
+
+    uint64_t mix_ns = 0;
+    for (int f = 0; f < FRAMES; ++f) {
+        for (int s = 0; s < STREAMS; ++s) {
+            audio_mixer_push(m, s, pcm, FRAME, 1, RATE);
+        }
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ck_assert(audio_mixer_mix(m, out) == (f ? STREAMS : 0));
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        mix_ns += (end.tv_sec - start.tv_sec) * 1000000000ull + end.tv_nsec - start.tv_nsec;
+    }
+
+    printf("Mixed %u streams of %u Hz audio: %.1f us per 20ms frame\n", STREAMS, RATE,
+           (double)mix_ns / FRAMES / 1000.0);
+
+    audio_mixer_free(m);
+}
+END_TEST
+
+static Suite *suite(void)
+{
+    Suite *s = suite_create("Audio Mixer");
+
+    MK_TEST_CASE(prebuffer);
+    MK_TEST_CASE(saturation);
+    MK_TEST_CASE(gain);
+    MK_TEST_CASE(silence_and_underrun);
+    MK_TEST_CASE(benchmark);
+
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    Suite *run = suite();
+    SRunner *test_runner = srunner_create(run);
+
+    int number_failed = 0;
+    srunner_run_all(test_runner, CK_NORMAL);
+    number_failed = srunner_ntests_failed(test_runner);
+
+    srunner_free(test_runner);
+
+    return number_failed;
+}
@@ -0,0 +1,119 @@
+#include "../src/av/audio_ring.c"
+
+#include "test.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+#define FRAMES 20000
+
+static AUDIO_RING ring;
+
+static void *producer(void *args) {
+    for (uint32_t i = 0; i < FRAMES;) {
+        AUDIO_RING_FRAME *frame = audio_ring_write_begin(&ring);
+        if (!frame) {
+            sched_yield();
+            continue;
+        }
+
+        frame->frame_samples = i;
+        frame->samples[0]    = i & 0x7FFF;
+        frame->samples[AUDIO_RING_MAX_SAMPLES - 1] = ~i & 0x7FFF;
+        audio_ring_write_end(&ring);
+        ++i;
+    }
+
+    return NULL;
+}
+
+START_TEST(test_spsc)
+{
+    audio_ring_init(&ring);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, producer, NULL);
+
+    for (uint32_t i = 0; i < FRAMES; ++i) {
+        AUDIO_RING_FRAME *frame = audio_ring_read_begin(&ring, 1000);
+        ck_assert_msg(frame, "Timed out waiting for frame %u", i);
+        ck_assert_msg(frame->frame_samples == i, "Expected frame %u, got %u", i, frame->frame_samples);
+        ck_assert(frame->samples[0] == (int16_t)(i & 0x7FFF));
+        ck_assert(frame->samples[AUDIO_RING_MAX_SAMPLES - 1] == (int16_t)(~i & 0x7FFF));
+        audio_ring_read_end(&ring);
+    }
+
+    pthread_join(thread, NULL);
+
+    ck_assert(audio_ring_read_begin(&ring, 0) == NULL);
+
+    audio_ring_destroy(&ring);
+}
+END_TEST
+
+START_TEST(test_full)
+{
+    audio_ring_init(&ring);
+
+    for (int i = 0; i < AUDIO_RING_FRAMES; ++i) {
+        ck_assert(audio_ring_write_begin(&ring));
+        audio_ring_write_end(&ring);
+    }
+
+    ck_assert_msg(audio_ring_write_begin(&ring) == NULL, "Expected a full ring");
+    ck_assert(ring.overflows == 1);
+
+    ck_assert(audio_ring_read_begin(&ring, 0));
+    audio_ring_read_end(&ring);
+    ck_assert(audio_ring_write_begin(&ring));
+
+    audio_ring_destroy(&ring);
+}
+END_TEST
+
+START_TEST(test_histogram)
+{
+    AUDIO_HISTOGRAM h = { 0 };
+
+    audio_histogram_add(&h, 0);
+    audio_histogram_add(&h, AUDIO_HISTOGRAM_FIRST_NS - 1);
+    audio_histogram_add(&h, AUDIO_HISTOGRAM_FIRST_NS);
+    audio_histogram_add(&h, 20 * 1000 * 1000); // 20ms, between 16 and 32
+    audio_histogram_add(&h, UINT64_MAX / 2);
+
+    ck_assert(h.buckets[0] == 2);
+    ck_assert(h.buckets[1] == 1);
+    ck_assert_msg(h.buckets[7] == 1, "Expected 20ms in bucket 7");
+    ck_assert(h.buckets[AUDIO_HISTOGRAM_BUCKETS - 1] == 1);
+    ck_assert(h.count == 5 && h.max_ns == UINT64_MAX / 2);
+
+    ck_assert(audio_histogram_bucket_limit(2) == 1000 * 1000);
+    ck_assert(audio_histogram_bucket_limit(AUDIO_HISTOGRAM_BUCKETS - 1) == UINT64_MAX);
+}
+END_TEST
+
+static Suite *suite(void)
+{
+    Suite *s = suite_create("Audio Ring");
+
+    MK_TEST_CASE(spsc);
+    MK_TEST_CASE(full);
+    MK_TEST_CASE(histogram);
+
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    Suite *run = suite();
+    SRunner *test_runner = srunner_create(run);
+
+    int number_failed = 0;
+    srunner_run_all(test_runner, CK_NORMAL);
+    number_failed = srunner_ntests_failed(test_runner);
+
+    srunner_free(test_runner);
+
+    return number_failed;
+}
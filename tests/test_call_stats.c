@@ -0,0 +1,106 @@
+#include "../src/av/call_stats.c"
+
+#include "test.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MS (1000 * 1000ull)
+
+START_TEST(test_sampling)
+{
+    call_stats_start(3, 0);
+    call_stats_video_bitrate(3, 800);
+
+    uint32_t friends[CALL_STATS_MAX_CALLS];
+    ck_assert(call_stats_due(500 * MS, friends, COUNTOF(friends)) == 0);
+
+    // 20 frames in a second, each taking 2ms to convert and 10ms to encode, 15 of them shown 30ms after decoding.
+    for (int i = 0; i < 20; ++i) {
+        call_stats_video_captured(2 * MS);
+        call_stats_video_sent(3, 10 * MS, false);
+        call_stats_video_received(3);
+    }
+    for (int i = 0; i < 15; ++i) {
+        call_stats_video_displayed(3, 30 * MS);
+    }
+    call_stats_video_sent(3, 0, true);
+    call_stats_video_sent(4, 10 * MS, false); // Not in a call
+
+    ck_assert(call_stats_due(1000 * MS, friends, COUNTOF(friends)) == 1 && friends[0] == 3);
+
+    const CALL_STATS_AUDIO audio = { .queued = 4, .underruns = 2, .dropped = 5 };
+    call_stats_sample(3, 1000 * MS, &audio);
+
+    CALL_STATS_SAMPLE s;
+    ck_assert(call_stats_latest(3, &s));
+    ck_assert_msg(s.capture_fps == 20.0f && s.send_fps == 20.0f && s.recv_fps == 20.0f, "Got %f %f %f",
+                  s.capture_fps, s.send_fps, s.recv_fps);
+    ck_assert(s.convert_ms == 2.0f && s.encode_ms == 10.0f && s.latency_ms == 30.0f);
+    ck_assert(s.video_send_errors == 1 && s.video_bitrate == 800);
+    ck_assert(s.audio_queued == 4 && s.audio_underruns == 2 && s.audio_dropped == 5);
+
+    // The next sample only counts what happened since.
+    const CALL_STATS_AUDIO later = { .queued = 3, .underruns = 3, .dropped = 5 };
+    call_stats_sample(3, 2000 * MS, &later);
+    ck_assert(call_stats_latest(3, &s));
+    ck_assert(s.time_ms == 2000 && s.send_fps == 0.0f && s.audio_underruns == 1 && s.audio_dropped == 0);
+
+    // The history outlives the call.
+    call_stats_stop(3);
+    ck_assert(call_stats_due(5000 * MS, friends, COUNTOF(friends)) == 0);
+    ck_assert(call_stats_latest(3, &s));
+    ck_assert(!call_stats_latest(4, &s));
+}
+END_TEST
+
+START_TEST(test_csv)
+{
+    call_stats_start(7, 0);
+    for (uint32_t i = 1; i <= CALL_STATS_HISTORY + 10; ++i) {
+        call_stats_sample(7, i * 1000 * MS, NULL);
+    }
+
+    char  *buf  = NULL;
+    size_t size = 0;
+    FILE  *fp   = open_memstream(&buf, &size);
+    ck_assert(call_stats_write_csv(7, fp));
+    fclose(fp);
+
+    // A header, then the newest CALL_STATS_HISTORY samples, oldest first.
+    uint32_t lines = 0;
+    for (size_t i = 0; i < size; ++i) {
+        lines += buf[i] == '\n';
+    }
+    ck_assert_msg(lines == CALL_STATS_HISTORY + 1, "Got %u lines", lines);
+    ck_assert(!strncmp(buf, "time_ms,", 8));
+    ck_assert(!strncmp(strchr(buf, '\n') + 1, "11000,", 6));
+
+    free(buf);
+}
+END_TEST
+
+static Suite *suite(void)
+{
+    Suite *s = suite_create("Call stats");
+
+    MK_TEST_CASE(sampling);
+    MK_TEST_CASE(csv);
+
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    Suite *run = suite();
+    SRunner *test_runner = srunner_create(run);
+
+    int number_failed = 0;
+    srunner_run_all(test_runner, CK_NORMAL);
+    number_failed = srunner_ntests_failed(test_runner);
+
+    srunner_free(test_runner);
+
+    return number_failed;
+}
@@ -0,0 +1,106 @@
+#include "../src/ui/damage.c"
+
+#include "test.h"
+
+#include <stdint.h>
+
+#define MS (1000 * 1000ull)
+
+START_TEST(test_coalescing)
+{
+    DAMAGE_RECT rects[DAMAGE_MAX_RECTS];
+
+    // Nothing is known about the window before it's drawn the first time.
+    damage_add(10, 10, 5, 5);
+    ck_assert(damage_take(rects, 800, 600) == 1);
+    ck_assert(rects[0].x == 0 && rects[0].y == 0 && rects[0].width == 800 && rects[0].height == 600);
+    ck_assert(damage_take(rects, 800, 600) == 0);
+
+    // Rectangles that are cheaper to draw as one become one, far apart ones stay apart.
+    damage_add(10, 10, 20, 20);
+    damage_add(20, 10, 20, 20);
+    damage_add(40, 10, 10, 20);
+    damage_add(500, 500, 10, 10);
+    damage_add(0, 0, 0, 10);
+    ck_assert(damage_take(rects, 800, 600) == 2);
+    ck_assert(rects[0].x == 10 && rects[0].y == 10 && rects[0].width == 40 && rects[0].height == 20);
+    ck_assert(rects[1].x == 500 && rects[1].y == 500 && rects[1].width == 10 && rects[1].height == 10);
+
+    // Everything is cut to the window.
+    damage_add(-10, 590, 20, 20);
+    damage_add(900, 0, 10, 10);
+    ck_assert(damage_take(rects, 800, 600) == 1);
+    ck_assert(rects[0].x == 0 && rects[0].y == 590 && rects[0].width == 10 && rects[0].height == 10);
+
+    // When full, the new one goes where it grows a rectangle the least.
+    for (int i = 0; i < DAMAGE_MAX_RECTS; ++i) {
+        damage_add(i * 100, 0, 10, 10);
+    }
+    damage_add(705, 20, 10, 10);
+    ck_assert(damage_take(rects, 800, 600) == DAMAGE_MAX_RECTS);
+    ck_assert(rects[DAMAGE_MAX_RECTS - 1].x == 700 && rects[DAMAGE_MAX_RECTS - 1].width == 15);
+    ck_assert(rects[DAMAGE_MAX_RECTS - 1].height == 30);
+
+    // A whole window redraw swallows everything else.
+    damage_add(10, 10, 20, 20);
+    damage_all();
+    damage_add(10, 10, 20, 20);
+    ck_assert(damage_take(rects, 640, 480) == 1);
+    ck_assert(rects[0].width == 640 && rects[0].height == 480);
+}
+END_TEST
+
+START_TEST(test_intersects)
+{
+    const DAMAGE_RECT r = { 10, 10, 20, 20 };
+
+    ck_assert(damage_intersects(&r, 0, 0, 11, 11));
+    ck_assert(damage_intersects(&r, 29, 29, 100, 100));
+    ck_assert(damage_intersects(&r, 0, 0, 100, 100));
+    ck_assert(!damage_intersects(&r, 0, 0, 10, 100));
+    ck_assert(!damage_intersects(&r, 30, 0, 10, 100));
+    ck_assert(!damage_intersects(&r, 0, 30, 100, 10));
+}
+END_TEST
+
+START_TEST(test_frame_counter)
+{
+    DAMAGE_STATS stats;
+
+    ck_assert(!damage_count_frame(1000 * MS, 2 * MS, 100, &stats));
+    ck_assert(!damage_count_frame(5000 * MS, 4 * MS, 300, &stats));
+    ck_assert(damage_count_frame((1000 + DAMAGE_REPORT_INTERVAL_MS) * MS, 3 * MS, 200, &stats));
+
+    ck_assert(stats.frames == 3);
+    ck_assert(stats.draw_ns == 9 * MS);
+    ck_assert(stats.max_draw_ns == 4 * MS);
+    ck_assert(stats.pixels == 600);
+
+    ck_assert(!damage_count_frame((2000 + DAMAGE_REPORT_INTERVAL_MS) * MS, 1 * MS, 50, &stats));
+}
+END_TEST
+
+static Suite *suite(void)
+{
+    Suite *s = suite_create("Damage");
+
+    MK_TEST_CASE(coalescing);
+    MK_TEST_CASE(intersects);
+    MK_TEST_CASE(frame_counter);
+
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    Suite *run = suite();
+    SRunner *test_runner = srunner_create(run);
+
+    int number_failed = 0;
+    srunner_run_all(test_runner, CK_NORMAL);
+    number_failed = srunner_ntests_failed(test_runner);
+
+    srunner_free(test_runner);
+
+    return number_failed;
+}
@@ -0,0 +1,178 @@
+#include "../src/ft_scheduler.c"
+
+#include "test.h"
+
+#include <stdint.h>
+
+#define CHUNK 1371
+
+static uint32_t sent[4];
+static uint32_t order[64];
+static uint32_t order_count;
+static bool     sendq_full;
+static uint64_t last_position;
+static bool     out_of_order;
+
+static FT_SCHED_SEND_RESULT mock_send(void *userdata, uint32_t friend_number, uint32_t file_number,
+                                      uint64_t position, size_t length)
+{
+    if (sendq_full) {
+        return FT_SCHED_SEND_RETRY;
+    }
+
+    sent[friend_number]++;
+    out_of_order |= friend_number == 3 && position < last_position;
+    if (friend_number == 3) {
+        last_position = position;
+    }
+    if (order_count < 64) {
+        order[order_count++] = file_number;
+    }
+    return FT_SCHED_SEND_OK;
+}
+
+static void reset(void) {
+    ft_sched_raze();
+    ft_sched_set_limits(0, 0);
+    memset(sent, 0, sizeof(sent));
+    order_count   = 0;
+    sendq_full    = false;
+    last_position = 0;
+    out_of_order  = false;
+}
+
+START_TEST(test_priority)
+{
+    reset();
+
+    ft_sched_add(0, 1, FT_SCHED_PRIORITY_BULK);
+    ft_sched_add(0, 2, FT_SCHED_PRIORITY_HIGH);
+
+    ft_sched_enqueue(0, 1, 0, CHUNK);
+    ft_sched_enqueue(0, 1, CHUNK, CHUNK);
+    ft_sched_enqueue(0, 2, 0, CHUNK);
+
+    ft_sched_run(1, mock_send, NULL);
+
+    ck_assert_msg(order_count == 3, "Expected 3 chunks sent got: %u", order_count);
+    ck_assert_msg(order[0] == 2, "Expected the avatar to go first, got file %u", order[0]);
+}
+END_TEST
+
+START_TEST(test_fairness)
+{
+    reset();
+
+    ft_sched_add(1, 0, FT_SCHED_PRIORITY_BULK);
+    ft_sched_add(2, 0, FT_SCHED_PRIORITY_BULK);
+
+    for (int i = 0; i < 10; ++i) {
+        ft_sched_enqueue(1, 0, i * CHUNK, CHUNK);
+        ft_sched_enqueue(2, 0, i * CHUNK, CHUNK);
+    }
+
+    // Global limit lets 4 chunks through on the first run after the bucket fills up.
+    ft_sched_set_limits(CHUNK * 4 * 4, 0);
+    ft_sched_run(1, mock_send, NULL);
+    ft_sched_run(1 + 1000 * 1000 * 1000, mock_send, NULL);
+
+    ck_assert_msg(sent[1] == sent[2], "Expected friends to share evenly, got %u and %u", sent[1], sent[2]);
+    ck_assert_msg(sent[1] + sent[2] == 4, "Expected 4 chunks through the global bucket, got %u", sent[1] + sent[2]);
+}
+END_TEST
+
+START_TEST(test_friend_limit)
+{
+    reset();
+
+    ft_sched_add(1, 0, FT_SCHED_PRIORITY_BULK);
+    ft_sched_add(2, 0, FT_SCHED_PRIORITY_BULK);
+
+    for (int i = 0; i < 10; ++i) {
+        ft_sched_enqueue(1, 0, i * CHUNK, CHUNK);
+        ft_sched_enqueue(2, 0, i * CHUNK, CHUNK);
+    }
+
+    ft_sched_set_limits(0, CHUNK * 4);
+    ft_sched_run(1, mock_send, NULL);
+    ck_assert_msg(sent[1] == 0 && sent[2] == 0, "Expected empty buckets on the first run");
+
+    ft_sched_run(1 + 1000 * 1000 * 1000, mock_send, NULL);
+    ck_assert_msg(sent[1] == 1 && sent[2] == 1, "Expected one chunk per friend, got %u and %u", sent[1], sent[2]);
+
+    SCHED_TRANSFER *t = find_transfer(1, 0);
+    ck_assert(t);
+    ck_assert_msg(t->stats.bytes_sent == CHUNK, "Expected %u bytes sent, got %" PRIu64, CHUNK, t->stats.bytes_sent);
+    ck_assert_msg(t->stats.chunks_throttled > 0, "Expected the transfer to be throttled");
+}
+END_TEST
+
+START_TEST(test_sendq_full)
+{
+    reset();
+
+    ft_sched_add(1, 0, FT_SCHED_PRIORITY_BULK);
+    ft_sched_enqueue(1, 0, 0, CHUNK);
+
+    sendq_full = true;
+    ft_sched_run(1, mock_send, NULL);
+    ck_assert_msg(sent[1] == 0, "Expected nothing sent while the send queue is full");
+
+    sendq_full = false;
+    ft_sched_run(2, mock_send, NULL);
+    ck_assert_msg(sent[1] == 1, "Expected the chunk to be retried, got %u", sent[1]);
+
+    ft_sched_remove(1, 0);
+    ck_assert_msg(!ft_sched_enqueue(1, 0, CHUNK, CHUNK), "Expected enqueue to fail for a removed transfer");
+}
+END_TEST
+
+START_TEST(test_queue_grows)
+{
+    reset();
+
+    // More chunks than the queue starts out with, requested while the wrap around is mid ring.
+    ft_sched_add(3, 0, FT_SCHED_PRIORITY_BULK);
+    for (uint32_t i = 0; i < 10; ++i) {
+        ck_assert(ft_sched_enqueue(3, 0, i * CHUNK, CHUNK));
+    }
+    ft_sched_run(1, mock_send, NULL);
+
+    sendq_full = true;
+    for (uint32_t i = 10; i < 10 + FT_SCHED_QUEUE_SIZE * 3; ++i) {
+        ck_assert(ft_sched_enqueue(3, 0, i * CHUNK, CHUNK));
+    }
+    sendq_full = false;
+    ft_sched_run(2, mock_send, NULL);
+
+    ck_assert_msg(sent[3] == 10 + FT_SCHED_QUEUE_SIZE * 3, "Expected every chunk sent, got %u", sent[3]);
+    ck_assert_msg(!out_of_order, "Expected the chunks to go out in the order they were requested");
+}
+END_TEST
+
+static Suite *suite(void)
+{
+    Suite *s = suite_create("FT Scheduler");
+
+    MK_TEST_CASE(priority);
+    MK_TEST_CASE(fairness);
+    MK_TEST_CASE(friend_limit);
+    MK_TEST_CASE(sendq_full);
+    MK_TEST_CASE(queue_grows);
+
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    Suite *run = suite();
+    SRunner *test_runner = srunner_create(run);
+
+    int number_failed = 0;
+    srunner_run_all(test_runner, CK_NORMAL);
+    number_failed = srunner_ntests_failed(test_runner);
+
+    srunner_free(test_runner);
+
+    return number_failed;
+}
@@ -0,0 +1,174 @@
+#include "../src/hash_index.c"
+
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define FRIENDS 10000
+#define LOOKUPS 100000
+
+// Just what the friend lookups look at.
+static struct {
+    char id_str[64];
+    char name[16];
+} friends[FRIENDS];
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void make_friends(HASH_INDEX *by_id, HASH_INDEX *by_name) {
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    for (uint32_t i = 0; i < FRIENDS; ++i) {
+        for (int j = 0; j < 64; ++j) {
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            friends[i].id_str[j] = "0123456789ABCDEF"[x & 0xF];
+        }
+        snprintf(friends[i].name, sizeof(friends[i].name), "Friend %u", i);
+
+        hash_index_add(by_id, hash_index_bytes(friends[i].id_str, 64), i);
+        hash_index_add(by_name, hash_index_case(friends[i].name, strlen(friends[i].name)), i);
+    }
+}
+
+static uint32_t find(const HASH_INDEX *index, uint64_t hash, const char *key, size_t length, bool by_name) {
+    uint32_t pos = 0, i;
+    while ((i = hash_index_next(index, hash, &pos)) != HASH_INDEX_NONE) {
+        if (!memcmp(by_name ? friends[i].name : friends[i].id_str, key, length)) {
+            return i;
+        }
+    }
+
+    return HASH_INDEX_NONE;
+}
+
+START_TEST(test_add_remove)
+{
+    HASH_INDEX index = { 0 };
+
+    // Values under the same hash, and hashes that land on the same slots, are all found until removed.
+    for (uint32_t i = 0; i < 100; ++i) {
+        hash_index_add(&index, i % 10, i);
+        hash_index_add(&index, (i % 10) | 1ull << 40, 1000 + i);
+    }
+    ck_assert(index.count == 200);
+    ck_assert(index.size >= 400);
+
+    for (uint32_t i = 0; i < 100; i += 2) {
+        hash_index_remove(&index, i % 10, i);
+        hash_index_remove(&index, (i % 10) | 1ull << 40, 1000 + i);
+    }
+    hash_index_remove(&index, 3, 4);
+    ck_assert(index.count == 100);
+
+    for (uint64_t hash = 0; hash < 10; ++hash) {
+        uint32_t pos = 0, value, found = 0;
+        while ((value = hash_index_next(&index, hash, &pos)) != HASH_INDEX_NONE) {
+            ck_assert(value < 100 && value % 10 == hash && value % 2);
+            found++;
+        }
+        ck_assert(found == (hash % 2 ? 10 : 0));
+
+        pos = found = 0;
+        while ((value = hash_index_next(&index, hash | 1ull << 40, &pos)) != HASH_INDEX_NONE) {
+            ck_assert(value >= 1000 && value % 10 == hash && value % 2);
+            found++;
+        }
+        ck_assert(found == (hash % 2 ? 10 : 0));
+    }
+
+    hash_index_clear(&index);
+    uint32_t pos = 0;
+    ck_assert(hash_index_next(&index, 7, &pos) == HASH_INDEX_NONE);
+    hash_index_remove(&index, 7, 7);
+    ck_assert(hash_index_case("Tox User", 8) == hash_index_case("tOX uSER", 8));
+    ck_assert(hash_index_case("Tox User", 8) != hash_index_case("Tox Usel", 8));
+}
+END_TEST
+
+START_TEST(test_benchmark)
+{
+    HASH_INDEX by_id = { 0 }, by_name = { 0 };
+    make_friends(&by_id, &by_name);
+
+    // How get_friend_by_id() and find_friend_by_name() used to look, from one end of the list to the other.
+    uint64_t start = now_ns();
+    uint32_t found = 0;
+    for (uint32_t n = 0; n < LOOKUPS / 100; ++n) {
+        const uint32_t want = n * 7919 % FRIENDS;
+        for (uint32_t i = 0; i < FRIENDS; ++i) {
+            if (!strncmp(friends[i].id_str, friends[want].id_str, 64)) {
+                found += i == want;
+                break;
+            }
+        }
+    }
+    const uint64_t scan = (now_ns() - start) * 100;
+    ck_assert(found == LOOKUPS / 100);
+
+    start = now_ns();
+    found = 0;
+    for (uint32_t n = 0; n < LOOKUPS; ++n) {
+        const uint32_t want = n * 7919 % FRIENDS;
+        found += find(&by_id, hash_index_bytes(friends[want].id_str, 64), friends[want].id_str, 64, false) == want;
+    }
+    const uint64_t indexed = now_ns() - start;
+    ck_assert(found == LOOKUPS);
+
+    start = now_ns();
+    found = 0;
+    for (uint32_t n = 0; n < LOOKUPS; ++n) {
+        const char *name = friends[n * 7919 % FRIENDS].name;
+        const size_t length = strlen(name);
+        found += find(&by_name, hash_index_case(name, length), name, length + 1, true) == n * 7919 % FRIENDS;
+    }
+    const uint64_t named = now_ns() - start;
+    ck_assert(found == LOOKUPS);
+
+    // Taking friends out and putting them back, like when they're deleted and added.
+    start = now_ns();
+    for (uint32_t i = 0; i < FRIENDS; ++i) {
+        hash_index_remove(&by_id, hash_index_bytes(friends[i].id_str, 64), i);
+        hash_index_add(&by_id, hash_index_bytes(friends[i].id_str, 64), i);
+    }
+    const uint64_t churn = now_ns() - start;
+    ck_assert(by_id.count == FRIENDS);
+
+    printf("%u friends, %u lookups by id: %.1f ms scanning, %.2f ms indexed; by name %.2f ms\n", FRIENDS, LOOKUPS,
+           scan / 1000000.0, indexed / 1000000.0, named / 1000000.0);
+    printf("Removing and adding every friend again: %.2f ms\n", churn / 1000000.0);
+
+    hash_index_clear(&by_id);
+    hash_index_clear(&by_name);
+}
+END_TEST
+
+static Suite *suite(void)
+{
+    Suite *s = suite_create("Hash Index");
+
+    MK_TEST_CASE(add_remove);
+    MK_TEST_CASE(benchmark);
+
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    Suite *run = suite();
+    SRunner *test_runner = srunner_create(run);
+
+    int number_failed = 0;
+    srunner_run_all(test_runner, CK_NORMAL);
+    number_failed = srunner_ntests_failed(test_runner);
+
+    srunner_free(test_runner);
+
+    return number_failed;
+}
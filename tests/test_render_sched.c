@@ -0,0 +1,81 @@
+#include "../src/ui/render_sched.c"
+
+#include "test.h"
+
+#include <stdint.h>
+
+#define MS (1000 * 1000ull)
+
+START_TEST(test_capped)
+{
+    RENDER_SCHED s = { 0 };
+    render_sched_set_fps(&s, 50);
+
+    ck_assert(render_sched_due_in(&s, 1000 * MS) == UINT64_MAX);
+
+    // The first frame goes right away, everything asked for after it waits for the next one.
+    render_sched_request(&s);
+    ck_assert(render_sched_due_in(&s, 1000 * MS) == 0);
+    render_sched_rendered(&s, 1000 * MS);
+    ck_assert(render_sched_due_in(&s, 1001 * MS) == UINT64_MAX);
+
+    render_sched_request(&s);
+    render_sched_request(&s);
+    render_sched_request(&s);
+    ck_assert(render_sched_due_in(&s, 1005 * MS) == 15 * MS);
+    ck_assert(render_sched_due_in(&s, 1020 * MS) == 0);
+    ck_assert(render_sched_due_in(&s, 1100 * MS) == 0);
+    render_sched_rendered(&s, 1100 * MS);
+
+    ck_assert(render_sched_take_requested(&s) == 4);
+    ck_assert(render_sched_take_requested(&s) == 0);
+}
+END_TEST
+
+START_TEST(test_hurry)
+{
+    RENDER_SCHED s = { 0 };
+    render_sched_set_fps(&s, 0);
+    ck_assert(s.interval == 1000 * MS / RENDER_SCHED_DEFAULT_FPS);
+
+    render_sched_request(&s);
+    render_sched_rendered(&s, 1000 * MS);
+
+    // Nothing to hurry.
+    render_sched_hurry(&s);
+    ck_assert(render_sched_due_in(&s, 1001 * MS) == UINT64_MAX);
+
+    render_sched_request(&s);
+    ck_assert(render_sched_due_in(&s, 1001 * MS) != 0);
+    render_sched_hurry(&s);
+    ck_assert(render_sched_due_in(&s, 1001 * MS) == 0);
+
+    render_sched_rendered(&s, 1001 * MS);
+    render_sched_request(&s);
+    ck_assert(render_sched_due_in(&s, 1002 * MS) != 0);
+}
+END_TEST
+
+static Suite *suite(void)
+{
+    Suite *s = suite_create("Render scheduler");
+
+    MK_TEST_CASE(capped);
+    MK_TEST_CASE(hurry);
+
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    Suite *run = suite();
+    SRunner *test_runner = srunner_create(run);
+
+    int number_failed = 0;
+    srunner_run_all(test_runner, CK_NORMAL);
+    number_failed = srunner_ntests_failed(test_runner);
+
+    srunner_free(test_runner);
+
+    return number_failed;
+}
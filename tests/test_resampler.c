@@ -0,0 +1,156 @@
+#include "../src/av/resampler.c"
+
+#include "test.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#define OUT_RATE 48000
+
+/* Feeds one second of a sine wave through in 10ms chunks, returns the number of samples written to out. */
+static uint32_t resample_sine(RESAMPLER *r, uint32_t in_rate, double freq, double amplitude, int16_t *out,
+                              uint32_t out_size) {
+    const uint32_t chunk = in_rate / 100;
+    int16_t in[chunk];
+    uint32_t written = 0;
+
+    for (uint32_t n = 0; n < in_rate; n += chunk) {
+        for (uint32_t i = 0; i < chunk; ++i) {
+            in[i] = amplitude * sin(2 * M_PI * freq * (n + i) / in_rate);
+        }
+
+        ck_assert(resampler_max_output(r, chunk) <= out_size - written);
+        written += resampler_process(r, in, chunk, out + written, out_size - written);
+    }
+
+    return written;
+}
+
+static void check_sine(uint32_t in_rate) {
+    RESAMPLER *r = resampler_create(in_rate, OUT_RATE);
+    ck_assert(r);
+
+    static int16_t out[OUT_RATE * 2];
+    const uint32_t written = resample_sine(r, in_rate, 1000, 10000, out, COUNTOF(out));
+
+    // Everything but the filter delay has to come out.
+    const uint32_t delay = RESAMPLER_TAPS / 2 * OUT_RATE / in_rate + 1;
+    ck_assert_msg(written >= OUT_RATE - delay && written <= OUT_RATE, "Expected ~%u samples, got %u", OUT_RATE, written);
+
+    // Skip the start while the filter fills up.
+    double power = 0;
+    uint32_t crossings = 0;
+    for (uint32_t i = OUT_RATE / 10; i < written; ++i) {
+        power += (double)out[i] * out[i];
+        crossings += (out[i - 1] < 0) != (out[i] < 0);
+    }
+
+    const uint32_t measured = written - OUT_RATE / 10;
+    const double rms = sqrt(power / measured);
+    ck_assert_msg(fabs(rms - 10000 / M_SQRT2) < 10000 / M_SQRT2 * 0.01, "%u Hz: expected RMS %.0f, got %.0f", in_rate,
+                  10000 / M_SQRT2, rms);
+
+    const double freq = crossings / 2.0 * OUT_RATE / measured;
+    ck_assert_msg(fabs(freq - 1000) < 5, "%u Hz: expected 1000 Hz, measured %.1f Hz", in_rate, freq);
+
+    resampler_free(r);
+}
+
+START_TEST(test_44100)
+{
+    check_sine(44100);
+}
+END_TEST
+
+START_TEST(test_16000)
+{
+    check_sine(16000);
+}
+END_TEST
+
+START_TEST(test_dc)
+{
+    RESAMPLER *r = resampler_create(32000, OUT_RATE);
+
+    int16_t in[320], out[1024];
+    for (int i = 0; i < 320; ++i) {
+        in[i] = -5000;
+    }
+
+    uint32_t written = 0;
+    for (int i = 0; i < 3; ++i) {
+        written = resampler_process(r, in, 320, out, COUNTOF(out));
+    }
+
+    // Every phase has unity gain, so a constant has to stay exactly constant.
+    for (uint32_t i = 0; i < written; ++i) {
+        ck_assert_msg(out[i] == -5000, "Expected -5000 at %u, got %i", i, out[i]);
+    }
+
+    resampler_free(r);
+}
+END_TEST
+
+START_TEST(test_limits)
+{
+    ck_assert(resampler_create(0, OUT_RATE) == NULL);
+    ck_assert(resampler_create(44100, 0) == NULL);
+    ck_assert_msg(resampler_create(44101, OUT_RATE) == NULL, "Expected a ratio that needs 48000 phases to be refused");
+
+    RESAMPLER *r = resampler_create(16000, OUT_RATE);
+    int16_t in[160] = { 0 }, out[4];
+    ck_assert(resampler_process(r, in, 160, out, COUNTOF(out)) == COUNTOF(out));
+    resampler_free(r);
+}
+END_TEST
+
+START_TEST(test_benchmark)
+{
+    enum { SECONDS = 10 };
+
+    RESAMPLER *r = resampler_create(44100, OUT_RATE);
+    static int16_t out[OUT_RATE * 2];
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < SECONDS; ++i) {
+        resample_sine(r, 44100, 440, 8000, out, COUNTOF(out));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    const double ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+    printf("Resampled %u seconds of 44100 Hz audio to %u Hz in %.1f ms (including sine generation)\n", SECONDS,
+           OUT_RATE, ms);
+
+    resampler_free(r);
+}
+END_TEST
+
+static Suite *suite(void)
+{
+    Suite *s = suite_create("Resampler");
+
+    MK_TEST_CASE(44100);
+    MK_TEST_CASE(16000);
+    MK_TEST_CASE(dc);
+    MK_TEST_CASE(limits);
+    MK_TEST_CASE(benchmark);
+
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    Suite *run = suite();
+    SRunner *test_runner = srunner_create(run);
+
+    int number_failed = 0;
+    srunner_run_all(test_runner, CK_NORMAL);
+    number_failed = srunner_ntests_failed(test_runner);
+
+    srunner_free(test_runner);
+
+    return number_failed;
+}
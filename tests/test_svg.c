@@ -0,0 +1,145 @@
+#include "../src/ui/svg.c"
+
+#include "test.h"
+
+#include <stdio.h>
+#include <time.h>
+
+static int      loads;
+static uint8_t *loaded_data[BM_ENDMARKER];
+static int      loaded_width[BM_ENDMARKER], loaded_height[BM_ENDMARKER];
+
+void loadalpha(int bm, void *data, int width, int height) {
+    loads++;
+    loaded_data[bm]   = data;
+    loaded_width[bm]  = width;
+    loaded_height[bm] = height;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+START_TEST(test_lazy)
+{
+    ui_scale = 10;
+    ck_assert(svg_draw());
+
+    loads = 0;
+    svg_load(BM_ADD);
+    svg_load(BM_ADD);
+    ck_assert(loads == 1);
+    ck_assert(loaded_width[BM_ADD] == BM_ADD_WIDTH);
+    ck_assert(loaded_height[BM_ADD] == BM_ADD_WIDTH);
+    ck_assert(!svg_current->bitmaps[BM_CONTACT].drawn);
+
+    // The cross goes through the middle, the corners stay empty.
+    const uint8_t *add = loaded_data[BM_ADD];
+    ck_assert(add[BM_ADD_WIDTH / 2 * BM_ADD_WIDTH + BM_ADD_WIDTH / 2] == 0xFF);
+    ck_assert(add[0] == 0);
+
+    // The scroll bar ends are the two halves of a circle.
+    svg_load(BM_SCROLLHALFTOP);
+    svg_load(BM_SCROLLHALFBOT);
+    const uint8_t *top = loaded_data[BM_SCROLLHALFTOP], *bottom = loaded_data[BM_SCROLLHALFBOT];
+    for (int y = 0; y < SCROLL_WIDTH / 2; ++y) {
+        ck_assert(!memcmp(&top[y * SCROLL_WIDTH], &bottom[(SCROLL_WIDTH / 2 - 1 - y) * SCROLL_WIDTH], SCROLL_WIDTH));
+    }
+
+    // Out of range, and not drawn by us.
+    loads = 0;
+    svg_load(0);
+    svg_load(BM_ENDMARKER);
+    svg_load(BM_SETTINGS_THREE_BAR);
+    ck_assert(loads == 0);
+}
+END_TEST
+
+START_TEST(test_scale_cache)
+{
+    ui_scale = 10;
+    ck_assert(svg_draw());
+    svg_load(BM_CONTACT);
+    uint8_t *contact = loaded_data[BM_CONTACT];
+
+    ui_scale = 20;
+    ck_assert(svg_draw());
+    svg_load(BM_CONTACT);
+    ck_assert(loaded_data[BM_CONTACT] != contact);
+    ck_assert(loaded_width[BM_CONTACT] == SCALE(40));
+
+    // Coming back hands over what was drawn before, without drawing it again.
+    ui_scale = 10;
+    ck_assert(svg_draw());
+    ck_assert(svg_current->bitmaps[BM_CONTACT].drawn);
+    loads = 0;
+    svg_load(BM_CONTACT);
+    ck_assert(loads == 1);
+    ck_assert(loaded_data[BM_CONTACT] == contact);
+
+    // Only the most recently used scales are kept.
+    for (int scale = 11; scale < 11 + SVG_SETS; ++scale) {
+        ui_scale = scale;
+        ck_assert(svg_draw());
+    }
+    ui_scale = 10;
+    ck_assert(svg_draw());
+    ck_assert(!svg_current->bitmaps[BM_CONTACT].drawn);
+}
+END_TEST
+
+START_TEST(test_benchmark)
+{
+    uint64_t total_cold = 0, total_warm = 0;
+    for (int scale = 5; scale <= 25; ++scale) {
+        ui_scale = scale;
+
+        uint64_t start = now_ns();
+        ck_assert(svg_draw());
+        for (int bm = 1; bm < BM_ENDMARKER; ++bm) {
+            svg_load(bm);
+        }
+        const uint64_t cold = now_ns() - start;
+
+        start = now_ns();
+        ck_assert(svg_draw());
+        for (int bm = 1; bm < BM_ENDMARKER; ++bm) {
+            svg_load(bm);
+        }
+        const uint64_t warm = now_ns() - start;
+
+        printf("Icons at scale %2d: %7.1f us rasterized, %5.1f us cached\n", scale, cold / 1000.0, warm / 1000.0);
+        total_cold += cold;
+        total_warm += warm;
+    }
+
+    printf("All scales: %.1f ms rasterized, %.1f ms cached\n", total_cold / 1000000.0, total_warm / 1000000.0);
+}
+END_TEST
+
+static Suite *suite(void)
+{
+    Suite *s = suite_create("SVG");
+
+    MK_TEST_CASE(lazy);
+    MK_TEST_CASE(scale_cache);
+    MK_TEST_CASE(benchmark);
+
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    Suite *run = suite();
+    SRunner *test_runner = srunner_create(run);
+
+    int number_failed = 0;
+    srunner_run_all(test_runner, CK_NORMAL);
+    number_failed = srunner_ntests_failed(test_runner);
+
+    srunner_free(test_runner);
+
+    return number_failed;
+}
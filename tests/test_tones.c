@@ -0,0 +1,147 @@
+#include "../src/av/tones.c"
+
+#include "test.h"
+
+#include <stdint.h>
+
+static size_t make_wav(uint8_t *wav, uint16_t format, uint16_t channels, uint32_t rate, uint16_t bits,
+                       const int16_t *samples, uint32_t count, uint32_t data_length) {
+    uint8_t *p = wav;
+
+    #define PUT16(v) do { *p++ = (v) & 0xFF; *p++ = ((v) >> 8) & 0xFF; } while (0)
+    #define PUT32(v) do { PUT16((v) & 0xFFFF); PUT16(((uint32_t)(v) >> 16) & 0xFFFF); } while (0)
+
+    memcpy(p, "RIFF", 4); p += 4;
+    PUT32(4 + 8 + 16 + 8 + 6 + 8 + count * 2);
+    memcpy(p, "WAVE", 4); p += 4;
+
+    memcpy(p, "fmt ", 4); p += 4;
+    PUT32(16);
+    PUT16(format);
+    PUT16(channels);
+    PUT32(rate);
+    PUT32(rate * channels * bits / 8);
+    PUT16(channels * bits / 8);
+    PUT16(bits);
+
+    // An odd sized chunk we don't know about, it has to be skipped along with its pad byte.
+    memcpy(p, "LIST", 4); p += 4;
+    PUT32(5);
+    memcpy(p, "INFO", 4); p += 4;
+    *p++ = 0;
+    *p++ = 0;
+
+    memcpy(p, "data", 4); p += 4;
+    PUT32(data_length);
+    for (uint32_t i = 0; i < count; ++i) {
+        PUT16((uint16_t)samples[i]);
+    }
+
+    #undef PUT16
+    #undef PUT32
+
+    return p - wav;
+}
+
+START_TEST(test_builtin)
+{
+    tones_load();
+
+    for (TONE i = 0; i < TONE_MAX; ++i) {
+        const TONE_PCM *pcm = tone_get(i);
+        ck_assert_msg(pcm, "Expected tone %u to be built", i);
+        ck_assert(pcm->channels == 1 && pcm->sample_rate == 22000);
+        ck_assert(pcm->frames == builtin_tones[i].seconds * pcm->sample_rate);
+    }
+
+    // Loading again has to reuse what's already there.
+    const int16_t *ringtone = tone_get(TONE_RINGTONE)->samples;
+    tones_load();
+    ck_assert(tone_get(TONE_RINGTONE)->samples == ringtone);
+
+    // The first 3/8 of a second of the new message tone is silence.
+    const TONE_PCM *msg = tone_get(TONE_FRIEND_NEW_MSG);
+    for (uint32_t i = 0; i < msg->sample_rate * 3 / 8; ++i) {
+        ck_assert_msg(msg->samples[i] == 0, "Expected silence at %u, got %i", i, msg->samples[i]);
+    }
+
+    tones_free();
+    ck_assert(tone_get(TONE_RINGTONE) == NULL);
+}
+END_TEST
+
+START_TEST(test_wav)
+{
+    const int16_t samples[] = { 0, 1000, -1000, INT16_MAX, INT16_MIN, 42 };
+    uint8_t wav[128];
+    TONE_PCM pcm;
+
+    size_t size = make_wav(wav, 1, 2, 44100, 16, samples, 6, sizeof(samples));
+    ck_assert(tone_decode_wav(wav, size, &pcm));
+    ck_assert(pcm.channels == 2 && pcm.sample_rate == 44100 && pcm.frames == 3);
+    ck_assert(!memcmp(pcm.samples, samples, sizeof(samples)));
+    free(pcm.samples);
+
+    // Streamed files can claim more data than there is.
+    size = make_wav(wav, 1, 1, 8000, 16, samples, 6, UINT32_MAX);
+    ck_assert(tone_decode_wav(wav, size, &pcm));
+    ck_assert_msg(pcm.frames == 6, "Expected 6 frames, got %u", pcm.frames);
+    free(pcm.samples);
+
+    size = make_wav(wav, 1, 1, 8000, 8, samples, 6, sizeof(samples));
+    ck_assert_msg(!tone_decode_wav(wav, size, &pcm), "Expected 8 bit WAV to be rejected");
+
+    size = make_wav(wav, 3, 1, 8000, 16, samples, 6, sizeof(samples));
+    ck_assert_msg(!tone_decode_wav(wav, size, &pcm), "Expected float WAV to be rejected");
+
+    size = make_wav(wav, 1, 1, 8000, 16, samples, 6, sizeof(samples));
+    ck_assert_msg(!tone_decode_wav(wav, 30, &pcm), "Expected truncated WAV to be rejected");
+    ck_assert_msg(!tone_decode_wav((const uint8_t *)"RIFF", 4, &pcm), "Expected truncated WAV to be rejected");
+}
+END_TEST
+
+START_TEST(test_opus_rejects)
+{
+    TONE_PCM pcm;
+    uint8_t page[64] = "OggS";
+
+    ck_assert(!tone_decode_opus(page, 3, &pcm));
+    ck_assert_msg(!tone_decode_opus(page, sizeof(page), &pcm), "Expected an empty page to be rejected");
+
+    // A page whose segment table runs past the end of the file.
+    page[26] = 200;
+    ck_assert(!tone_decode_opus(page, sizeof(page), &pcm));
+
+    // A complete page, but with a Vorbis header instead of OpusHead.
+    memset(page + 4, 0, sizeof(page) - 4);
+    page[26] = 1;
+    page[27] = 30;
+    memcpy(page + 28, "\x01vorbis", 7);
+    ck_assert(!tone_decode_opus(page, 28 + 30, &pcm));
+}
+END_TEST
+
+static Suite *suite(void)
+{
+    Suite *s = suite_create("Tones");
+
+    MK_TEST_CASE(builtin);
+    MK_TEST_CASE(wav);
+    MK_TEST_CASE(opus_rejects);
+
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    Suite *run = suite();
+    SRunner *test_runner = srunner_create(run);
+
+    int number_failed = 0;
+    srunner_run_all(test_runner, CK_NORMAL);
+    number_failed = srunner_ntests_failed(test_runner);
+
+    srunner_free(test_runner);
+
+    return number_failed;
+}
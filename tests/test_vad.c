@@ -0,0 +1,137 @@
+#include "../src/av/vad.c"
+
+#include "test.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#define RATE 48000
+#define PERIOD 480 // 10ms
+
+static uint32_t noise_seed = 1;
+
+/* A period of white noise at noise_rms with a tone_rms sine at freq on top. */
+static void make_period(int16_t *pcm, uint32_t *t, double freq, double tone_rms, uint16_t noise_rms) {
+    vad_comfort_noise(&noise_seed, noise_rms, pcm, PERIOD);
+    for (uint32_t i = 0; i < PERIOD; ++i, ++*t) {
+        pcm[i] += (int16_t)(sin(2 * M_PI * freq * *t / RATE) * tone_rms * sqrt(2));
+    }
+}
+
+START_TEST(test_silence)
+{
+    VAD v;
+    vad_init(&v, RATE);
+
+    int16_t pcm[PERIOD] = { 0 };
+    for (int i = 0; i < 100; ++i) {
+        ck_assert_msg(!vad_process(&v, pcm, PERIOD), "Expected digital silence to keep the gate closed");
+    }
+}
+END_TEST
+
+START_TEST(test_speech_in_noise)
+{
+    VAD v;
+    vad_init(&v, RATE);
+
+    int16_t pcm[PERIOD];
+    uint32_t t = 0;
+
+    // A second of fairly loud fan noise (-40dBFS) has to be learned as background.
+    int open = 0;
+    for (int i = 0; i < 100; ++i) {
+        make_period(pcm, &t, 0, 0, 330);
+        open += vad_process(&v, pcm, PERIOD);
+    }
+    ck_assert_msg(open <= 40, "Expected the gate to close on steady noise, it was open for %i periods", open);
+    ck_assert(!v.voice);
+
+    // A 200Hz tone 12dB over the noise is voice.
+    make_period(pcm, &t, 200, 1300, 330);
+    ck_assert_msg(vad_process(&v, pcm, PERIOD), "Expected a tone over the noise to open the gate");
+
+    // Back to noise: the gate stays open for the hangover and then closes.
+    uint32_t periods = 0;
+    do {
+        make_period(pcm, &t, 0, 0, 330);
+        ++periods;
+    } while (vad_process(&v, pcm, PERIOD) && periods < 1000);
+
+    ck_assert_msg(periods == VAD_HANGOVER_MS / 10, "Expected %u periods of hangover, got %u", VAD_HANGOVER_MS / 10, periods);
+}
+END_TEST
+
+START_TEST(test_flat_noise)
+{
+    VAD v;
+    vad_init(&v, RATE);
+
+    int16_t pcm[PERIOD];
+    uint32_t t = 0;
+
+    for (int i = 0; i < 100; ++i) {
+        make_period(pcm, &t, 0, 0, 100);
+        vad_process(&v, pcm, PERIOD);
+    }
+    ck_assert(!v.voice);
+
+    // Noise 8dB louder than before is too flat to be voice...
+    make_period(pcm, &t, 0, 0, 250);
+    ck_assert_msg(!vad_process(&v, pcm, PERIOD), "Expected a jump in white noise not to open the gate");
+
+    // ...but a tone of the same level is.
+    make_period(pcm, &t, 300, 250, 100);
+    ck_assert(vad_process(&v, pcm, PERIOD));
+}
+END_TEST
+
+START_TEST(test_comfort_noise)
+{
+    int16_t pcm[RATE];
+    uint32_t seed = 42;
+
+    vad_comfort_noise(&seed, 1000, pcm, RATE);
+
+    double energy = 0, mean = 0;
+    for (uint32_t i = 0; i < RATE; ++i) {
+        energy += (double)pcm[i] * pcm[i];
+        mean   += pcm[i];
+    }
+    const double rms = sqrt(energy / RATE);
+
+    ck_assert_msg(fabs(rms - 1000) < 20, "Expected RMS of 1000, got %f", rms);
+    ck_assert_msg(fabs(mean / RATE) < 20, "Expected no DC offset, got %f", mean / RATE);
+
+    vad_comfort_noise(&seed, 0, pcm, RATE);
+    for (uint32_t i = 0; i < RATE; ++i) {
+        ck_assert(pcm[i] == 0);
+    }
+}
+END_TEST
+
+static Suite *suite(void)
+{
+    Suite *s = suite_create("VAD");
+
+    MK_TEST_CASE(silence);
+    MK_TEST_CASE(speech_in_noise);
+    MK_TEST_CASE(flat_noise);
+    MK_TEST_CASE(comfort_noise);
+
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    Suite *run = suite();
+    SRunner *test_runner = srunner_create(run);
+
+    int number_failed = 0;
+    srunner_run_all(test_runner, CK_NORMAL);
+    number_failed = srunner_ntests_failed(test_runner);
+
+    srunner_free(test_runner);
+
+    return number_failed;
+}
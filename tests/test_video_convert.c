@@ -0,0 +1,87 @@
+#include "../src/av/video_convert.c"
+
+#include "test.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define WIDTH 70 // Not a multiple of the vector width, so the scalar tail runs too
+#define HEIGHT 11
+#define STRIDE (WIDTH * 2 + 12)
+
+static uint8_t in[STRIDE * HEIGHT];
+static uint8_t y[WIDTH * HEIGHT], u[(WIDTH / 2) * (HEIGHT / 2 + 1)], v[(WIDTH / 2) * (HEIGHT / 2 + 1)];
+
+static void fill(uint8_t *buf, size_t size) {
+    srand(1);
+    for (size_t i = 0; i < size; ++i) {
+        buf[i] = rand();
+    }
+}
+
+START_TEST(test_yuyv)
+{
+    fill(in, sizeof(in));
+    yuyv_to_i420(y, u, v, in, STRIDE, WIDTH, HEIGHT);
+
+    for (int r = 0; r < HEIGHT; ++r) {
+        for (int x = 0; x < WIDTH; ++x) {
+            ck_assert_msg(y[r * WIDTH + x] == in[r * STRIDE + x * 2], "Bad luma at %i,%i", x, r);
+        }
+    }
+
+    for (int r = 0; r < (HEIGHT + 1) / 2; ++r) {
+        const uint8_t *row0 = in + 2 * r * STRIDE;
+        const uint8_t *row1 = 2 * r + 1 < HEIGHT ? row0 + STRIDE : row0;
+        for (int x = 0; x < WIDTH / 2; ++x) {
+            const uint8_t exp_u = (row0[x * 4 + 1] + row1[x * 4 + 1] + 1) / 2;
+            const uint8_t exp_v = (row0[x * 4 + 3] + row1[x * 4 + 3] + 1) / 2;
+            ck_assert_msg(u[r * (WIDTH / 2) + x] == exp_u, "Bad U at %i,%i", x, r);
+            ck_assert_msg(v[r * (WIDTH / 2) + x] == exp_v, "Bad V at %i,%i", x, r);
+        }
+    }
+}
+END_TEST
+
+START_TEST(test_nv12)
+{
+    fill(in, sizeof(in));
+    const uint8_t *uv = in + STRIDE * (HEIGHT - 1);
+    nv12_to_i420(y, u, v, in, STRIDE, uv, STRIDE, WIDTH, HEIGHT - 1);
+
+    for (int r = 0; r < HEIGHT - 1; ++r) {
+        ck_assert(!memcmp(y + r * WIDTH, in + r * STRIDE, WIDTH));
+    }
+
+    for (int r = 0; r < (HEIGHT - 1) / 2; ++r) {
+        for (int x = 0; x < WIDTH / 2; ++x) {
+            ck_assert(u[r * (WIDTH / 2) + x] == uv[r * STRIDE + x * 2]);
+            ck_assert(v[r * (WIDTH / 2) + x] == uv[r * STRIDE + x * 2 + 1]);
+        }
+    }
+}
+END_TEST
+
+static Suite *suite(void)
+{
+    Suite *s = suite_create("Video convert");
+
+    MK_TEST_CASE(yuyv);
+    MK_TEST_CASE(nv12);
+
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    Suite *run = suite();
+    SRunner *test_runner = srunner_create(run);
+
+    int number_failed = 0;
+    srunner_run_all(test_runner, CK_NORMAL);
+    number_failed = srunner_ntests_failed(test_runner);
+
+    srunner_free(test_runner);
+
+    return number_failed;
+}
@@ -0,0 +1,135 @@
+#include "../src/av/video_pacer.c"
+
+#include "test.h"
+
+#include <stdint.h>
+
+#define MS (1000 * 1000ull)
+
+START_TEST(test_operating_points)
+{
+    VIDEO_PACER p;
+    video_pacer_init(&p, 5000);
+
+    // 5Mbit/s carries 720p at the full 25 fps.
+    ck_assert(video_pacer_update(&p, 1280, 720, 25, 0));
+    ck_assert_msg(p.width == 1280 && p.height == 720 && p.fps == 25, "Got %ux%u at %u", p.width, p.height, p.fps);
+
+    // Congestion: dropping down happens right away and trades resolution for keeping 15 fps.
+    video_pacer_set_bitrate(&p, 800);
+    ck_assert(video_pacer_update(&p, 1280, 720, 25, 1 * MS));
+    ck_assert_msg(p.width == 960 && p.height == 540, "Expected 3/4 size, got %ux%u", p.width, p.height);
+    ck_assert_msg(p.fps >= VIDEO_PACER_PREFERRED_FPS, "Expected at least %u fps, got %u", VIDEO_PACER_PREFERRED_FPS,
+                  p.fps);
+
+    // Going back up has to wait.
+    video_pacer_set_bitrate(&p, 5000);
+    ck_assert(!video_pacer_update(&p, 1280, 720, 25, 2 * MS));
+    ck_assert(p.width == 960);
+    ck_assert(video_pacer_update(&p, 1280, 720, 25, (VIDEO_PACER_HOLD_MS + 2) * MS));
+    ck_assert(p.width == 1280 && p.fps == 25);
+
+    // A terrible link bottoms out at the smallest size and lowest frame rate.
+    video_pacer_set_bitrate(&p, 1);
+    ck_assert(p.bitrate == VIDEO_PACER_MIN_BITRATE);
+    video_pacer_update(&p, 1280, 720, 25, (VIDEO_PACER_HOLD_MS + 3) * MS);
+    ck_assert_msg(p.width == 320 && p.height == 180 && p.fps >= VIDEO_PACER_MIN_FPS, "Got %ux%u at %u", p.width,
+                  p.height, p.fps);
+
+    // A new capture size is picked up immediately.
+    video_pacer_set_bitrate(&p, 5000);
+    ck_assert(video_pacer_update(&p, 640, 480, 25, (VIDEO_PACER_HOLD_MS + 4) * MS));
+    ck_assert(p.width == 640 && p.height == 480);
+}
+END_TEST
+
+START_TEST(test_send_errors)
+{
+    VIDEO_PACER p;
+    video_pacer_init(&p, 1000);
+
+    video_pacer_send_error(&p);
+    ck_assert(p.bitrate == 750 && p.send_errors == 1);
+
+    for (int i = 0; i < 100; ++i) {
+        video_pacer_send_error(&p);
+    }
+    ck_assert(p.bitrate == VIDEO_PACER_MIN_BITRATE);
+}
+END_TEST
+
+START_TEST(test_pacing)
+{
+    VIDEO_PACER p;
+    video_pacer_init(&p, 400);
+    video_pacer_update(&p, 640, 480, 30, 0);
+    ck_assert_msg(p.width == 480 && p.fps == 23, "Got %ux%u at %u", p.width, p.height, p.fps);
+
+    // Capturing at 30 fps with a bit of jitter, only about p.fps a second go out.
+    p.fps = 10;
+    uint32_t sent = 0;
+    for (uint32_t i = 0; i < 300; ++i) {
+        const uint64_t now = i * 33333333ull + (i % 3) * 2 * MS;
+        sent += video_pacer_due(&p, now, now);
+    }
+    ck_assert_msg(sent >= 98 && sent <= 102, "Expected 100 frames in 10 seconds, sent %u", sent);
+    ck_assert(p.frames_skipped == 300 - sent);
+}
+END_TEST
+
+START_TEST(test_stale_frames)
+{
+    VIDEO_PACER p;
+    video_pacer_init(&p, 5000);
+    video_pacer_update(&p, 640, 480, 20, 0);
+    ck_assert(p.fps == 20);
+
+    // A frame that sat around for more than two 50ms intervals is dropped, a fresher one still goes out.
+    ck_assert(!video_pacer_due(&p, 1000 * MS, 880 * MS));
+    ck_assert(p.frames_skipped == 1);
+    ck_assert(video_pacer_due(&p, 1000 * MS, 960 * MS));
+}
+END_TEST
+
+START_TEST(test_scaled_size)
+{
+    uint16_t w, h;
+
+    video_pacer_scaled_size(0, 1279, 719, &w, &h);
+    ck_assert(w == 1278 && h == 718);
+
+    video_pacer_scaled_size(3, 1280, 720, &w, &h);
+    ck_assert(w == 480 && h == 270);
+
+    // Too small to scale any further.
+    video_pacer_scaled_size(4, 40, 40, &w, &h);
+    ck_assert(w == 40 && h == 40);
+}
+END_TEST
+
+static Suite *suite(void)
+{
+    Suite *s = suite_create("Video pacer");
+
+    MK_TEST_CASE(operating_points);
+    MK_TEST_CASE(send_errors);
+    MK_TEST_CASE(pacing);
+    MK_TEST_CASE(stale_frames);
+    MK_TEST_CASE(scaled_size);
+
+    return s;
+}
+
+int main(int argc, char *argv[])
+{
+    Suite *run = suite();
+    SRunner *test_runner = srunner_create(run);
+
+    int number_failed = 0;
+    srunner_run_all(test_runner, CK_NORMAL);
+    number_failed = srunner_ntests_failed(test_runner);
+
+    srunner_free(test_runner);
+
+    return number_failed;
+}